@@ -0,0 +1,122 @@
+/**
+ * @file bench_array_io.cxx
+ * @brief Throughput of writing and reading a gridded array, by codec and
+ * thread count, compared with writing the raw bytes with std::ofstream
+ *
+ * Usage: fdpapi-bench-array-io [cells=4096] [layers=64] [threads=0]
+ *
+ * The array is layers x cells x cells float32. threads = 0 uses all
+ * hardware threads for the threaded rows.
+ */
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "fdp/utilities/array_io.hxx"
+
+using namespace FairDataPipeline;
+
+template <typename Function> double time_seconds(Function &&function) {
+  const auto start_ = std::chrono::steady_clock::now();
+  function();
+  const auto end_ = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end_ - start_).count();
+}
+
+void report(const std::string &format, const std::string &mode,
+            std::size_t n_bytes, double ratio, double seconds) {
+  std::cout << std::setw(16) << format << std::setw(18) << mode
+            << std::setw(12) << seconds << std::setw(12)
+            << n_bytes / seconds / 1e6 << std::setw(12) << ratio << "\n";
+}
+
+int main(int argc, char *argv[]) {
+  const std::uint64_t n_cells = argc > 1 ? std::atol(argv[1]) : 4096;
+  const std::uint64_t n_layers = argc > 2 ? std::atol(argv[2]) : 64;
+  const unsigned int n_threads = argc > 3 ? std::atoi(argv[3]) : 0;
+
+  const ghc::filesystem::path directory_ =
+      ghc::filesystem::temp_directory_path() / "fdpapi-bench-array-io";
+  ghc::filesystem::remove_all(directory_);
+  ghc::filesystem::create_directories(directory_);
+
+  // A smooth field with noise, like a model output
+  const std::vector<std::uint64_t> shape_ = {n_layers, n_cells, n_cells};
+  std::vector<float> data_(n_layers * n_cells * n_cells);
+  for (std::size_t i = 0; i < data_.size(); ++i) {
+    data_[i] = std::floor(100.0f * std::sin(0.001f * (i % 100003))) +
+               static_cast<float>(i % 7);
+  }
+  const std::size_t n_bytes_ = data_.size() * sizeof(float);
+
+  std::cout << std::left << std::setw(16) << "format" << std::setw(18)
+            << "mode" << std::setw(12) << "seconds" << std::setw(12)
+            << "MB/s" << std::setw(12) << "ratio" << "\n";
+
+  const ghc::filesystem::path raw_path_ = directory_ / "raw.bin";
+  report("raw", "ofstream", n_bytes_, 1.0, time_seconds([&]() {
+           std::ofstream out_(raw_path_.string(), std::ios_base::binary);
+           out_.write(reinterpret_cast<const char *>(data_.data()), n_bytes_);
+         }));
+
+  std::vector<std::string> formats_ = {"fdpa"};
+  if (array_hdf5_available()) {
+    formats_.push_back("h5");
+  }
+  const ArrayCodec codecs_[] = {ArrayCodec::NONE, ArrayCodec::LZ4,
+                                ArrayCodec::ZSTD, ArrayCodec::DEFLATE};
+  double checksum_ = 0.0;
+  for (const std::string &extension_ : formats_) {
+    for (ArrayCodec codec_ : codecs_) {
+      // HDF5 files are deflated for any codec
+      if (!array_codec_available(codec_) ||
+          (extension_ == "h5" && codec_ != ArrayCodec::NONE &&
+           codec_ != ArrayCodec::DEFLATE)) {
+        continue;
+      }
+      const std::string format_ = extension_ + " " + to_string(codec_);
+      const ghc::filesystem::path path_ =
+          directory_ / ("array_" + to_string(codec_) + "." + extension_);
+      ArrayOptions options_;
+      options_.codec = codec_;
+
+      options_.n_threads = 1;
+      const double serial_ = time_seconds(
+          [&]() { write_array(path_, "grid", data_, shape_, options_); });
+      const double ratio_ =
+          static_cast<double>(ghc::filesystem::file_size(path_)) / n_bytes_;
+      report(format_, "write", n_bytes_, ratio_, serial_);
+      ghc::filesystem::remove(path_);
+
+      options_.n_threads = n_threads;
+      report(format_, "write threaded", n_bytes_, ratio_,
+             time_seconds([&]() {
+               write_array(path_, "grid", data_, shape_, options_);
+             }));
+
+      const ArrayReader::sptr reader_ =
+          ArrayReader::open(path_, "grid", n_threads);
+      std::vector<float> read_;
+      report(format_, "read threaded", n_bytes_, ratio_,
+             time_seconds([&]() { read_ = reader_->read<float>(); }));
+      std::vector<float> slab_;
+      const double slab_seconds_ = time_seconds([&]() {
+        slab_ = reader_->read_slab<float>({n_layers / 2, 0, n_cells / 4},
+                                          {1, n_cells, n_cells / 2});
+      });
+      report(format_, "read slab", slab_.size() * sizeof(float), ratio_,
+             slab_seconds_);
+      checksum_ += read_.back() + slab_.back();
+    }
+  }
+
+  ghc::filesystem::remove_all(directory_);
+  // Keep the results alive
+  std::cerr << "checksum " << checksum_ << "\n";
+  return 0;
+}
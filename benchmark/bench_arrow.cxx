@@ -0,0 +1,134 @@
+/**
+ * @file bench_arrow.cxx
+ * @brief Throughput of ArrowWriter and ArrowTable, compared with writing
+ * and reading the same table as CSV with CsvWriter and CsvTable
+ *
+ * Usage: fdpapi-bench-arrow [rows=20000000] [batch_rows=65536]
+ *
+ * The table is written a batch at a time, so memory use is bounded by the
+ * batch size rather than the number of rows. Reading sums two columns: the
+ * CSV file is parsed into columns first, the Arrow file is summed in place
+ * in the map.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "fdp/utilities/arrow_table.hxx"
+#include "fdp/utilities/csv_table.hxx"
+
+using namespace FairDataPipeline;
+
+template <typename Function> double time_seconds(Function &&function) {
+  const auto start_ = std::chrono::steady_clock::now();
+  function();
+  const auto end_ = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end_ - start_).count();
+}
+
+void report(const std::string &method, std::uintmax_t n_bytes,
+            std::size_t n_rows, double seconds) {
+  std::cout << std::setw(20) << method << std::setw(12) << seconds
+            << std::setw(12) << n_bytes / 1e6 << std::setw(16)
+            << n_rows / seconds << "\n";
+}
+
+int main(int argc, char *argv[]) {
+  const std::size_t n_rows = argc > 1 ? std::atol(argv[1]) : 20000000;
+  const std::size_t batch_rows = argc > 2 ? std::atol(argv[2]) : 65536;
+
+  const ghc::filesystem::path directory_ =
+      ghc::filesystem::temp_directory_path() / "fdpapi-bench-arrow";
+  ghc::filesystem::remove_all(directory_);
+  ghc::filesystem::create_directories(directory_);
+  const ghc::filesystem::path csv_path_ = directory_ / "table.csv";
+  const ghc::filesystem::path arrow_path_ = directory_ / "table.arrow";
+  const char *names_[] = {"north", "south", "east", "west", "mid, west"};
+
+  std::vector<std::int64_t> days_(batch_rows);
+  std::vector<std::string> regions_(batch_rows);
+  std::vector<std::int32_t> cases_(batch_rows);
+  std::vector<double> rates_(batch_rows);
+  // Fill the batch holding rows first to first + size
+  const auto fill_batch_ = [&](std::size_t first, std::size_t size) {
+    days_.resize(size);
+    regions_.resize(size);
+    cases_.resize(size);
+    rates_.resize(size);
+    for (std::size_t i = 0; i < size; ++i) {
+      const std::size_t row_ = first + i;
+      days_[i] = static_cast<std::int64_t>(row_ / 1000);
+      regions_[i] = names_[row_ % 5];
+      cases_[i] = static_cast<std::int32_t>(row_ % 9973);
+      rates_[i] = 1e-3 * static_cast<double>(row_ % 100003);
+    }
+  };
+
+  std::cout << std::left << std::setw(20) << "method" << std::setw(12)
+            << "seconds" << std::setw(12) << "MB" << std::setw(16)
+            << "rows/s" << "\n";
+
+  const double csv_write_seconds_ = time_seconds([&]() {
+    CsvWriter::sptr writer_ = CsvWriter::construct(
+        csv_path_, {"day", "region", "cases", "rate"});
+    for (std::size_t first_ = 0; first_ < n_rows; first_ += batch_rows) {
+      fill_batch_(first_, std::min(batch_rows, n_rows - first_));
+      for (std::size_t i = 0; i < days_.size(); ++i) {
+        writer_->write_row(days_[i], regions_[i], cases_[i], rates_[i]);
+      }
+    }
+    writer_->close();
+  });
+  report("write CsvWriter", ghc::filesystem::file_size(csv_path_), n_rows,
+         csv_write_seconds_);
+
+  const double arrow_write_seconds_ = time_seconds([&]() {
+    ArrowWriter::sptr writer_ =
+        ArrowWriter::construct(arrow_path_, {{"day", ArrowType::INT64},
+                                             {"region", ArrowType::STRING},
+                                             {"cases", ArrowType::INT32},
+                                             {"rate", ArrowType::FLOAT64}});
+    for (std::size_t first_ = 0; first_ < n_rows; first_ += batch_rows) {
+      fill_batch_(first_, std::min(batch_rows, n_rows - first_));
+      writer_->write_batch({days_, regions_, cases_, rates_});
+    }
+    writer_->close();
+  });
+  report("write ArrowWriter", ghc::filesystem::file_size(arrow_path_), n_rows,
+         arrow_write_seconds_);
+
+  double checksum_ = 0.0;
+  report("read CsvTable", ghc::filesystem::file_size(csv_path_), n_rows,
+         time_seconds([&]() {
+           CsvTable::sptr table_ = CsvTable::read(csv_path_);
+           for (std::int64_t cases_read_ : table_->get_int64(2)) {
+             checksum_ += static_cast<double>(cases_read_);
+           }
+           for (double rate_ : table_->get_float64(3)) {
+             checksum_ += rate_;
+           }
+         }));
+
+  report("read ArrowTable", ghc::filesystem::file_size(arrow_path_), n_rows,
+         time_seconds([&]() {
+           ArrowTable::sptr table_ = ArrowTable::open(arrow_path_);
+           for (std::size_t b = 0; b < table_->n_batches(); ++b) {
+             const std::int32_t *cases_read_ =
+                 table_->values<std::int32_t>(b, 2);
+             const double *rates_read_ = table_->values<double>(b, 3);
+             for (std::size_t i = 0; i < table_->batch_rows(b); ++i) {
+               checksum_ += cases_read_[i] + rates_read_[i];
+             }
+           }
+         }));
+
+  ghc::filesystem::remove_all(directory_);
+  // Keep the results alive
+  std::cerr << "checksum " << checksum_ << "\n";
+  return 0;
+}
@@ -0,0 +1,130 @@
+/**
+ * @file bench_csv.cxx
+ * @brief Throughput of CsvTable and CsvWriter, compared with reading a CSV
+ * file with std::getline and a std::istringstream per row, and writing it
+ * with std::ofstream
+ *
+ * Usage: fdpapi-bench-csv [rows=20000000] [threads=0]
+ *
+ * Each row is about 60 bytes, so the default is a file of about 1.2 GB.
+ * threads = 0 uses all hardware threads for the threaded rows.
+ */
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "fdp/utilities/csv_table.hxx"
+
+using namespace FairDataPipeline;
+
+template <typename Function> double time_seconds(Function &&function) {
+  const auto start_ = std::chrono::steady_clock::now();
+  function();
+  const auto end_ = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end_ - start_).count();
+}
+
+void report(const std::string &method, std::uintmax_t n_bytes,
+            std::size_t n_rows, double seconds) {
+  std::cout << std::setw(28) << method << std::setw(12) << seconds
+            << std::setw(12) << n_bytes / seconds / 1e6 << std::setw(16)
+            << n_rows / seconds << "\n";
+}
+
+int main(int argc, char *argv[]) {
+  const std::size_t n_rows = argc > 1 ? std::atol(argv[1]) : 20000000;
+  const unsigned int n_threads = argc > 2 ? std::atoi(argv[2]) : 0;
+
+  const ghc::filesystem::path directory_ =
+      ghc::filesystem::temp_directory_path() / "fdpapi-bench-csv";
+  ghc::filesystem::remove_all(directory_);
+  ghc::filesystem::create_directories(directory_);
+  const ghc::filesystem::path naive_path_ = directory_ / "naive.csv";
+  const ghc::filesystem::path csv_path_ = directory_ / "table.csv";
+  const char *regions_[] = {"north", "south", "east", "west", "\"mid, west\""};
+
+  std::cout << std::left << std::setw(28) << "method" << std::setw(12)
+            << "seconds" << std::setw(12) << "MB/s" << std::setw(16)
+            << "rows/s" << "\n";
+
+  const double naive_seconds_ = time_seconds([&]() {
+    std::ofstream out_(naive_path_.string());
+    out_ << std::setprecision(17) << "day,region,cases,rate\n";
+    for (std::size_t i = 0; i < n_rows; ++i) {
+      out_ << i / 1000 << ',' << regions_[i % 5] << ',' << i % 9973
+           << ',' << 1e-3 * static_cast<double>(i % 100003) << '\n';
+    }
+  });
+  const std::uintmax_t n_bytes_ = ghc::filesystem::file_size(naive_path_);
+  report("write ofstream", n_bytes_, n_rows, naive_seconds_);
+
+  report("write CsvWriter", n_bytes_, n_rows, time_seconds([&]() {
+           const char *names_[] = {"north", "south", "east", "west",
+                                   "mid, west"};
+           CsvWriter::sptr writer_ = CsvWriter::construct(
+               csv_path_, {"day", "region", "cases", "rate"});
+           for (std::size_t i = 0; i < n_rows; ++i) {
+             writer_->field(i / 1000)
+                 .field(names_[i % 5])
+                 .field(i % 9973)
+                 .field(1e-3 * static_cast<double>(i % 100003))
+                 .end_row();
+           }
+           writer_->close();
+         }));
+
+  // Read into the same typed columns as CsvTable
+  double checksum_ = 0.0;
+  report("read getline+istringstream", n_bytes_, n_rows, time_seconds([&]() {
+           std::ifstream in_(naive_path_.string());
+           std::string line_;
+           std::getline(in_, line_);
+           std::vector<std::int64_t> days_, cases_;
+           std::vector<std::string> regions_read_;
+           std::vector<double> rates_;
+           while (std::getline(in_, line_)) {
+             std::istringstream fields_(line_);
+             std::string field_;
+             std::getline(fields_, field_, ',');
+             days_.push_back(std::stoll(field_));
+             std::getline(fields_, field_, ',');
+             if (!field_.empty() && field_[0] == '"') {
+               // The quoted region holds a delimiter
+               std::string rest_;
+               std::getline(fields_, rest_, ',');
+               field_ = field_.substr(1) + "," + rest_;
+               field_.pop_back();
+             }
+             regions_read_.push_back(field_);
+             std::getline(fields_, field_, ',');
+             cases_.push_back(std::stoll(field_));
+             std::getline(fields_, field_, ',');
+             rates_.push_back(std::stod(field_));
+           }
+           checksum_ += rates_.back() + days_.back();
+         }));
+
+  for (unsigned int threads_ : {1u, n_threads}) {
+    CsvOptions options_;
+    options_.n_threads = threads_;
+    const std::string method_ =
+        threads_ == 1 ? "read CsvTable" : "read CsvTable threaded";
+    report(method_, n_bytes_, n_rows, time_seconds([&]() {
+             CsvTable::sptr table_ = CsvTable::read(naive_path_, options_);
+             checksum_ += table_->get_float64(3).back() +
+                          table_->get_int64(0).back();
+           }));
+  }
+
+  ghc::filesystem::remove_all(directory_);
+  // Keep the results alive
+  std::cerr << "checksum " << checksum_ << "\n";
+  return 0;
+}
@@ -0,0 +1,88 @@
+/**
+ * @file bench_link_write_paths.cxx
+ * @brief Rate at which link_write can allocate data product paths, before
+ * and after PathAllocator
+ *
+ * Usage: fdpapi-bench-link-write-paths [writes=200000] [threads=4] [dir=.]
+ *
+ * Each write takes a unique file name and makes sure its directory exists,
+ * spread over 16 data products, which is the per-call filesystem and name
+ * generation work of Config::link_write excluding the config lookup.
+ */
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "fdp/objects/metadata.hxx"
+#include "fdp/utilities/path_allocator.hxx"
+
+using namespace FairDataPipeline;
+
+template <typename Function> double time_seconds(Function &&function) {
+  const auto start_ = std::chrono::steady_clock::now();
+  function();
+  const auto end_ = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end_ - start_).count();
+}
+
+template <typename Write>
+double run_threads(std::size_t n_writes, unsigned int n_threads,
+                   Write &&write) {
+  return time_seconds([&]() {
+    std::vector<std::thread> threads_;
+    for (unsigned int t = 0; t < n_threads; ++t) {
+      threads_.emplace_back([&, t]() {
+        for (std::size_t i = t; i < n_writes; i += n_threads) {
+          write(i);
+        }
+      });
+    }
+    for (auto &thread_ : threads_) {
+      thread_.join();
+    }
+  });
+}
+
+int main(int argc, char *argv[]) {
+  const std::size_t n_writes = argc > 1 ? std::atol(argv[1]) : 200000;
+  const unsigned int max_threads = argc > 2 ? std::atoi(argv[2]) : 4;
+  const ghc::filesystem::path root =
+      ghc::filesystem::path(argc > 3 ? argv[3] : ".") /
+      "fdpapi-bench-link-write-paths";
+
+  std::vector<ghc::filesystem::path> products_;
+  for (int p = 0; p < 16; ++p) {
+    products_.push_back(root / "PSU" / ("model/output/" + std::to_string(p)));
+  }
+
+  std::cout << std::left << std::setw(16) << "mode" << std::setw(10)
+            << "threads" << std::setw(12) << "seconds" << "writes/min\n";
+
+  for (unsigned int threads_ = 1; threads_ <= max_threads; threads_ *= 2) {
+    const double legacy_s_ = run_threads(n_writes, threads_, [&](std::size_t i) {
+      const ghc::filesystem::path path_ =
+          products_[i % products_.size()] /
+          ("dat-" + generate_random_hash() + ".csv");
+      ghc::filesystem::create_directories(path_.parent_path());
+    });
+    std::cout << std::setw(16) << "random-hash" << std::setw(10) << threads_
+              << std::setw(12) << legacy_s_ << n_writes * 60.0 / legacy_s_
+              << "\n";
+
+    PathAllocator allocator_;
+    const double fast_s_ = run_threads(n_writes, threads_, [&](std::size_t i) {
+      const ghc::filesystem::path path_ = products_[i % products_.size()] /
+                                          allocator_.unique_filename("csv");
+      allocator_.ensure_directory(path_.parent_path());
+    });
+    std::cout << std::setw(16) << "path-allocator" << std::setw(10) << threads_
+              << std::setw(12) << fast_s_ << n_writes * 60.0 / fast_s_ << "\n";
+  }
+
+  ghc::filesystem::remove_all(root);
+  return 0;
+}
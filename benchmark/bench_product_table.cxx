@@ -0,0 +1,116 @@
+/**
+ * @file bench_product_table.cxx
+ * @brief Memory and insert/lookup cost of tracking data products in a
+ * ProductTable against a std::map of IOObjects
+ *
+ * Usage: fdpapi-bench-product-table [max_products=1000000]
+ *
+ * Memory is reported as the growth in resident set size while the table is
+ * filled, and for the ProductTable also as the heap it reports reserving.
+ * Resident set size is only read on Linux.
+ */
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+
+#include "fdp/objects/product_table.hxx"
+
+using namespace FairDataPipeline;
+
+template <typename Function> double time_seconds(Function &&function) {
+  const auto start_ = std::chrono::steady_clock::now();
+  function();
+  const auto end_ = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end_ - start_).count();
+}
+
+std::size_t resident_bytes() {
+  std::ifstream statm_("/proc/self/statm");
+  std::size_t pages_ = 0;
+  std::size_t resident_ = 0;
+  if (!(statm_ >> pages_ >> resident_)) {
+    return 0;
+  }
+  return resident_ * 4096;
+}
+
+IOObject make_product(std::size_t i) {
+  const std::string name_ = "model/output/" + std::to_string(i);
+  return IOObject(name_, name_, "0.1.0", "PSU",
+                  "data_store/PSU/" + name_ + "/" + std::to_string(i * 7919) +
+                      ".csv",
+                  "Output of the model run", true);
+}
+
+template <typename Fill, typename Lookup, typename Heap>
+void report(const std::string &mode, std::size_t n_products, Fill &&fill,
+            Lookup &&lookup, Heap &&heap_bytes) {
+  const std::size_t rss_before_ = resident_bytes();
+  const double insert_s_ = time_seconds(fill);
+  const std::size_t rss_ = resident_bytes() - rss_before_;
+  const double lookup_s_ = time_seconds(lookup);
+  const std::size_t reported_bytes = heap_bytes();
+
+  std::cout << std::setw(14) << mode << std::setw(12) << n_products
+            << std::setw(14) << rss_ / 1048576.0 << std::setw(14)
+            << (reported_bytes ? reported_bytes / 1048576.0 : 0.0)
+            << std::setw(14) << static_cast<double>(rss_) / n_products
+            << std::setw(14) << insert_s_ << lookup_s_ << "\n";
+}
+
+int main(int argc, char *argv[]) {
+  const std::size_t max_products = argc > 1 ? std::atol(argv[1]) : 1000000;
+
+  std::cout << std::left << std::setw(14) << "mode" << std::setw(12)
+            << "products" << std::setw(14) << "rss MiB" << std::setw(14)
+            << "heap MiB" << std::setw(14) << "bytes/item" << std::setw(14)
+            << "insert s" << "lookup s\n";
+
+  for (std::size_t n_ = 100000; n_ <= max_products; n_ *= 10) {
+    std::size_t found_ = 0;
+    {
+      // Filled first, heap released by the map is not returned to the OS
+      // and would hide the growth of anything measured after it
+      ProductTable table_;
+      report(
+          "ProductTable", n_,
+          [&]() {
+            for (std::size_t i = 0; i < n_; ++i) {
+              table_.insert_or_assign(make_product(i));
+            }
+          },
+          [&]() {
+            for (std::size_t i = 0; i < n_; ++i) {
+              found_ += table_.contains("model/output/" + std::to_string(i));
+            }
+          },
+          [&]() { return table_.memory_usage(); });
+    }
+    {
+      std::map<std::string, IOObject> map_;
+      report(
+          "std::map", n_,
+          [&]() {
+            for (std::size_t i = 0; i < n_; ++i) {
+              IOObject product_ = make_product(i);
+              map_[product_.get_data_product()] = product_;
+            }
+          },
+          [&]() {
+            for (std::size_t i = 0; i < n_; ++i) {
+              found_ += map_.count("model/output/" + std::to_string(i));
+            }
+          },
+          []() { return std::size_t(0); });
+    }
+    if (found_ != 2 * n_) {
+      std::cerr << "lookups failed\n";
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,81 @@
+/**
+ * @file bench_sampling.cxx
+ * @brief Throughput of Distribution batch sampling and density evaluation,
+ * compared with drawing one value at a time from <random>
+ *
+ * Usage: fdpapi-bench-sampling [samples=10000000] [threads=0]
+ *
+ * threads = 0 uses all hardware threads for the threaded rows.
+ */
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "fdp/objects/distribution.hxx"
+
+using namespace FairDataPipeline;
+
+template <typename Function> double time_seconds(Function &&function) {
+  const auto start_ = std::chrono::steady_clock::now();
+  function();
+  const auto end_ = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end_ - start_).count();
+}
+
+void report(const std::string &family, const std::string &mode,
+            std::size_t n_samples, double seconds) {
+  std::cout << std::setw(12) << family << std::setw(18) << mode
+            << std::setw(12) << seconds << std::setw(16)
+            << n_samples / seconds << "\n";
+}
+
+int main(int argc, char *argv[]) {
+  const std::size_t n_samples = argc > 1 ? std::atol(argv[1]) : 10000000;
+  const unsigned int n_threads = argc > 2 ? std::atoi(argv[2]) : 0;
+
+  std::cout << std::left << std::setw(12) << "family" << std::setw(18)
+            << "mode" << std::setw(12) << "seconds" << std::setw(16)
+            << "values/s" << "\n";
+
+  std::vector<double> samples_(n_samples);
+  std::vector<double> results_(n_samples);
+  double checksum_ = 0.0;
+
+  std::mt19937_64 engine_(42);
+  std::normal_distribution<double> normal_(0.0, 1.0);
+  report("normal", "std::random", n_samples, time_seconds([&]() {
+           for (std::size_t i = 0; i < n_samples; ++i) {
+             samples_[i] = normal_(engine_);
+           }
+         }));
+  checksum_ += samples_[n_samples - 1];
+
+  const char *families_[] = {"normal", "lognormal", "gamma", "uniform"};
+  for (const char *family_ : families_) {
+    const Distribution distribution_(family_, 1.0, 0.5);
+    report(family_, "sample", n_samples, time_seconds([&]() {
+             distribution_.sample(samples_.data(), n_samples, 42);
+           }));
+    report(family_, "sample threaded", n_samples, time_seconds([&]() {
+             distribution_.sample(samples_.data(), n_samples, 42, 0,
+                                  n_threads);
+           }));
+    report(family_, "log_pdf", n_samples, time_seconds([&]() {
+             distribution_.log_pdf(samples_.data(), results_.data(),
+                                   n_samples);
+           }));
+    report(family_, "cdf threaded", n_samples, time_seconds([&]() {
+             distribution_.cdf(samples_.data(), results_.data(), n_samples,
+                               n_threads);
+           }));
+    checksum_ += results_[n_samples - 1];
+  }
+
+  // Keep the results alive
+  std::cerr << "checksum " << checksum_ << "\n";
+  return 0;
+}
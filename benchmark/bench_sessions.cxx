@@ -0,0 +1,97 @@
+/**
+ * @file bench_sessions.cxx
+ * @brief Sessions per second created by PipelineContext against independent
+ * DataPipeline::construct calls
+ *
+ * Usage: fdpapi-bench-sessions <config.yaml> <script> [n_sessions=10000]
+ *        [n_finalised=100] [n_constructed=20]
+ *
+ * Requires a running local registry and a token in ~/.fair/registry/token.
+ * Creation rates exclude the registry, finalised rates include registering
+ * and patching one code run per session.
+ */
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "fdp/fdp.hxx"
+#include "fdp/objects/metadata.hxx"
+
+using namespace FairDataPipeline;
+
+template <typename Function> double time_seconds(Function &&function) {
+  const auto start_ = std::chrono::steady_clock::now();
+  function();
+  const auto end_ = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end_ - start_).count();
+}
+
+void report(const std::string &mode, std::size_t n, double seconds) {
+  std::cout << std::left << std::setw(28) << mode << std::setw(10) << n
+            << std::setw(14) << seconds << n / seconds << "\n";
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 3) {
+    std::cerr << "usage: " << argv[0]
+              << " <config.yaml> <script> [n_sessions] [n_finalised]"
+                 " [n_constructed]\n";
+    return 1;
+  }
+  const std::string config_ = argv[1];
+  const std::string script_ = argv[2];
+  const std::size_t n_sessions = argc > 3 ? std::atol(argv[3]) : 10000;
+  const std::size_t n_finalised = argc > 4 ? std::atol(argv[4]) : 100;
+  const std::size_t n_constructed = argc > 5 ? std::atol(argv[5]) : 20;
+
+#ifdef _WIN32
+  const std::string home_ =
+      std::string(std::getenv("HOMEDRIVE")) + std::getenv("HOMEPATH");
+#else
+  const std::string home_ = std::getenv("HOME");
+#endif
+  const std::string token_ = read_token(ghc::filesystem::path(home_) / ".fair" /
+                                        "registry" / "token");
+
+  std::cout << std::left << std::setw(28) << "mode" << std::setw(10)
+            << "sessions" << std::setw(14) << "seconds"
+            << "sessions/s\n";
+
+  PipelineContext::sptr context_;
+  report("context construct", 1, time_seconds([&]() {
+           context_ = PipelineContext::construct(config_, script_, token_);
+         }));
+
+  std::vector<DataPipeline::sptr> sessions_;
+  sessions_.reserve(n_sessions);
+  report("context create_session", n_sessions, time_seconds([&]() {
+           for (std::size_t i = 0; i < n_sessions; ++i) {
+             sessions_.push_back(context_->create_session());
+           }
+         }));
+  sessions_.clear();
+
+  report("context session+finalise", n_finalised, time_seconds([&]() {
+           for (std::size_t i = 0; i < n_finalised; ++i) {
+             context_->create_session()->finalise();
+           }
+         }));
+
+  report("DataPipeline::construct", n_constructed, time_seconds([&]() {
+           for (std::size_t i = 0; i < n_constructed; ++i) {
+             sessions_.push_back(
+                 DataPipeline::construct(config_, script_, token_));
+           }
+         }));
+
+  report("construct+finalise", n_constructed, time_seconds([&]() {
+           for (std::size_t i = 0; i < n_constructed; ++i) {
+             DataPipeline::construct(config_, script_, token_)->finalise();
+           }
+         }));
+
+  return 0;
+}
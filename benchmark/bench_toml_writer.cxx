@@ -0,0 +1,106 @@
+/**
+ * @file bench_toml_writer.cxx
+ * @brief Cost of writing many point estimates to one TOML file, comparing
+ * the legacy parse-then-append per component with write_point_estimate and
+ * a single TomlWriter session
+ *
+ * Usage: fdpapi-bench-toml-writer [components=10000] [legacy_components=2000]
+ *        [dir=.]
+ *
+ * The legacy mode re-parses the whole file before every append, so its cost
+ * grows with the square of the component count and it is run on fewer
+ * components by default.
+ */
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "fdp/utilities/data_io.hxx"
+#include "fdp/utilities/toml_writer.hxx"
+
+using namespace FairDataPipeline;
+
+template <typename Function> double time_seconds(Function &&function) {
+  const auto start_ = std::chrono::steady_clock::now();
+  function();
+  const auto end_ = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end_ - start_).count();
+}
+
+std::string component_name(std::size_t i) {
+  return "parameter_" + std::to_string(i);
+}
+
+/**
+ * @brief What write_point_estimate did before TomlWriter
+ */
+void legacy_write(const ghc::filesystem::path &file_path,
+                  const std::string &component, double value) {
+  if (ghc::filesystem::exists(file_path)) {
+    const toml::value existing_ = toml::parse(file_path.string());
+    if (existing_.contains(component)) {
+      throw toml_error("Component " + component + " already exists");
+    }
+  }
+  const toml::value data_{
+      {component, {{"type", "point-estimate"}, {"value", value}}}};
+  std::ofstream toml_out_(file_path.string(), std::ios_base::app);
+  toml_out_ << data_;
+}
+
+void report(const std::string &mode, std::size_t n_components,
+            double seconds) {
+  std::cout << std::setw(16) << mode << std::setw(14) << n_components
+            << std::setw(12) << seconds << std::setw(14)
+            << n_components / seconds << "\n";
+}
+
+int main(int argc, char *argv[]) {
+  const std::size_t n_components = argc > 1 ? std::atol(argv[1]) : 10000;
+  const std::size_t n_legacy = argc > 2 ? std::atol(argv[2]) : 2000;
+  const ghc::filesystem::path dir = argc > 3 ? argv[3] : ".";
+  const ghc::filesystem::path file_path =
+      dir / "fdpapi-bench-toml-writer.toml";
+
+  std::cout << std::left << std::setw(16) << "mode" << std::setw(14)
+            << "components" << std::setw(12) << "seconds" << std::setw(14)
+            << "components/s" << "\n";
+
+  ghc::filesystem::remove(file_path);
+  report("legacy", n_legacy, time_seconds([&]() {
+           for (std::size_t i = 0; i < n_legacy; ++i) {
+             legacy_write(file_path, component_name(i), i * 0.5);
+           }
+         }));
+
+  ghc::filesystem::remove(file_path);
+  report("per-call", n_components, time_seconds([&]() {
+           for (std::size_t i = 0; i < n_components; ++i) {
+             double value_ = i * 0.5;
+             write_point_estimate(value_, component_name(i), file_path);
+           }
+         }));
+
+  ghc::filesystem::remove(file_path);
+  report("session", n_components, time_seconds([&]() {
+           TomlWriter::sptr writer_ = TomlWriter::construct(file_path);
+           for (std::size_t i = 0; i < n_components; ++i) {
+             write_point_estimate(i * 0.5, component_name(i), *writer_);
+           }
+           writer_->flush();
+         }));
+
+  // Check the session wrote every component
+  const double last_ =
+      read_point_estimate_from_toml(file_path, component_name(n_components - 1));
+  if (last_ != (n_components - 1) * 0.5) {
+    std::cerr << "read back " << last_ << " for the last component\n";
+    return 1;
+  }
+
+  ghc::filesystem::remove(file_path);
+  return 0;
+}
@@ -0,0 +1,85 @@
+/**
+ * @file bench_tree_hash.cxx
+ * @brief Thread scaling of calculate_tree_hash_from_file against the legacy
+ * single stream SHA-1 of calculate_hash_from_file
+ *
+ * Usage: fdpapi-bench-tree-hash [size_mib=1024] [max_threads=64] [dir=.]
+ *
+ * The file is written once and read repeatedly, so results reflect hashing
+ * throughput from the page cache unless the file exceeds available memory.
+ */
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "fdp/objects/metadata.hxx"
+#include "fdp/utilities/hash_cache.hxx"
+
+using namespace FairDataPipeline;
+
+template <typename Function> double time_seconds(Function &&function) {
+  const auto start_ = std::chrono::steady_clock::now();
+  function();
+  const auto end_ = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end_ - start_).count();
+}
+
+int main(int argc, char *argv[]) {
+  const std::size_t size_mib = argc > 1 ? std::atol(argv[1]) : 1024;
+  const unsigned int max_threads = argc > 2 ? std::atoi(argv[2]) : 64;
+  const ghc::filesystem::path dir = argc > 3 ? argv[3] : ".";
+
+  const ghc::filesystem::path file_path = dir / "fdpapi-bench-tree-hash.dat";
+  {
+    std::ofstream out_(file_path.string(), std::ios_base::binary);
+    std::vector<char> block_(1 << 20);
+    for (std::size_t i = 0; i < block_.size(); ++i) {
+      block_[i] = static_cast<char>((i * 2654435761u) >> 24);
+    }
+    for (std::size_t i = 0; i < size_mib; ++i) {
+      block_[0] = static_cast<char>(i);
+      out_.write(block_.data(), block_.size());
+    }
+  }
+
+  // Always hash from the file contents
+  HashCache::get_cache()->set_strict(true);
+
+  std::string digest_;
+  const double sha1_s_ =
+      time_seconds([&]() { digest_ = calculate_hash_from_file(file_path); });
+
+  std::cout << "file size: " << size_mib << " MiB\n";
+  std::cout << std::left << std::setw(16) << "mode" << std::setw(10)
+            << "threads" << std::setw(12) << "seconds" << std::setw(12)
+            << "MiB/s" << "speedup\n";
+  std::cout << std::setw(16) << "sha1" << std::setw(10) << 1 << std::setw(12)
+            << sha1_s_ << std::setw(12) << size_mib / sha1_s_ << "1.00\n";
+
+  double tree_1_s_ = 0.0;
+  std::string tree_digest_;
+  for (unsigned int threads_ = 1; threads_ <= max_threads; threads_ *= 2) {
+    std::string this_digest_;
+    const double s_ = time_seconds([&]() {
+      this_digest_ = calculate_tree_hash_from_file(file_path, threads_);
+    });
+    if (threads_ == 1) {
+      tree_1_s_ = s_;
+      tree_digest_ = this_digest_;
+    } else if (this_digest_ != tree_digest_) {
+      std::cerr << "tree hash differs at " << threads_ << " threads\n";
+      return 1;
+    }
+    std::cout << std::setw(16) << "sha256-tree" << std::setw(10) << threads_
+              << std::setw(12) << s_ << std::setw(12) << size_mib / s_
+              << std::fixed << std::setprecision(2) << tree_1_s_ / s_
+              << std::defaultfloat << std::setprecision(6) << "\n";
+  }
+
+  ghc::filesystem::remove(file_path);
+  return 0;
+}
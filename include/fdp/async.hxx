@@ -0,0 +1,415 @@
+/*! **************************************************************************
+ * @file FairDataPipeline/async.hxx
+ * @date 2026-10-19
+ * @brief File containing the C++20 coroutine layer of the DataPipeline
+ *
+ * Only available when the library is built with `FDPAPI_WITH_COROUTINES`.
+ * Each awaitable runs the synchronous call on an Executor and resumes the
+ * awaiting coroutine on the executor's thread when the call returns, so a
+ * driver running many sessions shares the executor's threads instead of
+ * blocking one thread per session on registry I/O.
+ ****************************************************************************/
+#ifndef __FDP_ASYNC_HXX__
+#define __FDP_ASYNC_HXX__
+
+#if !defined(FDPAPI_WITH_COROUTINES) || __cplusplus < 202002L
+#error "fdp/async.hxx requires C++20 and a build with FDPAPI_WITH_COROUTINES"
+#endif
+
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "fdp.hxx"
+
+namespace FairDataPipeline {
+namespace coro {
+
+/**
+ * @brief Runs tasks posted by the awaitables
+ *
+ * Implement post to plug in an existing event loop, e.g. with
+ * `asio::post(io_context, std::move(task))`.
+ */
+class Executor {
+public:
+  typedef std::shared_ptr<Executor> sptr;
+
+  virtual ~Executor() = default;
+
+  /**
+   * @brief Run a task at some later point, possibly on another thread
+   *
+   * @param task
+   */
+  virtual void post(std::function<void()> task) = 0;
+};
+
+/**
+ * @brief Executor running tasks on a fixed pool of threads
+ */
+class ThreadPoolExecutor : public Executor {
+public:
+  typedef std::shared_ptr<ThreadPoolExecutor> sptr;
+
+  /**
+   * @brief Construct a pool
+   *
+   * @param n_threads number of threads, 0 for all hardware threads
+   * @return ThreadPoolExecutor::sptr
+   */
+  static sptr construct(unsigned int n_threads = 0);
+
+  /**
+   * @brief Run the queued tasks, then join the threads
+   */
+  ~ThreadPoolExecutor() override;
+
+  void post(std::function<void()> task) override;
+
+  std::size_t size() const { return threads_.size(); }
+
+private:
+  explicit ThreadPoolExecutor(unsigned int n_threads);
+
+  ThreadPoolExecutor(const ThreadPoolExecutor &rhs) = delete;
+  ThreadPoolExecutor &operator=(const ThreadPoolExecutor &rhs) = delete;
+
+  /**
+   * @brief Queue shared with the threads, which may outlive the executor
+   * when its last reference is dropped by one of its own tasks
+   */
+  struct State {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::function<void()>> tasks;
+    bool stopping = false;
+  };
+
+  static void run_(std::shared_ptr<State> state);
+
+  std::shared_ptr<State> state_;
+  std::vector<std::thread> threads_;
+};
+
+namespace detail {
+/**
+ * @brief Value or exception produced by a call
+ */
+template <typename T> class Result {
+public:
+  template <typename Function> void capture(Function &function) {
+    try {
+      value_.emplace(function());
+    } catch (...) {
+      error_ = std::current_exception();
+    }
+  }
+  void set_value(T value) { value_.emplace(std::move(value)); }
+  void set_error(std::exception_ptr error) { error_ = error; }
+  T get() {
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+    return std::move(*value_);
+  }
+
+private:
+  std::optional<T> value_;
+  std::exception_ptr error_;
+};
+
+template <> class Result<void> {
+public:
+  template <typename Function> void capture(Function &function) {
+    try {
+      function();
+    } catch (...) {
+      error_ = std::current_exception();
+    }
+  }
+  void set_error(std::exception_ptr error) { error_ = error; }
+  void get() {
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+  }
+
+private:
+  std::exception_ptr error_;
+};
+
+/**
+ * @brief Resumes the awaiting coroutine, if any, when a Task completes
+ */
+struct FinalAwaiter {
+  bool await_ready() const noexcept { return false; }
+  template <typename Promise>
+  std::coroutine_handle<>
+  await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+    std::coroutine_handle<> continuation_ = handle.promise().continuation;
+    return continuation_ ? continuation_ : std::noop_coroutine();
+  }
+  void await_resume() const noexcept {}
+};
+
+template <typename T> struct PromiseBase {
+  std::coroutine_handle<> continuation;
+  Result<T> result;
+
+  std::suspend_always initial_suspend() const noexcept { return {}; }
+  FinalAwaiter final_suspend() const noexcept { return {}; }
+  void unhandled_exception() { result.set_error(std::current_exception()); }
+};
+} // namespace detail
+
+/**
+ * @brief Lazily started coroutine returning a T
+ *
+ * The body runs when the task is first awaited, or passed to sync_wait.
+ */
+template <typename T = void> class Task {
+public:
+  struct promise_type : detail::PromiseBase<T> {
+    Task get_return_object() {
+      return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+    template <typename U> void return_value(U &&value) {
+      this->result.set_value(std::forward<U>(value));
+    }
+  };
+
+  Task(Task &&rhs) noexcept : handle_(std::exchange(rhs.handle_, {})) {}
+  Task &operator=(Task &&rhs) noexcept {
+    if (this != &rhs) {
+      if (handle_) {
+        handle_.destroy();
+      }
+      handle_ = std::exchange(rhs.handle_, {});
+    }
+    return *this;
+  }
+  ~Task() {
+    if (handle_) {
+      handle_.destroy();
+    }
+  }
+
+  bool await_ready() const noexcept { return false; }
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) {
+    handle_.promise().continuation = awaiting;
+    return handle_;
+  }
+  T await_resume() { return handle_.promise().result.get(); }
+
+private:
+  explicit Task(std::coroutine_handle<promise_type> handle)
+      : handle_(handle) {}
+
+  std::coroutine_handle<promise_type> handle_;
+};
+
+template <> struct Task<void>::promise_type : detail::PromiseBase<void> {
+  Task get_return_object() {
+    return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+  }
+  void return_void() {}
+};
+
+/**
+ * @brief Awaitable running a blocking call on an Executor
+ */
+template <typename T> class BlockingCall {
+public:
+  BlockingCall(Executor::sptr executor, std::function<T()> function)
+      : executor_(std::move(executor)), function_(std::move(function)) {}
+
+  bool await_ready() const noexcept { return false; }
+  void await_suspend(std::coroutine_handle<> awaiting) {
+    // This awaitable lives in the suspended coroutine's frame until resumed,
+    // which may happen before post returns, so keep the executor alive here
+    const Executor::sptr executor_ref_ = executor_;
+    executor_ref_->post([this, awaiting]() {
+      result_.capture(function_);
+      awaiting.resume();
+    });
+  }
+  T await_resume() { return result_.get(); }
+
+private:
+  Executor::sptr executor_;
+  std::function<T()> function_;
+  detail::Result<T> result_;
+};
+
+/**
+ * @brief Await any blocking call on an executor
+ *
+ * @param executor
+ * @param function called on one of the executor's threads
+ * @return BlockingCall awaitable returning the result of function
+ */
+template <typename Function>
+BlockingCall<typename std::invoke_result<Function &>::type>
+async_call(Executor::sptr executor, Function function) {
+  return BlockingCall<typename std::invoke_result<Function &>::type>(
+      std::move(executor), std::move(function));
+}
+
+/**
+ * @brief Await DataPipeline::link_read
+ *
+ * @param executor
+ * @param pipeline
+ * @param data_product
+ * @return BlockingCall<std::string> awaitable returning the path
+ */
+inline BlockingCall<std::string> async_link_read(Executor::sptr executor,
+                                                 DataPipeline::sptr pipeline,
+                                                 std::string data_product) {
+  return BlockingCall<std::string>(
+      std::move(executor), [pipeline, data_product]() mutable {
+        return pipeline->link_read(data_product);
+      });
+}
+
+/**
+ * @brief Await DataPipeline::link_write
+ *
+ * @param executor
+ * @param pipeline
+ * @param data_product
+ * @return BlockingCall<std::string> awaitable returning the path
+ */
+inline BlockingCall<std::string> async_link_write(Executor::sptr executor,
+                                                  DataPipeline::sptr pipeline,
+                                                  std::string data_product) {
+  return BlockingCall<std::string>(
+      std::move(executor), [pipeline, data_product]() mutable {
+        return pipeline->link_write(data_product);
+      });
+}
+
+/**
+ * @brief Await DataPipeline::finalise
+ *
+ * @param executor
+ * @param pipeline
+ * @return BlockingCall<void>
+ */
+inline BlockingCall<void> async_finalise(Executor::sptr executor,
+                                         DataPipeline::sptr pipeline) {
+  return BlockingCall<void>(std::move(executor),
+                            [pipeline]() { pipeline->finalise(); });
+}
+
+namespace detail {
+/**
+ * @brief One-shot flag a thread can wait on
+ */
+class Event {
+public:
+  void set() {
+    // Notify under the lock so the waiter cannot destroy us mid-notify
+    std::lock_guard<std::mutex> lock_(mutex_);
+    set_ = true;
+    cv_.notify_all();
+  }
+  void wait() {
+    std::unique_lock<std::mutex> lock_(mutex_);
+    cv_.wait(lock_, [this]() { return set_; });
+  }
+
+private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool set_ = false;
+};
+
+/**
+ * @brief Coroutine used by sync_wait, sets an Event when it completes
+ */
+struct SyncWaitTask {
+  struct promise_type {
+    Event *event = nullptr;
+
+    SyncWaitTask get_return_object() {
+      return SyncWaitTask{
+          std::coroutine_handle<promise_type>::from_promise(*this)};
+    }
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    auto final_suspend() const noexcept {
+      struct Notify {
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(
+            std::coroutine_handle<promise_type> handle) const noexcept {
+          handle.promise().event->set();
+        }
+        void await_resume() const noexcept {}
+      };
+      return Notify{};
+    }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+
+  SyncWaitTask(SyncWaitTask &&rhs) noexcept
+      : handle(std::exchange(rhs.handle, {})) {}
+  explicit SyncWaitTask(std::coroutine_handle<promise_type> h) : handle(h) {}
+  ~SyncWaitTask() {
+    if (handle) {
+      handle.destroy();
+    }
+  }
+
+  std::coroutine_handle<promise_type> handle;
+};
+/**
+ * @brief Await a task, storing its result
+ */
+template <typename T>
+SyncWaitTask sync_wait_run(Task<T> &task, Result<T> &result) {
+  try {
+    if constexpr (std::is_void<T>::value) {
+      co_await task;
+    } else {
+      result.set_value(co_await task);
+    }
+  } catch (...) {
+    result.set_error(std::current_exception());
+  }
+}
+} // namespace detail
+
+/**
+ * @brief Block the calling thread until a task completes
+ *
+ * For use at the boundary with synchronous code, e.g. in main or tests.
+ *
+ * @param task
+ * @return T the value returned by task, exceptions are rethrown
+ */
+template <typename T> T sync_wait(Task<T> task) {
+  detail::Event event_;
+  detail::Result<T> result_;
+  detail::SyncWaitTask waiter_ = detail::sync_wait_run(task, result_);
+  waiter_.handle.promise().event = &event_;
+  waiter_.handle.resume();
+  event_.wait();
+  return result_.get();
+}
+
+} // namespace coro
+}; // namespace FairDataPipeline
+
+#endif
@@ -40,6 +40,26 @@ public:
   using std::runtime_error::runtime_error;
 };
 
+class parameter_store_error : public std::runtime_error {
+public:
+  using std::runtime_error::runtime_error;
+};
+
+class array_error : public std::runtime_error {
+public:
+  using std::runtime_error::runtime_error;
+};
+
+class csv_error : public std::runtime_error {
+public:
+  using std::runtime_error::runtime_error;
+};
+
+class arrow_error : public std::runtime_error {
+public:
+  using std::runtime_error::runtime_error;
+};
+
 }; // namespace FairDataPipeline
 
 #endif
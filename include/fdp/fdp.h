@@ -16,6 +16,13 @@ extern "C" {
  * to this struct should be passed to functions in the C API. Set up by the
  * function fdp_init, and finalised by fdp_finalise. Can also be generated from
  * a C++ DataPipeline using to_c_struct.
+ *
+ * Link functions and fdp_finalise_poll may be called concurrently on one
+ * FdpDataPipeline from any number of threads without external locking.
+ * fdp_finalise and fdp_finalise_start must only be called once all link calls
+ * have returned, and fdp_finalise_wait once polling has stopped. No call may
+ * be made on the pipeline once fdp_finalise or fdp_finalise_wait has been
+ * called.
  */
 struct FdpDataPipeline;
 typedef struct FdpDataPipeline FdpDataPipeline;
@@ -72,12 +79,73 @@ FdpError fdp_init(FdpDataPipeline **data_pipeline, const char *config_file_path,
  * with all appropriate meta data.
  *
  * @param data_pipeline Pointer-to-pointer of a FdpDataPipeline object. This
- * function finalises the FdpDataPipeline, and sets its pointer to NULL.
+ * function finalises the FdpDataPipeline, and sets its pointer to NULL. The
+ * pipeline is released even if finalise fails, as a failed finalise cannot
+ * be retried.
  *
  * @return Error code.
  */
 FdpError fdp_finalise(FdpDataPipeline **data_pipeline);
 
+/**
+ * @brief Progress of a finalise started with fdp_finalise_start.
+ */
+struct FdpFinaliseProgress {
+  size_t outputs_total;      /*!< Outputs to register */
+  size_t outputs_hashed;     /*!< Outputs hashed and stored */
+  size_t outputs_registered; /*!< Outputs registered */
+  size_t registry_calls;     /*!< Registry requests made */
+  int done;                  /*!< Non-zero once finalise has returned */
+};
+typedef struct FdpFinaliseProgress FdpFinaliseProgress;
+
+/**
+ * @brief Start finalising the pipeline on a background thread.
+ *
+ * Must be called after fdp_init, once all link calls have returned. The
+ * pipeline may not be used for links while finalising. Complete the call with
+ * fdp_finalise_wait. This function and fdp_finalise_poll may be called from
+ * any thread.
+ *
+ * @param data_pipeline Pointer to a FdpDataPipeline object.
+ *
+ * @return Error code. FDP_ERR_OTHER if finalise has already been started,
+ * by this function or by fdp_finalise.
+ */
+FdpError fdp_finalise_start(FdpDataPipeline *data_pipeline);
+
+/**
+ * @brief Report the progress of a finalise started with fdp_finalise_start
+ * without blocking.
+ *
+ * @param data_pipeline Pointer to a FdpDataPipeline object.
+ *
+ * @param progress Filled with the progress so far. May be `NULL`.
+ *
+ * Polling must stop before fdp_finalise_wait is called: a poll already in
+ * progress is allowed to return, a poll started once fdp_finalise_wait has
+ * been called fails, and a poll started after it has returned uses a
+ * deleted pipeline.
+ *
+ * @return Error code. FDP_ERR_NONE while finalise is running, the result of
+ * finalise once it has returned.
+ */
+FdpError fdp_finalise_poll(FdpDataPipeline *data_pipeline,
+                           FdpFinaliseProgress *progress);
+
+/**
+ * @brief Wait for a finalise started with fdp_finalise_start to complete.
+ *
+ * The FdpDataPipeline is then deleted and its pointer set to NULL, as in
+ * fdp_finalise, whether or not finalise succeeded. Only one thread may wait,
+ * and no call may be made on the pipeline once it has been called.
+ *
+ * @param data_pipeline Pointer-to-pointer of a FdpDataPipeline object.
+ *
+ * @return Error code
+ */
+FdpError fdp_finalise_wait(FdpDataPipeline **data_pipeline);
+
 /**
  * @brief Set a path to a given data product while recording its meta data for
  * the code run.
@@ -120,6 +188,216 @@ FdpError fdp_link_read(FdpDataPipeline *data_pipeline, const char *data_product,
 FdpError fdp_link_write(FdpDataPipeline *data_pipeline,
                         const char *data_product, char *data_store_path, size_t data_store_path_len);
 
+/**
+ * @brief Set paths to many data products in one call while recording their
+ * meta data for the code run.
+ *
+ * Must be called after fdp_init and before fdp_finalise. Registry lookups for
+ * the batch are made concurrently. Every product is attempted even if others
+ * fail.
+ *
+ * @param data_pipeline Pointer to a FdpDataPipeline object.
+ *
+ * @param data_products Array of input data product names.
+ *
+ * @param n_data_products Number of entries in data_products.
+ *
+ * @param data_store_paths Array of n_data_products buffers, each of
+ * data_store_path_len chars, receiving the assigned data store locations.
+ *
+ * @param data_store_path_len Size of each buffer in data_store_paths.
+ *
+ * @param errors Array of n_data_products error codes, one per product. May
+ * be `NULL`.
+ *
+ * @return Error code of the first product which failed, or FDP_ERR_NONE.
+ */
+FdpError fdp_link_read_many(FdpDataPipeline *data_pipeline,
+                            const char *const *data_products,
+                            size_t n_data_products, char **data_store_paths,
+                            size_t data_store_path_len, FdpError *errors);
+
+/**
+ * @brief Set paths for many output data products in one call while recording
+ * their meta data for the code run.
+ *
+ * As fdp_link_read_many, for outputs.
+ *
+ * @param data_pipeline Pointer to a FdpDataPipeline object.
+ *
+ * @param data_products Array of output data product names.
+ *
+ * @param n_data_products Number of entries in data_products.
+ *
+ * @param data_store_paths Array of n_data_products buffers, each of
+ * data_store_path_len chars, receiving the assigned data store locations.
+ *
+ * @param data_store_path_len Size of each buffer in data_store_paths.
+ *
+ * @param errors Array of n_data_products error codes, one per product. May
+ * be `NULL`.
+ *
+ * @return Error code of the first product which failed, or FDP_ERR_NONE.
+ */
+FdpError fdp_link_write_many(FdpDataPipeline *data_pipeline,
+                             const char *const *data_products,
+                             size_t n_data_products, char **data_store_paths,
+                             size_t data_store_path_len, FdpError *errors);
+
+/**
+ * @brief Read a point estimate from a TOML file.
+ *
+ * @param file_path Path to the TOML file, e.g. as returned by fdp_link_read.
+ *
+ * @param component Name of the component. If `NULL`, the first component in
+ * the file is read.
+ *
+ * @param value Set to the point estimate.
+ *
+ * @return Error code
+ */
+FdpError fdp_read_point_estimate(const char *file_path, const char *component,
+                                 double *value);
+
+/**
+ * @brief Append a point estimate to a TOML file.
+ *
+ * @param file_path Path to the TOML file, e.g. as returned by fdp_link_write.
+ *
+ * @param component Name of the component, which must not already exist.
+ *
+ * @param value The point estimate.
+ *
+ * @return Error code
+ */
+FdpError fdp_write_point_estimate(const char *file_path, const char *component,
+                                  double value);
+
+/**
+ * @brief Read many point estimates from a TOML file, parsing it once.
+ *
+ * @param file_path Path to the TOML file.
+ *
+ * @param components Array of n_components component names.
+ *
+ * @param n_components Number of components.
+ *
+ * @param values Array of n_components values, set on success.
+ *
+ * @return Error code
+ */
+FdpError fdp_read_point_estimates(const char *file_path,
+                                  const char *const *components,
+                                  size_t n_components, double *values);
+
+/**
+ * @brief Append many point estimates to a TOML file in a single write.
+ *
+ * Nothing is written if any component already exists.
+ *
+ * @param file_path Path to the TOML file.
+ *
+ * @param components Array of n_components component names.
+ *
+ * @param values Array of n_components values.
+ *
+ * @param n_components Number of components.
+ *
+ * @return Error code
+ */
+FdpError fdp_write_point_estimates(const char *file_path,
+                                   const char *const *components,
+                                   const double *values, size_t n_components);
+
+/**
+ * @brief Read a distribution from a TOML file.
+ *
+ * @param file_path Path to the TOML file.
+ *
+ * @param component Name of the component. If `NULL`, the first component in
+ * the file is read.
+ *
+ * @param name Buffer receiving the distribution name, e.g. "normal".
+ *
+ * @param name_len Size of the name buffer.
+ *
+ * @param mu Set to the distribution's mu.
+ *
+ * @param sigma Set to the distribution's sigma.
+ *
+ * @return Error code
+ */
+FdpError fdp_read_distribution(const char *file_path, const char *component,
+                               char *name, size_t name_len, double *mu,
+                               double *sigma);
+
+/**
+ * @brief Append a distribution to a TOML file.
+ *
+ * @param file_path Path to the TOML file.
+ *
+ * @param component Name of the component, which must not already exist.
+ *
+ * @param name Distribution name, e.g. "normal".
+ *
+ * @param mu The distribution's mu.
+ *
+ * @param sigma The distribution's sigma.
+ *
+ * @return Error code
+ */
+FdpError fdp_write_distribution(const char *file_path, const char *component,
+                                const char *name, double mu, double sigma);
+
+/**
+ * @brief Read many distributions from a TOML file, parsing it once.
+ *
+ * @param file_path Path to the TOML file.
+ *
+ * @param components Array of n_components component names.
+ *
+ * @param n_components Number of components.
+ *
+ * @param names Array of n_components buffers, each of name_len chars,
+ * receiving the distribution names.
+ *
+ * @param name_len Size of each buffer in names.
+ *
+ * @param mus Array of n_components values of mu, set on success.
+ *
+ * @param sigmas Array of n_components values of sigma, set on success.
+ *
+ * @return Error code
+ */
+FdpError fdp_read_distributions(const char *file_path,
+                                const char *const *components,
+                                size_t n_components, char **names,
+                                size_t name_len, double *mus, double *sigmas);
+
+/**
+ * @brief Append many distributions to a TOML file in a single write.
+ *
+ * Nothing is written if any component already exists.
+ *
+ * @param file_path Path to the TOML file.
+ *
+ * @param components Array of n_components component names.
+ *
+ * @param names Array of n_components distribution names.
+ *
+ * @param mus Array of n_components values of mu.
+ *
+ * @param sigmas Array of n_components values of sigma.
+ *
+ * @param n_components Number of components.
+ *
+ * @return Error code
+ */
+FdpError fdp_write_distributions(const char *file_path,
+                                 const char *const *components,
+                                 const char *const *names, const double *mus,
+                                 const double *sigmas, size_t n_components);
+
 /**
  * @brief Enumeration used to denote the different levels of logging.
  *
@@ -168,6 +446,27 @@ FdpLogLevel fdp_get_log_level();
  */
 int fdp_log(FdpLogLevel log_level, const char *msg);
 
+/**
+ * @brief Get the message of the last call on this thread which failed.
+ *
+ * Each thread keeps its own message, so calls on other threads do not
+ * change it. Successful calls leave it unchanged. The returned string is
+ * owned by the library and remains valid until the next failing call on this
+ * thread.
+ *
+ * @return Error message, empty if no call on this thread has failed.
+ */
+const char *fdp_last_error_message();
+
+/**
+ * @brief Get the name of an error code, e.g. "Config Parse".
+ *
+ * @param err Error code.
+ *
+ * @return Static string naming the error.
+ */
+const char *fdp_error_name(FdpError err);
+
 #ifdef __cplusplus
 
 } // close extern "C"
@@ -1,6 +1,11 @@
 #ifndef __FDP__
 #define __FDP__
 
+#include <cstddef>
+#include <exception>
+#include <string>
+#include <vector>
+
 #include "utilities/logging.hxx"
 
 namespace FairDataPipeline {
@@ -8,11 +13,24 @@ namespace FairDataPipeline {
  * @brief DataPipeline Class:
  * A PIMPL Class for interacting the the FAIR Data Pipeline
  * 
+ * link_read and link_write are thread safe and may be called concurrently,
+ * e.g. from within an OpenMP parallel region, without external locking.
+ * finalise must be called once, after all link calls have returned.
  */
     class DataPipeline {
 
         public:
             typedef std::shared_ptr< DataPipeline > sptr;
+
+  /**
+   * @brief Progress of a call to finalise
+   */
+            struct FinaliseProgress {
+                std::size_t outputs_total = 0;      /*!< Outputs to register */
+                std::size_t outputs_hashed = 0;     /*!< Outputs hashed and stored */
+                std::size_t outputs_registered = 0; /*!< Outputs registered */
+                std::size_t registry_calls = 0;     /*!< Registry requests made */
+            };
   /**
    * @brief Construct a new Data Pipeline (PIMPL)
    * 
@@ -25,6 +43,30 @@ namespace FairDataPipeline {
                     const std::string &script_file_path,
                     std::string token = "" );
 
+  /**
+   * @brief Construct a Data Pipeline sharing one code run between processes
+   * 
+   * Rank 0 registers the code run and finalises the outputs of every rank,
+   * all other ranks attach to it without contacting the registry. Every
+   * rank must call finalise.
+   * 
+   * @param config_file_path 
+   * @param script_file_path 
+   * @param token 
+   * @param session_rank rank of this process, 0 is the leader
+   * @param session_size number of processes sharing the code run
+   * @param session_id identifier common to all processes, defaults to the
+   * FDP_SESSION_ID or SLURM_JOB_ID environment variable and then to a hash
+   * of the config and script
+   */
+           static  sptr construct_shared(
+                    const std::string &config_file_path,
+                    const std::string &script_file_path,
+                    std::string token,
+                    int session_rank,
+                    int session_size,
+                    const std::string &session_id = "" );
+
 
   /**
    * @brief Destroy the Data Pipeline object
@@ -54,6 +96,34 @@ namespace FairDataPipeline {
    */
             std::string link_write(std::string &data_product);
 
+  /**
+   * @brief Return paths to many data products in one call
+   * Registry lookups for the batch run concurrently, see the
+   * run_metadata key `link_threads`
+   * 
+   * @param data_products 
+   * @param errors if given, filled with one entry per product which is
+   * null where the read succeeded; otherwise the first failure is rethrown
+   * once every product has been attempted
+   * @return std::vector<std::string> one path per product, empty where the
+   * read failed
+   */
+            std::vector<std::string> link_read_many(
+                    const std::vector<std::string> &data_products,
+                    std::vector<std::exception_ptr> *errors = nullptr);
+
+  /**
+   * @brief Return paths to be used for many data products in one call
+   * 
+   * @param data_products 
+   * @param errors as for link_read_many
+   * @return std::vector<std::string> one path per product, empty where the
+   * write failed
+   */
+            std::vector<std::string> link_write_many(
+                    const std::vector<std::string> &data_products,
+                    std::vector<std::exception_ptr> *errors = nullptr);
+
   /**
    * @brief Finalise the pipeline
    * Record all data products and meta data to the registry
@@ -62,11 +132,24 @@ namespace FairDataPipeline {
    */
             void finalise();
 
+  /**
+   * @brief Get the progress of finalise
+   * May be called from any thread while finalise runs on another
+   * 
+   * @return FinaliseProgress 
+   */
+            FinaliseProgress get_finalise_progress() const;
+
         private:
+            friend class PipelineContext;
+
             explicit DataPipeline(
                     const std::string &config_file_path,
                     const std::string &script_file_path,
-                    std::string token = ""
+                    std::string token = "",
+                    int session_rank = 0,
+                    int session_size = 1,
+                    const std::string &session_id = ""
                     );
 
             DataPipeline(const DataPipeline &rhs) = delete;
@@ -75,7 +158,68 @@ namespace FairDataPipeline {
 
             class impl;
 
+            explicit DataPipeline(std::shared_ptr< DataPipeline::impl > pimpl);
+
             std::shared_ptr< DataPipeline::impl > pimpl_;
     };
+
+/**
+ * @brief PipelineContext Class:
+ * Shared infrastructure for creating many DataPipeline sessions in one process
+ * 
+ * The config is parsed and the user, author, config, script and code
+ * repository objects are registered once when the context is constructed.
+ * Each session created from it has its own code run but shares the parsed
+ * config, registry connection and those objects, so creating a session
+ * makes no registry calls. A session's code run is registered when it is
+ * finalised. Batched links and hashing in every session run on one pool of
+ * worker threads owned by the context. Sessions may be created from any
+ * number of threads.
+ */
+    class PipelineContext {
+
+        public:
+            typedef std::shared_ptr< PipelineContext > sptr;
+
+  /**
+   * @brief Construct a new Pipeline Context
+   * 
+   * @param config_file_path 
+   * @param script_file_path 
+   * @param token 
+   */
+            static sptr construct(
+                    const std::string &config_file_path,
+                    const std::string &script_file_path,
+                    std::string token = "" );
+
+  /**
+   * @brief Destroy the Pipeline Context object
+   * 
+   */
+            ~PipelineContext();
+
+  /**
+   * @brief Create a new session with its own code run
+   * 
+   * @return DataPipeline::sptr 
+   */
+            DataPipeline::sptr create_session() const;
+
+        private:
+            explicit PipelineContext(
+                    const std::string &config_file_path,
+                    const std::string &script_file_path,
+                    std::string token
+                    );
+
+            PipelineContext(const PipelineContext &rhs) = delete;
+
+            PipelineContext &operator=(const PipelineContext &rhs) = delete;
+
+            class impl;
+
+            std::shared_ptr< PipelineContext::impl > pimpl_;
+    };
 }; // namespace FairDataPipeline
 #endif
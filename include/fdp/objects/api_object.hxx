@@ -25,6 +25,13 @@ namespace FairDataPipeline {
 
             static sptr from_json( const Json::Value& j );
 
+            /**
+             * @brief Get the underlying json representation of the object
+             * 
+             * @return const Json::Value& 
+             */
+            const Json::Value& to_json() const { return obj_; }
+
             //static copy( const ApiObject& src );
 
             /**
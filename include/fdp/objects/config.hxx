@@ -15,8 +15,12 @@
 #include <string>
 #include <ghc/filesystem.hpp>
 #include <yaml-cpp/yaml.h>
+#include <atomic>
+#include <exception>
 #include <map>
+#include <mutex>
 #include <regex>
+#include <vector>
 #include <ghc/filesystem.hpp>
 #include <stdio.h>
 
@@ -24,11 +28,21 @@
 #include "fdp/registry/api.hxx"
 #include "fdp/objects/api_object.hxx"
 #include "fdp/objects/io_object.hxx"
+#include "fdp/objects/product_table.hxx"
+#include "fdp/utilities/data_store.hxx"
+#include "fdp/utilities/journal.hxx"
+#include "fdp/utilities/parallel.hxx"
+#include "fdp/utilities/path_allocator.hxx"
+#include "fdp/utilities/sharded_map.hxx"
+#include "fdp/utilities/shared_session.hxx"
 
 namespace FairDataPipeline {
     /**
      * @brief class for interacting with confifurations
      * 
+     * link_read and link_write may be called concurrently from any number
+     * of threads. finalise must only be called once all link calls have
+     * returned.
      */
     class Config {
         public:
@@ -36,6 +50,16 @@ namespace FairDataPipeline {
 
             typedef std::map< std::string, IOObject > map_type;
 
+            /**
+             * @brief Progress of a call to finalise
+             */
+            struct FinaliseProgress {
+                std::size_t outputs_total = 0;      /*!< Outputs to register */
+                std::size_t outputs_hashed = 0;     /*!< Outputs hashed and stored */
+                std::size_t outputs_registered = 0; /*!< Outputs registered */
+                std::size_t registry_calls = 0;     /*!< Registry requests made */
+            };
+
         private:            
             const ghc::filesystem::path config_file_path_;
             const ghc::filesystem::path config_dir_;
@@ -62,13 +86,45 @@ namespace FairDataPipeline {
             ApiObject::sptr code_repo_storage_location_;
             ApiObject::sptr code_repo_obj_;
 
-            ApiObject::sptr code_run_;
+            // Sessions created from a template register their code run on
+            // first use, so creating them needs no registry calls
+            mutable ApiObject::sptr code_run_;
+            mutable std::mutex code_run_mutex_;
+            std::string run_date_;
+            bool is_template_ = false;
+
+            DataStore::sptr data_store_;
+
+            // Created by a template and shared with its sessions, which
+            // run link batches and hashing on it; null for a standalone
+            // session
+            ThreadPool::sptr pool_;
+
+            // Not copied, every session names its own files
+            PathAllocator path_allocator_;
+
+            Journal::sptr journal_;
+            int session_rank_ = 0;
+            int session_size_ = 1;
+            std::string session_id_;
+            SharedSession::sptr shared_session_;
+
+            ShardedMap< Json::Value > journal_stored_;
+            ShardedMap< Json::Value > journal_outputs_;
             
-            map_type writes_;
-            map_type reads_;
+            // Updated by finalise and read from any thread
+            std::atomic<std::size_t> progress_outputs_total_{0};
+            std::atomic<std::size_t> progress_outputs_hashed_{0};
+            std::atomic<std::size_t> progress_outputs_registered_{0};
+            std::atomic<std::size_t> progress_registry_calls_{0};
+
+            // Outputs and inputs are the writes and reads with registry objects
+            ProductTable writes_;
+            ProductTable reads_;
 
-            map_type outputs_;
-            map_type inputs_;
+            // yaml-cpp nodes share state between copies, so all access to
+            // the parsed config from link calls is serialised
+            mutable std::mutex config_mutex_;
 
             RESTAPI rest_api_location_ = RESTAPI::LOCAL;
 
@@ -76,7 +132,114 @@ namespace FairDataPipeline {
             bool config_has_reads() const;
             
             void initialise(RESTAPI api_location);
+
+            /**
+             * @brief Post the code run for this session to the registry
+             * 
+             */
+            void register_code_run() const;
             void validate_config(ghc::filesystem::path yaml_path, RESTAPI api_location);
+
+            /**
+             * @brief Hash a data product using the algorithm selected by
+             * run_metadata hash_algorithm ("sha1" by default, or
+             * "sha256-tree" for a parallel chunked hash)
+             * 
+             * @param file_path 
+             * @return std::string 
+             */
+            std::string hash_data_product(const ghc::filesystem::path &file_path) const;
+
+            /**
+             * @brief Move a hashed pending write into the data store and
+             * register its storage location
+             *
+             * A write which is no longer at its path but is already in the
+             * data store, moved there by an interrupted session, is only
+             * registered.
+             * 
+             * @param write 
+             * @param hash the hash of the write from hash_data_product
+             * @return ApiObject::sptr the storage location object
+             */
+            ApiObject::sptr store_data_product(const IOObject &write,
+                                               const std::string &hash);
+
+            /**
+             * @brief Open the session journal if run_metadata journal is set
+             * 
+             * @return true an earlier incomplete session was restored
+             * @return false a new session should be registered
+             */
+            bool open_journal();
+
+            /**
+             * @brief Record the session objects created by initialise
+             * 
+             */
+            void journal_initialise();
+
+            /**
+             * @brief Get the session objects created by initialise, keyed
+             * by their name in the journal
+             * 
+             * @return std::vector< std::pair< std::string, ApiObject::sptr* > > 
+             */
+            std::vector< std::pair< std::string, ApiObject::sptr* > > session_objects_();
+
+            /**
+             * @brief Serialise the session objects created by initialise
+             * 
+             * @return Json::Value 
+             */
+            Json::Value session_to_json_();
+
+            /**
+             * @brief Restore the session objects from their serialised form
+             * 
+             * @param session 
+             */
+            void session_from_json_(const Json::Value &session);
+
+            /**
+             * @brief Get the key identifying runs of the same config and script
+             * 
+             * @return std::string 
+             */
+            std::string default_session_key_() const;
+
+            /**
+             * @brief Join a shared session if one was requested through the
+             * constructor, the environment or run_metadata shared_session
+             * 
+             */
+            void open_shared_session();
+
+            /**
+             * @brief Leader: wait for all workers and add their link calls
+             * to this session
+             * 
+             */
+            void merge_worker_records();
+
+            /**
+             * @brief Apply link to each distinct product concurrently, on
+             * up to run_metadata link_threads threads
+             * 
+             * @param data_products products to link, a product named more
+             * than once is linked once and its result repeated
+             * @param errors set to one entry per product, null where the
+             * link succeeded and holding the exception where it threw
+             * @param link link_read or link_write
+             * @return std::vector<ghc::filesystem::path> the path for each
+             * product, in the order of data_products, empty where the link
+             * failed
+             */
+            std::vector<ghc::filesystem::path> link_many_(
+                    const std::vector<std::string> &data_products,
+                    std::vector<std::exception_ptr> &errors,
+                    ghc::filesystem::path (Config::*link)(const std::string &));
+
             /**
              * @brief Construct a new Config object
              * 
@@ -84,20 +247,69 @@ namespace FairDataPipeline {
              * @param script_file_path the path to the script file
              * @param token the API token as a String
              * @param api_location whether or not the api is local
+             * @param session_rank rank of this process in a shared session
+             * @param session_size number of processes in a shared session,
+             * 1 unless the session is shared
+             * @param session_id identifier of the shared session
+             * @param is_template only resolve the registry objects shared by
+             * sessions, without registering a code run
              */
             Config(const ghc::filesystem::path &config_file_path,
                     const ghc::filesystem::path &script_file_path,
                     const std::string &token,
-                    RESTAPI api_location);
+                    RESTAPI api_location,
+                    int session_rank = 0,
+                    int session_size = 1,
+                    const std::string &session_id = "",
+                    bool is_template = false);
+
+            /**
+             * @brief Construct a new session sharing the parsed config, API
+             * connection and registry objects of a prototype
+             * 
+             * @param prototype 
+             */
+            explicit Config(const Config &prototype);
 
 
         public:
 
             static Config::sptr construct(const ghc::filesystem::path &config_file_path,
+                    const ghc::filesystem::path &script_file_path,
+                    const std::string &token,
+                    RESTAPI api_location,
+                    int session_rank = 0,
+                    int session_size = 1,
+                    const std::string &session_id = "");
+
+            /**
+             * @brief Construct a template from which many sessions sharing
+             * the same config and script can be created
+             * 
+             * Registers the user, author, config, script and code repository
+             * objects once but no code run.
+             * 
+             * @param config_file_path the path to the config file
+             * @param script_file_path the path to the script file
+             * @param token the API token as a String
+             * @param api_location whether or not the api is local
+             * @return Config::sptr 
+             */
+            static Config::sptr construct_template(const ghc::filesystem::path &config_file_path,
                     const ghc::filesystem::path &script_file_path,
                     const std::string &token,
                     RESTAPI api_location);
 
+            /**
+             * @brief Create a new session with its own code run
+             * 
+             * No registry calls are made until the session's code run uuid
+             * is requested or the session is finalised.
+             * 
+             * @return Config::sptr 
+             */
+            Config::sptr create_session() const;
+
 
             /**
              * @brief Destroy the Config object
@@ -111,6 +323,7 @@ namespace FairDataPipeline {
              * @return YAML::Node 
              */
             YAML::Node meta_data_() const;
+
             /**
              * @brief Returns the writes Yaml Node from the config
              * 
@@ -239,6 +452,35 @@ namespace FairDataPipeline {
              */
             ghc::filesystem::path link_read(const std::string& data_product);
 
+            /**
+             * @brief Return the filepaths of many data products in one call
+             * 
+             * Products are looked up concurrently using up to the
+             * run_metadata `link_threads` threads (default: all hardware
+             * threads). A product named more than once is read once.
+             * 
+             * @param data_products 
+             * @param errors set per product, null where the read succeeded
+             * @return std::vector<ghc::filesystem::path> empty where the read failed
+             */
+            std::vector<ghc::filesystem::path> link_read_many(
+                    const std::vector<std::string> &data_products,
+                    std::vector<std::exception_ptr> &errors);
+
+            /**
+             * @brief Provide file paths for many data products in one call
+             * 
+             * As link_read_many, a product named more than once receives
+             * one path.
+             * 
+             * @param data_products 
+             * @param errors set per product, null where the write succeeded
+             * @return std::vector<ghc::filesystem::path> empty where the write failed
+             */
+            std::vector<ghc::filesystem::path> link_write_many(
+                    const std::vector<std::string> &data_products,
+                    std::vector<std::exception_ptr> &errors);
+
             /**
              * @brief Finalise the pipeline
              * Write any pending metadata to the registry
@@ -247,6 +489,14 @@ namespace FairDataPipeline {
              */
             void finalise();
 
+            /**
+             * @brief Get the progress of finalise, may be called from any
+             * thread while finalise runs
+             * 
+             * @return FinaliseProgress 
+             */
+            FinaliseProgress get_finalise_progress() const;
+
             /**
              * @brief Read a given yaml file into a Yaml Node
              * 
@@ -269,6 +519,22 @@ namespace FairDataPipeline {
              */
              API::sptr get_api() const {return api_;}
 
+            /**
+             * @brief Get the session journal, null unless run_metadata
+             * journal is enabled
+             * 
+             * @return Journal::sptr 
+             */
+            Journal::sptr get_journal() const {return journal_;}
+
+            /**
+             * @brief Get the shared session, null unless the code run is
+             * shared between processes
+             * 
+             * @return SharedSession::sptr 
+             */
+            SharedSession::sptr get_shared_session() const {return shared_session_;}
+
             /**
              * @brief Get the rest api location (local / remote)
              * 
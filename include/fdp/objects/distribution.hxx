@@ -1,10 +1,15 @@
 #ifndef __FDP_DISTRIBUTION_HXX__
 #define __FDP_DISTRIBUTION_HXX__
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <vector>
 #include <ghc/filesystem.hpp>
 
 namespace FairDataPipeline {
+    class TomlWriter;
+
     /**
      * @brief Class for API objects
      * 
@@ -33,6 +38,84 @@ namespace FairDataPipeline {
             std::string write_to_toml(std::string &file_name);
             std::string write_to_toml(std::string &component, std::string &file_name);
 
+            /**
+             * @brief Buffer the distribution in a writer session
+             * Use one TomlWriter to write many distributions in one write
+             * 
+             * @param writer 
+             */
+            void write_to_toml(TomlWriter &writer) const;
+
+            /**
+             * @brief Read many distributions, parsing the file once
+             * 
+             * @param file_name 
+             * @param components 
+             * @return std::vector<Distribution> one per component
+             */
+            static std::vector<Distribution> read_many_from_toml(
+                    const std::string &file_name,
+                    const std::vector<std::string> &components);
+
+            /**
+             * @brief Write many distributions under their own components,
+             * writing the file once
+             * 
+             * @param distributions 
+             * @param file_name 
+             * @return std::string 
+             */
+            static std::string write_many_to_toml(
+                    const std::vector<Distribution> &distributions,
+                    const std::string &file_name);
+
+            /**
+             * @brief Draw samples first, ..., first + n - 1 of a stream
+             * Draws depend only on seed and index, so they are the same for
+             * any thread count or batch split
+             * 
+             * @param out buffer of n doubles
+             * @param n 
+             * @param seed identifies the stream
+             * @param first index of the first draw
+             * @param n_threads number of threads, 0 for all hardware threads
+             * @throws validation_error if the family or parameters are not
+             * supported, see sampling::Family
+             */
+            void sample(double *out, std::size_t n, std::uint64_t seed,
+                    std::uint64_t first = 0, unsigned int n_threads = 1) const;
+
+            /**
+             * @brief Draw the first n samples of a stream
+             * 
+             * @param n 
+             * @param seed 
+             * @return std::vector<double> 
+             */
+            std::vector<double> sample(std::size_t n, std::uint64_t seed) const;
+
+            /**
+             * @brief Evaluate the log density at n points
+             * 
+             * @param x n points
+             * @param out n results
+             * @param n 
+             * @param n_threads 
+             */
+            void log_pdf(const double *x, double *out, std::size_t n,
+                    unsigned int n_threads = 1) const;
+
+            /**
+             * @brief Evaluate the cumulative distribution function at n points
+             * 
+             * @param x n points
+             * @param out n results
+             * @param n 
+             * @param n_threads 
+             */
+            void cdf(const double *x, double *out, std::size_t n,
+                    unsigned int n_threads = 1) const;
+
         private:
             std::string _name;
             double _mu;
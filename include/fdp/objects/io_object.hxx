@@ -24,6 +24,7 @@ namespace FairDataPipeline {
             std::string data_product_description_ = "None";
             std::string component_description_ = "None";
             bool public_ = false;
+            bool directory_ = false;
 
             ApiObject::sptr component_obj_;
             ApiObject::sptr data_product_obj_;
@@ -45,6 +46,7 @@ namespace FairDataPipeline {
              * @param path file path to data_product
              * @param data_product_description data product description
              * @param isPublic whether or not the data product should be public
+             * @param isDirectory whether the data product is a directory of files
              */
             IOObject (const std::string& data_product,
                     const std::string& use_data_product,
@@ -52,7 +54,8 @@ namespace FairDataPipeline {
                     const std::string& use_namespace,
                     ghc::filesystem::path path,
                     const std::string& data_product_description,
-                    bool isPublic)
+                    bool isPublic,
+                    bool isDirectory = false)
                 :
                     data_product_(data_product),
                     use_data_product_(use_data_product),
@@ -60,7 +63,8 @@ namespace FairDataPipeline {
                     use_namespace_(use_namespace),
                     path_(path),
                     data_product_description_(data_product_description),
-                    public_(isPublic){};
+                    public_(isPublic),
+                    directory_(isDirectory){};
 
             /**
              * @brief Construct a new IOObject object
@@ -154,6 +158,14 @@ namespace FairDataPipeline {
              */
             bool is_public() const {return public_;}
 
+            /**
+             * @brief Check whether the data product is a directory of files
+             * 
+             * @return true the data product path is a directory
+             * @return false the data product path is a single file
+             */
+            bool is_directory() const {return directory_;}
+
             /**
              * @brief Get the component object object
              * 
@@ -19,8 +19,12 @@
 #include <random>
 #include <chrono>
 #include <regex>
+#include <string>
+#include <functional>
 
 #include "digestpp/digestpp.hpp"
+#include "fdp/utilities/hashing.hxx"
+#include "fdp/utilities/parallel.hxx"
 
 #ifdef _WIN32
    #include <io.h> 
@@ -33,24 +37,58 @@ namespace FairDataPipeline {
 /*! **************************************************************************
  * @brief calculates a hash from a given input file via SHA1
  *
+ * Digests are served from the process wide HashCache when the file's
+ * (device, inode, size, mtime) are unchanged since it was last hashed.
+ *
  * @return the hash obtained from the file contents
  ****************************************************************************/
 std::string calculate_hash_from_file(const ghc::filesystem::path &);
 
 /*! **************************************************************************
- * @brief calculates a hash from a given string via SHA1
+ * @brief calculates a chunked SHA-256 tree hash of a given input file
+ *
+ * The file is split into fixed size chunks which are hashed in parallel.
+ * The root digest is the SHA-256 of the chunk size, file size and the
+ * ordered chunk digests, so the result does not depend on the number of
+ * threads used. Digests are cached in the HashCache under the algorithm
+ * name "sha256-tree-<chunk_size>".
  *
- * @param input string to be hashed
- * @return the hash obtained from the string contents
+ * @param file_path the file to hash
+ * @param n_threads number of worker threads, 0 to use all hardware threads
+ * @param chunk_size size of each leaf chunk in bytes
+ * @param pool if given, workers are taken from the pool
+ * @return the root hash of the file contents
  ****************************************************************************/
-std::string calculate_hash_from_string(const std::string &input);
+std::string calculate_tree_hash_from_file(const ghc::filesystem::path &file_path,
+                                          unsigned int n_threads = 0,
+                                          std::size_t chunk_size = 4194304,
+                                          ThreadPool *pool = nullptr);
+
+/*! **************************************************************************
+ * @brief calculates a Merkle root for a directory of files
+ *
+ * The directory is walked recursively and every regular file is hashed
+ * concurrently. The root is the digest of the sorted list of
+ * (relative path, file hash) pairs, so it is deterministic and changes if
+ * any file is added, removed, renamed or modified. The root uses the same
+ * digest as the leaves: SHA1 for "sha1" and SHA-256 for "sha256-tree",
+ * whose roots are also tagged with the algorithm name.
+ *
+ * @param dir_path the directory to hash
+ * @param n_threads number of worker threads, 0 to use all hardware threads
+ * @param file_hasher function used to hash each file, defaults to
+ * calculate_hash_from_file or calculate_tree_hash_from_file to match
+ * algorithm
+ * @param algorithm the leaf algorithm, "sha1" or "sha256-tree"
+ * @param pool if given, workers are taken from the pool
+ * @return the root hash of the directory contents
+ ****************************************************************************/
+std::string calculate_directory_hash(
+    const ghc::filesystem::path &dir_path, unsigned int n_threads = 0,
+    const std::function<std::string(const ghc::filesystem::path &)>
+        &file_hasher = nullptr,
+    const std::string &algorithm = "sha1", ThreadPool *pool = nullptr);
 
-/**
- * @brief Generate a random hash
- * 
- * @return std::string a random hash
- */
-std::string generate_random_hash();
 
 /*! *************************************************************************
  * @brief returns the current time as a timestamp
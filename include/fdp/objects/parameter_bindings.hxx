@@ -0,0 +1,307 @@
+/*! **************************************************************************
+ * @file FairDataPipeline/objects/parameter_bindings.hxx
+ * @date 2026-10-19
+ * @brief File containing compile-time bindings of parameter components to
+ * the members of a model's struct
+ *
+ * A model declares its parameters once as a plain struct plus a schema
+ * naming the component behind each member:
+ *
+ *     struct SeirParameters {
+ *       double r0;
+ *       int n_age_groups;
+ *       FairDataPipeline::Distribution incubation{"gamma", 5.2, 2.8};
+ *     };
+ *     FDP_PARAMETER_SCHEMA(SeirParameters,
+ *                          FDP_PARAMETER(r0, "R0"),
+ *                          FDP_PARAMETER(n_age_groups, "age_groups"),
+ *                          FDP_PARAMETER(incubation, "incubation"))
+ *
+ * Member types, and the validity and uniqueness of component names, are
+ * checked when the schema is compiled. bind_parameters then fills the
+ * struct from a file in one pass, and model code reads plain members.
+ ****************************************************************************/
+#ifndef __FDP_PARAMETER_BINDINGS_HXX__
+#define __FDP_PARAMETER_BINDINGS_HXX__
+
+#include <cmath>
+#include <cstddef>
+#include <ghc/filesystem.hpp>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "fdp/exceptions.hxx"
+#include "fdp/objects/distribution.hxx"
+#include "fdp/objects/parameter_set.hxx"
+#include "fdp/objects/parameter_store.hxx"
+
+namespace FairDataPipeline {
+/**
+ * @brief Whether a member type can be bound to a component
+ * Floating point and integer members bind to point estimates, Distribution
+ * members to distributions
+ */
+template <typename Field>
+struct is_bindable_parameter
+    : std::integral_constant<
+          bool, std::is_floating_point<Field>::value ||
+                    (std::is_integral<Field>::value &&
+                     !std::is_same<Field, bool>::value) ||
+                    std::is_same<Field, Distribution>::value> {};
+
+/**
+ * @brief Binding of one component to a member of Struct
+ */
+template <typename Struct, typename Field> struct ParameterBinding {
+  constexpr ParameterBinding(const char *component, Field Struct::*member)
+      : component(component), member(member) {}
+
+  const char *component;
+  Field Struct::*member;
+};
+
+/**
+ * @brief Compile-time list of bindings
+ */
+template <typename... Bindings> struct ParameterBindings;
+
+template <> struct ParameterBindings<> {
+  static constexpr std::size_t size = 0;
+  constexpr ParameterBindings() {}
+};
+
+template <typename Head, typename... Tail>
+struct ParameterBindings<Head, Tail...> {
+  static constexpr std::size_t size = 1 + sizeof...(Tail);
+  constexpr ParameterBindings(Head head, Tail... tail)
+      : head(head), tail(tail...) {}
+
+  Head head;
+  ParameterBindings<Tail...> tail;
+};
+
+/**
+ * @brief Bind a component to a member
+ *
+ * @param member
+ * @param component
+ * @return ParameterBinding<Struct, Field>
+ */
+template <typename Struct, typename Field>
+constexpr ParameterBinding<Struct, Field>
+bind_parameter(Field Struct::*member, const char *component) {
+  static_assert(is_bindable_parameter<Field>::value,
+                "Parameter members must be floating point, integer or "
+                "Distribution");
+  return ParameterBinding<Struct, Field>(component, member);
+}
+
+template <typename... Bindings>
+constexpr ParameterBindings<Bindings...>
+make_parameter_bindings(Bindings... bindings) {
+  return ParameterBindings<Bindings...>(bindings...);
+}
+
+/**
+ * @brief Schema of a parameter struct, specialised by FDP_PARAMETER_SCHEMA
+ *
+ * A specialisation provides a constexpr static bindings() returning a
+ * ParameterBindings whose members all belong to Struct.
+ */
+template <typename Struct> struct ParameterSchema;
+
+namespace detail {
+constexpr bool names_equal_(const char *lhs, const char *rhs) {
+  return *lhs == *rhs && (*lhs == '\0' || names_equal_(lhs + 1, rhs + 1));
+}
+
+constexpr bool name_characters_valid_(const char *name) {
+  return *name == '\0' ||
+         (static_cast<unsigned char>(*name) >= 0x20 && *name != 0x7f &&
+          *name != '"' && *name != '\\' && name_characters_valid_(name + 1));
+}
+
+/**
+ * @brief A component name is non-empty with no control characters, quotes
+ * or backslashes
+ */
+constexpr bool valid_component_name_(const char *name) {
+  return name != nullptr && *name != '\0' && name_characters_valid_(name);
+}
+
+constexpr bool valid_component_names_(const ParameterBindings<> &) {
+  return true;
+}
+
+template <typename Head, typename... Tail>
+constexpr bool
+valid_component_names_(const ParameterBindings<Head, Tail...> &bindings) {
+  return valid_component_name_(bindings.head.component) &&
+         valid_component_names_(bindings.tail);
+}
+
+constexpr bool contains_component_(const ParameterBindings<> &,
+                                   const char *) {
+  return false;
+}
+
+template <typename Head, typename... Tail>
+constexpr bool
+contains_component_(const ParameterBindings<Head, Tail...> &bindings,
+                    const char *component) {
+  return names_equal_(bindings.head.component, component) ||
+         contains_component_(bindings.tail, component);
+}
+
+constexpr bool unique_components_(const ParameterBindings<> &) {
+  return true;
+}
+
+template <typename Head, typename... Tail>
+constexpr bool
+unique_components_(const ParameterBindings<Head, Tail...> &bindings) {
+  return !contains_component_(bindings.tail, bindings.head.component) &&
+         unique_components_(bindings.tail);
+}
+
+template <typename Source>
+void read_bound_(const Source &source, const char *component, double &field) {
+  field = source.point_estimate(component);
+}
+
+template <typename Source>
+void read_bound_(const Source &source, const char *component,
+                 Distribution &field) {
+  field = source.distribution(component);
+}
+
+template <typename Source, typename Field>
+void read_bound_(const Source &source, const char *component, Field &field) {
+  const double value_ = source.point_estimate(component);
+  // max() may round up to 2^digits as a double, so compare against that
+  // power of two exactly
+  if (std::is_integral<Field>::value &&
+      (value_ != std::trunc(value_) ||
+       value_ < static_cast<double>(std::numeric_limits<Field>::lowest()) ||
+       value_ >= std::ldexp(1.0, std::numeric_limits<Field>::digits))) {
+    throw validation_error("Point estimate " + std::string(component) +
+                           " cannot be bound to an integer member");
+  }
+  field = static_cast<Field>(value_);
+}
+
+template <typename Source, typename Struct>
+void bind_all_(const Source &, Struct &, const ParameterBindings<> &) {}
+
+template <typename Source, typename Struct, typename Head, typename... Tail>
+void bind_all_(const Source &source, Struct &parameters,
+               const ParameterBindings<Head, Tail...> &bindings) {
+  read_bound_(source, bindings.head.component,
+              parameters.*(bindings.head.member));
+  bind_all_(source, parameters, bindings.tail);
+}
+
+inline void append_components_(std::vector<std::string> &,
+                               const ParameterBindings<> &) {}
+
+template <typename Head, typename... Tail>
+void append_components_(std::vector<std::string> &components,
+                        const ParameterBindings<Head, Tail...> &bindings) {
+  components.push_back(bindings.head.component);
+  append_components_(components, bindings.tail);
+}
+} // namespace detail
+
+/**
+ * @brief Fill every bound member of a struct from a loaded parameter file
+ *
+ * @param source ParameterSet or ParameterStore
+ * @param parameters struct with a ParameterSchema
+ * @throws toml_error or parameter_store_error if a component is missing or
+ * has another type
+ * @throws validation_error if an integer member gets a non-integer value
+ */
+template <typename Struct, typename Source>
+void bind_parameters(const Source &source, Struct &parameters) {
+  detail::bind_all_(source, parameters, ParameterSchema<Struct>::bindings());
+}
+
+/**
+ * @brief Load a parameter file once and fill a struct from it
+ * Files with the parameter store file type are mapped, others are read as
+ * TOML
+ *
+ * @param file_path
+ * @param parameters
+ */
+template <typename Struct>
+void bind_parameters(const ghc::filesystem::path &file_path,
+                     Struct &parameters) {
+  if (file_path.extension().string() ==
+      std::string(".") + ParameterStore::file_type) {
+    bind_parameters(*ParameterStore::open(file_path), parameters);
+  } else {
+    bind_parameters(*ParameterSet::load(file_path), parameters);
+  }
+}
+
+/**
+ * @brief Load a default constructible parameter struct from a file
+ *
+ * @param file_path
+ * @return Struct
+ */
+template <typename Struct>
+Struct load_parameters(const ghc::filesystem::path &file_path) {
+  Struct parameters_;
+  bind_parameters(file_path, parameters_);
+  return parameters_;
+}
+
+/**
+ * @brief Get the component names of a schema, in declaration order
+ *
+ * @return std::vector<std::string>
+ */
+template <typename Struct> std::vector<std::string> parameter_components() {
+  std::vector<std::string> components_;
+  detail::append_components_(components_,
+                             ParameterSchema<Struct>::bindings());
+  return components_;
+}
+
+}; // namespace FairDataPipeline
+
+/**
+ * @brief Bind member of the schema's struct to a component name literal
+ */
+#define FDP_PARAMETER(member, component)                                       \
+  ::FairDataPipeline::bind_parameter(&fdp_struct_type::member, component)
+
+/**
+ * @brief Declare the parameter schema of a struct
+ * Use at global scope with the fully qualified struct name, followed by one
+ * FDP_PARAMETER per bound member
+ */
+#define FDP_PARAMETER_SCHEMA(Struct, ...)                                      \
+  namespace FairDataPipeline {                                                 \
+  template <> struct ParameterSchema<Struct> {                                 \
+    typedef Struct fdp_struct_type;                                            \
+    static constexpr auto bindings()                                           \
+        -> decltype(::FairDataPipeline::make_parameter_bindings(__VA_ARGS__)) { \
+      return ::FairDataPipeline::make_parameter_bindings(__VA_ARGS__);         \
+    }                                                                          \
+  };                                                                           \
+  static_assert(detail::valid_component_names_(                                \
+                    ParameterSchema<Struct>::bindings()),                      \
+                "Parameter schema of " #Struct                                 \
+                " has an empty or invalid component name");                    \
+  static_assert(detail::unique_components_(                                    \
+                    ParameterSchema<Struct>::bindings()),                      \
+                "Parameter schema of " #Struct                                 \
+                " binds a component more than once");                          \
+  }
+
+#endif
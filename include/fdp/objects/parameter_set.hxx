@@ -0,0 +1,159 @@
+/*! **************************************************************************
+ * @file FairDataPipeline/objects/parameter_set.hxx
+ * @date 2026-10-19
+ * @brief File containing a bulk loader for TOML parameter files
+ *
+ * Models reading every parameter of a file with one call per component
+ * paid for a lookup (and formerly a parse) per call. A ParameterSet parses
+ * the file once, types every component up front and serves lookups from a
+ * flat hash index whose keys point into the parsed document.
+ ****************************************************************************/
+#ifndef __FDP_PARAMETER_SET_HXX__
+#define __FDP_PARAMETER_SET_HXX__
+
+#include "toml.hpp"
+#include <cstddef>
+#include <ghc/filesystem.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "fdp/objects/distribution.hxx"
+#include "fdp/utilities/flat_index.hxx"
+#include "fdp/utilities/toml_document.hxx"
+
+namespace FairDataPipeline {
+/**
+ * @brief Every component of a TOML parameter file, typed
+ *
+ * Immutable once loaded, so a ParameterSet may be shared between threads.
+ */
+class ParameterSet {
+public:
+  typedef std::shared_ptr<const ParameterSet> sptr;
+
+  /**
+   * @brief Type of a component, from its `type` tag
+   */
+  enum class Type {
+    POINT_ESTIMATE, /*!< type = "point-estimate" */
+    DISTRIBUTION,   /*!< type = "distribution" */
+    OTHER           /*!< any other type, read through value() */
+  };
+
+  /**
+   * @brief Load all components of a file
+   *
+   * @param file_path
+   * @return ParameterSet::sptr
+   * @throws toml_error if the file cannot be read or a point estimate or
+   * distribution is malformed
+   */
+  static sptr load(const ghc::filesystem::path &file_path);
+
+  /**
+   * @brief Load several files in parallel
+   *
+   * @param file_paths
+   * @param n_threads number of threads, 0 for all hardware threads
+   * @return std::vector<ParameterSet::sptr> one set per file
+   * @throws the first error raised by any file
+   */
+  static std::vector<sptr>
+  load_many(const std::vector<ghc::filesystem::path> &file_paths,
+            unsigned int n_threads = 0);
+
+  const ghc::filesystem::path &get_path() const {
+    return document_->get_path();
+  }
+
+  std::size_t size() const { return entries_.size(); }
+  bool empty() const { return entries_.empty(); }
+
+  /**
+   * @brief Check a component was loaded
+   *
+   * @param component
+   * @return bool
+   */
+  bool contains(const std::string &component) const;
+
+  /**
+   * @brief Get the type of a component
+   *
+   * @param component
+   * @return Type
+   * @throws toml_error if the component does not exist
+   */
+  Type type(const std::string &component) const;
+
+  /**
+   * @brief Get a point estimate, integers are converted to double
+   *
+   * @param component
+   * @return double
+   * @throws toml_error if the component is missing or has another type
+   */
+  double point_estimate(const std::string &component) const;
+
+  /**
+   * @brief Get a distribution
+   *
+   * @param component
+   * @return Distribution
+   * @throws toml_error if the component is missing or has another type
+   */
+  Distribution distribution(const std::string &component) const;
+
+  /**
+   * @brief Get the table of any component
+   *
+   * @param component
+   * @return const toml::value&
+   * @throws toml_error if the component does not exist
+   */
+  const toml::value &value(const std::string &component) const;
+
+  /**
+   * @brief Get the names of all components, in no particular order
+   *
+   * @return std::vector<std::string>
+   */
+  std::vector<std::string> components() const;
+
+private:
+  explicit ParameterSet(TomlDocument::sptr document);
+
+  ParameterSet(const ParameterSet &rhs) = delete;
+  ParameterSet &operator=(const ParameterSet &rhs) = delete;
+
+  /**
+   * @brief One component, keys and tables are owned by document_
+   */
+  struct Entry {
+    const std::string *component;
+    const toml::value *table;
+    Type type;
+    double value; /*!< point estimate, or mu of a distribution */
+    double sigma;
+    std::string distribution;
+  };
+
+  const Entry &entry_(const std::string &component) const;
+
+  TomlDocument::sptr document_;
+  std::vector<Entry> entries_;
+  FlatIndex index_;
+};
+
+/**
+ * @brief Get the name of a parameter type
+ *
+ * @param type
+ * @return std::string
+ */
+std::string to_string(ParameterSet::Type type);
+
+}; // namespace FairDataPipeline
+
+#endif
@@ -0,0 +1,233 @@
+/*! **************************************************************************
+ * @file FairDataPipeline/objects/parameter_store.hxx
+ * @date 2026-10-19
+ * @brief File containing a binary, memory mapped parameter format
+ *
+ * TOML parameter files are parsed into a DOM on every read. A parameter
+ * store (file type `fdpp`) holds point estimates and distributions as
+ * fixed-layout records sorted by component name, followed by a pool of the
+ * name strings. Readers map the file and binary search the records, so a
+ * lookup neither parses nor allocates.
+ *
+ * Layout (little endian):
+ *   Header     magic "FDPPARM", byte order mark, version, record count,
+ *              offset and size of the string pool
+ *   Record[n]  sorted by component name
+ *   char[]     component and distribution names, not null terminated
+ ****************************************************************************/
+#ifndef __FDP_PARAMETER_STORE_HXX__
+#define __FDP_PARAMETER_STORE_HXX__
+
+#include <cstddef>
+#include <cstdint>
+#include <ghc/filesystem.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "fdp/objects/distribution.hxx"
+
+namespace FairDataPipeline {
+/**
+ * @brief Read-only view of a memory mapped parameter store
+ *
+ * Immutable once opened, so it may be shared between threads.
+ */
+class ParameterStore {
+public:
+  typedef std::shared_ptr<const ParameterStore> sptr;
+
+  /**
+   * @brief File type (extension) of parameter stores
+   */
+  static const char *const file_type;
+
+  /**
+   * @brief Record type
+   */
+  enum class Type : std::uint32_t { POINT_ESTIMATE = 1, DISTRIBUTION = 2 };
+
+  /**
+   * @brief Fixed-layout record, names are offsets into the string pool
+   */
+  struct Record {
+    std::uint32_t name_offset;
+    std::uint32_t name_size;
+    std::uint32_t type;
+    std::uint32_t distribution_offset;
+    std::uint32_t distribution_size;
+    std::uint32_t reserved;
+    double value; /*!< point estimate, or mu of a distribution */
+    double sigma;
+  };
+
+  /**
+   * @brief Map a parameter store
+   *
+   * @param file_path
+   * @return ParameterStore::sptr
+   * @throws parameter_store_error if the file is missing or not a store
+   */
+  static sptr open(const ghc::filesystem::path &file_path);
+
+  ~ParameterStore();
+
+  std::size_t size() const { return n_records_; }
+
+  /**
+   * @brief Find a record without allocating
+   *
+   * @param name component name, need not be null terminated
+   * @param name_size
+   * @return const Record* the record, or nullptr if not found
+   */
+  const Record *find(const char *name, std::size_t name_size) const;
+
+  bool contains(const std::string &component) const {
+    return find(component.data(), component.size()) != nullptr;
+  }
+
+  /**
+   * @brief Get a point estimate
+   *
+   * @param component
+   * @return double
+   * @throws parameter_store_error if missing or of another type
+   */
+  double point_estimate(const std::string &component) const;
+
+  /**
+   * @brief Get a distribution
+   *
+   * @param component
+   * @return Distribution
+   * @throws parameter_store_error if missing or of another type
+   */
+  Distribution distribution(const std::string &component) const;
+
+  /**
+   * @brief Get the name of a record's component
+   *
+   * @param record
+   * @return std::string
+   */
+  std::string component_name(const Record &record) const;
+
+  /**
+   * @brief Get the name of a record's distribution
+   *
+   * @param record
+   * @return std::string
+   */
+  std::string distribution_name(const Record &record) const;
+
+  const Record *begin() const { return records_; }
+  const Record *end() const { return records_ + n_records_; }
+
+  const ghc::filesystem::path &get_path() const { return file_path_; }
+
+private:
+  explicit ParameterStore(const ghc::filesystem::path &file_path);
+
+  ParameterStore(const ParameterStore &rhs) = delete;
+  ParameterStore &operator=(const ParameterStore &rhs) = delete;
+
+  void read_header_();
+  const Record &record_(const std::string &component, Type type) const;
+
+  ghc::filesystem::path file_path_;
+  const char *data_ = nullptr;
+  std::size_t size_ = 0;
+  bool mapped_ = false;
+  std::vector<char> buffer_;
+  const Record *records_ = nullptr;
+  std::size_t n_records_ = 0;
+  const char *strings_ = nullptr;
+  std::size_t strings_size_ = 0;
+};
+
+/**
+ * @brief Collects parameters and writes them as a parameter store
+ */
+class ParameterStoreWriter {
+public:
+  /**
+   * @brief Add a point estimate
+   *
+   * @param component
+   * @param value
+   */
+  void add_point_estimate(const std::string &component, double value);
+
+  /**
+   * @brief Add a distribution under its component
+   *
+   * @param distribution
+   */
+  void add_distribution(const Distribution &distribution);
+
+  std::size_t size() const { return entries_.size(); }
+
+  /**
+   * @brief Write the store, replacing any existing file
+   *
+   * The file is written under a temporary name and renamed into place.
+   *
+   * @param file_path
+   * @return ghc::filesystem::path
+   * @throws parameter_store_error if a component was added twice
+   */
+  ghc::filesystem::path write(const ghc::filesystem::path &file_path) const;
+
+private:
+  struct Entry {
+    std::string component;
+    ParameterStore::Type type;
+    std::string distribution;
+    double value;
+    double sigma;
+  };
+
+  std::vector<Entry> entries_;
+};
+
+/**
+ * @brief Add a point estimate to a parameter store
+ * The binary counterpart of write_point_estimate for TOML files
+ *
+ * @param value
+ * @param component
+ * @param writer
+ */
+inline void write_point_estimate(double value, const std::string &component,
+                                 ParameterStoreWriter &writer) {
+  writer.add_point_estimate(component, value);
+}
+
+/**
+ * @brief Convert a TOML parameter file to a parameter store
+ *
+ * @param toml_path
+ * @param store_path
+ * @return ghc::filesystem::path store_path
+ * @throws parameter_store_error if a component is neither a point estimate
+ * nor a distribution
+ */
+ghc::filesystem::path
+convert_toml_to_parameter_store(const ghc::filesystem::path &toml_path,
+                                const ghc::filesystem::path &store_path);
+
+/**
+ * @brief Convert a parameter store to a TOML parameter file
+ *
+ * @param store_path
+ * @param toml_path must not contain any of the store's components
+ * @return ghc::filesystem::path toml_path
+ */
+ghc::filesystem::path
+convert_parameter_store_to_toml(const ghc::filesystem::path &store_path,
+                                const ghc::filesystem::path &toml_path);
+
+}; // namespace FairDataPipeline
+
+#endif
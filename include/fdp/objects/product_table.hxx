@@ -0,0 +1,136 @@
+/*! **************************************************************************
+ * @file FairDataPipeline/objects/product_table.hxx
+ * @date 2026-10-19
+ * @brief File containing a compact table of the data products of a session
+ *
+ * A session may link hundreds of thousands of products. Rather than keeping
+ * an IOObject per product, each field is stored as a column of 32 bit ids
+ * into a string pool in which repeated values (namespaces, versions,
+ * descriptions) are stored once. Products are found through a flat
+ * open-addressed index, and an IOObject is only built when a product is
+ * read back.
+ ****************************************************************************/
+#ifndef __FDP_PRODUCT_TABLE_HXX__
+#define __FDP_PRODUCT_TABLE_HXX__
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <ghc/filesystem.hpp>
+#include <memory>
+#include <string>
+
+#include "fdp/objects/io_object.hxx"
+
+namespace FairDataPipeline {
+/**
+ * @brief Compact, thread safe table of data products keyed by name
+ *
+ * Products are spread over independently locked shards. Rows are never
+ * removed; linking a product again replaces its row in place.
+ */
+class ProductTable {
+public:
+  typedef std::function<void(const IOObject &)> visitor_type;
+
+  ProductTable();
+  ~ProductTable();
+
+  /**
+   * @brief Add a product, or replace the product with the same name
+   *
+   * Only the URIs of the component and data product objects are kept.
+   *
+   * @param product
+   */
+  void insert_or_assign(const IOObject &product);
+
+  /**
+   * @brief Build the IOObject for a product
+   *
+   * @param data_product name of the product
+   * @param product filled with the product if found
+   * @return true the product was found
+   * @return false the product is not in the table
+   */
+  bool find(const std::string &data_product, IOObject &product) const;
+
+  /**
+   * @brief Check whether a product is in the table
+   *
+   * @param data_product
+   * @return true
+   * @return false
+   */
+  bool contains(const std::string &data_product) const;
+
+  /**
+   * @brief Record the registry objects of a product once it is registered
+   *
+   * @param data_product name of the product
+   * @param component_uri URI of the object component
+   * @param data_product_uri URI of the data product
+   * @return true the product was found
+   * @return false the product is not in the table
+   */
+  bool set_registry_objects(const std::string &data_product,
+                            const std::string &component_uri,
+                            const std::string &data_product_uri);
+
+  /**
+   * @brief Visit every product
+   *
+   * No lock is held while the visitor runs, so it may modify the table.
+   * Products added during the call may or may not be visited.
+   *
+   * @param visitor
+   */
+  void for_each(const visitor_type &visitor) const;
+
+  /**
+   * @brief Get the number of products
+   *
+   * @return std::size_t
+   */
+  std::size_t size() const;
+
+  bool empty() const { return size() == 0; }
+
+  /**
+   * @brief Get the number of products with registry objects
+   *
+   * @return std::size_t
+   */
+  std::size_t count_registered() const;
+
+  /**
+   * @brief Get the heap memory reserved by the table in bytes
+   *
+   * @return std::size_t
+   */
+  std::size_t memory_usage() const;
+
+  /**
+   * @brief Get the mean number of index slots probed to find a product
+   *
+   * @return double 1 when no product is displaced from its home slot
+   */
+  double mean_probe_length() const;
+
+private:
+  ProductTable(const ProductTable &rhs) = delete;
+  ProductTable &operator=(const ProductTable &rhs) = delete;
+
+  class Shard;
+
+  static const unsigned int shard_bits_ = 4;
+  static const std::size_t n_shards_ = std::size_t(1) << shard_bits_;
+
+  Shard &shard_for_(const std::string &data_product) const;
+
+  std::array<std::unique_ptr<Shard>, n_shards_> shards_;
+};
+
+}; // namespace FairDataPipeline
+
+#endif
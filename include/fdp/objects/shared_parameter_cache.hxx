@@ -0,0 +1,164 @@
+/*! **************************************************************************
+ * @file FairDataPipeline/objects/shared_parameter_cache.hxx
+ * @date 2026-10-19
+ * @brief File containing a node-local cache of parameter files shared
+ * between processes
+ *
+ * When many replicas of a model run on one node, each parses the same
+ * TOML parameter files and keeps its own copy. With the cache enabled the
+ * first process to read a file converts it to a parameter store in a
+ * node-local directory (`/dev/shm` where available), named by the hash of
+ * the file. Every other process maps that store read-only, so the file is
+ * parsed once per node and its pages are shared.
+ ****************************************************************************/
+#ifndef __FDP_SHARED_PARAMETER_CACHE_HXX__
+#define __FDP_SHARED_PARAMETER_CACHE_HXX__
+
+#include <cstddef>
+#include <ghc/filesystem.hpp>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "fdp/objects/parameter_store.hxx"
+#include "fdp/utilities/hash_cache.hxx"
+
+namespace FairDataPipeline {
+/**
+ * @brief Cache of parameter stores in a directory shared by the processes
+ * of a node
+ *
+ * `<directory>/<hash>.fdpp` holds the store built from a file whose content
+ * hash is `<hash>`. A file whose contents change gets a new hash, and so a
+ * new store. The store for the old contents is kept, since other files may
+ * have the same contents, until it is removed by prune(). Files holding
+ * components other than point estimates and distributions are marked with
+ * `<hash>.none` and read as TOML. While a process builds a store it holds
+ * `<hash>.lock`, and other processes wait for the store rather than parse.
+ *
+ * The cache is opt-in: set `FDP_PARAMETER_CACHE` to `1` for the default
+ * directory or to a directory path, or call enable(). On POSIX systems the
+ * directory must be a real directory owned by the user with mode 0700,
+ * otherwise the cache is not used.
+ */
+class SharedParameterCache {
+public:
+  typedef std::shared_ptr<SharedParameterCache> sptr;
+
+  /**
+   * @brief Construct a cache
+   *
+   * @param directory node-local directory, created with mode 0700 if
+   * missing
+   * @param timeout_s seconds to wait for another process building a store
+   * before building it here
+   * @return SharedParameterCache::sptr
+   * @throws parameter_store_error if the directory is a symlink, is owned by
+   * another user or can be accessed by other users
+   */
+  static sptr construct(const ghc::filesystem::path &directory,
+                        double timeout_s = 60.0);
+
+  /**
+   * @brief Default directory, per user under `/dev/shm` on Linux and under
+   * the temporary directory elsewhere
+   *
+   * @return ghc::filesystem::path
+   */
+  static ghc::filesystem::path default_directory();
+
+  /**
+   * @brief Get the process wide cache used by the data_io readers
+   *
+   * @return SharedParameterCache::sptr nullptr unless the cache is enabled
+   */
+  static sptr get_cache();
+
+  /**
+   * @brief Open a file through the process wide cache, if enabled
+   * Errors are logged and reported as a miss, so callers can fall back to
+   * reading the file as TOML
+   *
+   * @param file_path
+   * @return ParameterStore::sptr nullptr if the cache is disabled or the
+   * file is not cached
+   */
+  static ParameterStore::sptr
+  open_shared(const ghc::filesystem::path &file_path);
+
+  /**
+   * @brief Enable the process wide cache
+   *
+   * @param directory
+   * @throws parameter_store_error if the directory fails the checks of
+   * construct()
+   */
+  static void enable(const ghc::filesystem::path &directory =
+                         default_directory());
+
+  /**
+   * @brief Disable the process wide cache, stores already opened stay valid
+   */
+  static void disable();
+
+  /**
+   * @brief Get the store for a parameter file, building it if this is the
+   * first process on the node to read the file
+   *
+   * @param file_path TOML parameter file
+   * @return ParameterStore::sptr nullptr if the file cannot be stored, in
+   * which case it should be read as TOML
+   */
+  ParameterStore::sptr open(const ghc::filesystem::path &file_path);
+
+  /**
+   * @brief Remove stores, markers and locks last modified more than
+   * max_age_s seconds ago
+   *
+   * Processes which already mapped a removed store keep their mapping on
+   * POSIX systems.
+   *
+   * @param max_age_s
+   * @return std::size_t number of files removed
+   */
+  std::size_t prune(double max_age_s);
+
+  /**
+   * @brief Remove every file of the cache, e.g. at the end of a job
+   *
+   * @return std::size_t number of files removed
+   */
+  std::size_t clear() { return prune(-1.0); }
+
+  const ghc::filesystem::path &get_directory() const { return directory_; }
+
+private:
+  SharedParameterCache(const ghc::filesystem::path &directory,
+                       double timeout_s);
+
+  SharedParameterCache(const SharedParameterCache &rhs) = delete;
+  SharedParameterCache &operator=(const SharedParameterCache &rhs) = delete;
+
+  /**
+   * @brief Store last opened for a file, valid while its key is unchanged
+   */
+  struct Entry {
+    HashCache::key_type key;
+    ParameterStore::sptr store;
+  };
+
+  ParameterStore::sptr attach_(const ghc::filesystem::path &file_path,
+                               const std::string &hash);
+  ParameterStore::sptr build_(const ghc::filesystem::path &file_path,
+                              const std::string &hash);
+
+  ghc::filesystem::path directory_;
+  double timeout_s_;
+  std::mutex mutex_; /*!< Guards entries_ only, not building stores */
+  std::map<std::string, Entry> entries_;
+};
+
+}; // namespace FairDataPipeline
+
+#endif
@@ -18,6 +18,7 @@
 #include <iterator>
 #include <json/reader.h>
 #include <map>
+#include <mutex>
 #include <regex>
 #include <string>
 #include <vector>
@@ -74,6 +75,12 @@ public:
    ***************************************************************************/
     static sptr construct( const std::string& url_root );
 
+  /**
+   * @brief Destroy the API object, closing any pooled connections
+   * 
+   */
+  ~API();
+
 
   /**
    * @brief sends the given 'packet' of information to the RestAPI
@@ -130,6 +137,15 @@ public:
    ***************************************************************************/
   std::string get_url_root() const { return url_root_; }
 
+  /**
+   * @brief Get the number of registry requests made by the calling thread
+   *
+   * Counts requests through every API instance, used to report progress.
+   *
+   * @return std::size_t
+   */
+  static std::size_t thread_request_count();
+
   /**
    * @brief Formats a json object into a string representation which can be used
    * as a url endpoint query
@@ -172,6 +188,15 @@ private:
       : url_root_(API::append_with_forward_slash(url_root)) {}
 
   std::string url_root_;
+
+  // Curl handles are reused so connections to the registry are kept alive
+  // between requests, including requests from different sessions
+  static const std::size_t max_idle_handles_ = 16;
+  std::vector<CURL *> idle_handles_;
+  std::mutex handles_mutex_;
+  CURL *acquire_handle_();
+  void release_handle_(CURL *curl);
+
   CURL *setup_json_session_(std::string &addr_path, std::string *response,
                             long &http_code, std::string token = "");
   CURL *setup_download_session_(const ghc::filesystem::path &addr_path,
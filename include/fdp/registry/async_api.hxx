@@ -0,0 +1,105 @@
+/*! **************************************************************************
+ * @file FairDataPipeline/registry/async_api.hxx
+ * @date 2026-10-19
+ * @brief File containing awaitable registry requests
+ *
+ * Coroutine counterparts of the API request methods, see fdp/async.hxx.
+ * Only available when the library is built with `FDPAPI_WITH_COROUTINES`.
+ ****************************************************************************/
+#ifndef __FDP_ASYNC_API_HXX__
+#define __FDP_ASYNC_API_HXX__
+
+#include <string>
+
+#include "fdp/async.hxx"
+#include "fdp/registry/api.hxx"
+
+namespace FairDataPipeline {
+namespace coro {
+
+/**
+ * @brief Await API::get_request
+ *
+ * @return BlockingCall<Json::Value> awaitable returning the response
+ */
+inline BlockingCall<Json::Value>
+async_get_request(Executor::sptr executor, API::sptr api,
+                  std::string addr_path, long expected_response = 200,
+                  std::string token = "") {
+  return BlockingCall<Json::Value>(
+      std::move(executor), [api, addr_path, expected_response, token]() {
+        return api->get_request(addr_path, expected_response, token);
+      });
+}
+
+/**
+ * @brief Await API::get_by_json_query
+ *
+ * @return BlockingCall<Json::Value> awaitable returning the response
+ */
+inline BlockingCall<Json::Value>
+async_get_by_json_query(Executor::sptr executor, API::sptr api,
+                        std::string addr_path, Json::Value query_data,
+                        long expected_response = 200, std::string token = "") {
+  return BlockingCall<Json::Value>(
+      std::move(executor),
+      [api, addr_path, query_data, expected_response, token]() mutable {
+        return api->get_by_json_query(addr_path, query_data,
+                                      expected_response, token);
+      });
+}
+
+/**
+ * @brief Await API::get_by_id
+ *
+ * @return BlockingCall<Json::Value> awaitable returning the response
+ */
+inline BlockingCall<Json::Value>
+async_get_by_id(Executor::sptr executor, API::sptr api, std::string table,
+                int id, long expected_response = 200, std::string token = "") {
+  return BlockingCall<Json::Value>(
+      std::move(executor), [api, table, id, expected_response, token]() {
+        return api->get_by_id(table, id, expected_response, token);
+      });
+}
+
+/**
+ * @brief Await API::post
+ *
+ * @return BlockingCall<Json::Value> awaitable returning the response
+ */
+inline BlockingCall<Json::Value> async_post(Executor::sptr executor,
+                                            API::sptr api,
+                                            std::string addr_path,
+                                            Json::Value post_data,
+                                            std::string token,
+                                            long expected_response = 201) {
+  return BlockingCall<Json::Value>(
+      std::move(executor),
+      [api, addr_path, post_data, token, expected_response]() mutable {
+        return api->post(addr_path, post_data, token, expected_response);
+      });
+}
+
+/**
+ * @brief Await API::patch
+ *
+ * @return BlockingCall<Json::Value> awaitable returning the response
+ */
+inline BlockingCall<Json::Value> async_patch(Executor::sptr executor,
+                                             API::sptr api,
+                                             std::string addr_path,
+                                             Json::Value post_data,
+                                             std::string token,
+                                             long expected_response = 200) {
+  return BlockingCall<Json::Value>(
+      std::move(executor),
+      [api, addr_path, post_data, token, expected_response]() mutable {
+        return api->patch(addr_path, post_data, token, expected_response);
+      });
+}
+
+} // namespace coro
+}; // namespace FairDataPipeline
+
+#endif
@@ -0,0 +1,296 @@
+/*! **************************************************************************
+ * @file FairDataPipeline/utilities/array_io.hxx
+ * @date 2026-10-19
+ * @brief File containing chunked, compressed N-dimensional array I/O
+ *
+ * Arrays are written to the path returned by link_write and read from the
+ * path returned by link_read. The array is split into chunks, and chunks
+ * are compressed and decompressed on several threads. Reads of a
+ * hyperslab only decompress the chunks it touches.
+ *
+ * Files with an `h5` or `hdf5` extension are HDF5 files, with each
+ * component stored in the dataset `<component>/array`, as in the other
+ * pipeline APIs. They need the library to be built with HDF5. Any other
+ * extension, conventionally `fdpa`, uses a native format holding a single
+ * array:
+ *
+ *   Header     magic "FDPARRY", byte order mark, version, element type,
+ *              codec, rank, component name size, chunk count
+ *   uint64[]   shape, then chunk shape
+ *   char[]     component name
+ *   bytes      chunks in row-major order of the chunk grid
+ *   Index[n]   offset, stored size and codec of each chunk
+ *   Footer     offset of the index, chunk count, magic
+ *
+ * The SHA-1 of the file is computed while it is written, and recorded in
+ * the hash cache, so registering the file at finalise does not read it
+ * again.
+ ****************************************************************************/
+#ifndef __FDP_ARRAY_IO_HXX__
+#define __FDP_ARRAY_IO_HXX__
+
+#include <cstddef>
+#include <cstdint>
+#include <ghc/filesystem.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "fdp/exceptions.hxx"
+
+namespace FairDataPipeline {
+/**
+ * @brief Element type of an array
+ */
+enum class ArrayType : std::uint32_t {
+  FLOAT32 = 1,
+  FLOAT64 = 2,
+  INT32 = 3,
+  INT64 = 4
+};
+
+/**
+ * @brief Chunk compression codec
+ */
+enum class ArrayCodec : std::uint32_t {
+  NONE = 0,
+  LZ4 = 1,    /*!< needs the library built with lz4 */
+  ZSTD = 2,   /*!< needs the library built with zstd */
+  DEFLATE = 3 /*!< needs the library built with zlib */
+};
+
+template <typename T> struct array_type_traits;
+
+template <> struct array_type_traits<float> {
+  static constexpr ArrayType value = ArrayType::FLOAT32;
+};
+template <> struct array_type_traits<double> {
+  static constexpr ArrayType value = ArrayType::FLOAT64;
+};
+template <> struct array_type_traits<std::int32_t> {
+  static constexpr ArrayType value = ArrayType::INT32;
+};
+template <> struct array_type_traits<std::int64_t> {
+  static constexpr ArrayType value = ArrayType::INT64;
+};
+
+/**
+ * @brief Size of an element in bytes
+ *
+ * @param type
+ * @return std::size_t
+ */
+std::size_t array_type_size(ArrayType type);
+
+std::string to_string(ArrayType type);
+std::string to_string(ArrayCodec codec);
+
+/**
+ * @brief Check whether the library was built with a codec
+ *
+ * @param codec
+ * @return bool
+ */
+bool array_codec_available(ArrayCodec codec);
+
+/**
+ * @brief The best available codec: zstd, then lz4, then deflate
+ *
+ * @return ArrayCodec
+ */
+ArrayCodec default_array_codec();
+
+/**
+ * @brief Check whether the library was built with HDF5
+ *
+ * @return bool
+ */
+bool array_hdf5_available();
+
+/**
+ * @brief Options for writing an array
+ */
+struct ArrayOptions {
+  /**
+   * @brief Shape of a chunk, empty for chunks of about 1 MiB which are
+   * contiguous in the trailing dimensions
+   *
+   * Each extent must be at least 1 and at most its dimension.
+   */
+  std::vector<std::uint64_t> chunk_shape;
+
+  /**
+   * @brief Codec, HDF5 files use deflate for any codec other than NONE
+   */
+  ArrayCodec codec = default_array_codec();
+
+  /**
+   * @brief Compression level of the codec
+   */
+  int level = 3;
+
+  /**
+   * @brief Number of threads, 0 for all hardware threads
+   */
+  unsigned int n_threads = 0;
+};
+
+/**
+ * @brief Write an array
+ *
+ * @param file_path usually from link_write
+ * @param component
+ * @param type element type
+ * @param data elements in row-major order
+ * @param shape
+ * @param options
+ * @return std::string SHA-1 of the file
+ * @throws array_error if the component exists, the options are invalid or
+ * the file is HDF5 and the library was built without it
+ */
+std::string write_array(const ghc::filesystem::path &file_path,
+                        const std::string &component, ArrayType type,
+                        const void *data,
+                        const std::vector<std::uint64_t> &shape,
+                        const ArrayOptions &options = ArrayOptions());
+
+/**
+ * @brief Write an array of a supported element type
+ *
+ * @param file_path
+ * @param component
+ * @param data elements in row-major order
+ * @param shape
+ * @param options
+ * @return std::string SHA-1 of the file
+ */
+template <typename T>
+std::string write_array(const ghc::filesystem::path &file_path,
+                        const std::string &component,
+                        const std::vector<T> &data,
+                        const std::vector<std::uint64_t> &shape,
+                        const ArrayOptions &options = ArrayOptions()) {
+  std::uint64_t n_elements_ = 1;
+  for (std::uint64_t extent_ : shape) {
+    n_elements_ *= extent_;
+  }
+  if (n_elements_ != data.size()) {
+    throw array_error("Array " + component + " has " +
+                      std::to_string(data.size()) +
+                      " elements, its shape needs " +
+                      std::to_string(n_elements_));
+  }
+  return write_array(file_path, component, array_type_traits<T>::value,
+                     data.data(), shape, options);
+}
+
+/**
+ * @brief Reader of one array component
+ *
+ * Reads may be made from several threads at once.
+ */
+class ArrayReader {
+public:
+  typedef std::shared_ptr<ArrayReader> sptr;
+
+  class Impl;
+
+  /**
+   * @brief Open an array
+   *
+   * @param file_path usually from link_read
+   * @param component
+   * @param n_threads number of threads used to decompress native files, 0
+   * for all hardware threads
+   * @return ArrayReader::sptr
+   * @throws array_error if the file or component is missing or invalid
+   */
+  static sptr open(const ghc::filesystem::path &file_path,
+                   const std::string &component, unsigned int n_threads = 0);
+
+  ~ArrayReader();
+
+  ArrayType get_type() const;
+  ArrayCodec get_codec() const;
+  const std::vector<std::uint64_t> &get_shape() const;
+  const std::vector<std::uint64_t> &get_chunk_shape() const;
+
+  /**
+   * @brief Number of elements
+   *
+   * @return std::uint64_t
+   */
+  std::uint64_t size() const;
+
+  /**
+   * @brief Read a hyperslab
+   *
+   * @param type must be the stored element type
+   * @param out buffer for the product of count elements, row-major
+   * @param offset first index in each dimension
+   * @param count number of elements in each dimension
+   * @throws array_error if the type differs or the slab is out of bounds
+   */
+  void read(ArrayType type, void *out, const std::vector<std::uint64_t> &offset,
+            const std::vector<std::uint64_t> &count) const;
+
+  /**
+   * @brief Read the whole array
+   *
+   * @return std::vector<T>
+   */
+  template <typename T> std::vector<T> read() const {
+    std::vector<T> data_(static_cast<std::size_t>(size()));
+    read(array_type_traits<T>::value, data_.data(),
+         std::vector<std::uint64_t>(get_shape().size(), 0), get_shape());
+    return data_;
+  }
+
+  /**
+   * @brief Read a hyperslab
+   *
+   * @param offset first index in each dimension
+   * @param count number of elements in each dimension
+   * @return std::vector<T>
+   */
+  template <typename T>
+  std::vector<T> read_slab(const std::vector<std::uint64_t> &offset,
+                           const std::vector<std::uint64_t> &count) const {
+    std::uint64_t n_elements_ = 1;
+    for (std::uint64_t extent_ : count) {
+      n_elements_ *= extent_;
+    }
+    std::vector<T> data_(static_cast<std::size_t>(n_elements_));
+    read(array_type_traits<T>::value, data_.data(), offset, count);
+    return data_;
+  }
+
+private:
+  explicit ArrayReader(std::unique_ptr<Impl> impl);
+
+  ArrayReader(const ArrayReader &rhs) = delete;
+  ArrayReader &operator=(const ArrayReader &rhs) = delete;
+
+  std::unique_ptr<Impl> impl_;
+};
+
+/**
+ * @brief Read a whole array
+ *
+ * @param file_path
+ * @param component
+ * @param shape filled with the shape of the array
+ * @return std::vector<T>
+ */
+template <typename T>
+std::vector<T> read_array(const ghc::filesystem::path &file_path,
+                          const std::string &component,
+                          std::vector<std::uint64_t> &shape) {
+  const ArrayReader::sptr reader_ = ArrayReader::open(file_path, component);
+  shape = reader_->get_shape();
+  return reader_->read<T>();
+}
+
+}; // namespace FairDataPipeline
+
+#endif
@@ -0,0 +1,434 @@
+/*! **************************************************************************
+ * @file FairDataPipeline/utilities/arrow_table.hxx
+ * @date 2026-10-19
+ * @brief File containing a writer and reader of Arrow IPC tables
+ *
+ * Tables are written in the Arrow IPC file format (file type `arrow`), which
+ * pyarrow, Arrow R, polars and DuckDB read without a parse step:
+ *
+ *   "ARROW1\0\0"
+ *   Message     schema
+ *   Message[n]  record batches, each a flatbuffer followed by its body
+ *   int32[2]    end of stream marker
+ *   Footer      flatbuffer with the schema and the offset of every batch
+ *   int32       size of the footer
+ *   "ARROW1"
+ *
+ * ArrowWriter streams record batches to the path returned by link_write,
+ * so only the batch being written is held in memory, and hashes the file as
+ * it is written. ArrowTable maps the path returned by link_read and gives
+ * pointers to the column buffers in the map, without copying.
+ *
+ * Columns are int32, int64, float32, float64 or utf8 strings. Dictionary
+ * encoded and compressed batches are not supported.
+ ****************************************************************************/
+#ifndef __FDP_ARROW_TABLE_HXX__
+#define __FDP_ARROW_TABLE_HXX__
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <ghc/filesystem.hpp>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "digestpp/digestpp.hpp"
+
+#include "fdp/exceptions.hxx"
+
+namespace FairDataPipeline {
+/**
+ * @brief Type of a column
+ */
+enum class ArrowType : std::uint32_t {
+  INT32 = 1,
+  INT64 = 2,
+  FLOAT32 = 3,
+  FLOAT64 = 4,
+  STRING = 5 /*!< utf8, with int32 offsets */
+};
+
+template <typename T> struct arrow_type_traits;
+
+template <> struct arrow_type_traits<std::int32_t> {
+  static constexpr ArrowType value = ArrowType::INT32;
+};
+template <> struct arrow_type_traits<std::int64_t> {
+  static constexpr ArrowType value = ArrowType::INT64;
+};
+template <> struct arrow_type_traits<float> {
+  static constexpr ArrowType value = ArrowType::FLOAT32;
+};
+template <> struct arrow_type_traits<double> {
+  static constexpr ArrowType value = ArrowType::FLOAT64;
+};
+
+std::string to_string(ArrowType type);
+
+/**
+ * @brief Name and type of a column
+ */
+struct ArrowField {
+  std::string name;
+  ArrowType type;
+};
+
+/**
+ * @brief Values of one column of a record batch, not copied
+ *
+ * Converts implicitly from a vector, so a batch may be written as
+ * `writer->write_batch({days, regions, rates})`.
+ */
+class ArrowColumn {
+public:
+  ArrowColumn(const std::vector<std::int32_t> &values)
+      : type_(ArrowType::INT32), values_(values.data()), size_(values.size()) {}
+  ArrowColumn(const std::vector<std::int64_t> &values)
+      : type_(ArrowType::INT64), values_(values.data()), size_(values.size()) {}
+  ArrowColumn(const std::vector<float> &values)
+      : type_(ArrowType::FLOAT32), values_(values.data()),
+        size_(values.size()) {}
+  ArrowColumn(const std::vector<double> &values)
+      : type_(ArrowType::FLOAT64), values_(values.data()),
+        size_(values.size()) {}
+  ArrowColumn(const std::vector<std::string> &values)
+      : type_(ArrowType::STRING), size_(values.size()), strings_(&values) {}
+
+  /**
+   * @brief Column of fixed width values from a pointer
+   *
+   * @param type any type other than STRING
+   * @param values
+   * @param size number of values
+   */
+  ArrowColumn(ArrowType type, const void *values, std::size_t size)
+      : type_(type), values_(values), size_(size) {}
+
+  ArrowType get_type() const { return type_; }
+  std::size_t size() const { return size_; }
+  const void *get_values() const { return values_; }
+  const std::vector<std::string> *get_strings() const { return strings_; }
+
+private:
+  ArrowType type_;
+  const void *values_ = nullptr;
+  std::size_t size_ = 0;
+  const std::vector<std::string> *strings_ = nullptr;
+};
+
+/**
+ * @brief Streaming writer of an Arrow IPC file
+ *
+ * Columns are written a batch at a time with write_batch(), or a row at a
+ * time with write_row(), in which case rows are collected into batches of
+ * batch_rows. The file is written next to its final path and renamed by
+ * close(), and its SHA-1 is recorded in the hash cache.
+ *
+ *     auto writer = ArrowWriter::construct(
+ *         path, {{"day", ArrowType::INT64}, {"rate", ArrowType::FLOAT64}});
+ *     writer->write_batch({days, rates});
+ *     std::string hash = writer->close();
+ */
+class ArrowWriter {
+public:
+  typedef std::shared_ptr<ArrowWriter> sptr;
+
+  /**
+   * @brief Create an Arrow IPC file
+   *
+   * @param file_path usually from link_write
+   * @param schema
+   * @param batch_rows rows in each batch written by write_row()
+   * @return ArrowWriter::sptr
+   * @throws arrow_error if the file cannot be created or the schema is empty
+   */
+  static sptr construct(const ghc::filesystem::path &file_path,
+                        const std::vector<ArrowField> &schema,
+                        std::size_t batch_rows = 65536);
+
+  /**
+   * @brief Closes the file if close() was not called, errors are logged
+   */
+  ~ArrowWriter();
+
+  /**
+   * @brief Write a record batch
+   *
+   * Rows collected by write_row() are written first.
+   *
+   * @param columns one for each field of the schema, of the same length
+   * @throws arrow_error if a column does not match its field
+   */
+  void write_batch(const std::vector<ArrowColumn> &columns);
+
+  /**
+   * @brief Append a field to the current row
+   *
+   * @throws arrow_error if the value does not fit the type of the column,
+   * and the row is dropped
+   */
+  ArrowWriter &field(double value);
+  ArrowWriter &field(const std::string &value);
+  ArrowWriter &field(const char *value) {
+    return string_field_(value, std::char_traits<char>::length(value));
+  }
+  template <typename T>
+  typename std::enable_if<std::is_integral<T>::value, ArrowWriter &>::type
+  field(T value) {
+    return std::is_unsigned<T>::value
+               ? unsigned_field_(static_cast<std::uint64_t>(value))
+               : integer_field_(static_cast<std::int64_t>(value));
+  }
+  ArrowWriter &field(float value) { return field(static_cast<double>(value)); }
+
+  /**
+   * @brief End the current row
+   *
+   * @throws arrow_error if the row has the wrong number of fields
+   */
+  ArrowWriter &end_row();
+
+  /**
+   * @brief Write a whole row
+   */
+  template <typename... Fields>
+  ArrowWriter &write_row(const Fields &...fields) {
+    append_fields_(fields...);
+    return end_row();
+  }
+
+  /**
+   * @brief Write the collected rows, the footer, and move the file to its
+   * path
+   *
+   * @return std::string SHA-1 of the file
+   * @throws arrow_error if writing failed
+   */
+  std::string close();
+
+  std::size_t n_rows() const { return n_rows_; }
+  std::size_t n_batches() const { return blocks_.size(); }
+
+private:
+  ArrowWriter(const ghc::filesystem::path &file_path,
+              const std::vector<ArrowField> &schema, std::size_t batch_rows);
+
+  ArrowWriter(const ArrowWriter &rhs) = delete;
+  ArrowWriter &operator=(const ArrowWriter &rhs) = delete;
+
+  void append_fields_() {}
+  template <typename Head, typename... Tail>
+  void append_fields_(const Head &head, const Tail &...tail) {
+    field(head);
+    append_fields_(tail...);
+  }
+
+  /**
+   * @brief Position of a message in the file
+   */
+  struct Block {
+    std::int64_t offset;
+    std::int32_t metadata_size;
+    std::int64_t body_size;
+  };
+
+  /**
+   * @brief Values of a column collected by write_row()
+   */
+  struct Builder {
+    std::vector<char> values;
+    std::vector<std::int32_t> offsets;
+  };
+
+  /**
+   * @brief Buffers of a column of a batch to be written
+   */
+  struct ColumnBuffers {
+    const void *values;
+    std::size_t values_size;
+    const std::int32_t *offsets; /*!< nullptr unless a string column */
+  };
+
+  ArrowWriter &integer_field_(std::int64_t value);
+  ArrowWriter &unsigned_field_(std::uint64_t value);
+  ArrowWriter &string_field_(const char *text, std::size_t size);
+  Builder &next_field_(ArrowType &type);
+  void drop_row_();
+  [[noreturn]] void mismatch_(const std::string &value);
+  void flush_rows_();
+  void write_record_batch_(std::size_t n_rows,
+                           const std::vector<ColumnBuffers> &columns);
+  void write_message_(const std::vector<std::uint8_t> &metadata);
+  void write_(const void *data, std::size_t size);
+
+  ghc::filesystem::path file_path_;
+  ghc::filesystem::path tmp_path_;
+  std::unique_ptr<std::ofstream> out_;
+  digestpp::sha1 hasher_;
+  std::vector<ArrowField> schema_;
+  std::vector<Builder> builders_;
+  std::vector<Block> blocks_;
+  std::string hash_;
+  std::size_t batch_rows_;
+  std::size_t n_fields_ = 0;
+  std::size_t n_rows_ = 0;
+  std::size_t n_pending_ = 0;
+  std::int64_t offset_ = 0;
+  bool closed_ = false;
+};
+
+/**
+ * @brief Read-only view of a memory mapped Arrow IPC file
+ *
+ * Immutable once opened, so it may be shared between threads. Pointers
+ * returned by values() and the string accessors are valid while the table
+ * is.
+ */
+class ArrowTable {
+public:
+  typedef std::shared_ptr<const ArrowTable> sptr;
+
+  /**
+   * @brief File type (extension) of Arrow IPC files
+   */
+  static const char *const file_type;
+
+  /**
+   * @brief Map an Arrow IPC file
+   *
+   * @param file_path usually from link_read
+   * @return ArrowTable::sptr
+   * @throws arrow_error if the file is missing, not an Arrow IPC file, or
+   * holds unsupported types, dictionaries or compressed batches
+   */
+  static sptr open(const ghc::filesystem::path &file_path);
+
+  ~ArrowTable();
+
+  const std::vector<ArrowField> &get_schema() const { return schema_; }
+  std::size_t n_columns() const { return schema_.size(); }
+  std::size_t n_batches() const { return batches_.size(); }
+
+  /**
+   * @brief Number of rows in all batches
+   *
+   * @return std::size_t
+   */
+  std::size_t n_rows() const { return n_rows_; }
+
+  std::size_t batch_rows(std::size_t batch) const;
+
+  /**
+   * @brief Get the index of a column
+   *
+   * @param name
+   * @return std::size_t
+   * @throws arrow_error if there is no such column
+   */
+  std::size_t column_index(const std::string &name) const;
+
+  /**
+   * @brief Number of null values of a column in a batch
+   */
+  std::size_t null_count(std::size_t batch, std::size_t column) const;
+
+  /**
+   * @brief Whether a value is not null
+   */
+  bool is_valid(std::size_t batch, std::size_t column, std::size_t row) const;
+
+  /**
+   * @brief Values of a fixed width column in a batch, in the map
+   *
+   * @param batch
+   * @param column
+   * @return const T* batch_rows(batch) values, those which are null are
+   * undefined
+   * @throws arrow_error if the column has another type
+   */
+  template <typename T>
+  const T *values(std::size_t batch, std::size_t column) const {
+    return static_cast<const T *>(
+        values_(batch, column, arrow_type_traits<T>::value));
+  }
+
+  /**
+   * @brief Offsets of the strings of a column in a batch, in the map
+   * String i is string_data()[offsets[i]] to string_data()[offsets[i + 1]]
+   *
+   * @throws arrow_error if the column is not a string column
+   */
+  const std::int32_t *string_offsets(std::size_t batch,
+                                     std::size_t column) const;
+  const char *string_data(std::size_t batch, std::size_t column) const;
+
+  /**
+   * @brief Copy a string, empty if null
+   */
+  std::string get_string(std::size_t batch, std::size_t column,
+                         std::size_t row) const;
+
+  /**
+   * @brief Copy a fixed width column of every batch
+   *
+   * @param column
+   * @return std::vector<T>
+   */
+  template <typename T> std::vector<T> read_column(std::size_t column) const {
+    std::vector<T> data_;
+    data_.reserve(n_rows_);
+    for (std::size_t b = 0; b < batches_.size(); ++b) {
+      const T *values_ = values<T>(b, column);
+      data_.insert(data_.end(), values_, values_ + batch_rows(b));
+    }
+    return data_;
+  }
+
+  /**
+   * @brief Copy a string column of every batch
+   *
+   * @param column
+   * @return std::vector<std::string>
+   */
+  std::vector<std::string> read_strings(std::size_t column) const;
+
+private:
+  ArrowTable() = default;
+
+  ArrowTable(const ArrowTable &rhs) = delete;
+  ArrowTable &operator=(const ArrowTable &rhs) = delete;
+
+  /**
+   * @brief Buffers of a column in a batch
+   */
+  struct Buffers {
+    std::size_t null_count;
+    const std::uint8_t *validity; /*!< nullptr if no value is null */
+    const void *values;
+    const std::int32_t *offsets;
+  };
+
+  struct Batch {
+    std::size_t n_rows;
+    std::vector<Buffers> columns;
+  };
+
+  const Buffers &buffers_(std::size_t batch, std::size_t column) const;
+  const void *values_(std::size_t batch, std::size_t column,
+                      ArrowType type) const;
+  void parse_(const ghc::filesystem::path &file_path);
+
+  const std::uint8_t *data_ = nullptr;
+  std::size_t size_ = 0;
+  bool mapped_ = false;
+  std::vector<std::uint64_t> buffer_;
+  std::vector<ArrowField> schema_;
+  std::vector<Batch> batches_;
+  std::size_t n_rows_ = 0;
+};
+
+}; // namespace FairDataPipeline
+
+#endif
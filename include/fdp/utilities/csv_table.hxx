@@ -0,0 +1,262 @@
+/*! **************************************************************************
+ * @file FairDataPipeline/utilities/csv_table.hxx
+ * @date 2026-10-19
+ * @brief File containing a reader and writer of CSV tables
+ *
+ * CsvTable reads the file at a link_read path into typed columns. The file
+ * is mapped and split into chunks at row boundaries, found by counting
+ * quotes with 16 bytes compared per instruction, and the chunks are parsed
+ * on several threads. Each column is inferred as int64, float64 or string,
+ * unless its type is given.
+ *
+ * CsvWriter formats rows into a buffer and writes the file at a link_write
+ * path, hashing it as it is written so finalise does not read it again.
+ ****************************************************************************/
+#ifndef __FDP_CSV_TABLE_HXX__
+#define __FDP_CSV_TABLE_HXX__
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <ghc/filesystem.hpp>
+#include <map>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "digestpp/digestpp.hpp"
+
+#include "fdp/exceptions.hxx"
+
+namespace FairDataPipeline {
+/**
+ * @brief Type of a column, in order of promotion
+ */
+enum class CsvType : std::uint32_t { INT64 = 1, FLOAT64 = 2, STRING = 3 };
+
+std::string to_string(CsvType type);
+
+/**
+ * @brief Options for reading and writing CSV files
+ */
+struct CsvOptions {
+  char delimiter = ',';
+
+  /**
+   * @brief Whether the first row holds the column names, if not columns are
+   * named `column_1`, `column_2`, ...
+   */
+  bool header = true;
+
+  /**
+   * @brief Types of columns by name, other columns are inferred
+   */
+  std::map<std::string, CsvType> column_types;
+
+  /**
+   * @brief Number of threads, 0 for all hardware threads
+   */
+  unsigned int n_threads = 0;
+};
+
+/**
+ * @brief Table of typed columns read from a CSV file
+ *
+ * Fields may be quoted, with `""` for a quote, and rows may end with `\n`
+ * or `\r\n`. Empty lines are skipped. An empty field is missing: NaN in a
+ * float64 column, which an int64 column is promoted to, and an empty
+ * string in a string column.
+ */
+class CsvTable {
+public:
+  typedef std::shared_ptr<CsvTable> sptr;
+
+  /**
+   * @brief Read a CSV file
+   *
+   * @param file_path usually from link_read
+   * @param options
+   * @return CsvTable::sptr
+   * @throws csv_error if the file is missing, a row has the wrong number of
+   * fields or a field does not parse as the type given for its column
+   */
+  static sptr read(const ghc::filesystem::path &file_path,
+                   const CsvOptions &options = CsvOptions());
+
+  std::size_t n_rows() const { return n_rows_; }
+  std::size_t n_columns() const { return names_.size(); }
+  const std::vector<std::string> &get_column_names() const { return names_; }
+
+  /**
+   * @brief Get the index of a column
+   *
+   * @param name
+   * @return std::size_t
+   * @throws csv_error if there is no such column
+   */
+  std::size_t column_index(const std::string &name) const;
+
+  CsvType get_type(std::size_t column) const;
+
+  /**
+   * @brief Get the values of a column of the given type
+   *
+   * @param column
+   * @throws csv_error if the column has another type
+   */
+  const std::vector<std::int64_t> &get_int64(std::size_t column) const;
+  const std::vector<double> &get_float64(std::size_t column) const;
+  const std::vector<std::string> &get_strings(std::size_t column) const;
+
+  /**
+   * @brief Get the values of an int64 or float64 column as doubles
+   *
+   * @param column
+   * @return std::vector<double>
+   */
+  std::vector<double> as_float64(std::size_t column) const;
+
+  /**
+   * @brief Typed values of a column
+   */
+  struct Column {
+    CsvType type = CsvType::INT64;
+    std::vector<std::int64_t> int64s;
+    std::vector<double> float64s;
+    std::vector<std::string> strings;
+  };
+
+private:
+  CsvTable() = default;
+  const Column &column_(std::size_t column, CsvType type) const;
+
+  std::vector<std::string> names_;
+  std::vector<Column> columns_;
+  std::size_t n_rows_ = 0;
+};
+
+/**
+ * @brief Streaming writer of a CSV file
+ *
+ * Rows are formatted into a buffer, so many small fields cost no more than
+ * one large write. The file is written next to its final path and renamed
+ * by close(), and its SHA-1 is recorded in the hash cache.
+ *
+ *     auto writer = CsvWriter::construct(path, {"day", "region", "cases"});
+ *     writer->write_row(1, "north", 10.5);
+ *     std::string hash = writer->close();
+ */
+class CsvWriter {
+public:
+  typedef std::shared_ptr<CsvWriter> sptr;
+
+  /**
+   * @brief Create a CSV file
+   *
+   * @param file_path usually from link_write
+   * @param column_names written as the header, and the number of fields of
+   * every row, unless empty
+   * @param delimiter
+   * @return CsvWriter::sptr
+   * @throws csv_error if the file cannot be created
+   */
+  static sptr construct(const ghc::filesystem::path &file_path,
+                        const std::vector<std::string> &column_names,
+                        char delimiter = ',');
+
+  /**
+   * @brief Closes the file if close() was not called, errors are logged
+   */
+  ~CsvWriter();
+
+  /**
+   * @brief Append a field to the current row
+   * NaN is written as an empty field, other doubles in the fewest digits
+   * which read back as the same value. An unsigned value above the int64
+   * range is written in full and reads back as float64.
+   */
+  CsvWriter &field(double value);
+  CsvWriter &field(const std::string &value);
+  CsvWriter &field(const char *value) {
+    return string_field_(value, std::char_traits<char>::length(value));
+  }
+  template <typename T>
+  typename std::enable_if<std::is_integral<T>::value, CsvWriter &>::type
+  field(T value) {
+    return std::is_unsigned<T>::value
+               ? unsigned_field_(static_cast<std::uint64_t>(value))
+               : integer_field_(static_cast<std::int64_t>(value));
+  }
+  CsvWriter &field(float value) { return field(static_cast<double>(value)); }
+
+  /**
+   * @brief End the current row
+   *
+   * @throws csv_error if the row has the wrong number of fields
+   */
+  CsvWriter &end_row();
+
+  /**
+   * @brief Write a whole row
+   */
+  template <typename... Fields> CsvWriter &write_row(const Fields &...fields) {
+    append_fields_(fields...);
+    return end_row();
+  }
+
+  /**
+   * @brief Write every row of a table
+   *
+   * @param table with the same number of columns as the writer
+   */
+  void write_table(const CsvTable &table);
+
+  /**
+   * @brief Flush and move the file to its path
+   *
+   * @return std::string SHA-1 of the file
+   * @throws csv_error if writing failed
+   */
+  std::string close();
+
+  std::size_t n_rows() const { return n_rows_; }
+
+private:
+  CsvWriter(const ghc::filesystem::path &file_path,
+            const std::vector<std::string> &column_names, char delimiter);
+
+  CsvWriter(const CsvWriter &rhs) = delete;
+  CsvWriter &operator=(const CsvWriter &rhs) = delete;
+
+  void append_fields_() {}
+  template <typename Head, typename... Tail>
+  void append_fields_(const Head &head, const Tail &...tail) {
+    field(head);
+    append_fields_(tail...);
+  }
+
+  CsvWriter &integer_field_(std::int64_t value);
+  CsvWriter &unsigned_field_(std::uint64_t value);
+  CsvWriter &string_field_(const char *text, std::size_t size);
+  void separator_();
+  void end_line_();
+  void flush_();
+
+  ghc::filesystem::path file_path_;
+  ghc::filesystem::path tmp_path_;
+  std::unique_ptr<std::ofstream> out_;
+  digestpp::sha1 hasher_;
+  std::string buffer_;
+  std::string hash_;
+  std::size_t n_columns_ = 0;
+  std::size_t n_fields_ = 0;
+  std::size_t n_rows_ = 0;
+  std::size_t row_start_ = 0;
+  char delimiter_;
+  bool closed_ = false;
+};
+
+}; // namespace FairDataPipeline
+
+#endif
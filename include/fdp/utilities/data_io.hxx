@@ -26,6 +26,7 @@
 #include "fdp/objects/metadata.hxx"
 #include "fdp/utilities/logging.hxx"
 #include "fdp/utilities/semver.hxx"
+#include "fdp/utilities/toml_writer.hxx"
 #include "fdp/exceptions.hxx"
 
 namespace FairDataPipeline {
@@ -59,6 +60,44 @@ ghc::filesystem::path write_toml_data(ghc::filesystem::path file_path,
                                       const std::string &component,
                                       const toml::value &data);
 
+/**
+ * @brief Append many components to a TOML file in a single write
+ *
+ * The file is checked once for existing components, see TomlWriter.
+ * If any exist, or a component is repeated, nothing is written.
+ *
+ * @param file_path
+ * @param components component names, one per entry of data
+ * @param data tables of the form {component: {...}}
+ * @return ghc::filesystem::path
+ */
+ghc::filesystem::path write_toml_data(ghc::filesystem::path file_path,
+                                      const std::vector<std::string> &components,
+                                      const std::vector<toml::value> &data);
+
+/**
+ * @brief Read many point estimates, parsing the file once
+ *
+ * @param file_path
+ * @param components
+ * @return std::vector<double> one value per component
+ */
+std::vector<double> read_point_estimates_from_toml(
+    const ghc::filesystem::path file_path,
+    const std::vector<std::string> &components);
+
+/**
+ * @brief Write many point estimates, writing the file once
+ *
+ * @param components
+ * @param values one value per component
+ * @param file_path
+ * @return ghc::filesystem::path
+ */
+ghc::filesystem::path write_point_estimates(
+    const std::vector<std::string> &components,
+    const std::vector<double> &values, const ghc::filesystem::path file_path);
+
 /**
  * @brief Create an estimate
  * 
@@ -89,6 +128,21 @@ write_point_estimate(T &value, const std::string &component,
                               component, file_path);
 }
 
+/**
+ * @brief Buffer a point estimate in a writer session
+ * Use one TomlWriter to write many estimates to a file in one write
+ *
+ * @tparam T
+ * @param value
+ * @param component
+ * @param writer
+ */
+template <typename T>
+void write_point_estimate(const T &value, const std::string &component,
+                          TomlWriter &writer) {
+  writer.add_parameter("point-estimate", component, value);
+}
+
 std::string get_first_component(const ghc::filesystem::path &file_path);
 
 bool component_exists(const ghc::filesystem::path &file_path, const std::string &component);
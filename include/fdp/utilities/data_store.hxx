@@ -0,0 +1,116 @@
+/*! **************************************************************************
+ * @file FairDataPipeline/utilities/data_store.hxx
+ * @date 2026-10-19
+ * @brief File containing the content-addressed layer of the write data store
+ *
+ * Finalised outputs are stored once as blobs keyed by their hash under
+ * `<write_data_store>/.fdp/blobs`. The product paths registered with the
+ * registry, `<namespace>/<data_product>/<hash><extension>`, are reflinks or
+ * hardlinks to the blob where the filesystem supports them and copies
+ * otherwise, so storage grows with unique content rather than run count.
+ ****************************************************************************/
+#ifndef __FDP_DATA_STORE_HXX__
+#define __FDP_DATA_STORE_HXX__
+
+#include <ghc/filesystem.hpp>
+#include <memory>
+#include <string>
+
+namespace FairDataPipeline {
+/**
+ * @brief Content-addressed blob store under a write data store
+ */
+class DataStore {
+public:
+  typedef std::shared_ptr<DataStore> sptr;
+
+  /**
+   * @brief How a product path was materialised from its blob
+   */
+  enum class LinkType {
+    REFLINK,  /*!< Copy-on-write clone sharing the blob's extents */
+    HARDLINK, /*!< Additional directory entry for the blob's inode */
+    COPY,     /*!< Full copy of the blob */
+    EXISTING  /*!< The product path already held the content */
+  };
+
+  /**
+   * @brief Construct a data store rooted at the given write data store
+   *
+   * @param root the write data store directory
+   * @return DataStore::sptr
+   */
+  static sptr construct(const ghc::filesystem::path &root);
+
+  /**
+   * @brief Get the path of the blob for a given hash
+   *
+   * @param hash content hash
+   * @param extension file extension including the leading '.', may be empty
+   * @return ghc::filesystem::path
+   */
+  ghc::filesystem::path blob_path(const std::string &hash,
+                                  const std::string &extension) const;
+
+  /**
+   * @brief Move a file into the blob store
+   *
+   * If a blob with the same hash already exists the source is removed.
+   * Moves across filesystems fall back to copying.
+   *
+   * @param source the file to store, consumed by the call
+   * @param hash content hash of the source
+   * @param extension file extension including the leading '.'
+   * @return ghc::filesystem::path the blob path
+   */
+  ghc::filesystem::path store(const ghc::filesystem::path &source,
+                              const std::string &hash,
+                              const std::string &extension);
+
+  /**
+   * @brief Materialise a product path from a blob
+   *
+   * Tries a reflink, then a hardlink, then falls back to a copy.
+   *
+   * @param blob the blob path
+   * @param target the product path to create
+   * @return LinkType the method used
+   */
+  static LinkType link(const ghc::filesystem::path &blob,
+                       const ghc::filesystem::path &target);
+
+  /**
+   * @brief Store a file and materialise its product path in one step
+   *
+   * @param source the file to store, consumed by the call
+   * @param hash content hash of the source
+   * @param target the product path to create
+   * @return LinkType the method used to create target
+   */
+  LinkType commit(const ghc::filesystem::path &source, const std::string &hash,
+                  const ghc::filesystem::path &target);
+
+  /**
+   * @brief Get the root of the blob store
+   *
+   * @return ghc::filesystem::path
+   */
+  ghc::filesystem::path get_blob_root() const { return blob_root_; }
+
+private:
+  explicit DataStore(const ghc::filesystem::path &root);
+
+  ghc::filesystem::path blob_root_;
+};
+
+/**
+ * @brief Get the name of a link type
+ *
+ * @param link_type
+ * @return std::string
+ */
+std::string to_string(DataStore::LinkType link_type);
+
+}; // namespace FairDataPipeline
+
+#endif
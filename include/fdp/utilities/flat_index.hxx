@@ -0,0 +1,118 @@
+/*! **************************************************************************
+ * @file FairDataPipeline/utilities/flat_index.hxx
+ * @date 2026-10-19
+ * @brief File containing a flat open-addressed index of 32 bit ids
+ *
+ * Used by the compact tables (ProductTable, ParameterSet) which keep their
+ * rows in columns and only need a hash index from a key to a row id.
+ ****************************************************************************/
+#ifndef __FDP_FLAT_INDEX_HXX__
+#define __FDP_FLAT_INDEX_HXX__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace FairDataPipeline {
+
+/**
+ * @brief FNV-1a hash of a byte range
+ *
+ * @param data
+ * @param size
+ * @return std::uint64_t
+ */
+inline std::uint64_t hash_bytes(const char *data, std::size_t size) {
+  std::uint64_t hash_ = 14695981039346656037ULL;
+  for (std::size_t i = 0; i < size; ++i) {
+    hash_ ^= static_cast<unsigned char>(data[i]);
+    hash_ *= 1099511628211ULL;
+  }
+  return hash_;
+}
+
+/**
+ * @brief Open-addressed (linear probing) set of 32 bit ids
+ *
+ * Slots hold id + 1 so that zero marks an empty slot. The caller supplies
+ * the hash of an id, the set only stores the ids themselves.
+ */
+class FlatIndex {
+public:
+  template <typename Hash> void insert(std::uint32_t id, Hash &&hash_of) {
+    if ((size_ + 1) * 10 > slots_.size() * 7) {
+      grow_(hash_of);
+    }
+    place_(id, hash_of(id));
+    ++size_;
+  }
+
+  /**
+   * @brief Find the id for which matches(id) is true
+   */
+  template <typename Match>
+  bool find(std::uint64_t hash, Match &&matches, std::uint32_t &id) const {
+    if (slots_.empty()) {
+      return false;
+    }
+    const std::size_t mask_ = slots_.size() - 1;
+    for (std::size_t i = hash & mask_;; i = (i + 1) & mask_) {
+      if (slots_[i] == 0) {
+        return false;
+      }
+      if (matches(slots_[i] - 1)) {
+        id = slots_[i] - 1;
+        return true;
+      }
+    }
+  }
+
+  std::size_t memory_usage() const {
+    return slots_.capacity() * sizeof(std::uint32_t);
+  }
+
+  /**
+   * @brief Total number of slots probed to find every id
+   *
+   * Divided by the number of ids this is the mean cost of a hit, 1 when no
+   * id is displaced from its home slot.
+   */
+  template <typename Hash>
+  std::size_t probe_length(Hash &&hash_of) const {
+    const std::size_t mask_ = slots_.size() - 1;
+    std::size_t total_ = 0;
+    for (std::size_t i = 0; i < slots_.size(); ++i) {
+      if (slots_[i] != 0) {
+        total_ += ((i - hash_of(slots_[i] - 1)) & mask_) + 1;
+      }
+    }
+    return total_;
+  }
+
+private:
+  void place_(std::uint32_t id, std::uint64_t hash) {
+    const std::size_t mask_ = slots_.size() - 1;
+    std::size_t i = hash & mask_;
+    while (slots_[i] != 0) {
+      i = (i + 1) & mask_;
+    }
+    slots_[i] = id + 1;
+  }
+
+  template <typename Hash> void grow_(Hash &&hash_of) {
+    std::vector<std::uint32_t> old_(slots_.empty() ? 16 : slots_.size() * 2, 0);
+    old_.swap(slots_);
+    for (std::uint32_t slot_ : old_) {
+      if (slot_ != 0) {
+        place_(slot_ - 1, hash_of(slot_ - 1));
+      }
+    }
+  }
+
+  std::vector<std::uint32_t> slots_;
+  std::size_t size_ = 0;
+};
+
+}; // namespace FairDataPipeline
+
+#endif
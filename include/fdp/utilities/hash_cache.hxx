@@ -0,0 +1,169 @@
+/*! **************************************************************************
+ * @file FairDataPipeline/utilities/hash_cache.hxx
+ * @date 2026-10-19
+ * @brief File containing a persistent cache of file content hashes
+ *
+ * Hashing large data products dominates the cost of constructing a Config
+ * and of finalising a code run. The cache stores previously computed
+ * digests keyed by (device, inode, size, mtime_ns) so that files which have
+ * not changed since they were last hashed are not read again. Entries are
+ * stored in an extended attribute on the file where the filesystem allows
+ * it, and otherwise in a sidecar database inside the data store.
+ ****************************************************************************/
+#ifndef __FDP_HASH_CACHE_HXX__
+#define __FDP_HASH_CACHE_HXX__
+
+#include <cstdint>
+#include <ghc/filesystem.hpp>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace FairDataPipeline {
+/**
+ * @brief Cache of file content hashes keyed by file identity
+ *
+ * Strict mode disables all lookups and stores so every call to
+ * calculate_hash_from_file reads the file. It is enabled by setting the
+ * environment variable `FDP_STRICT_HASH` or the `strict_hash` key in the
+ * run_metadata section of the config. When both are given the environment
+ * variable takes precedence. An empty `FDP_STRICT_HASH`, `0` or `false`
+ * turns strict mode off.
+ */
+class HashCache {
+public:
+  typedef std::shared_ptr<HashCache> sptr;
+
+  /**
+   * @brief Identity of a file at the point it was hashed
+   */
+  struct key_type {
+    std::uint64_t device = 0;
+    std::uint64_t inode = 0;
+    std::uint64_t size = 0;
+    std::int64_t mtime_ns = 0;
+
+    bool operator<(const key_type &rhs) const;
+    bool operator==(const key_type &rhs) const;
+    bool operator!=(const key_type &rhs) const { return !(*this == rhs); }
+  };
+
+  /**
+   * @brief Construct a cache without a sidecar database
+   *
+   * Entries will only be persisted via extended attributes.
+   *
+   * @return HashCache::sptr
+   */
+  static sptr construct();
+
+  /**
+   * @brief Construct a cache backed by a sidecar database
+   *
+   * @param database_path file used to persist entries which cannot be
+   * stored as extended attributes
+   * @return HashCache::sptr
+   */
+  static sptr construct(const ghc::filesystem::path &database_path);
+
+  /**
+   * @brief Destroy the Hash Cache object, flushing the sidecar database
+   */
+  ~HashCache();
+
+  /**
+   * @brief Read the identity of a file
+   *
+   * @param file_path
+   * @param key filled with the identity of the file on success
+   * @return true the key was read
+   * @return false the platform does not provide stable file identities
+   */
+  static bool get_key(const ghc::filesystem::path &file_path, key_type &key);
+
+  /**
+   * @brief Look up the cached digest of a file
+   *
+   * @param file_path
+   * @param algorithm name of the hash algorithm, e.g. "sha1"
+   * @param hash filled with the cached digest on a hit
+   * @return true a digest matching the current file identity was found
+   * @return false the file must be hashed
+   */
+  bool lookup(const ghc::filesystem::path &file_path,
+              const std::string &algorithm, std::string &hash);
+
+  /**
+   * @brief Record the digest of a file
+   *
+   * @param file_path
+   * @param algorithm name of the hash algorithm, e.g. "sha1"
+   * @param key identity of the file taken before it was hashed
+   * @param hash the digest of the file
+   */
+  void store(const ghc::filesystem::path &file_path,
+             const std::string &algorithm, const key_type &key,
+             const std::string &hash);
+
+  /**
+   * @brief Write any pending sidecar entries to disk
+   */
+  void flush();
+
+  /**
+   * @brief Attach a sidecar database, flushing any previous one
+   *
+   * @param database_path
+   */
+  void set_database_path(const ghc::filesystem::path &database_path);
+
+  /**
+   * @brief Get the sidecar database path (empty if none is attached)
+   *
+   * @return ghc::filesystem::path
+   */
+  ghc::filesystem::path get_database_path() const;
+
+  void set_strict(bool strict);
+  bool is_strict() const;
+
+  /**
+   * @brief Read strict mode from the environment variable FDP_STRICT_HASH
+   *
+   * @param strict set to false if the value is empty, "0" or "false", and
+   * to true otherwise
+   * @return true the variable is set
+   * @return false the variable is not set and strict is unchanged
+   */
+  static bool strict_from_environment(bool &strict);
+
+  /**
+   * @brief Get the process wide cache used by calculate_hash_from_file
+   *
+   * @return HashCache::sptr
+   */
+  static sptr get_cache();
+
+private:
+  HashCache();
+
+  HashCache(const HashCache &rhs) = delete;
+  HashCache &operator=(const HashCache &rhs) = delete;
+
+  void load_();
+  void flush_(bool log_errors);
+
+  typedef std::map<std::pair<key_type, std::string>, std::string> table_type;
+
+  mutable std::mutex mutex_;
+  ghc::filesystem::path database_path_;
+  table_type entries_;
+  bool loaded_ = false;
+  bool dirty_ = false;
+  bool strict_ = false;
+};
+
+}; // namespace FairDataPipeline
+
+#endif
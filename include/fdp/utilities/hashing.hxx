@@ -0,0 +1,34 @@
+/*! **************************************************************************
+ * @file FairDataPipeline/utilities/hashing.hxx
+ * @date 2026-10-19
+ * @brief File containing the string hashing primitives
+ *
+ * Kept apart from the file hashing in objects/metadata.hxx, which depends on
+ * the hash cache, so that utilities can name temporary files without
+ * depending on the objects layer.
+ ****************************************************************************/
+#ifndef __FDP_HASHING_HXX__
+#define __FDP_HASHING_HXX__
+
+#include <string>
+
+namespace FairDataPipeline {
+
+/*! **************************************************************************
+ * @brief calculates a hash from a given string via SHA1
+ *
+ * @param input string to be hashed
+ * @return the hash obtained from the string contents
+ ****************************************************************************/
+std::string calculate_hash_from_string(const std::string &input);
+
+/**
+ * @brief Generate a random hash
+ * 
+ * @return std::string a random hash
+ */
+std::string generate_random_hash();
+
+}; // namespace FairDataPipeline
+
+#endif
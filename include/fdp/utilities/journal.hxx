@@ -0,0 +1,123 @@
+/*! **************************************************************************
+ * @file FairDataPipeline/utilities/journal.hxx
+ * @date 2026-10-19
+ * @brief File containing a write-ahead journal for pipeline sessions
+ *
+ * The journal records each completed step of a session (initialisation,
+ * links and every stage of finalise) together with the registry objects it
+ * produced. Each record is flushed to disk before the next step starts, so
+ * a session which is interrupted can be resumed by a new session from the
+ * first incomplete step without repeating registry calls or hashing.
+ ****************************************************************************/
+#ifndef __FDP_JOURNAL_HXX__
+#define __FDP_JOURNAL_HXX__
+
+#include <cstdint>
+#include <cstdio>
+#include <ghc/filesystem.hpp>
+#include <json/value.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace FairDataPipeline {
+/**
+ * @brief Append-only journal of completed session steps
+ */
+class Journal {
+public:
+  typedef std::shared_ptr<Journal> sptr;
+
+  /**
+   * @brief Open a journal, replaying any records already in the file
+   *
+   * The journal is locked for as long as it is open, so only one session
+   * writes to it. A truncated final record, left by a crash mid-write, is
+   * ignored and cut from the file before new records are appended.
+   *
+   * @param journal_path
+   * @return Journal::sptr
+   */
+  static sptr open(const ghc::filesystem::path &journal_path);
+
+  /**
+   * @brief Open a journal unless another live session holds it
+   *
+   * @param journal_path
+   * @return Journal::sptr the journal, null if it is locked by another
+   * session
+   * @throws write_error if the journal cannot be opened or locked, for
+   * example on a file system without locks
+   */
+  static sptr try_open(const ghc::filesystem::path &journal_path);
+
+  /**
+   * @brief Read the records of a journal without opening it for writing
+   *
+   * @param journal_path
+   * @return std::vector<Json::Value> the complete records, empty if the file
+   * does not exist
+   */
+  static std::vector<Json::Value> load(const ghc::filesystem::path &journal_path);
+
+  /**
+   * @brief Destroy the Journal object, closing the file
+   */
+  ~Journal();
+
+  /**
+   * @brief Durably append a record for a completed step
+   *
+   * @param step name of the step, e.g. "initialise"
+   * @param data registry objects and values produced by the step
+   */
+  void record(const std::string &step, const Json::Value &data);
+
+  /**
+   * @brief Get the records replayed when the journal was opened
+   *
+   * Each record has the members "step" and "data".
+   *
+   * @return const std::vector<Json::Value>&
+   */
+  const std::vector<Json::Value> &replayed() const { return replayed_; }
+
+  /**
+   * @brief Find the last replayed record for a given step
+   *
+   * @param step
+   * @return Json::Value the record data, null if there is none
+   */
+  Json::Value find_last(const std::string &step) const;
+
+  /**
+   * @brief Mark the session as complete and delete the journal file
+   */
+  void complete();
+
+  /**
+   * @brief Get the journal file path
+   *
+   * @return ghc::filesystem::path
+   */
+  ghc::filesystem::path get_path() const { return path_; }
+
+private:
+  explicit Journal(const ghc::filesystem::path &journal_path);
+
+  static std::vector<Json::Value> load_(const ghc::filesystem::path &journal_path,
+                                        std::uintmax_t &good_size);
+
+  Journal(const Journal &rhs) = delete;
+  Journal &operator=(const Journal &rhs) = delete;
+
+  ghc::filesystem::path path_;
+  std::FILE *file_ = nullptr;
+  std::vector<Json::Value> replayed_;
+  std::mutex mutex_;
+};
+
+}; // namespace FairDataPipeline
+
+#endif
@@ -10,7 +10,9 @@
  ****************************************************************************/
 #ifndef __FDP_LOGGING_HXX__
 #define __FDP_LOGGING_HXX__
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -73,7 +75,7 @@ namespace FairDataPipeline {
             private:
 
 
-                enum LOG_LEVEL _log_lvl;
+                std::atomic< enum LOG_LEVEL > _log_lvl;
                 ISinkFormatter::sptr _fmtr;
         };
 
@@ -92,6 +94,7 @@ namespace FairDataPipeline {
                 OStreamSink(enum LOG_LEVEL log_lvl, std::ostream& os);
 
                 std::ostream& _os;
+                std::mutex _mutex;
         };
 
         class CompositeSink : public Sink
@@ -182,12 +185,16 @@ namespace FairDataPipeline {
 
             private:
 
-                enum LOG_LEVEL _log_lvl;
+                std::atomic< enum LOG_LEVEL > _log_lvl;
                 Sink::sptr _sink;
                 std::string _name;
         };
     }
 
+    /**
+     * @brief Process wide logger, created once on first use from any thread
+     * 
+     */
     class logger
     {
         public:
@@ -0,0 +1,111 @@
+/*! **************************************************************************
+ * @file FairDataPipeline/utilities/parallel.hxx
+ * @date 2026-10-19
+ * @brief File containing helpers for running independent work in parallel
+ ****************************************************************************/
+#ifndef __FDP_PARALLEL_HXX__
+#define __FDP_PARALLEL_HXX__
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace FairDataPipeline {
+
+/**
+ * @brief Resolve a requested thread count
+ *
+ * @param n_threads requested threads, 0 for all hardware threads
+ * @param n_tasks number of tasks, no more threads than tasks are used
+ * @return unsigned int the number of threads to use (at least 1)
+ */
+unsigned int resolve_thread_count(unsigned int n_threads, std::size_t n_tasks);
+
+/**
+ * @brief ThreadPool Class:
+ * A fixed set of worker threads reused by every parallel_for run through it
+ *
+ * Any number of threads may call parallel_for on one pool at once. The
+ * calling thread always runs tasks itself and idle workers join in, so a
+ * parallel_for never waits for a worker to become free and may safely be
+ * nested inside a task running on the same pool.
+ */
+class ThreadPool {
+public:
+  typedef std::shared_ptr<ThreadPool> sptr;
+
+  /**
+   * @brief Construct a new Thread Pool
+   *
+   * @param n_threads worker threads, 0 for one fewer than the hardware
+   * threads since callers also run tasks
+   * @return sptr
+   */
+  static sptr construct(unsigned int n_threads = 0);
+
+  /**
+   * @brief Stop and join the workers, pending calls must have returned
+   */
+  ~ThreadPool();
+
+  /**
+   * @brief Get the number of worker threads
+   *
+   * @return unsigned int
+   */
+  unsigned int size() const;
+
+  /**
+   * @brief As the free parallel_for, but helpers are taken from the pool
+   *
+   * @param n_tasks number of tasks
+   * @param n_threads number of threads including the caller, 0 for the
+   * caller and every worker
+   * @param function task body, called with the task index
+   */
+  void parallel_for(std::size_t n_tasks, unsigned int n_threads,
+                    const std::function<void(std::size_t)> &function);
+
+private:
+  explicit ThreadPool(unsigned int n_threads);
+
+  ThreadPool(const ThreadPool &rhs) = delete;
+
+  ThreadPool &operator=(const ThreadPool &rhs) = delete;
+
+  struct job;
+
+  void work_();
+
+  std::vector<std::thread> threads_;
+  std::deque<std::shared_ptr<job>> jobs_;
+  mutable std::mutex mutex_;
+  std::condition_variable wake_;
+  bool stopping_ = false;
+};
+
+/**
+ * @brief Call function(i) for every i in [0, n_tasks) using a pool of threads
+ *
+ * Tasks are handed out dynamically, the calling thread also runs tasks.
+ * If any task throws, remaining tasks are skipped and the first exception is
+ * rethrown on the calling thread once all workers have stopped.
+ *
+ * @param n_tasks number of tasks
+ * @param n_threads number of threads, 0 for all hardware threads
+ * @param function task body, called with the task index
+ * @param pool if given, helpers are taken from the pool instead of being
+ * started for this call
+ */
+void parallel_for(std::size_t n_tasks, unsigned int n_threads,
+                  const std::function<void(std::size_t)> &function,
+                  ThreadPool *pool = nullptr);
+
+}; // namespace FairDataPipeline
+
+#endif
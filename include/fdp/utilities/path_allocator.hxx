@@ -0,0 +1,68 @@
+/*! **************************************************************************
+ * @file FairDataPipeline/utilities/path_allocator.hxx
+ * @date 2026-10-19
+ * @brief File containing the allocation of data product paths for writes
+ *
+ * Every link_write needs a file name that no other session will use and a
+ * directory to put it in. Names are a random session id drawn once plus a
+ * counter, so no random number generator is seeded or hash computed per
+ * write, and directories are only created the first time they are needed.
+ ****************************************************************************/
+#ifndef __FDP_PATH_ALLOCATOR_HXX__
+#define __FDP_PATH_ALLOCATOR_HXX__
+
+#include <atomic>
+#include <cstdint>
+#include <ghc/filesystem.hpp>
+#include <string>
+
+#include "fdp/utilities/sharded_map.hxx"
+
+namespace FairDataPipeline {
+/**
+ * @brief Per-session source of unique file names and created directories
+ *
+ * Safe for concurrent use. Directories removed by another process after
+ * they were created are not recreated.
+ */
+class PathAllocator {
+public:
+  PathAllocator();
+
+  /**
+   * @brief Get a file name not used by this or any other session
+   *
+   * Names are of the form `dat-<session id>-<n>.<extension>`.
+   *
+   * @param extension file extension without the leading '.'
+   * @return std::string
+   */
+  std::string unique_filename(const std::string &extension);
+
+  /**
+   * @brief Create a directory and its parents unless this allocator has
+   * already done so
+   *
+   * @param directory
+   */
+  void ensure_directory(const ghc::filesystem::path &directory);
+
+  /**
+   * @brief Get the random id of the session, 32 hexadecimal characters
+   *
+   * @return const std::string&
+   */
+  const std::string &get_session_id() const { return session_id_; }
+
+private:
+  PathAllocator(const PathAllocator &rhs) = delete;
+  PathAllocator &operator=(const PathAllocator &rhs) = delete;
+
+  const std::string session_id_;
+  std::atomic<std::uint64_t> counter_;
+  ShardedMap<bool> created_directories_;
+};
+
+}; // namespace FairDataPipeline
+
+#endif
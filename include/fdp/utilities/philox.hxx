@@ -0,0 +1,81 @@
+/*! **************************************************************************
+ * @file FairDataPipeline/utilities/philox.hxx
+ * @date 2026-10-19
+ * @brief File containing the Philox4x32-10 counter-based random generator
+ *
+ * A counter-based generator maps (key, counter) to random bits with no
+ * state, so draw i of a stream can be computed independently of every
+ * other draw. Work can then be split across any number of threads and
+ * still produce the same numbers. See Salmon et al., "Parallel random
+ * numbers: as easy as 1, 2, 3" (SC11).
+ ****************************************************************************/
+#ifndef __FDP_PHILOX_HXX__
+#define __FDP_PHILOX_HXX__
+
+#include <array>
+#include <cstdint>
+
+namespace FairDataPipeline {
+
+/**
+ * @brief Philox4x32-10 block function
+ */
+class Philox4x32 {
+public:
+  typedef std::array<std::uint32_t, 4> counter_type;
+  typedef std::array<std::uint32_t, 2> key_type;
+
+  /**
+   * @brief Make a key from a 64 bit seed
+   *
+   * @param seed
+   * @return key_type
+   */
+  static key_type make_key(std::uint64_t seed) {
+    return key_type{{static_cast<std::uint32_t>(seed),
+                     static_cast<std::uint32_t>(seed >> 32)}};
+  }
+
+  /**
+   * @brief Generate 128 random bits for a counter
+   *
+   * @param counter
+   * @param key
+   * @return counter_type
+   */
+  static counter_type block(counter_type counter, key_type key) {
+    for (int round_ = 0; round_ < 10; ++round_) {
+      if (round_ > 0) {
+        key[0] += 0x9E3779B9u;
+        key[1] += 0xBB67AE85u;
+      }
+      const std::uint64_t product0_ =
+          static_cast<std::uint64_t>(0xD2511F53u) * counter[0];
+      const std::uint64_t product1_ =
+          static_cast<std::uint64_t>(0xCD9E8D57u) * counter[2];
+      counter = counter_type{
+          {static_cast<std::uint32_t>(product1_ >> 32) ^ counter[1] ^ key[0],
+           static_cast<std::uint32_t>(product1_),
+           static_cast<std::uint32_t>(product0_ >> 32) ^ counter[3] ^ key[1],
+           static_cast<std::uint32_t>(product0_)}};
+    }
+    return counter;
+  }
+
+  /**
+   * @brief Convert 64 random bits to a double in [0, 1)
+   *
+   * @param hi
+   * @param lo
+   * @return double
+   */
+  static double to_unit(std::uint32_t hi, std::uint32_t lo) {
+    const std::uint64_t bits_ =
+        (static_cast<std::uint64_t>(hi) << 32) | static_cast<std::uint64_t>(lo);
+    return static_cast<double>(bits_ >> 11) * (1.0 / 9007199254740992.0);
+  }
+};
+
+}; // namespace FairDataPipeline
+
+#endif
@@ -0,0 +1,151 @@
+/*! **************************************************************************
+ * @file FairDataPipeline/utilities/sharded_map.hxx
+ * @date 2026-10-19
+ * @brief File containing a string keyed map safe for concurrent use
+ *
+ * Entries are spread over a fixed number of independently locked shards so
+ * that threads working on different keys rarely contend for the same lock.
+ ****************************************************************************/
+#ifndef __FDP_SHARDED_MAP_HXX__
+#define __FDP_SHARDED_MAP_HXX__
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace FairDataPipeline {
+/**
+ * @brief Map from strings to values with per-shard locking
+ *
+ * Values are copied in and out so no reference to an entry outlives the
+ * lock protecting it.
+ *
+ * @tparam Value mapped type, must be copyable
+ * @tparam NShards number of shards
+ */
+template <typename Value, std::size_t NShards = 16> class ShardedMap {
+public:
+  typedef std::map<std::string, Value> map_type;
+
+  /**
+   * @brief Insert a value or replace the existing value for a key
+   *
+   * @param key
+   * @param value
+   */
+  void insert_or_assign(const std::string &key, const Value &value) {
+    shard &shard_ = shard_for_(key);
+    std::lock_guard<std::mutex> lock_(shard_.mutex);
+    shard_.items[key] = value;
+  }
+
+  /**
+   * @brief Copy the value for a key
+   *
+   * @param key
+   * @param value filled with the value if the key is present
+   * @return true the key was found
+   * @return false the key is absent
+   */
+  bool find(const std::string &key, Value &value) const {
+    const shard &shard_ = shard_for_(key);
+    std::lock_guard<std::mutex> lock_(shard_.mutex);
+    auto it = shard_.items.find(key);
+    if (it == shard_.items.end()) {
+      return false;
+    }
+    value = it->second;
+    return true;
+  }
+
+  /**
+   * @brief Check whether a key is present
+   *
+   * @param key
+   * @return true
+   * @return false
+   */
+  bool contains(const std::string &key) const {
+    const shard &shard_ = shard_for_(key);
+    std::lock_guard<std::mutex> lock_(shard_.mutex);
+    return shard_.items.count(key) > 0;
+  }
+
+  /**
+   * @brief Remove a key
+   *
+   * @param key
+   * @return std::size_t number of entries removed
+   */
+  std::size_t erase(const std::string &key) {
+    shard &shard_ = shard_for_(key);
+    std::lock_guard<std::mutex> lock_(shard_.mutex);
+    return shard_.items.erase(key);
+  }
+
+  /**
+   * @brief Count the entries across all shards
+   *
+   * @return std::size_t
+   */
+  std::size_t size() const {
+    std::size_t size_ = 0;
+    for (const shard &shard_ : shards_) {
+      std::lock_guard<std::mutex> lock_(shard_.mutex);
+      size_ += shard_.items.size();
+    }
+    return size_;
+  }
+
+  bool empty() const { return size() == 0; }
+
+  /**
+   * @brief Remove all entries
+   */
+  void clear() {
+    for (shard &shard_ : shards_) {
+      std::lock_guard<std::mutex> lock_(shard_.mutex);
+      shard_.items.clear();
+    }
+  }
+
+  /**
+   * @brief Copy all entries into an ordered map
+   *
+   * Shards are locked one at a time, so entries inserted concurrently with
+   * the call may or may not be included.
+   *
+   * @return map_type
+   */
+  map_type snapshot() const {
+    map_type items_;
+    for (const shard &shard_ : shards_) {
+      std::lock_guard<std::mutex> lock_(shard_.mutex);
+      items_.insert(shard_.items.begin(), shard_.items.end());
+    }
+    return items_;
+  }
+
+private:
+  struct shard {
+    mutable std::mutex mutex;
+    map_type items;
+  };
+
+  shard &shard_for_(const std::string &key) {
+    return shards_[std::hash<std::string>()(key) % NShards];
+  }
+
+  const shard &shard_for_(const std::string &key) const {
+    return shards_[std::hash<std::string>()(key) % NShards];
+  }
+
+  std::array<shard, NShards> shards_;
+};
+
+}; // namespace FairDataPipeline
+
+#endif
@@ -0,0 +1,146 @@
+/*! **************************************************************************
+ * @file FairDataPipeline/utilities/shared_session.hxx
+ * @date 2026-10-19
+ * @brief File containing a code run session shared between processes
+ *
+ * In a job array or MPI job one leader process (rank 0) registers the code
+ * run and publishes the resulting registry objects to a session file in the
+ * write data store. Worker processes attach to the session without any
+ * registry traffic and log their link calls locally. At finalise the leader
+ * waits for every worker and registers all of their outputs against the
+ * single shared code run.
+ ****************************************************************************/
+#ifndef __FDP_SHARED_SESSION_HXX__
+#define __FDP_SHARED_SESSION_HXX__
+
+#include <ghc/filesystem.hpp>
+#include <json/value.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace FairDataPipeline {
+/**
+ * @brief File based rendezvous between the processes of a shared code run
+ *
+ * The session directory `<write_data_store>/.fdp/sessions/<id>` holds
+ * `session.json`, written by the leader, and one
+ * `worker-<rank>-<nonce>.jsonl` log per worker. Each run of the leader
+ * stamps its session with a new nonce, which names the worker logs, so the
+ * leader never collects a log left by an earlier run with the same id. The
+ * directory must be on a filesystem visible to every process.
+ */
+class SharedSession {
+public:
+  typedef std::shared_ptr<SharedSession> sptr;
+
+  /**
+   * @brief Construct a shared session
+   *
+   * @param root the write data store directory
+   * @param session_id identifier shared by every process of the job
+   * @param rank rank of this process, 0 is the leader
+   * @param n_ranks total number of processes in the session
+   * @param timeout_s seconds to wait for the leader or the workers
+   * @return SharedSession::sptr
+   */
+  static sptr construct(const ghc::filesystem::path &root,
+                        const std::string &session_id, int rank, int n_ranks,
+                        double timeout_s = 600.0);
+
+  /**
+   * @brief Read the rank and size of this process from the environment
+   *
+   * `FDP_SESSION_RANK` and `FDP_SESSION_SIZE` take precedence, followed by
+   * the variables set by common MPI launchers.
+   *
+   * @param rank filled with the rank if found
+   * @param n_ranks filled with the number of processes if found
+   * @return true both values were found
+   * @return false this process is not part of a detectable job
+   */
+  static bool detect_rank(int &rank, int &n_ranks);
+
+  /**
+   * @brief Read the session identifier from the environment
+   *
+   * Uses `FDP_SESSION_ID`, then `SLURM_JOB_ID`.
+   *
+   * @return std::string empty if neither is set
+   */
+  static std::string detect_id();
+
+  bool is_leader() const { return rank_ == 0; }
+  int get_rank() const { return rank_; }
+  int get_size() const { return n_ranks_; }
+  const std::string &get_id() const { return id_; }
+  ghc::filesystem::path get_directory() const { return directory_; }
+
+  /**
+   * @brief Leader: start a new run of the session
+   *
+   * Draws the nonce of this run and removes the session file of any
+   * earlier run. Logs of earlier runs are left for close() to remove, so a
+   * worker still writing to one is never disturbed.
+   */
+  void prepare();
+
+  /**
+   * @brief Leader: atomically publish the session objects to workers
+   *
+   * @param session registry objects of the code run
+   */
+  void publish(const Json::Value &session);
+
+  /**
+   * @brief Worker: wait for the leader to publish the session
+   *
+   * A session file last written more than the timeout before this call is
+   * left by an earlier run and is ignored. Both times are modification
+   * times stamped by the filesystem holding the session, so clock skew
+   * between hosts does not matter.
+   *
+   * @return Json::Value the published session objects
+   */
+  Json::Value attach();
+
+  /**
+   * @brief Worker: path of the log its link calls are recorded in, only
+   * valid once attached
+   *
+   * @return ghc::filesystem::path
+   */
+  ghc::filesystem::path worker_log_path() const;
+
+  /**
+   * @brief Leader: wait for every worker to finalise and collect their logs
+   *
+   * Logs written for a different code run are ignored. Each returned record
+   * has a "rank" member added.
+   *
+   * @param code_run_uuid uuid of the shared code run
+   * @return std::vector<Json::Value> link records in rank order
+   */
+  std::vector<Json::Value> collect(const std::string &code_run_uuid) const;
+
+  /**
+   * @brief Leader: remove the session directory once the run is finalised
+   */
+  void close();
+
+private:
+  SharedSession(const ghc::filesystem::path &root,
+                const std::string &session_id, int rank, int n_ranks,
+                double timeout_s);
+
+  ghc::filesystem::path directory_;
+  std::string id_;
+  int rank_;
+  int n_ranks_;
+  double timeout_s_;
+  std::string nonce_;
+};
+
+}; // namespace FairDataPipeline
+
+#endif
@@ -0,0 +1,125 @@
+/*! **************************************************************************
+ * @file FairDataPipeline/utilities/toml_document.hxx
+ * @date 2026-10-19
+ * @brief File containing a parsed TOML parameter file and its cache
+ *
+ * Reading a parameter used to parse the file up to three times (to find the
+ * first component, to check the component exists and to read it). A
+ * TomlDocument is parsed once and serves all component and parameter
+ * lookups from memory. Documents are cached by path and reused while the
+ * file's identity (device, inode, size, mtime_ns) is unchanged, so a model
+ * reading hundreds of estimates from one file parses it once.
+ ****************************************************************************/
+#ifndef __FDP_TOML_DOCUMENT_HXX__
+#define __FDP_TOML_DOCUMENT_HXX__
+
+#include "toml.hpp"
+#include <cstddef>
+#include <ghc/filesystem.hpp>
+#include <memory>
+#include <string>
+
+namespace FairDataPipeline {
+/**
+ * @brief Immutable parsed TOML file
+ */
+class TomlDocument {
+public:
+  typedef std::shared_ptr<const TomlDocument> sptr;
+
+  /**
+   * @brief Get the parsed document for a file, parsing only if it has
+   * changed since it was last opened
+   *
+   * @param file_path
+   * @return TomlDocument::sptr
+   * @throws toml_error if the file does not exist or is empty
+   */
+  static sptr open(const ghc::filesystem::path &file_path);
+
+  /**
+   * @brief Parse a file, bypassing the cache
+   *
+   * @param file_path
+   * @return TomlDocument::sptr
+   * @throws toml_error if the file does not exist or is empty
+   */
+  static sptr parse(const ghc::filesystem::path &file_path);
+
+  /**
+   * @brief Drop any cached document for a file
+   * Called after writing to the file through the API
+   *
+   * @param file_path
+   */
+  static void invalidate(const ghc::filesystem::path &file_path);
+
+  /**
+   * @brief Drop all cached documents
+   */
+  static void clear_cache();
+
+  /**
+   * @brief Number of documents currently cached
+   *
+   * @return std::size_t
+   */
+  static std::size_t cache_size();
+
+  const ghc::filesystem::path &get_path() const { return file_path_; }
+  const toml::value &get_data() const { return data_; }
+
+  /**
+   * @brief Get the name of the first component in the file
+   *
+   * @return const std::string&
+   */
+  const std::string &first_component() const;
+
+  /**
+   * @brief Check the file has a table named component
+   *
+   * @param component
+   * @return bool
+   */
+  bool has_component(const std::string &component) const;
+
+  /**
+   * @brief Get the table of a component
+   *
+   * @param component
+   * @return const toml::value&
+   * @throws toml_error if the component does not exist
+   */
+  const toml::value &component(const std::string &component) const;
+
+  /**
+   * @brief Get the value of a component of the given type
+   *
+   * @param parameter expected type, e.g. "point-estimate"
+   * @param component
+   * @return const toml::value&
+   * @throws toml_error if the component does not exist or has another type
+   */
+  const toml::value &parameter(const std::string &parameter,
+                               const std::string &component) const;
+
+  /**
+   * @brief Get a point estimate, integers are converted to double
+   *
+   * @param component
+   * @return double
+   */
+  double point_estimate(const std::string &component) const;
+
+private:
+  TomlDocument(const ghc::filesystem::path &file_path, toml::value data);
+
+  ghc::filesystem::path file_path_;
+  toml::value data_;
+  std::string first_component_;
+};
+
+}; // namespace FairDataPipeline
+
+#endif
@@ -0,0 +1,126 @@
+/*! **************************************************************************
+ * @file FairDataPipeline/utilities/toml_writer.hxx
+ * @date 2026-10-19
+ * @brief File containing a buffered writer for TOML parameter files
+ *
+ * Appending a component used to re-parse the whole file to check for a
+ * duplicate name and then reopen it, so writing N components was O(N^2).
+ * A TomlWriter keeps the file's component names in memory, buffers new
+ * components and appends them in one write when flushed. The names are
+ * shared between writers on the same file and kept while the file's
+ * identity matches the one recorded at the last flush, so repeated single
+ * writes through write_point_estimate do not re-parse the file either.
+ ****************************************************************************/
+#ifndef __FDP_TOML_WRITER_HXX__
+#define __FDP_TOML_WRITER_HXX__
+
+#include "toml.hpp"
+#include <cstddef>
+#include <ghc/filesystem.hpp>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+
+namespace FairDataPipeline {
+/**
+ * @brief Buffered appender of components to a TOML file
+ *
+ * Not thread safe, but writers on the same file may be used from different
+ * threads: a pending component is reserved, so no other writer can add it,
+ * and flushes append one at a time. Pending components are flushed on
+ * destruction.
+ */
+class TomlWriter {
+public:
+  typedef std::shared_ptr<TomlWriter> sptr;
+
+  /**
+   * @brief Open a writer on a file, which need not exist yet
+   *
+   * @param file_path
+   * @return TomlWriter::sptr
+   */
+  static sptr construct(const ghc::filesystem::path &file_path);
+
+  /**
+   * @brief Destroy the TomlWriter object, flushing pending components
+   */
+  ~TomlWriter();
+
+  /**
+   * @brief Check a component is already in the file or pending
+   *
+   * @param component
+   * @return bool
+   */
+  bool has_component(const std::string &component) const;
+
+  /**
+   * @brief Buffer a component
+   *
+   * @param component
+   * @param data table of the form {component: {...}}
+   * @throws toml_error if the component is in the file or pending in this
+   * or another writer on the file
+   */
+  void add(const std::string &component, const toml::value &data);
+
+  /**
+   * @brief Buffer a component of the form {type = parameter, value = value}
+   *
+   * @tparam T
+   * @param parameter type of the component, e.g. "point-estimate"
+   * @param component
+   * @param value
+   */
+  template <typename T>
+  void add_parameter(const std::string &parameter,
+                     const std::string &component, const T &value) {
+    const toml::value data_{
+        {component, {{"type", parameter}, {"value", value}}}};
+    add(component, data_);
+  }
+
+  /**
+   * @brief Number of components waiting to be flushed
+   *
+   * @return std::size_t
+   */
+  std::size_t pending() const { return pending_.size(); }
+
+  /**
+   * @brief Append all pending components to the file in one write
+   *
+   * If the write fails, any partial append is cut from the file and the
+   * pending components are dropped.
+   *
+   * @return ghc::filesystem::path
+   * @throws toml_error if the file cannot be written
+   */
+  ghc::filesystem::path flush();
+
+  /**
+   * @brief Drop all pending components without writing them
+   */
+  void discard();
+
+  const ghc::filesystem::path &get_path() const { return file_path_; }
+
+  struct ComponentIndex;
+
+private:
+  explicit TomlWriter(const ghc::filesystem::path &file_path);
+
+  TomlWriter(const TomlWriter &rhs) = delete;
+  TomlWriter &operator=(const TomlWriter &rhs) = delete;
+
+  ghc::filesystem::path file_path_;
+  std::shared_ptr<ComponentIndex> index_;
+  std::set<std::string> pending_;
+  std::ostringstream buffer_;
+};
+
+}; // namespace FairDataPipeline
+
+#endif
@@ -0,0 +1,73 @@
+#include "fdp/async.hxx"
+
+#include <limits>
+
+#include "fdp/utilities/logging.hxx"
+#include "fdp/utilities/parallel.hxx"
+
+namespace FairDataPipeline {
+namespace coro {
+
+ThreadPoolExecutor::ThreadPoolExecutor(unsigned int n_threads)
+    : state_(std::make_shared<State>()) {
+  n_threads = resolve_thread_count(n_threads,
+                                   std::numeric_limits<std::size_t>::max());
+  threads_.reserve(n_threads);
+  for (unsigned int i = 0; i < n_threads; ++i) {
+    threads_.emplace_back(&ThreadPoolExecutor::run_, state_);
+  }
+}
+
+ThreadPoolExecutor::sptr ThreadPoolExecutor::construct(unsigned int n_threads) {
+  return sptr(new ThreadPoolExecutor(n_threads));
+}
+
+ThreadPoolExecutor::~ThreadPoolExecutor() {
+  {
+    std::lock_guard<std::mutex> lock_(state_->mutex);
+    state_->stopping = true;
+  }
+  state_->cv.notify_all();
+  for (std::thread &thread_ : threads_) {
+    if (thread_.get_id() == std::this_thread::get_id()) {
+      // Destroyed from one of our own tasks, the thread keeps the state alive
+      thread_.detach();
+    } else {
+      thread_.join();
+    }
+  }
+}
+
+void ThreadPoolExecutor::post(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock_(state_->mutex);
+    state_->tasks.push_back(std::move(task));
+  }
+  state_->cv.notify_one();
+}
+
+void ThreadPoolExecutor::run_(std::shared_ptr<State> state) {
+  for (;;) {
+    std::function<void()> task_;
+    {
+      std::unique_lock<std::mutex> lock_(state->mutex);
+      state->cv.wait(lock_, [&state]() {
+        return state->stopping || !state->tasks.empty();
+      });
+      if (state->tasks.empty()) {
+        return;
+      }
+      task_ = std::move(state->tasks.front());
+      state->tasks.pop_front();
+    }
+    try {
+      task_();
+    } catch (const std::exception &e) {
+      logger::get_logger()->error()
+          << "ThreadPoolExecutor: Task threw: " << e.what();
+    }
+  }
+}
+
+} // namespace coro
+}; // namespace FairDataPipeline
@@ -39,13 +39,25 @@ namespace FairDataPipeline {
       impl(const ghc::filesystem::path &config_file_path,
           const ghc::filesystem::path &file_system_path,
           const std::string& token,
-          RESTAPI api_location = RESTAPI::LOCAL);
+          RESTAPI api_location = RESTAPI::LOCAL,
+          int session_rank = 0,
+          int session_size = 1,
+          const std::string &session_id = "");
+
+      explicit impl(Config::sptr config) : config_(config) {}
 
       impl(const impl &dp) = delete;
       impl& operator=(const impl& ) = delete;
 
   public:
       typedef std::shared_ptr< impl > sptr;
+
+  /**
+   * @brief construct a DataPipelineImpl_ instance around an existing session
+   *
+   * @param config the session
+   */
+  static sptr construct(Config::sptr config) { return sptr( new impl( config ) ); }
   
   /*! *************************************************************************
    * @brief construct a DataPipelineImpl_ instance from configurations and setup
@@ -54,11 +66,17 @@ namespace FairDataPipeline {
    * @param access_token_file API authorisation token where required
    * @param log_level level for the output logging statements
    * @param api_location whether to use local/remote RestAPI endpoint
+   * @param session_rank rank of this process in a shared session
+   * @param session_size number of processes in a shared session
+   * @param session_id identifier of the shared session
    ***************************************************************************/
   static sptr construct(const ghc::filesystem::path &config_file_path,
           const ghc::filesystem::path &file_system_path,
           const std::string& token,
-          RESTAPI api_location = RESTAPI::LOCAL);
+          RESTAPI api_location = RESTAPI::LOCAL,
+          int session_rank = 0,
+          int session_size = 1,
+          const std::string &session_id = "");
 
 
 
@@ -88,6 +106,29 @@ namespace FairDataPipeline {
 
   ghc::filesystem::path link_write(std::string &data_product);
 
+  /**
+   * @brief Return paths to many data products, see Config::link_read_many
+   * 
+   * @param data_products 
+   * @param errors 
+   * @return std::vector<ghc::filesystem::path> 
+   */
+  std::vector<ghc::filesystem::path> link_read_many(
+      const std::vector<std::string> &data_products,
+      std::vector<std::exception_ptr> &errors);
+
+  /**
+   * @brief Return paths to be used for many data products, see
+   * Config::link_write_many
+   * 
+   * @param data_products 
+   * @param errors 
+   * @return std::vector<ghc::filesystem::path> 
+   */
+  std::vector<ghc::filesystem::path> link_write_many(
+      const std::vector<std::string> &data_products,
+      std::vector<std::exception_ptr> &errors);
+
   /**
    * @brief Finalise the pipeline
    * Record all data products and meta data to the registry
@@ -96,6 +137,13 @@ namespace FairDataPipeline {
    */
   void finalise();
 
+  /**
+   * @brief Get the progress of finalise
+   * 
+   * @return Config::FinaliseProgress 
+   */
+  Config::FinaliseProgress get_finalise_progress() const;
+
   /**
    * @brief Get the code run uuid
    * 
@@ -107,22 +155,32 @@ namespace FairDataPipeline {
 DataPipeline::impl::sptr DataPipeline::impl::construct(const ghc::filesystem::path &config_file_path,
                     const ghc::filesystem::path &script_file_path,
                     const std::string& token,
-                    RESTAPI api_location)
+                    RESTAPI api_location,
+                    int session_rank,
+                    int session_size,
+                    const std::string &session_id)
 {
 
     sptr pobj = impl::sptr( new impl( config_file_path,
                     script_file_path,
                     token,
-                    api_location ) );
+                    api_location,
+                    session_rank,
+                    session_size,
+                    session_id ) );
     return pobj;
 }
 
 DataPipeline::impl::impl(const ghc::filesystem::path &config_file_path,
                     const ghc::filesystem::path &script_file_path,
                     const std::string& token,
-                    RESTAPI api_location)
+                    RESTAPI api_location,
+                    int session_rank,
+                    int session_size,
+                    const std::string &session_id)
 {
-    this->config_  = Config::construct(config_file_path, script_file_path, token, api_location);
+    this->config_  = Config::construct(config_file_path, script_file_path, token, api_location,
+                    session_rank, session_size, session_id);
 
     const std::string api_root_ = config_->get_api_url();
 
@@ -140,10 +198,24 @@ ghc::filesystem::path FairDataPipeline::DataPipeline::impl::link_read(std::strin
 ghc::filesystem::path FairDataPipeline::DataPipeline::impl::link_write(std::string &data_product){
     return config_->link_write(data_product);
 }
+std::vector<ghc::filesystem::path> FairDataPipeline::DataPipeline::impl::link_read_many(
+    const std::vector<std::string> &data_products,
+    std::vector<std::exception_ptr> &errors){
+    return config_->link_read_many(data_products, errors);
+}
+std::vector<ghc::filesystem::path> FairDataPipeline::DataPipeline::impl::link_write_many(
+    const std::vector<std::string> &data_products,
+    std::vector<std::exception_ptr> &errors){
+    return config_->link_write_many(data_products, errors);
+}
 void FairDataPipeline::DataPipeline::impl::finalise(){
     config_->finalise();
 }
 
+FairDataPipeline::Config::FinaliseProgress FairDataPipeline::DataPipeline::impl::get_finalise_progress() const{
+    return config_->get_finalise_progress();
+}
+
 std::string FairDataPipeline::DataPipeline::impl::get_code_run_uuid() const { 
     return config_->get_code_run_uuid();
 }
@@ -161,17 +233,43 @@ DataPipeline::sptr DataPipeline::construct(
     token ) );
 }
 
+DataPipeline::sptr DataPipeline::construct_shared(
+        const std::string &config_file_path,
+        const std::string &script_file_path,
+        std::string token,
+        int session_rank,
+        int session_size,
+        const std::string &session_id )
+{
+   return DataPipeline::sptr( new DataPipeline(
+    config_file_path,
+    script_file_path,
+    token,
+    session_rank,
+    session_size,
+    session_id ) );
+}
+
 
 DataPipeline::DataPipeline(
         const std::string &config_file_path,
         const std::string &script_file_path,
-        std::string token )
-: pimpl_( DataPipeline::impl::construct(ghc::filesystem::path(config_file_path), ghc::filesystem::path(script_file_path), token )) 
+        std::string token,
+        int session_rank,
+        int session_size,
+        const std::string &session_id )
+: pimpl_( DataPipeline::impl::construct(ghc::filesystem::path(config_file_path), ghc::filesystem::path(script_file_path), token,
+        RESTAPI::LOCAL, session_rank, session_size, session_id )) 
 {
     logger::get_logger()->debug() << "DataPipeline: Initialising session '" 
         << pimpl_->get_code_run_uuid() << "'";
 }
 
+DataPipeline::DataPipeline(std::shared_ptr< DataPipeline::impl > pimpl)
+: pimpl_( pimpl )
+{
+}
+
 std::string FairDataPipeline::DataPipeline::link_read(std::string &data_product){
     return pimpl_->link_read(data_product).string();
 }
@@ -180,10 +278,116 @@ std::string FairDataPipeline::DataPipeline::link_write(std::string &data_product
     return pimpl_->link_write(data_product).string();
 }
 
+namespace {
+std::vector<std::string> batch_result_(
+    const std::vector<ghc::filesystem::path> &paths,
+    std::vector<std::exception_ptr> &item_errors,
+    std::vector<std::exception_ptr> *errors){
+  if (errors) {
+    errors->swap(item_errors);
+  }
+  else {
+    // Every product has been linked by now, report the first failure
+    for (const std::exception_ptr &error_ : item_errors) {
+      if (error_) {
+        std::rethrow_exception(error_);
+      }
+    }
+  }
+  std::vector<std::string> result_;
+  result_.reserve(paths.size());
+  for (const ghc::filesystem::path &path_ : paths) {
+    result_.push_back(path_.string());
+  }
+  return result_;
+}
+} // namespace
+
+std::vector<std::string> FairDataPipeline::DataPipeline::link_read_many(
+    const std::vector<std::string> &data_products,
+    std::vector<std::exception_ptr> *errors){
+    std::vector<std::exception_ptr> item_errors_;
+    const std::vector<ghc::filesystem::path> paths_ =
+        pimpl_->link_read_many(data_products, item_errors_);
+    return batch_result_(paths_, item_errors_, errors);
+}
+
+std::vector<std::string> FairDataPipeline::DataPipeline::link_write_many(
+    const std::vector<std::string> &data_products,
+    std::vector<std::exception_ptr> *errors){
+    std::vector<std::exception_ptr> item_errors_;
+    const std::vector<ghc::filesystem::path> paths_ =
+        pimpl_->link_write_many(data_products, item_errors_);
+    return batch_result_(paths_, item_errors_, errors);
+}
+
 void FairDataPipeline::DataPipeline::finalise(){
     pimpl_->finalise();
 }
 
+FairDataPipeline::DataPipeline::FinaliseProgress FairDataPipeline::DataPipeline::get_finalise_progress() const{
+    const Config::FinaliseProgress config_progress_ = pimpl_->get_finalise_progress();
+    FinaliseProgress progress_;
+    progress_.outputs_total = config_progress_.outputs_total;
+    progress_.outputs_hashed = config_progress_.outputs_hashed;
+    progress_.outputs_registered = config_progress_.outputs_registered;
+    progress_.registry_calls = config_progress_.registry_calls;
+    return progress_;
+}
+
+    /*! **************************************************************************
+     * @class PipelineContext::impl
+     * @brief private pointer-to-implementation class holding the session template
+     *
+     *****************************************************************************/
+    class PipelineContext::impl {
+
+  private:
+      Config::sptr template_;
+
+  public:
+      typedef std::shared_ptr< impl > sptr;
+
+      explicit impl(Config::sptr config_template) : template_(config_template) {}
+
+  /**
+   * @brief Create a session sharing the template's infrastructure
+   * 
+   * @return Config::sptr 
+   */
+      Config::sptr create_session() const { return template_->create_session(); }
+};
+
+PipelineContext::sptr PipelineContext::construct(
+        const std::string &config_file_path,
+        const std::string &script_file_path,
+        std::string token )
+{
+   return PipelineContext::sptr( new PipelineContext(
+    config_file_path,
+    script_file_path,
+    token ) );
+}
+
+PipelineContext::PipelineContext(
+        const std::string &config_file_path,
+        const std::string &script_file_path,
+        std::string token )
+: pimpl_( std::make_shared< PipelineContext::impl >( Config::construct_template(
+        ghc::filesystem::path(config_file_path), ghc::filesystem::path(script_file_path),
+        token, RESTAPI::LOCAL ) ) )
+{
+    logger::get_logger()->debug() << "PipelineContext: Initialised from '"
+        << config_file_path << "'";
+}
+
+PipelineContext::~PipelineContext() = default;
+
+DataPipeline::sptr PipelineContext::create_session() const {
+    return DataPipeline::sptr( new DataPipeline(
+        DataPipeline::impl::construct( pimpl_->create_session() ) ) );
+}
+
 
 
 
@@ -1,21 +1,58 @@
 #include <algorithm>
+#include <cstdio>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
 #include <cstring>
+#include <exception>
+#include <future>
 #include <map>
+#include <sstream>
+#include <mutex>
 #include <string>
+#include <system_error>
 #include <utility>
+#include <vector>
 
 #include "fdp/exceptions.hxx"
 #include "fdp/fdp.h"
 #include "fdp/fdp.hxx"
+#include "fdp/objects/distribution.hxx"
+#include "fdp/utilities/data_io.hxx"
 #include "fdp/utilities/logging.hxx"
 
 namespace FDP = FairDataPipeline;
 
 // Define FdpDataPipeline struct and conversion routines
 
+/**
+ * @brief Outcome of a finalise run on a background thread
+ *
+ * The error message is recorded on the background thread, so it is carried
+ * back to the thread which polls or waits.
+ */
+struct FdpFinaliseResult {
+  FdpError err;
+  std::string message;
+};
+
+// Calls on one FdpDataPipeline may be made concurrently: the pipeline itself
+// is thread safe, and the finalise state below is guarded by _finalise_mutex
 struct FdpDataPipeline {
+  explicit FdpDataPipeline(FDP::DataPipeline::sptr pipeline)
+      : _pipeline(pipeline), _finalise(), _finalising(false), _pollers(0),
+        _waiting(false) {}
+
   FDP::DataPipeline::sptr _pipeline;
+  std::mutex _finalise_mutex;
+  std::shared_future<FdpFinaliseResult> _finalise;
+  // fdp_finalise is running, the finalise_* calls are rejected
+  bool _finalising;
+  // fdp_finalise_poll calls in progress, fdp_finalise_wait lets them return
+  // before it deletes the pipeline and rejects any started after it
+  int _pollers;
+  bool _waiting;
+  std::condition_variable _pollers_done;
 };
 
 FDP::DataPipeline::sptr FDP::from_c_struct(FdpDataPipeline *data_pipeline) {
@@ -23,13 +60,77 @@ FDP::DataPipeline::sptr FDP::from_c_struct(FdpDataPipeline *data_pipeline) {
 }
 
 FdpDataPipeline *FDP::to_c_struct(FDP::DataPipeline::sptr data_pipeline) {
-  return new FdpDataPipeline{data_pipeline};
+  return new FdpDataPipeline(data_pipeline);
 }
 
 void FDP::delete_c_struct(FdpDataPipeline *data_pipeline) {
   delete data_pipeline;
 }
 
+namespace {
+/**
+ * @brief Get error name from error code
+ */
+const char *error_name(FdpError err) {
+  switch (err) {
+  case FDP_ERR_NONE:
+    return "None";
+  case FDP_ERR_CONFIG_PARSE:
+    return "Config Parse";
+  case FDP_ERR_REST_API_QUERY:
+    return "REST API Query";
+  case FDP_ERR_JSON_PARSE:
+    return "JSON Parse";
+  case FDP_ERR_VALIDATION:
+    return "Validation";
+  case FDP_ERR_SYNC:
+    return "Sync";
+  case FDP_ERR_WRITE:
+    return "Write";
+  case FDP_ERR_TOML:
+    return "TOML";
+  default:
+    return "Other";
+  }
+}
+
+/**
+ * @brief Message of the last failed call on each thread
+ *
+ * A fixed buffer, so recording an error never allocates and the pointer
+ * returned by fdp_last_error_message stays valid until the next failure.
+ */
+thread_local char last_error_message[1024] = "";
+
+/**
+ * @brief Record the message of a failed call for fdp_last_error_message
+ *
+ * @return The error code, unchanged
+ */
+FdpError record_error(FdpError err, const char *msg) {
+  snprintf(last_error_message, sizeof(last_error_message), "%s error: %s",
+           error_name(err), msg);
+  return err;
+}
+
+/**
+ * @brief Log an error raised by the C API itself and record its message
+ *
+ * @param err Error code to return.
+ *
+ * @param msg_parts Values streamed, in order, to form the message.
+ *
+ * @return The error code, unchanged
+ */
+template <typename... MsgParts>
+FdpError log_error(FdpError err, MsgParts &&... msg_parts) {
+  std::ostringstream msg;
+  int expand[] = {0, ((msg << std::forward<MsgParts>(msg_parts)), 0)...};
+  (void)expand;
+  FDP::logger::get_logger()->error() << msg.str();
+  return record_error(err, msg.str().c_str());
+}
+
 /**
  * @brief Utility method, calls exception-raising function and returns error
  * codes
@@ -59,22 +160,24 @@ FdpError exception_to_err_code(Function &&function, Return &ret,
   try {
     ret = std::forward<Function>(function)(std::forward<Args>(args)...);
     return FDP_ERR_NONE;
-  } catch (const FDP::config_parsing_error &) {
-    return FDP_ERR_CONFIG_PARSE;
-  } catch (const FDP::rest_apiquery_error &) {
-    return FDP_ERR_REST_API_QUERY;
-  } catch (const FDP::json_parse_error &) {
-    return FDP_ERR_JSON_PARSE;
-  } catch (const FDP::validation_error &) {
-    return FDP_ERR_VALIDATION;
-  } catch (const FDP::sync_error &) {
-    return FDP_ERR_SYNC;
-  } catch (const FDP::write_error &) {
-    return FDP_ERR_WRITE;
-  } catch (const FDP::toml_error &) {
-    return FDP_ERR_TOML;
+  } catch (const FDP::config_parsing_error &e) {
+    return record_error(FDP_ERR_CONFIG_PARSE, e.what());
+  } catch (const FDP::rest_apiquery_error &e) {
+    return record_error(FDP_ERR_REST_API_QUERY, e.what());
+  } catch (const FDP::json_parse_error &e) {
+    return record_error(FDP_ERR_JSON_PARSE, e.what());
+  } catch (const FDP::validation_error &e) {
+    return record_error(FDP_ERR_VALIDATION, e.what());
+  } catch (const FDP::sync_error &e) {
+    return record_error(FDP_ERR_SYNC, e.what());
+  } catch (const FDP::write_error &e) {
+    return record_error(FDP_ERR_WRITE, e.what());
+  } catch (const FDP::toml_error &e) {
+    return record_error(FDP_ERR_TOML, e.what());
+  } catch (const std::exception &e) {
+    return record_error(FDP_ERR_OTHER, e.what());
   } catch (...) {
-    return FDP_ERR_OTHER;
+    return record_error(FDP_ERR_OTHER, "unknown exception");
   }
 }
 
@@ -91,42 +194,7 @@ FdpError exception_to_err_code_void(Function &&function, Args &&... args) {
       },
       dummy);
 }
-
-/**
- * @brief Get error name from error code
- */
-std::string error_name(FdpError err) {
-  std::string result;
-  switch (err) {
-  FDP_ERR_NONE:
-    result = "None";
-    break;
-  FDP_ERR_CONFIG_PARSE:
-    result = "Config Parse";
-    break;
-  FDP_ERR_REST_API_QUERY:
-    result = "REST API Query";
-    break;
-  FDP_ERR_JSON_PARSE:
-    result = "JSON Parse";
-    break;
-  FDP_ERR_VALIDATION:
-    result = "Validation";
-    break;
-  FDP_ERR_SYNC:
-    result = "Sync";
-    break;
-  FDP_ERR_WRITE:
-    result = "Write";
-    break;
-  FDP_ERR_TOML:
-    result = "TOML";
-    break;
-  default:
-    result = "Other";
-  }
-  return result;
-}
+} // namespace
 
 // =================
 // init and finalise
@@ -137,8 +205,12 @@ FdpError fdp_init(FdpDataPipeline **data_pipeline, const char *config_file_path,
   std::string token_str = (token == nullptr ? "" : token);
   FDP::DataPipeline::sptr cpp_data_pipeline;
   FdpError err = exception_to_err_code(
-      FDP::DataPipeline::construct, cpp_data_pipeline,
-      std::string(config_file_path), std::string(script_file_path), token_str);
+      [](const std::string &config, const std::string &script,
+         const std::string &token) {
+        return FDP::DataPipeline::construct(config, script, token);
+      },
+      cpp_data_pipeline, std::string(config_file_path),
+      std::string(script_file_path), token_str);
   if (err) {
     // Trust that the C++ API logged the error before throwing
     *data_pipeline = nullptr;
@@ -150,22 +222,164 @@ FdpError fdp_init(FdpDataPipeline **data_pipeline, const char *config_file_path,
 
 FdpError fdp_finalise(FdpDataPipeline **data_pipeline) {
   if (*data_pipeline == nullptr || (*data_pipeline)->_pipeline == nullptr) {
-    FDP::logger::get_logger()->error()
-        << "Pipeline not initialiased in call to fdp_finalise";
-    return FDP_ERR_OTHER;
+    return log_error(FDP_ERR_OTHER,
+                     "Pipeline not initialiased in call to fdp_finalise");
+  }
+  {
+    std::lock_guard<std::mutex> lock((*data_pipeline)->_finalise_mutex);
+    if ((*data_pipeline)->_finalise.valid()) {
+      return log_error(FDP_ERR_OTHER,
+          "fdp_finalise_start already called, use fdp_finalise_wait");
+    }
+    if ((*data_pipeline)->_finalising) {
+      return log_error(FDP_ERR_OTHER, "fdp_finalise already called");
+    }
+    // Recorded before the lock is released, so a concurrent
+    // fdp_finalise_start cannot finalise the pipeline a second time
+    (*data_pipeline)->_finalising = true;
   }
   FdpError err = exception_to_err_code_void(
       [](FDP::DataPipeline::sptr pipeline) { pipeline->finalise(); },
       (*data_pipeline)->_pipeline);
-  if (err) {
-    // Trust that the C++ API logged the error before throwing
-    return err;
+  // Trust that the C++ API logged any error before throwing. A failed
+  // finalise may have stored or registered some outputs, so it is not
+  // retried and the pipeline is released either way
+  FDP::delete_c_struct(*data_pipeline);
+  *data_pipeline = nullptr;
+  return err;
+}
+
+namespace {
+/**
+ * @brief Record the error of a background finalise on the calling thread
+ *
+ * @return The error code of the finalise
+ */
+FdpError restore_error(const FdpFinaliseResult &result) {
+  if (result.err) {
+    snprintf(last_error_message, sizeof(last_error_message), "%s",
+             result.message.c_str());
+  }
+  return result.err;
+}
+} // namespace
+
+FdpError fdp_finalise_start(FdpDataPipeline *data_pipeline) {
+  if (data_pipeline == nullptr || data_pipeline->_pipeline == nullptr) {
+    return log_error(FDP_ERR_OTHER, "Pipeline not initialiased in call to ",
+                     "fdp_finalise_start");
+  }
+  std::lock_guard<std::mutex> lock(data_pipeline->_finalise_mutex);
+  if (data_pipeline->_finalise.valid() || data_pipeline->_finalising) {
+    return log_error(FDP_ERR_OTHER, "Finalise already started in call to ",
+                     "fdp_finalise_start");
+  }
+  FDP::DataPipeline::sptr pipeline = data_pipeline->_pipeline;
+  try {
+    data_pipeline->_finalise =
+        std::async(std::launch::async, [pipeline]() {
+          FdpFinaliseResult result;
+          result.err = exception_to_err_code_void(
+              [](FDP::DataPipeline::sptr pipeline) { pipeline->finalise(); },
+              pipeline);
+          if (result.err) {
+            result.message = last_error_message;
+          }
+          return result;
+        }).share();
+  } catch (const std::system_error &e) {
+    return log_error(FDP_ERR_OTHER, "Could not start finalise thread: ",
+                     e.what());
+  }
+  return FDP_ERR_NONE;
+}
+
+FdpError fdp_finalise_poll(FdpDataPipeline *data_pipeline,
+                           FdpFinaliseProgress *progress) {
+  if (data_pipeline == nullptr || data_pipeline->_pipeline == nullptr) {
+    return log_error(FDP_ERR_OTHER, "Pipeline not initialiased in call to ",
+                     "fdp_finalise_poll");
+  }
+  std::shared_future<FdpFinaliseResult> finalise;
+  {
+    std::lock_guard<std::mutex> lock(data_pipeline->_finalise_mutex);
+    if (data_pipeline->_waiting) {
+      return log_error(FDP_ERR_OTHER, "fdp_finalise_wait already called ",
+                       "in call to fdp_finalise_poll");
+    }
+    if (data_pipeline->_finalising) {
+      return log_error(FDP_ERR_OTHER, "fdp_finalise already called ",
+                       "in call to fdp_finalise_poll");
+    }
+    finalise = data_pipeline->_finalise;
+    if (finalise.valid()) {
+      ++data_pipeline->_pollers;
+    }
+  }
+  if (!finalise.valid()) {
+    return log_error(FDP_ERR_OTHER,
+                     "Finalise not started in call to fdp_finalise_poll");
+  }
+  const bool done = finalise.wait_for(std::chrono::seconds(0)) ==
+                    std::future_status::ready;
+  if (progress != nullptr) {
+    const FDP::DataPipeline::FinaliseProgress cpp_progress =
+        data_pipeline->_pipeline->get_finalise_progress();
+    progress->outputs_total = cpp_progress.outputs_total;
+    progress->outputs_hashed = cpp_progress.outputs_hashed;
+    progress->outputs_registered = cpp_progress.outputs_registered;
+    progress->registry_calls = cpp_progress.registry_calls;
+    progress->done = done ? 1 : 0;
+  }
+  const FdpError err = done ? restore_error(finalise.get()) : FDP_ERR_NONE;
+  {
+    // Notified under the lock, so a waiter cannot delete the pipeline
+    // before this call has finished with it
+    std::lock_guard<std::mutex> lock(data_pipeline->_finalise_mutex);
+    --data_pipeline->_pollers;
+    data_pipeline->_pollers_done.notify_all();
+  }
+  return err;
+}
+
+FdpError fdp_finalise_wait(FdpDataPipeline **data_pipeline) {
+  if (data_pipeline == nullptr || *data_pipeline == nullptr ||
+      (*data_pipeline)->_pipeline == nullptr) {
+    return log_error(FDP_ERR_OTHER, "Pipeline not initialiased in call to ",
+                     "fdp_finalise_wait");
+  }
+  std::shared_future<FdpFinaliseResult> finalise;
+  {
+    std::lock_guard<std::mutex> lock((*data_pipeline)->_finalise_mutex);
+    if ((*data_pipeline)->_finalising) {
+      return log_error(FDP_ERR_OTHER, "fdp_finalise already called ",
+                       "in call to fdp_finalise_wait");
+    }
+    finalise = (*data_pipeline)->_finalise;
+    if (finalise.valid() && (*data_pipeline)->_waiting) {
+      return log_error(FDP_ERR_OTHER, "fdp_finalise_wait already called ",
+                       "in call to fdp_finalise_wait");
+    }
+    (*data_pipeline)->_waiting = finalise.valid();
+  }
+  if (!finalise.valid()) {
+    return log_error(FDP_ERR_OTHER,
+                     "Finalise not started in call to fdp_finalise_wait");
+  }
+  // Trust that the C++ API logged any error before throwing. As in
+  // fdp_finalise, a failed finalise is not retried
+  FdpError err = restore_error(finalise.get());
+  {
+    std::unique_lock<std::mutex> lock((*data_pipeline)->_finalise_mutex);
+    (*data_pipeline)->_pollers_done.wait(
+        lock, [data_pipeline]() { return (*data_pipeline)->_pollers == 0; });
   }
   FDP::delete_c_struct(*data_pipeline);
   *data_pipeline = nullptr;
   return err;
 }
 
+namespace {
 template <typename LinkFunction>
 FdpError _fdp_link(LinkFunction &&link_function,
                    const std::string &link_function_name,
@@ -173,26 +387,23 @@ FdpError _fdp_link(LinkFunction &&link_function,
                    char *output, size_t output_len) {
   // Ensure pipeline is initialised
   if (data_pipeline == nullptr || data_pipeline->_pipeline == nullptr) {
-    FDP::logger::get_logger()->error()
-        << " Data pipeline not initialised in call to " << link_function_name;
-    return FDP_ERR_OTHER;
+    return log_error(FDP_ERR_OTHER,
+                     " Data pipeline not initialised in call to ",
+                     link_function_name);
   }
   // Ensure input and output paths are valid
   if (path == nullptr) {
-    FDP::logger::get_logger()->error()
-        << "Input path is NULL in call to " << link_function_name;
-    return FDP_ERR_OTHER;
+    return log_error(FDP_ERR_OTHER, "Input path is NULL in call to ",
+                     link_function_name);
   }
   if (output == nullptr) {
-    FDP::logger::get_logger()->error()
-        << "Output path is NULL in call to " << link_function_name;
-    return FDP_ERR_OTHER;
+    return log_error(FDP_ERR_OTHER, "Output path is NULL in call to ",
+                     link_function_name);
   }
   // Check output len is valid
   if (output_len == 0) {
-    FDP::logger::get_logger()->error()
-        << "output_len is zero in call to " << link_function_name;
-    return FDP_ERR_OTHER;
+    return log_error(FDP_ERR_OTHER, "output_len is zero in call to ",
+                     link_function_name);
   }
   // Check input is null terminated, max 4096 chars, including terminator
   // TODO Should we check MAX_PATH/PATH_MAX here?
@@ -206,11 +417,10 @@ FdpError _fdp_link(LinkFunction &&link_function,
     }
   }
   if (!path_null_terminated) {
-    FDP::logger::get_logger()->error()
-        << "Input path is not null-terminated or is longer than 4095 chars in "
-           "call to "
-        << link_function_name;
-    return FDP_ERR_OTHER;
+    return log_error(FDP_ERR_OTHER,
+                     "Input path is not null-terminated or is longer than "
+                     "4095 chars in call to ",
+                     link_function_name);
   }
   // Check input and output don't overlap
   auto x1 = reinterpret_cast<std::uintptr_t>(path);
@@ -218,9 +428,9 @@ FdpError _fdp_link(LinkFunction &&link_function,
   auto y1 = reinterpret_cast<std::uintptr_t>(output);
   auto y2 = y1 + output_len;
   if (std::max(x1, y1) <= std::min(x2, y2)) {
-    FDP::logger::get_logger()->error()
-        << "Input and output paths overlap in call to " << link_function_name;
-    return FDP_ERR_OTHER;
+    return log_error(FDP_ERR_OTHER,
+                     "Input and output paths overlap in call to ",
+                     link_function_name);
   }
   // Use C++ strings over C strings to interface with the C++ pipeline
   std::string input_path = path;
@@ -236,13 +446,14 @@ FdpError _fdp_link(LinkFunction &&link_function,
   // Don't copy if output_path won't fit in output buffer
   // Use >= instead of > to account for null terminator
   if (output_path.size() >= output_len) {
-    FDP::logger::get_logger()->error()
-        << "Output path won't fit in buffer in call to " << link_function_name;
-    return FDP_ERR_OTHER;
+    return log_error(FDP_ERR_OTHER,
+                     "Output path won't fit in buffer in call to ",
+                     link_function_name);
   }
   strncpy(output, output_path.c_str(), output_len);
   return FDP_ERR_NONE;
 }
+} // namespace
 
 FdpError fdp_link_read(FdpDataPipeline *data_pipeline, const char *path,
                        char *output, size_t output_len) {
@@ -262,6 +473,283 @@ FdpError fdp_link_write(FdpDataPipeline *data_pipeline, const char *path,
       "fdp_link_write", data_pipeline, path, output, output_len);
 }
 
+namespace {
+template <typename LinkManyFunction>
+FdpError _fdp_link_many(LinkManyFunction &&link_many_function,
+                        const std::string &link_function_name,
+                        FdpDataPipeline *data_pipeline,
+                        const char *const *paths, size_t n_paths,
+                        char **outputs, size_t output_len, FdpError *errors) {
+  if (data_pipeline == nullptr || data_pipeline->_pipeline == nullptr) {
+    return log_error(FDP_ERR_OTHER,
+                     " Data pipeline not initialised in call to ",
+                     link_function_name);
+  }
+  if (n_paths == 0) {
+    return FDP_ERR_NONE;
+  }
+  if (paths == nullptr || outputs == nullptr) {
+    return log_error(FDP_ERR_OTHER,
+                     "Input or output array is NULL in call to ",
+                     link_function_name);
+  }
+  if (output_len == 0) {
+    return log_error(FDP_ERR_OTHER, "output_len is zero in call to ",
+                     link_function_name);
+  }
+
+  // Invalid entries fail on their own, the rest of the batch is still linked
+  std::vector<FdpError> item_errors(n_paths, FDP_ERR_NONE);
+  std::vector<std::string> input_paths;
+  std::vector<size_t> input_index;
+  for (size_t ii = 0; ii < n_paths; ++ii) {
+    if (paths[ii] == nullptr || outputs[ii] == nullptr) {
+      item_errors[ii] = log_error(FDP_ERR_OTHER, "Entry ", ii,
+                                  " is NULL in call to ", link_function_name);
+      continue;
+    }
+    input_paths.push_back(paths[ii]);
+    input_index.push_back(ii);
+  }
+
+  std::vector<std::exception_ptr> cpp_errors;
+  std::vector<std::string> output_paths;
+  FdpError err = exception_to_err_code(
+      std::forward<LinkManyFunction>(link_many_function), output_paths,
+      data_pipeline->_pipeline, input_paths, &cpp_errors);
+  if (err) {
+    return err;
+  }
+
+  for (size_t jj = 0; jj < input_paths.size(); ++jj) {
+    const size_t ii = input_index[jj];
+    if (cpp_errors[jj]) {
+      // Trust that the C++ API logged the error before throwing
+      item_errors[ii] = exception_to_err_code_void(
+          [](const std::exception_ptr &e) { std::rethrow_exception(e); },
+          cpp_errors[jj]);
+    } else if (output_paths[jj].size() >= output_len) {
+      item_errors[ii] = log_error(FDP_ERR_OTHER, "Output path of entry ", ii,
+                                  " won't fit in buffer in call to ",
+                                  link_function_name);
+    } else {
+      strncpy(outputs[ii], output_paths[jj].c_str(), output_len);
+    }
+  }
+
+  FdpError first_err = FDP_ERR_NONE;
+  for (size_t ii = 0; ii < n_paths; ++ii) {
+    if (errors != nullptr) {
+      errors[ii] = item_errors[ii];
+    }
+    if (first_err == FDP_ERR_NONE) {
+      first_err = item_errors[ii];
+    }
+  }
+  return first_err;
+}
+} // namespace
+
+FdpError fdp_link_read_many(FdpDataPipeline *data_pipeline,
+                            const char *const *data_products,
+                            size_t n_data_products, char **data_store_paths,
+                            size_t data_store_path_len, FdpError *errors) {
+  return _fdp_link_many(
+      [](FDP::DataPipeline::sptr pipeline,
+         const std::vector<std::string> &paths,
+         std::vector<std::exception_ptr> *errors) {
+        return pipeline->link_read_many(paths, errors);
+      },
+      "fdp_link_read_many", data_pipeline, data_products, n_data_products,
+      data_store_paths, data_store_path_len, errors);
+}
+
+FdpError fdp_link_write_many(FdpDataPipeline *data_pipeline,
+                             const char *const *data_products,
+                             size_t n_data_products, char **data_store_paths,
+                             size_t data_store_path_len, FdpError *errors) {
+  return _fdp_link_many(
+      [](FDP::DataPipeline::sptr pipeline,
+         const std::vector<std::string> &paths,
+         std::vector<std::exception_ptr> *errors) {
+        return pipeline->link_write_many(paths, errors);
+      },
+      "fdp_link_write_many", data_pipeline, data_products, n_data_products,
+      data_store_paths, data_store_path_len, errors);
+}
+
+// ===============================
+// point estimates & distributions
+// ===============================
+
+namespace {
+/**
+ * @brief Check the C arrays passed to a batch function are not NULL
+ */
+bool valid_c_strings(const char *const *strings, size_t n_strings) {
+  if (strings == nullptr) {
+    return false;
+  }
+  for (size_t ii = 0; ii < n_strings; ++ii) {
+    if (strings[ii] == nullptr) {
+      return false;
+    }
+  }
+  return true;
+}
+} // namespace
+
+FdpError fdp_read_point_estimate(const char *file_path, const char *component,
+                                 double *value) {
+  if (file_path == nullptr || value == nullptr) {
+    return log_error(FDP_ERR_OTHER,
+                     "NULL argument in call to fdp_read_point_estimate");
+  }
+  return exception_to_err_code(
+      [file_path, component]() {
+        return component == nullptr
+                   ? FDP::read_point_estimate_from_toml(file_path)
+                   : FDP::read_point_estimate_from_toml(file_path, component);
+      },
+      *value);
+}
+
+FdpError fdp_write_point_estimate(const char *file_path, const char *component,
+                                  double value) {
+  if (file_path == nullptr || component == nullptr) {
+    return log_error(FDP_ERR_OTHER,
+                     "NULL argument in call to fdp_write_point_estimate");
+  }
+  return exception_to_err_code_void([file_path, component, &value]() {
+    FDP::write_point_estimate(value, component, file_path);
+  });
+}
+
+FdpError fdp_read_point_estimates(const char *file_path,
+                                  const char *const *components,
+                                  size_t n_components, double *values) {
+  if (file_path == nullptr || !valid_c_strings(components, n_components) ||
+      values == nullptr) {
+    return log_error(FDP_ERR_OTHER,
+                     "NULL argument in call to fdp_read_point_estimates");
+  }
+  const std::vector<std::string> components_vec(components,
+                                                components + n_components);
+  std::vector<double> values_vec;
+  FdpError err = exception_to_err_code(
+      [file_path, &components_vec]() {
+        return FDP::read_point_estimates_from_toml(file_path, components_vec);
+      },
+      values_vec);
+  if (!err) {
+    std::copy(values_vec.begin(), values_vec.end(), values);
+  }
+  return err;
+}
+
+FdpError fdp_write_point_estimates(const char *file_path,
+                                   const char *const *components,
+                                   const double *values, size_t n_components) {
+  if (file_path == nullptr || !valid_c_strings(components, n_components) ||
+      (values == nullptr && n_components > 0)) {
+    return log_error(FDP_ERR_OTHER,
+                     "NULL argument in call to fdp_write_point_estimates");
+  }
+  const std::vector<std::string> components_vec(components,
+                                                components + n_components);
+  const std::vector<double> values_vec(values, values + n_components);
+  return exception_to_err_code_void([file_path, &components_vec,
+                                     &values_vec]() {
+    FDP::write_point_estimates(components_vec, values_vec, file_path);
+  });
+}
+
+FdpError fdp_read_distribution(const char *file_path, const char *component,
+                               char *name, size_t name_len, double *mu,
+                               double *sigma) {
+  const char *components[] = {component};
+  if (component == nullptr) {
+    if (file_path == nullptr) {
+      return log_error(FDP_ERR_OTHER,
+                       "NULL argument in call to fdp_read_distribution");
+    }
+    std::string first;
+    FdpError err = exception_to_err_code(
+        [file_path]() { return FDP::get_first_component(file_path); }, first);
+    if (err) {
+      return err;
+    }
+    return fdp_read_distribution(file_path, first.c_str(), name, name_len, mu,
+                                 sigma);
+  }
+  char *names[] = {name};
+  return fdp_read_distributions(file_path, components, 1, names, name_len, mu,
+                                sigma);
+}
+
+FdpError fdp_write_distribution(const char *file_path, const char *component,
+                                const char *name, double mu, double sigma) {
+  const char *components[] = {component};
+  const char *names[] = {name};
+  return fdp_write_distributions(file_path, components, names, &mu, &sigma, 1);
+}
+
+FdpError fdp_read_distributions(const char *file_path,
+                                const char *const *components,
+                                size_t n_components, char **names,
+                                size_t name_len, double *mus, double *sigmas) {
+  if (file_path == nullptr || !valid_c_strings(components, n_components) ||
+      names == nullptr || mus == nullptr || sigmas == nullptr) {
+    return log_error(FDP_ERR_OTHER,
+                     "NULL argument in call to fdp_read_distributions");
+  }
+  const std::vector<std::string> components_vec(components,
+                                                components + n_components);
+  std::vector<FDP::Distribution> distributions;
+  FdpError err = exception_to_err_code(
+      [file_path, &components_vec]() {
+        return FDP::Distribution::read_many_from_toml(file_path,
+                                                      components_vec);
+      },
+      distributions);
+  if (err) {
+    return err;
+  }
+  for (size_t ii = 0; ii < n_components; ++ii) {
+    const std::string dist_name = distributions[ii].get_name();
+    if (names[ii] == nullptr || dist_name.size() >= name_len) {
+      return log_error(FDP_ERR_OTHER, "Name of distribution ", components[ii],
+                       " won't fit in buffer in call to "
+                       "fdp_read_distributions");
+    }
+    strncpy(names[ii], dist_name.c_str(), name_len);
+    mus[ii] = distributions[ii].get_mu();
+    sigmas[ii] = distributions[ii].get_sigma();
+  }
+  return FDP_ERR_NONE;
+}
+
+FdpError fdp_write_distributions(const char *file_path,
+                                 const char *const *components,
+                                 const char *const *names, const double *mus,
+                                 const double *sigmas, size_t n_components) {
+  if (file_path == nullptr || !valid_c_strings(components, n_components) ||
+      !valid_c_strings(names, n_components) ||
+      ((mus == nullptr || sigmas == nullptr) && n_components > 0)) {
+    return log_error(FDP_ERR_OTHER,
+                     "NULL argument in call to fdp_write_distributions");
+  }
+  std::vector<FDP::Distribution> distributions;
+  distributions.reserve(n_components);
+  for (size_t ii = 0; ii < n_components; ++ii) {
+    distributions.push_back(
+        FDP::Distribution(names[ii], mus[ii], sigmas[ii], components[ii]));
+  }
+  return exception_to_err_code_void([file_path, &distributions]() {
+    FDP::Distribution::write_many_to_toml(distributions, file_path);
+  });
+}
+
 // =======
 // logging
 // =======
@@ -269,7 +757,7 @@ FdpError fdp_link_write(FdpDataPipeline *data_pipeline, const char *path,
 /**
  * @brief Map converting C API logging enums to the C++ API
  */
-std::map<FdpLogLevel, FDP::logging::LOG_LEVEL> to_cpp_enum = {
+const std::map<FdpLogLevel, FDP::logging::LOG_LEVEL> to_cpp_enum = {
     {FDP_LOG_TRACE, FDP::logging::TRACE},
     {FDP_LOG_DEBUG, FDP::logging::DEBUG},
     {FDP_LOG_INFO, FDP::logging::INFO},
@@ -281,7 +769,7 @@ std::map<FdpLogLevel, FDP::logging::LOG_LEVEL> to_cpp_enum = {
 /**
  * @brief Map converting C++ API logging enums to the C API
  */
-std::map<FDP::logging::LOG_LEVEL, FdpLogLevel> to_c_enum = {
+const std::map<FDP::logging::LOG_LEVEL, FdpLogLevel> to_c_enum = {
     {FDP::logging::TRACE, FDP_LOG_TRACE},
     {FDP::logging::DEBUG, FDP_LOG_DEBUG},
     {FDP::logging::INFO, FDP_LOG_INFO},
@@ -290,14 +778,29 @@ std::map<FDP::logging::LOG_LEVEL, FdpLogLevel> to_c_enum = {
     {FDP::logging::CRITICAL, FDP_LOG_CRITICAL},
     {FDP::logging::OFF, FDP_LOG_OFF}};
 
+// The maps are only read, so these may be called from any thread
 void fdp_set_log_level(FdpLogLevel log_level) {
-  FDP::logger::get_logger()->set_level(to_cpp_enum[log_level]);
+  auto it = to_cpp_enum.find(log_level);
+  if (it == to_cpp_enum.end()) {
+    log_error(FDP_ERR_OTHER, "Invalid log level ", static_cast<int>(log_level),
+              " in call to fdp_set_log_level");
+    return;
+  }
+  FDP::logger::get_logger()->set_level(it->second);
 }
 
 FdpLogLevel fdp_get_log_level() {
-  return to_c_enum[FDP::logger::get_logger()->get_level()];
+  return to_c_enum.at(FDP::logger::get_logger()->get_level());
 }
 
+// ======
+// errors
+// ======
+
+const char *fdp_last_error_message() { return last_error_message; }
+
+const char *fdp_error_name(FdpError err) { return error_name(err); }
+
 int fdp_log(FdpLogLevel log_level, const char *msg) {
   switch (log_level) {
   case FDP_LOG_TRACE:
@@ -1,33 +1,159 @@
 #include "fdp/objects/config.hxx"
 
+#include <cstdlib>
+
+#include "fdp/utilities/arrow_table.hxx"
+#include "fdp/utilities/data_store.hxx"
+#include "fdp/utilities/hash_cache.hxx"
+#include "fdp/utilities/parallel.hxx"
+
 namespace FairDataPipeline {
 
+namespace {
+Json::Value io_object_to_json_(const IOObject &io) {
+  Json::Value j_;
+  j_["data_product"] = io.get_data_product();
+  j_["use_data_product"] = io.get_use_data_product();
+  j_["use_version"] = io.get_use_version();
+  j_["use_namespace"] = io.get_use_namespace();
+  j_["path"] = io.get_path().string();
+  j_["description"] = io.get_data_product_description();
+  j_["public"] = io.is_public();
+  j_["directory"] = io.is_directory();
+  if (io.get_component_object()) {
+    j_["component"] = io.get_component_object()->to_json();
+  }
+  if (io.get_data_product_object()) {
+    j_["data_product_object"] = io.get_data_product_object()->to_json();
+  }
+  return j_;
+}
+
+IOObject io_object_from_json_(const Json::Value &j) {
+  if (j.isMember("component")) {
+    return IOObject(j["data_product"].asString(),
+                    j["use_data_product"].asString(),
+                    j["use_version"].asString(),
+                    j["use_namespace"].asString(),
+                    ghc::filesystem::path(j["path"].asString()),
+                    *ApiObject::from_json(j["component"]),
+                    *ApiObject::from_json(j["data_product_object"]));
+  }
+  return IOObject(j["data_product"].asString(),
+                  j["use_data_product"].asString(),
+                  j["use_version"].asString(),
+                  j["use_namespace"].asString(),
+                  ghc::filesystem::path(j["path"].asString()),
+                  j["description"].asString(),
+                  j["public"].asBool(),
+                  j["directory"].asBool());
+}
+
+/**
+ * @brief Name to register for the file type of an output, by extension
+ * Formats written by the library get a descriptive name, so consumers can
+ * find outputs by format in the registry
+ */
+std::string file_type_name_(const std::string &extension) {
+  if (extension == std::string(".") + ArrowTable::file_type) {
+    return "Apache Arrow IPC";
+  }
+  return extension;
+}
+} // namespace
+
     Config::sptr Config::construct(const ghc::filesystem::path &config_file_path,
                     const ghc::filesystem::path &script_file_path,
                     const std::string &token,
-                    RESTAPI api_location)
+                    RESTAPI api_location,
+                    int session_rank,
+                    int session_size,
+                    const std::string &session_id)
     {
         Config::sptr pobj = Config::sptr( new Config( 
                     config_file_path
                     , script_file_path
                     , token
-                    , api_location ) );
+                    , api_location
+                    , session_rank
+                    , session_size
+                    , session_id ) );
         return pobj;
     }
 
 
 
+    Config::sptr Config::construct_template(const ghc::filesystem::path &config_file_path,
+                    const ghc::filesystem::path &script_file_path,
+                    const std::string &token,
+                    RESTAPI api_location)
+    {
+        Config::sptr pobj = Config::sptr( new Config( 
+                    config_file_path
+                    , script_file_path
+                    , token
+                    , api_location
+                    , 0
+                    , 1
+                    , ""
+                    , true ) );
+        return pobj;
+    }
+
+    Config::sptr Config::create_session() const
+    {
+        return Config::sptr( new Config( *this ) );
+    }
+
 FairDataPipeline::Config::Config(const ghc::filesystem::path &config_file_path,
                     const ghc::filesystem::path &script_file_path,
                     const std::string &token, 
-                    RESTAPI api_location)
-    : token_(token), config_file_path_(config_file_path), script_file_path_(script_file_path),
-    rest_api_location_(api_location) {
+                    RESTAPI api_location,
+                    int session_rank,
+                    int session_size,
+                    const std::string &session_id,
+                    bool is_template)
+    : config_file_path_(config_file_path), script_file_path_(script_file_path), token_(token),
+    run_date_(current_time_stamp()), is_template_(is_template),
+    session_rank_(session_rank), session_size_(session_size),
+    session_id_(session_id), rest_api_location_(api_location) {
   validate_config(config_file_path, api_location);
   initialise(api_location);
+  if (is_template_) {
+    pool_ = ThreadPool::construct();
+  }
 
     }
 
+FairDataPipeline::Config::Config(const Config &prototype)
+    : config_file_path_(prototype.config_file_path_),
+    config_dir_(prototype.config_dir_),
+    script_file_path_(prototype.script_file_path_),
+    api_url_(prototype.api_url_),
+    token_(prototype.token_),
+    api_(prototype.api_),
+    user_(prototype.user_),
+    author_(prototype.author_),
+    config_storage_root_(prototype.config_storage_root_),
+    config_storage_location_(prototype.config_storage_location_),
+    config_file_type_(prototype.config_file_type_),
+    config_obj_(prototype.config_obj_),
+    script_storage_root_(prototype.script_storage_root_),
+    script_storage_location_(prototype.script_storage_location_),
+    script_file_type_(prototype.script_file_type_),
+    script_obj_(prototype.script_obj_),
+    code_repo_storage_root_(prototype.code_repo_storage_root_),
+    code_repo_storage_location_(prototype.code_repo_storage_location_),
+    code_repo_obj_(prototype.code_repo_obj_),
+    run_date_(current_time_stamp()),
+    data_store_(prototype.data_store_),
+    pool_(prototype.pool_),
+    rest_api_location_(prototype.rest_api_location_) {
+  // Sessions must not share yaml-cpp node state with the prototype
+  std::lock_guard<std::mutex> lock_(prototype.config_mutex_);
+  config_data_ = YAML::Clone(prototype.config_data_);
+}
+
 Config::~Config() {
 }
 
@@ -72,11 +198,11 @@ bool FairDataPipeline::Config::has_reads() const{
 }
 
 bool FairDataPipeline::Config::has_inputs() const{
-  return ! inputs_.empty();
+  return reads_.count_registered() > 0;
 }
 
 bool FairDataPipeline::Config::has_outputs() const{
-  return ! outputs_.empty();
+  return writes_.count_registered() > 0;
 }
 
 ghc::filesystem::path FairDataPipeline::Config::get_data_store() const {
@@ -169,6 +295,15 @@ void FairDataPipeline::Config::validate_config(ghc::filesystem::path yaml_path,
     throw std::runtime_error("Submission script: " + script_file_path_.string() + " does not exist");
   }
 
+  if (meta_data_()["hash_algorithm"]) {
+    const std::string algorithm_ = meta_data_()["hash_algorithm"].as<std::string>();
+    if (algorithm_ != "sha1" && algorithm_ != "sha256-tree") {
+      logger::get_logger()->error()
+          << "Unrecognised hash_algorithm '" << algorithm_ << "' in " << yaml_path.string();
+      throw config_parsing_error("Unrecognised hash_algorithm '" + algorithm_ + "' in " + yaml_path.string());
+    }
+  }
+
   if(!meta_data_()["public"]){
     meta_data_()["public"] = "true";
   }
@@ -186,6 +321,30 @@ void FairDataPipeline::Config::validate_config(ghc::filesystem::path yaml_path,
 
 }
 
+std::string FairDataPipeline::Config::hash_data_product(const ghc::filesystem::path &file_path) const {
+  const std::string algorithm_ = meta_data_()["hash_algorithm"] ?
+      meta_data_()["hash_algorithm"].as<std::string>() : "sha1";
+  const unsigned int threads_ = meta_data_()["hash_threads"] ?
+      meta_data_()["hash_threads"].as<unsigned int>() : 0;
+
+  if (algorithm_ != "sha1" && algorithm_ != "sha256-tree") {
+    logger::get_logger()->error()
+        << "Config Error: Unrecognised hash_algorithm '" << algorithm_ << "'";
+    throw config_parsing_error("Config Error: Unrecognised hash_algorithm '" + algorithm_ + "'");
+  }
+  const bool tree_ = algorithm_ == "sha256-tree";
+
+  if (ghc::filesystem::is_directory(file_path)) {
+    return calculate_directory_hash(file_path, threads_, nullptr, algorithm_,
+                                    pool_.get());
+  }
+
+  // Default chunk size, only the pool differs from a standalone call
+  return tree_ ? calculate_tree_hash_from_file(file_path, threads_, 4194304,
+                                               pool_.get())
+               : calculate_hash_from_file(file_path);
+}
+
 void FairDataPipeline::Config::initialise(RESTAPI api_location) {
   // Set API URL
   if (api_location == RESTAPI::REMOTE) {
@@ -199,9 +358,55 @@ void FairDataPipeline::Config::initialise(RESTAPI api_location) {
   logger::get_logger()->info() << "Reading " 
       << config_file_path_.string()
       << " from local filestore";
+
+  // Persist file hashes in the data store so re-runs can skip re-hashing
+  HashCache::sptr hash_cache_ = HashCache::get_cache();
+  hash_cache_->set_database_path(
+      ghc::filesystem::path(remove_local_from_root(get_data_store().string())) /
+      ".fdp" / "hash_cache");
+  // FDP_STRICT_HASH takes precedence over the config
+  bool strict_from_environment_ = false;
+  if (meta_data_()["strict_hash"] &&
+      !HashCache::strict_from_environment(strict_from_environment_)) {
+    hash_cache_->set_strict(meta_data_()["strict_hash"].as<bool>());
+  }
+  if (hash_cache_->is_strict()) {
+    logger::get_logger()->info() << "Strict hashing enabled, hash cache disabled";
+  }
+
+  data_store_ = DataStore::construct(
+      ghc::filesystem::path(remove_local_from_root(get_data_store().string())));
+
   // Create and API object as a shared pointer
   api_ = API::construct(api_url_);
 
+  // Templates have no code run to share or resume
+  if (!is_template_) {
+    // Workers of a shared session reuse the leader's code run and only
+    // log their link calls, so they make no registry calls here
+    open_shared_session();
+    if (shared_session_ && !shared_session_->is_leader()) {
+      session_from_json_(shared_session_->attach());
+      journal_ = Journal::open(shared_session_->worker_log_path());
+      logger::get_logger()->info()
+          << "Rank " << shared_session_->get_rank()
+          << " attached to code run " << get_code_run_uuid();
+      return;
+    }
+
+    if (shared_session_) {
+      shared_session_->prepare();
+    }
+
+    // An interrupted session with the same config and script is resumed
+    if (open_journal()) {
+      if (shared_session_) {
+        shared_session_->publish(session_to_json_());
+      }
+      return;
+    }
+  }
+
   // Get the admin user from registry
   Json::Value user_json_;
   user_json_["username"] = "admin";
@@ -345,8 +550,23 @@ void FairDataPipeline::Config::initialise(RESTAPI api_location) {
   Json::Value j_code_repo_obj = api_->post("object", code_repo_obj_value_, token_);
   this->code_repo_obj_ = ApiObject::from_json( j_code_repo_obj );
 
+  // Sessions created from a template register their own code runs
+  if (is_template_) {
+    return;
+  }
+
+  register_code_run();
+
+  journal_initialise();
+
+  if (shared_session_) {
+    shared_session_->publish(session_to_json_());
+  }
+}
+
+void FairDataPipeline::Config::register_code_run() const {
   Json::Value code_run_value_;
-  code_run_value_["run_date"] = current_time_stamp();
+  code_run_value_["run_date"] = run_date_;
   code_run_value_["description"] = meta_data_()["description"].as<std::string>();
   code_run_value_["code_repo"] = code_repo_obj_->get_uri();
   code_run_value_["model_config"] = config_obj_->get_uri();
@@ -365,16 +585,174 @@ void FairDataPipeline::Config::initialise(RESTAPI api_location) {
       << " successfully generated";
 }
 
+std::vector< std::pair< std::string, ApiObject::sptr* > > FairDataPipeline::Config::session_objects_() {
+  std::vector< std::pair< std::string, ApiObject::sptr* > > objects_;
+  objects_.push_back(std::make_pair("user", &user_));
+  objects_.push_back(std::make_pair("author", &author_));
+  objects_.push_back(std::make_pair("config_storage_root", &config_storage_root_));
+  objects_.push_back(std::make_pair("config_storage_location", &config_storage_location_));
+  objects_.push_back(std::make_pair("config_obj", &config_obj_));
+  objects_.push_back(std::make_pair("script_storage_location", &script_storage_location_));
+  objects_.push_back(std::make_pair("script_obj", &script_obj_));
+  objects_.push_back(std::make_pair("code_repo_storage_root", &code_repo_storage_root_));
+  objects_.push_back(std::make_pair("code_repo_storage_location", &code_repo_storage_location_));
+  objects_.push_back(std::make_pair("code_repo_obj", &code_repo_obj_));
+  objects_.push_back(std::make_pair("code_run", &code_run_));
+  return objects_;
+}
+
+bool FairDataPipeline::Config::open_journal() {
+  if (!meta_data_()["journal"] || !meta_data_()["journal"].as<bool>()) {
+    return false;
+  }
+
+  const std::string key_ = meta_data_()["journal_key"] ?
+      meta_data_()["journal_key"].as<std::string>() : default_session_key_();
+
+  // Each live session keeps its journal locked, so concurrent runs of the
+  // same config use separate journals and a new run resumes the first one
+  // released by a crashed run
+  const ghc::filesystem::path journal_dir_ =
+      ghc::filesystem::path(remove_local_from_root(get_data_store().string())) /
+      ".fdp" / "journal";
+  const int max_slots_ = 64;
+  for (int slot_ = 0; !journal_ && slot_ < max_slots_; ++slot_) {
+    journal_ = Journal::try_open(journal_dir_ /
+        (key_ + (slot_ ? "-" + std::to_string(slot_) : "") + ".jsonl"));
+  }
+  if (!journal_) {
+    throw write_error("All " + std::to_string(max_slots_) + " journals for '" +
+                      key_ + "' are in use by other sessions");
+  }
+
+  const Json::Value session_ = journal_->find_last("initialise");
+  if (session_.isNull()) {
+    return false;
+  }
+
+  session_from_json_(session_);
+
+  // Replay in order, a later link_write of a product supersedes its earlier steps
+  for (const Json::Value &record_ : journal_->replayed()) {
+    const std::string step_ = record_["step"].asString();
+    const Json::Value &data_ = record_["data"];
+    const std::string product_ = data_["data_product"].asString();
+
+    if (step_ == "link_write") {
+      writes_.insert_or_assign(io_object_from_json_(data_));
+      journal_stored_.erase(product_);
+      journal_outputs_.erase(product_);
+    }
+    else if (step_ == "link_read") {
+      reads_.insert_or_assign(io_object_from_json_(data_));
+    }
+    else if (step_ == "storing" || step_ == "stored") {
+      journal_stored_.insert_or_assign(product_, data_);
+    }
+    else if (step_ == "output") {
+      journal_outputs_.insert_or_assign(product_, data_);
+    }
+  }
+
+  logger::get_logger()->info()
+      << "Resuming code run "
+      << code_run_->get_value_as_string("uuid")
+      << " from journal '" << journal_->get_path().string() << "'";
+
+  return true;
+}
+
+void FairDataPipeline::Config::journal_initialise() {
+  if (!journal_) {
+    return;
+  }
+  journal_->record("initialise", session_to_json_());
+}
+
+Json::Value FairDataPipeline::Config::session_to_json_() {
+  Json::Value session_;
+  for (const auto &object_ : session_objects_()) {
+    session_[object_.first] = (*object_.second)->to_json();
+  }
+  return session_;
+}
+
+void FairDataPipeline::Config::session_from_json_(const Json::Value &session) {
+  for (const auto &object_ : session_objects_()) {
+    *object_.second = ApiObject::from_json(session[object_.first]);
+  }
+}
+
+std::string FairDataPipeline::Config::default_session_key_() const {
+  // Identified by the content of the config and script
+  return calculate_hash_from_string(calculate_hash_from_file(config_file_path_) + ":" +
+                                    calculate_hash_from_file(script_file_path_));
+}
+
+void FairDataPipeline::Config::open_shared_session() {
+  int rank_ = session_rank_;
+  int size_ = session_size_;
+
+  if (size_ <= 1) {
+    // Not requested by the caller, a job may opt in without code changes
+    const bool requested_ = std::getenv("FDP_SESSION_SIZE") ||
+        (meta_data_()["shared_session"] && meta_data_()["shared_session"].as<bool>());
+    if (!requested_ || !SharedSession::detect_rank(rank_, size_) || size_ <= 1) {
+      return;
+    }
+  }
+
+  std::string id_ = session_id_.empty() ? SharedSession::detect_id() : session_id_;
+  if (id_.empty()) {
+    id_ = default_session_key_();
+  }
+
+  const double timeout_ = meta_data_()["session_timeout"] ?
+      meta_data_()["session_timeout"].as<double>() : 600.0;
+
+  shared_session_ = SharedSession::construct(
+      ghc::filesystem::path(remove_local_from_root(get_data_store().string())),
+      id_, rank_, size_, timeout_);
+}
+
+void FairDataPipeline::Config::merge_worker_records() {
+  for (const Json::Value &record_ : shared_session_->collect(get_code_run_uuid())) {
+    const std::string step_ = record_["step"].asString();
+    const Json::Value &data_ = record_["data"];
+    const std::string product_ = data_["data_product"].asString();
+
+    if (step_ == "link_write") {
+      const IOObject write_ = io_object_from_json_(data_);
+      IOObject existing_;
+      if (writes_.find(product_, existing_) && existing_.get_path() != write_.get_path()) {
+        logger::get_logger()->warn()
+            << "Write of " << product_ << " from rank "
+            << record_["rank"].asInt() << " replaces an earlier write";
+      }
+      writes_.insert_or_assign(write_);
+    }
+    else if (step_ == "link_read") {
+      reads_.insert_or_assign(io_object_from_json_(data_));
+    }
+  }
+}
+
 std::string Config::get_config_directory() const{
   return config_file_path_.parent_path().string();
 };
 
 std::string Config::get_code_run_uuid() const{
+  std::lock_guard<std::mutex> lock_(code_run_mutex_);
+  if (!code_run_) {
+    register_code_run();
+  }
   return code_run_->get_value_as_string("uuid");
 };
 
 
 ghc::filesystem::path Config::link_write( const std::string& data_product){
+  std::unique_lock<std::mutex> config_lock_(config_mutex_);
+
   if (!config_has_writes()){
     logger::get_logger()->error()
         << "Config Error: Write has not been specified in the given config file";
@@ -447,34 +825,62 @@ ghc::filesystem::path Config::link_write( const std::string& data_product){
     currentWrite["use"]["namespace"] = meta_data_()["default_output_namespace"].as<std::string>();
   }
 
-  std::string filename_("dat-" + generate_random_hash() + "." + currentWrite["file_type"].as<std::string>());
-  ghc::filesystem::path path_ = ghc::filesystem::path(meta_data_()["write_data_store"].as<std::string>()) / currentWrite["use"]["namespace"].as<std::string>() / currentWrite["use"]["data_product"].as<std::string>() / filename_;
+  const bool directory_ = currentWrite["directory"] && currentWrite["directory"].as<bool>();
 
-  logger::get_logger()->info() << "Link Path: " << path_.string();
+  std::string filename_ = path_allocator_.unique_filename(currentWrite["file_type"].as<std::string>());
 
-  // Create Directory
-  ghc::filesystem::create_directories(path_.parent_path().string());
+  // Every rank of a shared session writes its shards into the same directory
+  if (directory_ && shared_session_) {
+    filename_ = "dat-" + calculate_hash_from_string(shared_session_->get_id() + ":" + data_product) +
+        "." + currentWrite["file_type"].as<std::string>();
+  }
+  ghc::filesystem::path path_ = ghc::filesystem::path(meta_data_()["write_data_store"].as<std::string>()) / currentWrite["use"]["namespace"].as<std::string>() / currentWrite["use"]["data_product"].as<std::string>() / filename_;
 
-  writes_[data_product] = IOObject(data_product, 
+  const IOObject write_(data_product, 
     currentWrite["data_product"].as<std::string>(),
     currentWrite["use"]["version"].as<std::string>(),
     currentWrite["use"]["namespace"].as<std::string>(),
     path_,
     currentWrite["description"].as<std::string>(),
-    meta_data_()["public"].as<bool>()
+    meta_data_()["public"].as<bool>(),
+    directory_
     );
+
+  config_lock_.unlock();
+
+  logger::get_logger()->info() << "Link Path: " << path_.string();
+
+  // Create Directory, for directory products the returned path itself
+  if (directory_) {
+    path_allocator_.ensure_directory(path_);
+  }
+  else {
+    path_allocator_.ensure_directory(path_.parent_path());
+  }
+
+  writes_.insert_or_assign(write_);
+
+  if (journal_) {
+    journal_stored_.erase(data_product);
+    journal_outputs_.erase(data_product);
+    journal_->record("link_write", io_object_to_json_(write_));
+  }
+
   return path_;
 
 }
 
 ghc::filesystem::path FairDataPipeline::Config::link_read( const std::string &data_product){
-  YAML::Node currentRead;
-
-  auto it = inputs_.find("data_product");
-  if (it != inputs_.end()) {
-      return it->second.get_path();
+  // A product already read in this session is not looked up again
+  IOObject existingRead;
+  if (reads_.find(data_product, existingRead)) {
+      return existingRead.get_path();
   }
 
+  std::unique_lock<std::mutex> config_lock_(config_mutex_);
+
+  YAML::Node currentRead;
+
   if(config_reads_().IsSequence()){
     for (YAML::const_iterator it = config_reads_().begin(); it != config_reads_().end(); ++it) {
       if(it->as<YAML::Node>()["data_product"]){
@@ -517,8 +923,16 @@ ghc::filesystem::path FairDataPipeline::Config::link_read( const std::string &da
     currentRead["use"]["namespace"] = meta_data_()["default_input_namespace"].as<std::string>();
   }
 
+  const std::string readDataProduct = currentRead["data_product"].as<std::string>();
+  const std::string useDataProduct = currentRead["use"]["data_product"].as<std::string>();
+  const std::string useVersion = currentRead["use"]["version"].as<std::string>();
+  const std::string useNamespace = currentRead["use"]["namespace"].as<std::string>();
+
+  // Registry lookups run concurrently
+  config_lock_.unlock();
+
   Json::Value namespaceData;
-  namespaceData["name"] = currentRead["use"]["namespace"].as<std::string>();
+  namespaceData["name"] = useNamespace;
 
   Json::Value j_namespace = api_->get_by_json_query("namespace", namespaceData)[0];
   ApiObject::sptr namespaceObj = ApiObject::from_json( j_namespace );
@@ -526,14 +940,14 @@ ghc::filesystem::path FairDataPipeline::Config::link_read( const std::string &da
   if (namespaceObj->is_empty()){
     logger::get_logger()->error()
         << "Namespace Error: could not find namespace " 
-        <<  currentRead["use"]["namespace"].as<std::string>() 
+        <<  useNamespace 
         << " in registry";
-    throw std::runtime_error("Namespace Error: could not find namespace " + currentRead["use"]["namespace"].as<std::string>() + " in Registry");
+    throw std::runtime_error("Namespace Error: could not find namespace " + useNamespace + " in Registry");
   }
 
   Json::Value dataProductData;
-  dataProductData["name"] = currentRead["use"]["data_product"].as<std::string>();
-  dataProductData["version"] = currentRead["use"]["version"].as<std::string>();
+  dataProductData["name"] = useDataProduct;
+  dataProductData["version"] = useVersion;
   dataProductData["namespace"] = namespaceObj->get_id();
   
   Json::Value j_data_prod_obj = api_->get_by_json_query("data_product", dataProductData)[0];
@@ -542,9 +956,9 @@ ghc::filesystem::path FairDataPipeline::Config::link_read( const std::string &da
   if (dataProductObj->is_empty()){
     logger::get_logger()->error() 
         << "data_product Error: could not find data_product "
-        <<  currentRead["use"]["data_product"].as<std::string>() 
+        <<  useDataProduct 
         << " in registry";
-    throw std::runtime_error("Namespace Error: could not find data_product " + currentRead["use"]["data_product"].as<std::string>() + " in Registry");
+    throw std::runtime_error("Namespace Error: could not find data_product " + useDataProduct + " in Registry");
   }
 
   Json::Value _j_ = api_->get_by_id("object", ApiObject::get_id_from_string(dataProductObj->get_value_as_string("object")));
@@ -598,73 +1012,256 @@ ghc::filesystem::path FairDataPipeline::Config::link_read( const std::string &da
   ghc::filesystem::path path_ = ghc::filesystem::path(remove_local_from_root(storageRootObj->get_value_as_string("root"))) / 
     API::remove_leading_forward_slash(storageLocationObj->get_value_as_string("path"));
 
-  reads_[data_product] = IOObject(data_product, 
-    currentRead["data_product"].as<std::string>(),
-    currentRead["use"]["version"].as<std::string>(),
-    currentRead["use"]["namespace"].as<std::string>(),
+  const IOObject read_(data_product, 
+    readDataProduct,
+    useVersion,
+    useNamespace,
     path_,
     *componentObj,
     *dataProductObj
     );
 
+  reads_.insert_or_assign(read_);
+
+  if (journal_) {
+    journal_->record("link_read", io_object_to_json_(read_));
+  }
+
   return path_;
 }
 
-void FairDataPipeline::Config::finalise(){
+ApiObject::sptr FairDataPipeline::Config::store_data_product(const IOObject &currentWrite,
+                                                             const std::string &hash){
+  Json::Value storageData;
+  storageData["hash"] = hash;
+  storageData["storage_root"] = config_storage_root_->get_id();
+  storageData["public"] = currentWrite.is_public();
 
-  if(has_writes()){
-      Config::map_type::iterator it;
-    for (it = writes_.begin(); it != writes_.end(); it++){
-      IOObject& currentWrite = it->second;
 
-      if(! file_exists(currentWrite.get_path().string())){
-        logger::get_logger()->error() 
-            << "File Error: Cannot Find file for write" << currentWrite.get_use_data_product();
+  ApiObject::sptr storageLocationObj = ApiObject::from_json(api_->get_by_json_query("storage_location", storageData)[0]);
+  ApiObject::sptr StorageRootObj;
+
+  ghc::filesystem::path newPath;
+  std::string extension = currentWrite.get_path().extension().string();
 
-        throw std::runtime_error("File Error Cannot Find file for write: " + currentWrite.get_use_data_product());
+  if (!storageLocationObj->is_empty()){
+    ghc::filesystem::remove_all(currentWrite.get_path());
+
+    StorageRootObj = ApiObject::from_json(api_->get_by_id("storage_root", ApiObject::get_id_from_string(storageLocationObj->get_value_as_string("storage_root"))));
+
+    newPath = ghc::filesystem::path(remove_local_from_root(StorageRootObj->get_value_as_string("root"))) / storageLocationObj->get_value_as_string("path");
+
+  }
+  else {
+    ghc::filesystem::path tmpFilename = currentWrite.get_path().filename();
+    ghc::filesystem::path newFileName = ghc::filesystem::path(storageData["hash"].asString() + extension);
+
+    newPath = ghc::filesystem::path(remove_local_from_root(get_data_store().string())) / currentWrite.get_use_namespace() / currentWrite.get_use_data_product() / newFileName;
+
+    // A resumed session may find the product already moved into the store
+    const bool pending_ = ghc::filesystem::exists(currentWrite.get_path());
+    if (!pending_ && !currentWrite.is_directory() &&
+        !ghc::filesystem::exists(newPath)) {
+      const ghc::filesystem::path blob_ =
+          data_store_->blob_path(storageData["hash"].asString(), extension);
+      if (ghc::filesystem::exists(blob_)) {
+        DataStore::link(blob_, newPath);
+      }
+    }
+    if (!pending_ && !ghc::filesystem::exists(newPath)) {
+      logger::get_logger()->error()
+          << "File Error: Cannot Find file for write" << currentWrite.get_use_data_product();
+      throw std::runtime_error("File Error Cannot Find file for write: " + currentWrite.get_use_data_product());
+    }
+
+    if (!pending_) {
+      logger::get_logger()->info()
+          << "Data product " << currentWrite.get_use_data_product()
+          << " was already stored at " << newPath.string();
+    }
+    else if (currentWrite.is_directory()) {
+      // Directories are moved as a whole so the tree appears atomically,
+      // an existing tree with the same root already holds identical content
+      if (ghc::filesystem::exists(newPath)) {
+        ghc::filesystem::remove_all(currentWrite.get_path());
+      }
+      else {
+        ghc::filesystem::rename(currentWrite.get_path().string(), newPath.string());
       }
+    }
+    else {
+      // Files are stored once per hash and linked into the product path
+      data_store_->commit(currentWrite.get_path(), storageData["hash"].asString(), newPath);
+    }
 
-      Json::Value storageData;
-      storageData["hash"] = calculate_hash_from_file(currentWrite.get_path());
-      storageData["storage_root"] = config_storage_root_->get_id();
-      storageData["public"] = currentWrite.is_public();
+    ghc::filesystem::path str_path =  ghc::filesystem::path(currentWrite.get_use_namespace()) / currentWrite.get_use_data_product() / newFileName;
 
+    storageData["path"] = str_path.string();
+    storageData["path"] = remove_backslash_from_path(storageData["path"].asString());
+    storageData["path"] = API::remove_leading_forward_slash(storageData["path"].asString());
+    storageData["storage_root"] = config_storage_root_->get_uri();
 
-      ApiObject::sptr storageLocationObj = ApiObject::from_json(api_->get_by_json_query("storage_location", storageData)[0]);
-      ApiObject::sptr StorageRootObj;
+    storageLocationObj = ApiObject::from_json(api_->post("storage_location", storageData, token_));
 
-      ghc::filesystem::path newPath;
-      std::string extension = currentWrite.get_path().extension().string();
+  }
 
-      if (!storageLocationObj->is_empty()){
-        remove(currentWrite.get_path());
+  return storageLocationObj;
+}
 
-        StorageRootObj = ApiObject::from_json(api_->get_by_id("storage_root", ApiObject::get_id_from_string(storageLocationObj->get_value_as_string("storage_root"))));
+FairDataPipeline::Config::FinaliseProgress FairDataPipeline::Config::get_finalise_progress() const{
+  FinaliseProgress progress_;
+  progress_.outputs_total = progress_outputs_total_;
+  progress_.outputs_hashed = progress_outputs_hashed_;
+  progress_.outputs_registered = progress_outputs_registered_;
+  progress_.registry_calls = progress_registry_calls_;
+  return progress_;
+}
 
-        newPath = ghc::filesystem::path(remove_local_from_root(StorageRootObj->get_value_as_string("root"))) / storageLocationObj->get_value_as_string("path");
+std::vector<ghc::filesystem::path> FairDataPipeline::Config::link_read_many(
+    const std::vector<std::string> &data_products,
+    std::vector<std::exception_ptr> &errors){
+  return link_many_(data_products, errors, &Config::link_read);
+}
 
-      }
-      else {
-        ghc::filesystem::path tmpFilename = currentWrite.get_path().filename();
-        ghc::filesystem::path newFileName = ghc::filesystem::path(storageData["hash"].asString() + extension);
+std::vector<ghc::filesystem::path> FairDataPipeline::Config::link_write_many(
+    const std::vector<std::string> &data_products,
+    std::vector<std::exception_ptr> &errors){
+  return link_many_(data_products, errors, &Config::link_write);
+}
 
-        newPath = ghc::filesystem::path(remove_local_from_root(get_data_store().string())) / currentWrite.get_use_namespace() / currentWrite.get_use_data_product() / newFileName;
+std::vector<ghc::filesystem::path> FairDataPipeline::Config::link_many_(
+    const std::vector<std::string> &data_products,
+    std::vector<std::exception_ptr> &errors,
+    ghc::filesystem::path (Config::*link)(const std::string &)){
+  // Each distinct product is linked once, duplicates share its result
+  std::vector<std::string> distinct_;
+  std::vector<std::size_t> slot_(data_products.size());
+  std::map<std::string, std::size_t> seen_;
+  for (std::size_t i = 0; i < data_products.size(); ++i) {
+    auto it = seen_.insert(std::make_pair(data_products[i], distinct_.size()));
+    if (it.second) {
+      distinct_.push_back(data_products[i]);
+    }
+    slot_[i] = it.first->second;
+  }
 
-        ghc::filesystem::rename(currentWrite.get_path().string(), newPath.string());
+  unsigned int threads_ = 0;
+  {
+    std::lock_guard<std::mutex> config_lock_(config_mutex_);
+    if (meta_data_()["link_threads"]) {
+      threads_ = meta_data_()["link_threads"].as<unsigned int>();
+    }
+  }
+
+  std::vector<ghc::filesystem::path> distinct_paths_(distinct_.size());
+  std::vector<std::exception_ptr> distinct_errors_(distinct_.size());
+  parallel_for(distinct_.size(), threads_, [&](std::size_t i) {
+    try {
+      distinct_paths_[i] = (this->*link)(distinct_[i]);
+    }
+    catch (...) {
+      distinct_errors_[i] = std::current_exception();
+    }
+  }, pool_.get());
+
+  std::vector<ghc::filesystem::path> paths_(data_products.size());
+  errors.assign(data_products.size(), std::exception_ptr());
+  for (std::size_t i = 0; i < data_products.size(); ++i) {
+    paths_[i] = distinct_paths_[slot_[i]];
+    errors[i] = distinct_errors_[slot_[i]];
+  }
+  return paths_;
+}
+
+void FairDataPipeline::Config::finalise(){
 
-        ghc::filesystem::path str_path =  ghc::filesystem::path(currentWrite.get_use_namespace()) / currentWrite.get_use_data_product() / newFileName;
+  // Workers hand their links to the leader, which finalises the shared run
+  if (shared_session_ && !shared_session_->is_leader()) {
+    Json::Value finalised_;
+    finalised_["code_run"] = get_code_run_uuid();
+    journal_->record("finalise", finalised_);
+    journal_.reset();
+    logger::get_logger()->info()
+        << "Rank " << shared_session_->get_rank()
+        << " handed its links to the leader of code run " << get_code_run_uuid();
+    return;
+  }
 
-        storageData["path"] = str_path.string();
-        storageData["path"] = remove_backslash_from_path(storageData["path"].asString());
-        storageData["path"] = API::remove_leading_forward_slash(storageData["path"].asString());
-        storageData["storage_root"] = config_storage_root_->get_uri();
+  if (shared_session_) {
+    merge_worker_records();
+  }
 
-        storageLocationObj = ApiObject::from_json(api_->post("storage_location", storageData, token_));
+  // Registry requests are counted on this thread, finalise makes them all
+  const std::size_t calls_before_ = API::thread_request_count();
+  auto count_calls_ = [this, calls_before_]() {
+    progress_registry_calls_ = API::thread_request_count() - calls_before_;
+  };
+  progress_outputs_total_ = writes_.size();
+  progress_outputs_hashed_ = 0;
+  progress_outputs_registered_ = 0;
+  progress_registry_calls_ = 0;
 
+  if(has_writes()){
+    // Rows are built one at a time, so the whole table is never copied
+    writes_.for_each([this, &count_calls_](const IOObject &write_){
+      IOObject currentWrite = write_;
+
+      const std::string product_ = currentWrite.get_data_product();
+
+      // Steps completed by an interrupted session are restored, not repeated
+      Json::Value journalled_;
+      if (journal_outputs_.find(product_, journalled_)) {
+        currentWrite.set_component_object(*ApiObject::from_json(journalled_["component"]));
+        currentWrite.set_data_product_object(*ApiObject::from_json(journalled_["data_product_object"]));
+        writes_.set_registry_objects(product_,
+                                     currentWrite.get_component_object()->get_uri(),
+                                     currentWrite.get_data_product_object()->get_uri());
+        ++progress_outputs_hashed_;
+        ++progress_outputs_registered_;
+        return;
       }
 
+      ApiObject::sptr storageLocationObj;
+      const bool journalled_stored_ = journal_stored_.find(product_, journalled_);
+      if (journalled_stored_ && journalled_.isMember("storage_location")) {
+        storageLocationObj = ApiObject::from_json(journalled_["storage_location"]);
+      }
+      else {
+        // The hash is journalled before the file is moved, so a session
+        // interrupted mid-move resumes with the hash of the committed file
+        std::string hash_;
+        if (journalled_stored_) {
+          hash_ = journalled_["hash"].asString();
+        }
+        else {
+          if (!file_exists(currentWrite.get_path().string())) {
+            logger::get_logger()->error()
+                << "File Error: Cannot Find file for write" << currentWrite.get_use_data_product();
+            throw std::runtime_error("File Error Cannot Find file for write: " + currentWrite.get_use_data_product());
+          }
+          hash_ = hash_data_product(currentWrite.get_path());
+          if (journal_) {
+            Json::Value storing_;
+            storing_["data_product"] = product_;
+            storing_["hash"] = hash_;
+            journal_->record("storing", storing_);
+          }
+        }
+        storageLocationObj = store_data_product(currentWrite, hash_);
+        if (journal_) {
+          Json::Value stored_;
+          stored_["data_product"] = product_;
+          stored_["storage_location"] = storageLocationObj->to_json();
+          journal_->record("stored", stored_);
+        }
+      }
+      ++progress_outputs_hashed_;
+      count_calls_();
+
+      std::string extension = currentWrite.get_path().extension().string();
+
       Json::Value filetypeData;
-      filetypeData["name"] = extension;
+      filetypeData["name"] = file_type_name_(extension);
       filetypeData["extension"] = extension;
       ApiObject::sptr filetypeObj = ApiObject::from_json(api_->post_file_type(filetypeData, token_));
 
@@ -725,25 +1322,25 @@ void FairDataPipeline::Config::finalise(){
       currentWrite.set_component_object( *componentObj);
       currentWrite.set_data_product_object( *dataProductObj );
 
-      outputs_[currentWrite.get_data_product()] = currentWrite;      
+      writes_.set_registry_objects(product_, componentObj->get_uri(),
+                                   dataProductObj->get_uri());
+      ++progress_outputs_registered_;
+      count_calls_();
 
-    }
-  }
+      if (journal_) {
+        journal_->record("output", io_object_to_json_(currentWrite));
+      }
 
-  if(has_reads()){
-    map_type::iterator it;
-    for (it = reads_.begin(); it != reads_.end(); it++){
-      IOObject& currentRead = it->second;
-      inputs_[currentRead.get_data_product()] = currentRead;
-    }
+    });
   }
 
   Json::Value patch_data;
 
   if(has_outputs()){
-    map_type::iterator it;
-    for (it = outputs_.begin(); it != outputs_.end(); it++){
-      IOObject& currentOutput = it->second;
+    writes_.for_each([&patch_data](const IOObject &currentOutput){
+      if (!currentOutput.get_component_object()){
+        return;
+      }
       Json::Value output = currentOutput.get_component_object()->get_uri();
       patch_data["outputs"].append(output);
       //logger::get_logger()->info() 
@@ -753,26 +1350,44 @@ void FairDataPipeline::Config::finalise(){
       logger::get_logger()->info() 
           << "Writing " <<  currentOutput.get_use_data_product() << " to local registry";
 
-    }
+    });
   }
 
   if(has_inputs()){
-   map_type::iterator it;
-    for (it = inputs_.begin(); it != inputs_.end(); it++){
-      IOObject& currentInput = it->second;
+    reads_.for_each([&patch_data](const IOObject &currentInput){
+      if (!currentInput.get_component_object()){
+        return;
+      }
       Json::Value input = currentInput.get_component_object()->get_uri();
       patch_data["inputs"].append(input);
       logger::get_logger()->info() 
           << "Writing " <<  currentInput.get_use_data_product() << " to local registry";
-    }
+    });
   }
 
+  // Ensures a session created from a template has registered its code run
+  get_code_run_uuid();
   std::string code_run_endpoint = "code_run/" + std::to_string(code_run_->get_id());
   logger::get_logger()->info() << "Code Run: " << code_run_endpoint;
 
   Json::Value j_code_run = api_->patch(code_run_endpoint, patch_data, token_);
+  count_calls_();
   this-> code_run_ = ApiObject::from_json( j_code_run );
 
+  // The code run is complete, a new session must not resume it
+  if (journal_) {
+    journal_->complete();
+    journal_.reset();
+    journal_stored_.clear();
+    journal_outputs_.clear();
+  }
+
+  if (shared_session_) {
+    shared_session_->close();
+  }
+
+  HashCache::get_cache()->flush();
+
 }
 
 }; // namespace FairDataPipeline
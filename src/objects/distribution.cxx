@@ -1,6 +1,10 @@
 #include "fdp/objects/distribution.hxx"
 #include "fdp/exceptions.hxx"
+#include "fdp/objects/shared_parameter_cache.hxx"
 #include "fdp/utilities/data_io.hxx"
+#include "fdp/utilities/sampling.hxx"
+#include "fdp/utilities/toml_document.hxx"
+#include "fdp/utilities/toml_writer.hxx"
 
 #include <vector>
 
@@ -17,15 +21,26 @@ Distribution::Distribution(const std::string &file_name,
   read_from_toml(file_name_, _component);
 }
 
-void Distribution::read_from_toml(const ghc::filesystem::path &file_path,
-                                  const std::string &component) {
-  auto data_ = read_component_from_toml(file_path, component);
-  if (!data_.contains("type")) {
+namespace {
+double number_from_toml_(const toml::value &data, const std::string &key) {
+  if (data.at(key).is_floating()) {
+    return data.at(key).as_floating();
+  } else if (data.at(key).is_integer()) {
+    return static_cast<double>(data.at(key).as_integer());
+  }
+  throw toml_error("Error " + key + " value is not a number");
+}
+
+void distribution_from_toml_(const toml::value &data,
+                             const ghc::filesystem::path &file_path,
+                             const std::string &component, std::string &name,
+                             double &mu, double &sigma) {
+  if (!data.contains("type")) {
     throw toml_error("Error Toml file: " + file_path.string() +
                      " does not contain a type tag");
   }
 
-  if (data_.at("type").as_string() != "distribution") {
+  if (data.at("type").as_string() != "distribution") {
     throw toml_error("Error component: " + component +
                      " does not contain a distribution");
   }
@@ -33,29 +48,78 @@ void Distribution::read_from_toml(const ghc::filesystem::path &file_path,
   std::vector<std::string> required_keys_{"distribution", "mu", "sigma"};
 
   for (const auto &key : required_keys_) {
-    if (!data_.contains(key)) {
+    if (!data.contains(key)) {
       throw toml_error("Error component: " + component +
                        " does not contain a " + key);
     }
   }
 
-  _name = data_.at("distribution").as_string();
+  name = data.at("distribution").as_string();
+  mu = number_from_toml_(data, "mu");
+  sigma = number_from_toml_(data, "sigma");
+}
+
+toml::value distribution_to_toml_(const Distribution &distribution,
+                                  const std::string &component) {
+  const toml::value data_{{component,
+                           {{"type", "distribution"},
+                            {"distribution", distribution.get_name()},
+                            {"mu", distribution.get_mu()},
+                            {"sigma", distribution.get_sigma()}}}};
+  return data_;
+}
+} // namespace
+
+void Distribution::read_from_toml(const ghc::filesystem::path &file_path,
+                                  const std::string &component) {
+  const ParameterStore::sptr store_ =
+      SharedParameterCache::open_shared(file_path);
+  const ParameterStore::Record *record_ =
+      store_ ? store_->find(component.data(), component.size()) : nullptr;
+  if (record_ && record_->type == static_cast<std::uint32_t>(
+                                      ParameterStore::Type::DISTRIBUTION)) {
+    _name = store_->distribution_name(*record_);
+    _mu = record_->value;
+    _sigma = record_->sigma;
+    return;
+  }
+  distribution_from_toml_(TomlDocument::open(file_path)->component(component),
+                          file_path, component, _name, _mu, _sigma);
+}
+
+std::vector<Distribution>
+Distribution::read_many_from_toml(const std::string &file_name,
+                                  const std::vector<std::string> &components) {
+  const ghc::filesystem::path file_path_(file_name);
+  const TomlDocument::sptr document_ = TomlDocument::open(file_path_);
 
-  if (data_.at("mu").is_floating()) {
-    _mu = data_.at("mu").as_floating();
-  } else if (data_.is_integer()) {
-    _mu = static_cast<double>(data_.at("mu").as_integer());
-  } else {
-    throw toml_error("Error mu value is not a number");
+  std::vector<Distribution> distributions_;
+  distributions_.reserve(components.size());
+  for (const std::string &component_ : components) {
+    std::string name_;
+    double mu_ = 0.0;
+    double sigma_ = 0.0;
+    distribution_from_toml_(document_->component(component_), file_path_,
+                            component_, name_, mu_, sigma_);
+    distributions_.push_back(Distribution(name_, mu_, sigma_, component_));
   }
+  return distributions_;
+}
 
-  if (data_.at("sigma").is_floating()) {
-    _sigma = data_.at("sigma").as_floating();
-  } else if (data_.is_integer()) {
-    _sigma = static_cast<double>(data_.at("sigma").as_integer());
-  } else {
-    throw toml_error("Error sigma value is not a number");
+std::string
+Distribution::write_many_to_toml(const std::vector<Distribution> &distributions,
+                                 const std::string &file_name) {
+  TomlWriter::sptr writer_ = TomlWriter::construct(file_name);
+  try {
+    for (const Distribution &distribution_ : distributions) {
+      distribution_.write_to_toml(*writer_);
+    }
+  } catch (...) {
+    // Nothing is written if any component is a duplicate
+    writer_->discard();
+    throw;
   }
+  return writer_->flush().string();
 }
 
 std::string Distribution::write_to_toml(std::string &file_name) {
@@ -64,14 +128,38 @@ std::string Distribution::write_to_toml(std::string &file_name) {
 
 std::string Distribution::write_to_toml(std::string &component,
                                         std::string &file_name) {
-  const toml::value data_{{component,
-                           {{"type", "distribution"},
-                            {"distribution", _name},
-                            {"mu", _mu},
-                            {"sigma", _sigma}}}};
+  TomlWriter::sptr writer_ = TomlWriter::construct(file_name);
+  writer_->add(component, distribution_to_toml_(*this, component));
+  return writer_->flush().string();
+}
+
+void Distribution::write_to_toml(TomlWriter &writer) const {
+  writer.add(_component, distribution_to_toml_(*this, _component));
+}
+
+void Distribution::sample(double *out, std::size_t n, std::uint64_t seed,
+                          std::uint64_t first, unsigned int n_threads) const {
+  sampling::sample(sampling::family_from_name(_name), _mu, _sigma, seed, first,
+                   out, n, n_threads);
+}
+
+std::vector<double> Distribution::sample(std::size_t n,
+                                         std::uint64_t seed) const {
+  std::vector<double> samples_(n);
+  sample(samples_.data(), n, seed);
+  return samples_;
+}
+
+void Distribution::log_pdf(const double *x, double *out, std::size_t n,
+                           unsigned int n_threads) const {
+  sampling::log_pdf(sampling::family_from_name(_name), _mu, _sigma, x, out, n,
+                    n_threads);
+}
 
-  return write_toml_data(ghc::filesystem::path(file_name), component, data_)
-      .string();
+void Distribution::cdf(const double *x, double *out, std::size_t n,
+                       unsigned int n_threads) const {
+  sampling::cdf(sampling::family_from_name(_name), _mu, _sigma, x, out, n,
+                n_threads);
 }
 
 bool Distribution::isEqual(const Distribution &dist) const {
@@ -1,52 +1,191 @@
 #include "fdp/objects/metadata.hxx"
+#include "fdp/utilities/hash_cache.hxx"
+#include "fdp/utilities/parallel.hxx"
+
+#include <algorithm>
+#include <vector>
 
 namespace FairDataPipeline {
+namespace {
+/**
+ * @brief Store a digest in the hash cache if the file is unchanged and old
+ * enough that a later same-size write would alter its mtime
+ */
+void cache_file_hash_(const ghc::filesystem::path &file_path,
+                      const std::string &algorithm,
+                      const HashCache::key_type &key_before,
+                      const std::string &hash) {
+  HashCache::key_type key_after_;
+  if (!HashCache::get_key(file_path, key_after_) || key_before != key_after_) {
+    return;
+  }
+  const std::int64_t now_ns_ =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::system_clock::now().time_since_epoch())
+          .count();
+  if (now_ns_ - key_before.mtime_ns > 1000000000LL) {
+    HashCache::get_cache()->store(file_path, algorithm, key_before, hash);
+  }
+}
+
+/**
+ * @brief Combine the sorted (relative path, file hash) pairs of a directory
+ * into its root digest
+ */
+template <typename Hasher>
+std::string directory_root_(
+    const std::string &prefix,
+    const std::vector<std::pair<std::string, ghc::filesystem::path>> &files,
+    const std::vector<std::string> &leaves) {
+  Hasher root_;
+  root_.absorb(prefix + std::to_string(files.size()) + "\n");
+  for (std::size_t i = 0; i < files.size(); ++i) {
+    root_.absorb(files[i].first);
+    root_.absorb(std::string(1, '\0'));
+    root_.absorb(leaves[i]);
+    root_.absorb(std::string("\n"));
+  }
+  return root_.hexdigest();
+}
+} // namespace
+
 std::string calculate_hash_from_file(const ghc::filesystem::path &file_path) {
   if (!ghc::filesystem::exists(file_path)) {
     throw std::invalid_argument("File '" + file_path.string() + "' not found");
   }
 
+  HashCache::sptr cache_ = HashCache::get_cache();
+  std::string hash_;
+  if (cache_->lookup(file_path, "sha1", hash_)) {
+    return hash_;
+  }
+
+  HashCache::key_type key_before_;
+  const bool cacheable_ = HashCache::get_key(file_path, key_before_);
+
   std::ifstream file_(file_path.string(), std::ios_base::in | std::ios_base::binary);
 
-  const std::string hash_ = digestpp::sha1().absorb(file_).hexdigest();
+  hash_ = digestpp::sha1().absorb(file_).hexdigest();
 
   file_.close();
 
+  if (cacheable_) {
+    cache_file_hash_(file_path, "sha1", key_before_, hash_);
+  }
+
   return hash_;
 }
 
-std::string calculate_hash_from_string(const std::string &input) {
-  return digestpp::sha1().absorb(input).hexdigest();
-}
+std::string calculate_tree_hash_from_file(const ghc::filesystem::path &file_path,
+                                          unsigned int n_threads,
+                                          std::size_t chunk_size,
+                                          ThreadPool *pool) {
+  if (!ghc::filesystem::exists(file_path)) {
+    throw std::invalid_argument("File '" + file_path.string() + "' not found");
+  }
+  if (chunk_size == 0) {
+    throw std::invalid_argument("Tree hash chunk size must be non-zero");
+  }
+
+  const std::string algorithm_ = "sha256-tree-" + std::to_string(chunk_size);
+
+  HashCache::sptr cache_ = HashCache::get_cache();
+  std::string hash_;
+  if (cache_->lookup(file_path, algorithm_, hash_)) {
+    return hash_;
+  }
+
+  HashCache::key_type key_before_;
+  const bool cacheable_ = HashCache::get_key(file_path, key_before_);
+
+  const std::uint64_t file_size_ = ghc::filesystem::file_size(file_path);
+  const std::size_t n_chunks_ =
+      std::max<std::size_t>(1, (file_size_ + chunk_size - 1) / chunk_size);
+
+  std::vector<std::string> leaves_(n_chunks_);
+
+  // Each worker hashes a contiguous run of chunks through one file handle
+  // and one buffer, reading the file sequentially
+  const unsigned int n_workers_ = resolve_thread_count(n_threads, n_chunks_);
+  parallel_for(n_workers_, n_workers_, [&](std::size_t w) {
+    const std::size_t first_ = w * n_chunks_ / n_workers_;
+    const std::size_t last_ = (w + 1) * n_chunks_ / n_workers_;
+    std::ifstream file_(file_path.string(),
+                        std::ios_base::in | std::ios_base::binary);
+    if (!file_) {
+      throw std::runtime_error("Failed to open '" + file_path.string() +
+                               "' for hashing");
+    }
+    std::vector<char> buffer_(chunk_size);
+    file_.seekg(static_cast<std::streamoff>(first_ * chunk_size));
+    for (std::size_t i = first_; i < last_; ++i) {
+      file_.read(buffer_.data(), static_cast<std::streamsize>(chunk_size));
+      leaves_[i] =
+          digestpp::sha256()
+              .absorb(buffer_.data(), static_cast<std::size_t>(file_.gcount()))
+              .hexdigest();
+    }
+  }, pool);
+
+  digestpp::sha256 root_;
+  root_.absorb("fdp-sha256-tree:" + std::to_string(chunk_size) + ":" +
+               std::to_string(file_size_) + ":");
+  for (const auto &leaf : leaves_) {
+    root_.absorb(leaf);
+  }
+  hash_ = root_.hexdigest();
 
-std::string generate_random_hash() {
-  std::string random_string;
-
-  // Use Both the random_device and chrono high resolution clock to generate
-  // a good random seed
-
-  std::random_device rd;
-  std::mt19937::result_type seed =
-      rd() ^
-      ((std::mt19937::result_type)
-           std::chrono::duration_cast<std::chrono::seconds>(
-               std::chrono::system_clock::now().time_since_epoch())
-               .count() +
-       (std::mt19937::result_type)
-           std::chrono::duration_cast<std::chrono::microseconds>(
-               std::chrono::high_resolution_clock::now().time_since_epoch())
-               .count());
-
-  // Using mt19937 and a uniform distribution generate a 24 character random
-  // string
-  std::mt19937 gen(seed);
-  std::uniform_int_distribution<unsigned> distrib('a', '9');
-
-  for (unsigned long j = 0; j < 24; ++j) {
-    random_string += distrib(gen);
+  if (cacheable_) {
+    cache_file_hash_(file_path, algorithm_, key_before_, hash_);
   }
 
-  return calculate_hash_from_string(random_string);
+  return hash_;
+}
+
+std::string calculate_directory_hash(
+    const ghc::filesystem::path &dir_path, unsigned int n_threads,
+    const std::function<std::string(const ghc::filesystem::path &)>
+        &file_hasher,
+    const std::string &algorithm, ThreadPool *pool) {
+  if (!ghc::filesystem::is_directory(dir_path)) {
+    throw std::invalid_argument("Directory '" + dir_path.string() +
+                                "' not found");
+  }
+  if (algorithm != "sha1" && algorithm != "sha256-tree") {
+    throw std::invalid_argument("Unrecognised hash algorithm '" + algorithm +
+                                "'");
+  }
+  const bool tree_ = algorithm == "sha256-tree";
+
+  // Relative paths use '/' separators so the root is platform independent
+  std::vector<std::pair<std::string, ghc::filesystem::path>> files_;
+  for (ghc::filesystem::recursive_directory_iterator it(dir_path), end;
+       it != end; ++it) {
+    if (ghc::filesystem::is_regular_file(it->path())) {
+      files_.push_back(std::make_pair(
+          it->path().lexically_relative(dir_path).generic_string(),
+          it->path()));
+    }
+  }
+  std::sort(files_.begin(), files_.end());
+
+  std::vector<std::string> leaves_(files_.size());
+  // Files are already hashed concurrently, so tree leaves use a single thread
+  parallel_for(files_.size(), n_threads, [&](std::size_t i) {
+    if (file_hasher) {
+      leaves_[i] = file_hasher(files_[i].second);
+    } else {
+      leaves_[i] = tree_ ? calculate_tree_hash_from_file(files_[i].second, 1)
+                         : calculate_hash_from_file(files_[i].second);
+    }
+  }, pool);
+
+  // SHA1 roots keep their original untagged prefix so existing directory
+  // hashes are unchanged
+  const std::string prefix_ =
+      tree_ ? "fdp-directory-" + algorithm + ":" : "fdp-directory:";
+  return tree_ ? directory_root_<digestpp::sha256>(prefix_, files_, leaves_)
+               : directory_root_<digestpp::sha1>(prefix_, files_, leaves_);
 }
 
 std::string current_time_stamp(bool file_name) {
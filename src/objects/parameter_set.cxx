@@ -0,0 +1,163 @@
+#include "fdp/objects/parameter_set.hxx"
+
+#include "fdp/exceptions.hxx"
+#include "fdp/utilities/logging.hxx"
+#include "fdp/utilities/parallel.hxx"
+
+namespace FairDataPipeline {
+
+namespace {
+double number_from_toml_(const toml::value &table,
+                         const std::string &component,
+                         const std::string &key) {
+  if (!table.contains(key)) {
+    throw toml_error("Error component: " + component +
+                     " does not contain a " + key);
+  }
+  const toml::value &value_ = table.at(key);
+  if (value_.is_floating()) {
+    return value_.as_floating();
+  } else if (value_.is_integer()) {
+    return static_cast<double>(value_.as_integer());
+  }
+  throw toml_error("Error component: " + component + " " + key +
+                   " value is not a number");
+}
+} // namespace
+
+ParameterSet::ParameterSet(TomlDocument::sptr document)
+    : document_(std::move(document)) {
+  const toml::value &data_ = document_->get_data();
+  if (!data_.is_table()) {
+    return;
+  }
+  entries_.reserve(data_.as_table().size());
+
+  for (const auto &item_ : data_.as_table()) {
+    if (!item_.second.is_table()) {
+      continue;
+    }
+    Entry row_;
+    row_.component = &item_.first;
+    row_.table = &item_.second;
+    row_.type = Type::OTHER;
+    row_.value = 0.0;
+    row_.sigma = 0.0;
+
+    const toml::value &table_ = item_.second;
+    const std::string type_ =
+        table_.contains("type") && table_.at("type").is_string()
+            ? static_cast<std::string>(table_.at("type").as_string())
+            : std::string();
+    if (type_ == "point-estimate") {
+      row_.type = Type::POINT_ESTIMATE;
+      row_.value = number_from_toml_(table_, item_.first, "value");
+    } else if (type_ == "distribution") {
+      row_.type = Type::DISTRIBUTION;
+      if (!table_.contains("distribution")) {
+        throw toml_error("Error component: " + item_.first +
+                         " does not contain a distribution");
+      }
+      row_.distribution =
+          static_cast<std::string>(table_.at("distribution").as_string());
+      row_.value = number_from_toml_(table_, item_.first, "mu");
+      row_.sigma = number_from_toml_(table_, item_.first, "sigma");
+    }
+
+    entries_.push_back(row_);
+    index_.insert(static_cast<std::uint32_t>(entries_.size() - 1),
+                  [this](std::uint32_t id) {
+                    const std::string &name_ = *entries_[id].component;
+                    return hash_bytes(name_.data(), name_.size());
+                  });
+  }
+}
+
+ParameterSet::sptr ParameterSet::load(const ghc::filesystem::path &file_path) {
+  sptr set_(new ParameterSet(TomlDocument::open(file_path)));
+  logger::get_logger()->debug()
+      << "ParameterSet: Loaded " << set_->size() << " components from '"
+      << file_path.string() << "'";
+  return set_;
+}
+
+std::vector<ParameterSet::sptr>
+ParameterSet::load_many(const std::vector<ghc::filesystem::path> &file_paths,
+                        unsigned int n_threads) {
+  std::vector<sptr> sets_(file_paths.size());
+  parallel_for(file_paths.size(), n_threads,
+               [&](std::size_t i) { sets_[i] = load(file_paths[i]); });
+  return sets_;
+}
+
+bool ParameterSet::contains(const std::string &component) const {
+  std::uint32_t id_;
+  return index_.find(
+      hash_bytes(component.data(), component.size()),
+      [&](std::uint32_t id) { return *entries_[id].component == component; },
+      id_);
+}
+
+const ParameterSet::Entry &
+ParameterSet::entry_(const std::string &component) const {
+  std::uint32_t id_;
+  if (!index_.find(hash_bytes(component.data(), component.size()),
+                   [&](std::uint32_t id) {
+                     return *entries_[id].component == component;
+                   },
+                   id_)) {
+    throw toml_error("Component " + component + " does not exist in " +
+                     get_path().string());
+  }
+  return entries_[id_];
+}
+
+ParameterSet::Type ParameterSet::type(const std::string &component) const {
+  return entry_(component).type;
+}
+
+double ParameterSet::point_estimate(const std::string &component) const {
+  const Entry &found_ = entry_(component);
+  if (found_.type != Type::POINT_ESTIMATE) {
+    throw toml_error("Expected point-estimate for type of " + component +
+                     " but got '" + to_string(found_.type) + "'");
+  }
+  return found_.value;
+}
+
+Distribution ParameterSet::distribution(const std::string &component) const {
+  const Entry &found_ = entry_(component);
+  if (found_.type != Type::DISTRIBUTION) {
+    throw toml_error("Expected distribution for type of " + component +
+                     " but got '" + to_string(found_.type) + "'");
+  }
+  return Distribution(found_.distribution, found_.value, found_.sigma,
+                      component);
+}
+
+const toml::value &ParameterSet::value(const std::string &component) const {
+  return *entry_(component).table;
+}
+
+std::vector<std::string> ParameterSet::components() const {
+  std::vector<std::string> components_;
+  components_.reserve(entries_.size());
+  for (const Entry &row_ : entries_) {
+    components_.push_back(*row_.component);
+  }
+  return components_;
+}
+
+std::string to_string(ParameterSet::Type type) {
+  switch (type) {
+  case ParameterSet::Type::POINT_ESTIMATE:
+    return "point-estimate";
+  case ParameterSet::Type::DISTRIBUTION:
+    return "distribution";
+  case ParameterSet::Type::OTHER:
+    return "other";
+  }
+  return "unknown";
+}
+
+}; // namespace FairDataPipeline
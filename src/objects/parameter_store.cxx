@@ -0,0 +1,373 @@
+#include "fdp/objects/parameter_store.hxx"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "fdp/exceptions.hxx"
+#include "fdp/objects/metadata.hxx"
+#include "fdp/objects/parameter_set.hxx"
+#include "fdp/utilities/logging.hxx"
+#include "fdp/utilities/toml_writer.hxx"
+
+namespace FairDataPipeline {
+
+const char *const ParameterStore::file_type = "fdpp";
+
+namespace {
+const char magic_[8] = {'F', 'D', 'P', 'P', 'A', 'R', 'M', '\0'};
+const std::uint32_t byte_order_mark_ = 0x01020304;
+const std::uint32_t version_ = 1;
+
+struct Header {
+  char magic[8];
+  std::uint32_t byte_order;
+  std::uint32_t version;
+  std::uint64_t n_records;
+  std::uint64_t strings_offset;
+  std::uint64_t strings_size;
+};
+
+static_assert(sizeof(Header) == 40, "Parameter store header must be packed");
+static_assert(sizeof(ParameterStore::Record) == 40,
+              "Parameter store record must be packed");
+
+/**
+ * @brief Order names as unsigned bytes, shorter names first on a tie
+ */
+int compare_names_(const char *lhs, std::size_t lhs_size, const char *rhs,
+                   std::size_t rhs_size) {
+  const int cmp_ = std::memcmp(lhs, rhs, std::min(lhs_size, rhs_size));
+  if (cmp_ != 0) {
+    return cmp_;
+  }
+  return lhs_size < rhs_size ? -1 : (lhs_size > rhs_size ? 1 : 0);
+}
+
+std::string type_name_(std::uint32_t type) {
+  switch (static_cast<ParameterStore::Type>(type)) {
+  case ParameterStore::Type::POINT_ESTIMATE:
+    return "point-estimate";
+  case ParameterStore::Type::DISTRIBUTION:
+    return "distribution";
+  }
+  return "unknown";
+}
+} // namespace
+
+ParameterStore::ParameterStore(const ghc::filesystem::path &file_path)
+    : file_path_(file_path) {
+  if (!ghc::filesystem::exists(file_path)) {
+    throw parameter_store_error("File '" + file_path.string() +
+                                "' could not be opened as it does not exist");
+  }
+
+#ifndef _WIN32
+  const int fd_ = ::open(file_path.string().c_str(), O_RDONLY);
+  if (fd_ < 0) {
+    throw parameter_store_error("Failed to open '" + file_path.string() +
+                                "'");
+  }
+  struct stat st_;
+  if (::fstat(fd_, &st_) != 0) {
+    ::close(fd_);
+    throw parameter_store_error("Failed to stat '" + file_path.string() +
+                                "'");
+  }
+  size_ = static_cast<std::size_t>(st_.st_size);
+  if (size_ > 0) {
+    void *data_map_ = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd_, 0);
+    if (data_map_ != MAP_FAILED) {
+      data_ = static_cast<const char *>(data_map_);
+      mapped_ = true;
+    }
+  }
+  ::close(fd_);
+#endif
+
+  if (!mapped_) {
+    // No mmap on this platform, or the map failed: read the file instead
+    std::ifstream in_(file_path.string(), std::ios_base::binary);
+    buffer_.assign(std::istreambuf_iterator<char>(in_),
+                   std::istreambuf_iterator<char>());
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+  }
+}
+
+void ParameterStore::read_header_() {
+  Header header_;
+  if (size_ < sizeof(Header)) {
+    throw parameter_store_error("File '" + file_path_.string() +
+                                "' is too small to be a parameter store");
+  }
+  std::memcpy(&header_, data_, sizeof(Header));
+  if (std::memcmp(header_.magic, magic_, sizeof(magic_)) != 0) {
+    throw parameter_store_error("File '" + file_path_.string() +
+                                "' is not a parameter store");
+  }
+  if (header_.byte_order != byte_order_mark_) {
+    throw parameter_store_error("Parameter store '" + file_path_.string() +
+                                "' was written with another byte order");
+  }
+  if (header_.version != version_) {
+    throw parameter_store_error("Parameter store '" + file_path_.string() +
+                                "' has unsupported version " +
+                                std::to_string(header_.version));
+  }
+  const std::uint64_t records_end_ =
+      sizeof(Header) + header_.n_records * sizeof(Record);
+  if (header_.n_records > size_ / sizeof(Record) ||
+      records_end_ > header_.strings_offset ||
+      header_.strings_offset > size_ ||
+      header_.strings_size > size_ - header_.strings_offset) {
+    throw parameter_store_error("Parameter store '" + file_path_.string() +
+                                "' is truncated or corrupt");
+  }
+
+  records_ = reinterpret_cast<const Record *>(data_ + sizeof(Header));
+  n_records_ = static_cast<std::size_t>(header_.n_records);
+  strings_ = data_ + header_.strings_offset;
+  strings_size_ = static_cast<std::size_t>(header_.strings_size);
+
+  // Check once here so lookups need no bounds checks
+  for (const Record &record_ : *this) {
+    if (std::uint64_t(record_.name_offset) + record_.name_size >
+            strings_size_ ||
+        std::uint64_t(record_.distribution_offset) +
+                record_.distribution_size >
+            strings_size_) {
+      throw parameter_store_error("Parameter store '" + file_path_.string() +
+                                  "' is truncated or corrupt");
+    }
+  }
+}
+
+ParameterStore::sptr
+ParameterStore::open(const ghc::filesystem::path &file_path) {
+  // Validate after construction so the destructor unmaps on failure
+  std::shared_ptr<ParameterStore> store_(new ParameterStore(file_path));
+  store_->read_header_();
+  return store_;
+}
+
+ParameterStore::~ParameterStore() {
+#ifndef _WIN32
+  if (mapped_) {
+    ::munmap(const_cast<char *>(data_), size_);
+  }
+#endif
+}
+
+const ParameterStore::Record *
+ParameterStore::find(const char *name, std::size_t name_size) const {
+  const Record *it_ = std::lower_bound(
+      begin(), end(), 0, [&](const Record &record, int) {
+        return compare_names_(strings_ + record.name_offset, record.name_size,
+                              name, name_size) < 0;
+      });
+  if (it_ == end() || compare_names_(strings_ + it_->name_offset,
+                                     it_->name_size, name, name_size) != 0) {
+    return nullptr;
+  }
+  return it_;
+}
+
+const ParameterStore::Record &
+ParameterStore::record_(const std::string &component, Type type) const {
+  const Record *record_ = find(component.data(), component.size());
+  if (!record_) {
+    throw parameter_store_error("Component " + component +
+                                " does not exist in " + file_path_.string());
+  }
+  if (record_->type != static_cast<std::uint32_t>(type)) {
+    throw parameter_store_error(
+        "Expected " + type_name_(static_cast<std::uint32_t>(type)) +
+        " for type of " + component + " but got '" +
+        type_name_(record_->type) + "'");
+  }
+  return *record_;
+}
+
+double ParameterStore::point_estimate(const std::string &component) const {
+  return record_(component, Type::POINT_ESTIMATE).value;
+}
+
+Distribution ParameterStore::distribution(const std::string &component) const {
+  const Record &record_ = this->record_(component, Type::DISTRIBUTION);
+  return Distribution(distribution_name(record_), record_.value,
+                      record_.sigma, component);
+}
+
+std::string ParameterStore::component_name(const Record &record) const {
+  return std::string(strings_ + record.name_offset, record.name_size);
+}
+
+std::string ParameterStore::distribution_name(const Record &record) const {
+  return std::string(strings_ + record.distribution_offset,
+                     record.distribution_size);
+}
+
+void ParameterStoreWriter::add_point_estimate(const std::string &component,
+                                              double value) {
+  Entry entry_;
+  entry_.component = component;
+  entry_.type = ParameterStore::Type::POINT_ESTIMATE;
+  entry_.value = value;
+  entry_.sigma = 0.0;
+  entries_.push_back(entry_);
+}
+
+void ParameterStoreWriter::add_distribution(const Distribution &distribution) {
+  Entry entry_;
+  entry_.component = distribution.get_component();
+  entry_.type = ParameterStore::Type::DISTRIBUTION;
+  entry_.distribution = distribution.get_name();
+  entry_.value = distribution.get_mu();
+  entry_.sigma = distribution.get_sigma();
+  entries_.push_back(entry_);
+}
+
+ghc::filesystem::path
+ParameterStoreWriter::write(const ghc::filesystem::path &file_path) const {
+  std::vector<const Entry *> sorted_;
+  sorted_.reserve(entries_.size());
+  for (const Entry &entry_ : entries_) {
+    sorted_.push_back(&entry_);
+  }
+  std::sort(sorted_.begin(), sorted_.end(),
+            [](const Entry *lhs, const Entry *rhs) {
+              return compare_names_(lhs->component.data(),
+                                    lhs->component.size(),
+                                    rhs->component.data(),
+                                    rhs->component.size()) < 0;
+            });
+
+  std::string strings_;
+  std::map<std::string, std::uint32_t> distribution_offsets_;
+  std::vector<ParameterStore::Record> records_(sorted_.size());
+  for (std::size_t i = 0; i < sorted_.size(); ++i) {
+    const Entry &entry_ = *sorted_[i];
+    if (i > 0 && entry_.component == sorted_[i - 1]->component) {
+      throw parameter_store_error("Component " + entry_.component +
+                                  " added more than once");
+    }
+    ParameterStore::Record &record_ = records_[i];
+    std::memset(&record_, 0, sizeof(record_));
+    record_.name_offset = static_cast<std::uint32_t>(strings_.size());
+    record_.name_size = static_cast<std::uint32_t>(entry_.component.size());
+    strings_ += entry_.component;
+    record_.type = static_cast<std::uint32_t>(entry_.type);
+    record_.value = entry_.value;
+    record_.sigma = entry_.sigma;
+    if (entry_.type == ParameterStore::Type::DISTRIBUTION) {
+      // Distribution names repeat, store each once
+      auto it = distribution_offsets_.find(entry_.distribution);
+      if (it == distribution_offsets_.end()) {
+        it = distribution_offsets_
+                 .insert(std::make_pair(
+                     entry_.distribution,
+                     static_cast<std::uint32_t>(strings_.size())))
+                 .first;
+        strings_ += entry_.distribution;
+      }
+      record_.distribution_offset = it->second;
+      record_.distribution_size =
+          static_cast<std::uint32_t>(entry_.distribution.size());
+    }
+    if (strings_.size() > UINT32_MAX) {
+      throw parameter_store_error("Parameter store names exceed 4 GiB");
+    }
+  }
+
+  Header header_;
+  std::memcpy(header_.magic, magic_, sizeof(magic_));
+  header_.byte_order = byte_order_mark_;
+  header_.version = version_;
+  header_.n_records = records_.size();
+  header_.strings_offset =
+      sizeof(Header) + records_.size() * sizeof(ParameterStore::Record);
+  header_.strings_size = strings_.size();
+
+  if (!file_path.parent_path().empty() &&
+      !ghc::filesystem::exists(file_path.parent_path())) {
+    ghc::filesystem::create_directories(file_path.parent_path());
+  }
+
+  // Write to a temporary file then rename so readers never map a partial store
+  const ghc::filesystem::path tmp_path_(file_path.string() + ".tmp-" +
+                                        generate_random_hash());
+  {
+    std::ofstream out_(tmp_path_.string(),
+                       std::ios_base::binary | std::ios_base::trunc);
+    out_.write(reinterpret_cast<const char *>(&header_), sizeof(header_));
+    out_.write(reinterpret_cast<const char *>(records_.data()),
+               records_.size() * sizeof(ParameterStore::Record));
+    out_.write(strings_.data(), strings_.size());
+    if (!out_.flush()) {
+      out_.close();
+      ghc::filesystem::remove(tmp_path_);
+      throw parameter_store_error("Failed to write parameter store '" +
+                                  file_path.string() + "'");
+    }
+  }
+  ghc::filesystem::rename(tmp_path_, file_path);
+
+  logger::get_logger()->debug()
+      << "ParameterStore: Wrote " << records_.size() << " components to '"
+      << file_path.string() << "'";
+  return file_path;
+}
+
+ghc::filesystem::path
+convert_toml_to_parameter_store(const ghc::filesystem::path &toml_path,
+                                const ghc::filesystem::path &store_path) {
+  const ParameterSet::sptr parameters_ = ParameterSet::load(toml_path);
+  ParameterStoreWriter writer_;
+  for (const std::string &component_ : parameters_->components()) {
+    switch (parameters_->type(component_)) {
+    case ParameterSet::Type::POINT_ESTIMATE:
+      writer_.add_point_estimate(component_,
+                                 parameters_->point_estimate(component_));
+      break;
+    case ParameterSet::Type::DISTRIBUTION:
+      writer_.add_distribution(parameters_->distribution(component_));
+      break;
+    default:
+      throw parameter_store_error("Component " + component_ + " of '" +
+                                  toml_path.string() +
+                                  "' cannot be stored, only point estimates "
+                                  "and distributions are supported");
+    }
+  }
+  return writer_.write(store_path);
+}
+
+ghc::filesystem::path
+convert_parameter_store_to_toml(const ghc::filesystem::path &store_path,
+                                const ghc::filesystem::path &toml_path) {
+  const ParameterStore::sptr store_ = ParameterStore::open(store_path);
+  TomlWriter::sptr writer_ = TomlWriter::construct(toml_path);
+  for (const ParameterStore::Record &record_ : *store_) {
+    const std::string component_ = store_->component_name(record_);
+    if (record_.type ==
+        static_cast<std::uint32_t>(ParameterStore::Type::DISTRIBUTION)) {
+      Distribution(store_->distribution_name(record_), record_.value,
+                   record_.sigma, component_)
+          .write_to_toml(*writer_);
+    } else {
+      writer_->add_parameter("point-estimate", component_, record_.value);
+    }
+  }
+  return writer_->flush();
+}
+
+}; // namespace FairDataPipeline
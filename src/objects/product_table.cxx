@@ -0,0 +1,343 @@
+#include "fdp/objects/product_table.hxx"
+
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "fdp/utilities/flat_index.hxx"
+
+namespace FairDataPipeline {
+
+namespace {
+/**
+ * @brief Append-only pool of strings addressed by 32 bit ids
+ *
+ * Id 0 is the empty string. Strings added with intern() are stored once,
+ * strings added with append() are assumed unique and are not indexed, and
+ * may be overwritten with replace().
+ */
+class StringPool {
+public:
+  StringPool() : offsets_(2, 0) {}
+
+  std::uint32_t intern(const std::string &value) {
+    if (value.empty()) {
+      return 0;
+    }
+    std::uint32_t id_;
+    if (index_.find(hash_bytes(value.data(), value.size()),
+                    [&](std::uint32_t candidate) { return equals(candidate, value); },
+                    id_)) {
+      return id_;
+    }
+    id_ = append(value);
+    index_.insert(id_, [this](std::uint32_t id) { return hash(id); });
+    return id_;
+  }
+
+  std::uint32_t append(const std::string &value) {
+    if (value.empty()) {
+      return 0;
+    }
+    if (chars_.size() + value.size() > UINT32_MAX) {
+      throw std::length_error("ProductTable: String pool exhausted");
+    }
+    chars_.insert(chars_.end(), value.begin(), value.end());
+    offsets_.push_back(static_cast<std::uint32_t>(chars_.size()));
+    return static_cast<std::uint32_t>(offsets_.size() - 2);
+  }
+
+  /**
+   * @brief Replace a string added with append(), reusing its entry when the
+   * new value has the same size
+   */
+  std::uint32_t replace(std::uint32_t id, const std::string &value) {
+    if (id == 0 || size_(id) != value.size()) {
+      return append(value);
+    }
+    std::memcpy(&chars_[offsets_[id]], value.data(), value.size());
+    return id;
+  }
+
+  std::string get(std::uint32_t id) const {
+    return std::string(data_(id), size_(id));
+  }
+
+  bool equals(std::uint32_t id, const std::string &value) const {
+    return size_(id) == value.size() &&
+           std::memcmp(data_(id), value.data(), value.size()) == 0;
+  }
+
+  std::uint64_t hash(std::uint32_t id) const {
+    return hash_bytes(data_(id), size_(id));
+  }
+
+  std::size_t memory_usage() const {
+    return chars_.capacity() + offsets_.capacity() * sizeof(std::uint32_t) +
+           index_.memory_usage();
+  }
+
+private:
+  const char *data_(std::uint32_t id) const {
+    return chars_.data() + offsets_[id];
+  }
+  std::size_t size_(std::uint32_t id) const {
+    return offsets_[id + 1] - offsets_[id];
+  }
+
+  std::vector<char> chars_;
+  // offsets_[id] and offsets_[id + 1] bound string id, id 0 is empty
+  std::vector<std::uint32_t> offsets_;
+  FlatIndex index_;
+};
+
+enum ProductFlags : std::uint8_t {
+  PUBLIC = 1,
+  DIRECTORY = 2,
+  REGISTERED = 4
+};
+
+ApiObject::sptr api_object_from_uri_(const std::string &uri) {
+  Json::Value j_;
+  j_["url"] = uri;
+  return ApiObject::from_json(j_);
+}
+} // namespace
+
+class ProductTable::Shard {
+public:
+  mutable std::mutex mutex;
+
+  bool find_row(const std::string &data_product, std::uint32_t &row) const {
+    return index_.find(hash_bytes(data_product.data(), data_product.size()),
+                       [&](std::uint32_t candidate) {
+                         return pool_.equals(key_[candidate], data_product);
+                       },
+                       row);
+  }
+
+  void assign(const IOObject &product) {
+    std::uint32_t row_;
+    if (!find_row(product.get_data_product(), row_)) {
+      if (key_.size() >= UINT32_MAX - 1) {
+        throw std::length_error("ProductTable: Too many products");
+      }
+      row_ = static_cast<std::uint32_t>(key_.size());
+      key_.push_back(pool_.append(product.get_data_product()));
+      use_data_product_.push_back(0);
+      use_version_.push_back(0);
+      use_namespace_.push_back(0);
+      path_.push_back(0);
+      description_.push_back(0);
+      component_uri_.push_back(0);
+      data_product_uri_.push_back(0);
+      flags_.push_back(0);
+      index_.insert(row_, [this](std::uint32_t row) {
+        return pool_.hash(key_[row]);
+      });
+    }
+
+    // Names, versions and descriptions repeat across products, paths do not
+    // and a re-link reuses the row's path entry
+    use_data_product_[row_] = pool_.intern(product.get_use_data_product());
+    use_version_[row_] = pool_.intern(product.get_use_version());
+    use_namespace_[row_] = pool_.intern(product.get_use_namespace());
+    path_[row_] = pool_.replace(path_[row_], product.get_path().string());
+    description_[row_] = pool_.intern(product.get_data_product_description());
+
+    std::uint8_t flags_value_ = 0;
+    if (product.is_public()) {
+      flags_value_ |= PUBLIC;
+    }
+    if (product.is_directory()) {
+      flags_value_ |= DIRECTORY;
+    }
+    if (flags_[row_] & REGISTERED) {
+      --n_registered_;
+    }
+    flags_[row_] = flags_value_;
+
+    if (product.get_component_object()) {
+      set_registry_objects(row_, product.get_component_object()->get_uri(),
+                           product.get_data_product_object()
+                               ? product.get_data_product_object()->get_uri()
+                               : std::string());
+    }
+  }
+
+  void set_registry_objects(std::uint32_t row,
+                            const std::string &component_uri,
+                            const std::string &data_product_uri) {
+    component_uri_[row] = pool_.replace(component_uri_[row], component_uri);
+    data_product_uri_[row] =
+        pool_.replace(data_product_uri_[row], data_product_uri);
+    if (!(flags_[row] & REGISTERED)) {
+      flags_[row] |= REGISTERED;
+      ++n_registered_;
+    }
+  }
+
+  IOObject build(std::uint32_t row) const {
+    IOObject product_(pool_.get(key_[row]), pool_.get(use_data_product_[row]),
+                      pool_.get(use_version_[row]),
+                      pool_.get(use_namespace_[row]),
+                      ghc::filesystem::path(pool_.get(path_[row])),
+                      pool_.get(description_[row]), flags_[row] & PUBLIC,
+                      (flags_[row] & DIRECTORY) != 0);
+    if (flags_[row] & REGISTERED) {
+      product_.set_component_object(
+          *api_object_from_uri_(pool_.get(component_uri_[row])));
+      product_.set_data_product_object(
+          *api_object_from_uri_(pool_.get(data_product_uri_[row])));
+    }
+    return product_;
+  }
+
+  std::size_t size() const { return key_.size(); }
+  std::size_t n_registered() const { return n_registered_; }
+
+  std::size_t memory_usage() const {
+    const std::size_t columns_ =
+        (key_.capacity() + use_data_product_.capacity() +
+         use_version_.capacity() + use_namespace_.capacity() +
+         path_.capacity() + description_.capacity() +
+         component_uri_.capacity() + data_product_uri_.capacity()) *
+            sizeof(std::uint32_t) +
+        flags_.capacity();
+    return columns_ + pool_.memory_usage() + index_.memory_usage();
+  }
+
+  std::size_t probe_length() const {
+    return index_.probe_length(
+        [this](std::uint32_t row) { return pool_.hash(key_[row]); });
+  }
+
+private:
+  StringPool pool_;
+  FlatIndex index_;
+  std::size_t n_registered_ = 0;
+
+  // One column per field, indexed by row
+  std::vector<std::uint32_t> key_;
+  std::vector<std::uint32_t> use_data_product_;
+  std::vector<std::uint32_t> use_version_;
+  std::vector<std::uint32_t> use_namespace_;
+  std::vector<std::uint32_t> path_;
+  std::vector<std::uint32_t> description_;
+  std::vector<std::uint32_t> component_uri_;
+  std::vector<std::uint32_t> data_product_uri_;
+  std::vector<std::uint8_t> flags_;
+};
+
+ProductTable::ProductTable() {
+  for (auto &shard_ : shards_) {
+    shard_.reset(new Shard());
+  }
+}
+
+ProductTable::~ProductTable() {}
+
+ProductTable::Shard &
+ProductTable::shard_for_(const std::string &data_product) const {
+  // The index of a shard starts probing at the low bits of the hash, so the
+  // shard is picked by the high bits
+  return *shards_[hash_bytes(data_product.data(), data_product.size()) >>
+                  (64 - shard_bits_)];
+}
+
+void ProductTable::insert_or_assign(const IOObject &product) {
+  Shard &shard_ = shard_for_(product.get_data_product());
+  std::lock_guard<std::mutex> lock_(shard_.mutex);
+  shard_.assign(product);
+}
+
+bool ProductTable::find(const std::string &data_product,
+                        IOObject &product) const {
+  const Shard &shard_ = shard_for_(data_product);
+  std::lock_guard<std::mutex> lock_(shard_.mutex);
+  std::uint32_t row_;
+  if (!shard_.find_row(data_product, row_)) {
+    return false;
+  }
+  product = shard_.build(row_);
+  return true;
+}
+
+bool ProductTable::contains(const std::string &data_product) const {
+  const Shard &shard_ = shard_for_(data_product);
+  std::lock_guard<std::mutex> lock_(shard_.mutex);
+  std::uint32_t row_;
+  return shard_.find_row(data_product, row_);
+}
+
+bool ProductTable::set_registry_objects(const std::string &data_product,
+                                        const std::string &component_uri,
+                                        const std::string &data_product_uri) {
+  Shard &shard_ = shard_for_(data_product);
+  std::lock_guard<std::mutex> lock_(shard_.mutex);
+  std::uint32_t row_;
+  if (!shard_.find_row(data_product, row_)) {
+    return false;
+  }
+  shard_.set_registry_objects(row_, component_uri, data_product_uri);
+  return true;
+}
+
+void ProductTable::for_each(const visitor_type &visitor) const {
+  for (const auto &shard_ : shards_) {
+    for (std::uint32_t row_ = 0;; ++row_) {
+      IOObject product_;
+      {
+        std::lock_guard<std::mutex> lock_(shard_->mutex);
+        if (row_ >= shard_->size()) {
+          break;
+        }
+        product_ = shard_->build(row_);
+      }
+      visitor(product_);
+    }
+  }
+}
+
+std::size_t ProductTable::size() const {
+  std::size_t size_ = 0;
+  for (const auto &shard_ : shards_) {
+    std::lock_guard<std::mutex> lock_(shard_->mutex);
+    size_ += shard_->size();
+  }
+  return size_;
+}
+
+std::size_t ProductTable::count_registered() const {
+  std::size_t count_ = 0;
+  for (const auto &shard_ : shards_) {
+    std::lock_guard<std::mutex> lock_(shard_->mutex);
+    count_ += shard_->n_registered();
+  }
+  return count_;
+}
+
+std::size_t ProductTable::memory_usage() const {
+  std::size_t bytes_ = sizeof(ProductTable);
+  for (const auto &shard_ : shards_) {
+    std::lock_guard<std::mutex> lock_(shard_->mutex);
+    bytes_ += sizeof(Shard) + shard_->memory_usage();
+  }
+  return bytes_;
+}
+
+double ProductTable::mean_probe_length() const {
+  std::size_t probes_ = 0;
+  std::size_t size_ = 0;
+  for (const auto &shard_ : shards_) {
+    std::lock_guard<std::mutex> lock_(shard_->mutex);
+    probes_ += shard_->probe_length();
+    size_ += shard_->size();
+  }
+  return size_ == 0 ? 0.0
+                    : static_cast<double>(probes_) / static_cast<double>(size_);
+}
+
+}; // namespace FairDataPipeline
@@ -0,0 +1,338 @@
+#include "fdp/objects/shared_parameter_cache.hxx"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "fdp/exceptions.hxx"
+#include "fdp/objects/metadata.hxx"
+#include "fdp/utilities/logging.hxx"
+
+namespace FairDataPipeline {
+
+namespace {
+std::mutex global_mutex_;
+SharedParameterCache::sptr global_cache_;
+bool global_checked_ = false;
+
+/**
+ * @brief Create a file only if it does not exist, atomically
+ */
+bool create_exclusive_(const ghc::filesystem::path &file_path) {
+#ifdef _WIN32
+  const int fd_ = ::_open(file_path.string().c_str(),
+                          _O_WRONLY | _O_CREAT | _O_EXCL, _S_IREAD | _S_IWRITE);
+  if (fd_ < 0) {
+    return false;
+  }
+  ::_close(fd_);
+#else
+  const int fd_ =
+      ::open(file_path.string().c_str(), O_WRONLY | O_CREAT | O_EXCL, 0600);
+  if (fd_ < 0) {
+    return false;
+  }
+  ::close(fd_);
+#endif
+  return true;
+}
+
+/**
+ * @brief Seconds since a file was last modified, negative if it is missing
+ */
+double age_seconds_(const ghc::filesystem::path &file_path) {
+  std::error_code ec_;
+  const ghc::filesystem::file_time_type modified_ =
+      ghc::filesystem::last_write_time(file_path, ec_);
+  if (ec_) {
+    return -1.0;
+  }
+  return std::chrono::duration<double>(
+             ghc::filesystem::file_time_type::clock::now() - modified_)
+      .count();
+}
+
+void remove_quietly_(const ghc::filesystem::path &file_path) {
+  std::error_code ec_;
+  ghc::filesystem::remove(file_path, ec_);
+}
+
+#ifndef _WIN32
+/**
+ * @brief Check only this user can write to a cache directory
+ *
+ * The default directory has a predictable name in a world writable
+ * location, so another user could have created it, or a symlink in its
+ * place, to feed stores to this user's processes.
+ */
+void check_private_directory_(const ghc::filesystem::path &directory) {
+  struct stat st_;
+  if (::lstat(directory.string().c_str(), &st_) != 0) {
+    throw parameter_store_error("Cannot stat parameter cache directory '" +
+                                directory.string() + "'");
+  }
+  if (S_ISLNK(st_.st_mode) || !S_ISDIR(st_.st_mode)) {
+    throw parameter_store_error("Parameter cache '" + directory.string() +
+                                "' is not a directory");
+  }
+  if (st_.st_uid != ::getuid()) {
+    throw parameter_store_error("Parameter cache directory '" +
+                                directory.string() +
+                                "' is owned by another user");
+  }
+  if ((st_.st_mode & 0777) != 0700) {
+    throw parameter_store_error("Parameter cache directory '" +
+                                directory.string() + "' must have mode 0700");
+  }
+}
+#endif
+} // namespace
+
+SharedParameterCache::SharedParameterCache(
+    const ghc::filesystem::path &directory, double timeout_s)
+    : directory_(directory), timeout_s_(timeout_s) {
+#ifdef _WIN32
+  if (!ghc::filesystem::exists(directory_)) {
+    ghc::filesystem::create_directories(directory_);
+    std::error_code ec_;
+    ghc::filesystem::permissions(directory_,
+                                 ghc::filesystem::perms::owner_all, ec_);
+  }
+#else
+  if (!directory_.parent_path().empty()) {
+    ghc::filesystem::create_directories(directory_.parent_path());
+  }
+  // Created here with mode 0700 whatever the umask, an existing directory
+  // (or anything else in its place) is only used if it passes the check
+  if (::mkdir(directory_.string().c_str(), 0700) == 0) {
+    ::chmod(directory_.string().c_str(), 0700);
+  }
+  check_private_directory_(directory_);
+#endif
+}
+
+SharedParameterCache::sptr
+SharedParameterCache::construct(const ghc::filesystem::path &directory,
+                                double timeout_s) {
+  return sptr(new SharedParameterCache(directory, timeout_s));
+}
+
+ghc::filesystem::path SharedParameterCache::default_directory() {
+#ifdef _WIN32
+  return ghc::filesystem::temp_directory_path() / "fdpapi-parameters";
+#else
+  const std::string name_ = "fdpapi-parameters-" + std::to_string(::getuid());
+  std::error_code ec_;
+  if (ghc::filesystem::is_directory("/dev/shm", ec_)) {
+    return ghc::filesystem::path("/dev/shm") / name_;
+  }
+  return ghc::filesystem::temp_directory_path() / name_;
+#endif
+}
+
+SharedParameterCache::sptr SharedParameterCache::get_cache() {
+  std::lock_guard<std::mutex> lock_(global_mutex_);
+  if (!global_checked_) {
+    global_checked_ = true;
+    const char *setting_ = std::getenv("FDP_PARAMETER_CACHE");
+    if (setting_ && *setting_ && std::string(setting_) != "0") {
+      const ghc::filesystem::path directory_ =
+          std::string(setting_) == "1" ? default_directory()
+                                       : ghc::filesystem::path(setting_);
+      try {
+        global_cache_ = construct(directory_);
+      } catch (const std::exception &e) {
+        logger::get_logger()->error()
+            << "SharedParameterCache: Cannot use '" << directory_.string()
+            << "': " << e.what();
+      }
+    }
+  }
+  return global_cache_;
+}
+
+ParameterStore::sptr
+SharedParameterCache::open_shared(const ghc::filesystem::path &file_path) {
+  const sptr cache_ = get_cache();
+  if (!cache_) {
+    return ParameterStore::sptr();
+  }
+  try {
+    return cache_->open(file_path);
+  } catch (const std::exception &e) {
+    logger::get_logger()->debug()
+        << "SharedParameterCache: Reading '" << file_path.string()
+        << "' directly: " << e.what();
+    return ParameterStore::sptr();
+  }
+}
+
+void SharedParameterCache::enable(const ghc::filesystem::path &directory) {
+  sptr cache_ = construct(directory);
+  std::lock_guard<std::mutex> lock_(global_mutex_);
+  global_checked_ = true;
+  global_cache_ = cache_;
+}
+
+void SharedParameterCache::disable() {
+  std::lock_guard<std::mutex> lock_(global_mutex_);
+  global_checked_ = true;
+  global_cache_.reset();
+}
+
+ParameterStore::sptr
+SharedParameterCache::open(const ghc::filesystem::path &file_path) {
+  const std::string source_ = file_path.string();
+  HashCache::key_type key_;
+  const bool has_key_ = HashCache::get_key(file_path, key_);
+
+  if (has_key_) {
+    std::lock_guard<std::mutex> lock_(mutex_);
+    auto it = entries_.find(source_);
+    if (it != entries_.end() && it->second.key == key_) {
+      return it->second.store;
+    }
+  }
+
+  // Hashing and waiting for another process are done without the lock, so
+  // one slow file does not hold up readers of others. The store of a file's
+  // old contents is kept, as another file with the same contents, here or
+  // in another process, may still use it
+  const std::string hash_ = calculate_hash_from_file(file_path);
+  Entry entry_;
+  entry_.key = key_;
+  entry_.store = attach_(file_path, hash_);
+  if (has_key_) {
+    std::lock_guard<std::mutex> lock_(mutex_);
+    entries_[source_] = entry_;
+  }
+  return entry_.store;
+}
+
+ParameterStore::sptr
+SharedParameterCache::attach_(const ghc::filesystem::path &file_path,
+                              const std::string &hash) {
+  const ghc::filesystem::path store_path_ = directory_ / (hash + ".fdpp");
+  const ghc::filesystem::path none_path_ = directory_ / (hash + ".none");
+  const ghc::filesystem::path lock_path_ = directory_ / (hash + ".lock");
+
+  const auto start_ = std::chrono::steady_clock::now();
+  for (;;) {
+    if (ghc::filesystem::exists(store_path_)) {
+      try {
+        return ParameterStore::open(store_path_);
+      } catch (const parameter_store_error &e) {
+        // Written by an incompatible version, or damaged: rebuild it
+        logger::get_logger()->debug()
+            << "SharedParameterCache: Discarding '" << store_path_.string()
+            << "': " << e.what();
+        remove_quietly_(store_path_);
+      }
+    }
+    if (ghc::filesystem::exists(none_path_)) {
+      return ParameterStore::sptr();
+    }
+    if (create_exclusive_(lock_path_)) {
+      ParameterStore::sptr store_;
+      try {
+        store_ = build_(file_path, hash);
+      } catch (...) {
+        remove_quietly_(lock_path_);
+        throw;
+      }
+      remove_quietly_(lock_path_);
+      return store_;
+    }
+
+    // Another process is building the store
+    const double waited_ = std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() - start_)
+                               .count();
+    if (waited_ > timeout_s_) {
+      if (age_seconds_(lock_path_) > timeout_s_) {
+        logger::get_logger()->debug()
+            << "SharedParameterCache: Removing stale lock '"
+            << lock_path_.string() << "'";
+        remove_quietly_(lock_path_);
+        continue;
+      }
+      logger::get_logger()->debug()
+          << "SharedParameterCache: Timed out waiting for '"
+          << store_path_.string() << "', reading '" << file_path.string()
+          << "' directly";
+      return ParameterStore::sptr();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+}
+
+ParameterStore::sptr
+SharedParameterCache::build_(const ghc::filesystem::path &file_path,
+                             const std::string &hash) {
+  const ghc::filesystem::path store_path_ = directory_ / (hash + ".fdpp");
+  try {
+    convert_toml_to_parameter_store(file_path, store_path_);
+  } catch (const parameter_store_error &e) {
+    logger::get_logger()->debug()
+        << "SharedParameterCache: '" << file_path.string()
+        << "' will be read directly: " << e.what();
+    std::ofstream marker_((directory_ / (hash + ".none")).string());
+    return ParameterStore::sptr();
+  }
+
+  // A file rewritten while it was converted is not cached under this hash
+  if (calculate_hash_from_file(file_path) != hash) {
+    remove_quietly_(store_path_);
+    return ParameterStore::sptr();
+  }
+  logger::get_logger()->debug()
+      << "SharedParameterCache: Built '" << store_path_.string()
+      << "' from '" << file_path.string() << "'";
+  return ParameterStore::open(store_path_);
+}
+
+std::size_t SharedParameterCache::prune(double max_age_s) {
+  std::lock_guard<std::mutex> lock_(mutex_);
+  std::vector<ghc::filesystem::path> expired_;
+  std::error_code ec_;
+  for (ghc::filesystem::directory_iterator it(directory_, ec_), end_;
+       !ec_ && it != end_; it.increment(ec_)) {
+    const ghc::filesystem::path path_ = it->path();
+    const std::string extension_ = path_.extension().string();
+    const bool cache_file_ =
+        extension_ == ".fdpp" || extension_ == ".none" ||
+        extension_ == ".lock" ||
+        path_.filename().string().find(".fdpp.tmp-") != std::string::npos;
+    if (cache_file_ && (max_age_s < 0.0 || age_seconds_(path_) > max_age_s)) {
+      expired_.push_back(path_);
+    }
+  }
+
+  std::size_t n_removed_ = 0;
+  for (const ghc::filesystem::path &path_ : expired_) {
+    std::error_code remove_ec_;
+    if (ghc::filesystem::remove(path_, remove_ec_)) {
+      ++n_removed_;
+    }
+  }
+  entries_.clear();
+  logger::get_logger()->debug()
+      << "SharedParameterCache: Removed " << n_removed_ << " files from '"
+      << directory_.string() << "'";
+  return n_removed_;
+}
+
+}; // namespace FairDataPipeline
@@ -1,6 +1,15 @@
 #include "fdp/registry/api.hxx"
 
+#include <mutex>
+
 namespace FairDataPipeline {
+// curl_global_init is not thread safe, so it is run exactly once and never
+// undone while sessions may still be making requests from other threads
+static void curl_global_init_once_() {
+    static std::once_flag curl_init_flag_;
+    std::call_once(curl_init_flag_, []() { curl_global_init(CURL_GLOBAL_DEFAULT); });
+}
+
 static size_t write_str_(char *ptr, size_t size, size_t nmemb, void* userdata ) {
     std::string* data = static_cast< std::string* >( userdata );
     data->append((char *)ptr, size * nmemb);
@@ -15,27 +24,63 @@ static size_t write_file_(char*ptr, size_t size, size_t nmemb, void* userdata )
 
 API::sptr API::construct( const std::string& url_root )
 {
+    curl_global_init_once_();
     return API::sptr( new API( url_root ) );
 }
 
 std::string url_encode( const std::string& url) {
+  curl_global_init_once_();
   CURL *curl_ = curl_easy_init();
   curl_easy_setopt(curl_, CURLOPT_SSLVERSION, CURL_SSLVERSION_TLSv1_2);
   return curl_easy_escape(curl_, url.c_str(), 0);
 }
 
+API::~API() {
+  for (CURL *curl_ : idle_handles_) {
+    curl_easy_cleanup(curl_);
+  }
+}
+
+// Requests made by each thread, read back to report finalise progress
+static thread_local std::size_t thread_requests_ = 0;
+
+std::size_t API::thread_request_count() { return thread_requests_; }
+
+CURL *API::acquire_handle_() {
+  ++thread_requests_;
+  {
+    std::lock_guard<std::mutex> lock_(handles_mutex_);
+    if (!idle_handles_.empty()) {
+      CURL *curl_ = idle_handles_.back();
+      idle_handles_.pop_back();
+      // Clears options but keeps open connections and the DNS cache
+      curl_easy_reset(curl_);
+      return curl_;
+    }
+  }
+  return curl_easy_init();
+}
+
+void API::release_handle_(CURL *curl) {
+  std::lock_guard<std::mutex> lock_(handles_mutex_);
+  if (idle_handles_.size() < max_idle_handles_) {
+    idle_handles_.push_back(curl);
+  } else {
+    curl_easy_cleanup(curl);
+  }
+}
+
 CURL *API::setup_json_session_(std::string &addr_path, std::string *response,
                                long &http_code, std::string token) {
-  CURL *curl_ = curl_easy_init();
+  CURL *curl_ = acquire_handle_();
   curl_easy_setopt(curl_, CURLOPT_SSLVERSION, CURL_SSLVERSION_TLSv1_2);
 
-
+  struct curl_slist *headers = NULL;
   if (!token.empty()) {
     logger::get_logger()->debug() 
         << "Adding token: " 
         << token
         << " to headers";
-    struct curl_slist *headers = NULL;
     headers = curl_slist_append(
         headers, (std::string("Authorization: token ") + token).c_str());
     curl_easy_setopt(curl_, CURLOPT_HTTPHEADER, headers);
@@ -53,8 +98,8 @@ CURL *API::setup_json_session_(std::string &addr_path, std::string *response,
   } else {
     http_code = 0;
   }
-  curl_easy_cleanup(curl_);
-  curl_global_cleanup();
+  curl_slist_free_all(headers);
+  release_handle_(curl_);
 
   return curl_;
 }
@@ -89,7 +134,6 @@ CURL *API::setup_download_session_(const ghc::filesystem::path &addr_path,
   curl_easy_setopt(curl_, CURLOPT_WRITEDATA, file);
   curl_easy_perform(curl_);
   curl_easy_cleanup(curl_);
-  curl_global_cleanup();
   return curl_;
 }
 
@@ -222,7 +266,12 @@ Json::Value API::post_file_type(Json::Value &post_data, const std::string &token
     logger::get_logger()->error() << "Error: Post Data does not contain a file extension";
     throw rest_apiquery_error("Failed to post file_type");
   }
-  post_data["extension"] = regex_replace(post_data["name"].asString(), std::regex("."), "");
+  // Extensions are stored without their leading dot
+  std::string extension_ = post_data["extension"].asString();
+  if (!extension_.empty() && extension_[0] == '.') {
+    extension_.erase(0, 1);
+  }
+  post_data["extension"] = extension_;
   Json::Value _file_type_query;
   _file_type_query["extension"] = post_data["extension"];
   Json::Value _file_type_exists = get_by_json_query("file_type", _file_type_query);
@@ -246,7 +295,7 @@ Json::Value API::post_patch_request(std::string addr_path, Json::Value &post_dat
   logger::get_logger()->debug() << "API:Post: Post Data\n" << data_;
   long return_code_;
   std::string response_;
-  CURL *curl_ = curl_easy_init();
+  CURL *curl_ = acquire_handle_();
 
   struct curl_slist *headers = NULL;
   headers = curl_slist_append(headers, "Content-Type: application/json");
@@ -276,8 +325,8 @@ Json::Value API::post_patch_request(std::string addr_path, Json::Value &post_dat
   if (res == CURLE_OK) {
     curl_easy_getinfo(curl_, CURLINFO_RESPONSE_CODE, &http_code);
   } else {
-    curl_easy_cleanup(curl_);
-    curl_global_cleanup();
+    curl_slist_free_all(headers);
+    release_handle_(curl_);
     logger::get_logger()->error() 
         << "API:Post: Post to '"
         <<url_path_
@@ -285,8 +334,8 @@ Json::Value API::post_patch_request(std::string addr_path, Json::Value &post_dat
     throw rest_apiquery_error("No response was given");
   }
 
-  curl_easy_cleanup(curl_);
-  curl_global_cleanup();
+  curl_slist_free_all(headers);
+  release_handle_(curl_);
 
   if (http_code == 404) {
     throw rest_apiquery_error("'" + addr_path + "' does not exist");
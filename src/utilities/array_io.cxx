@@ -0,0 +1,1091 @@
+#include "fdp/utilities/array_io.hxx"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+
+#include "digestpp/digestpp.hpp"
+
+#ifdef FDPAPI_WITH_ZSTD
+#include <zstd.h>
+#endif
+#ifdef FDPAPI_WITH_LZ4
+#include <lz4.h>
+#endif
+#ifdef FDPAPI_WITH_ZLIB
+#include <zlib.h>
+#endif
+#ifdef FDPAPI_WITH_HDF5
+#include <hdf5.h>
+#endif
+
+#include "fdp/objects/metadata.hxx"
+#include "fdp/utilities/hash_cache.hxx"
+#include "fdp/utilities/logging.hxx"
+#include "fdp/utilities/parallel.hxx"
+
+namespace FairDataPipeline {
+
+namespace {
+const char magic_[8] = {'F', 'D', 'P', 'A', 'R', 'R', 'Y', '\0'};
+const std::uint32_t byte_order_mark_ = 0x01020304;
+const std::uint32_t version_ = 1;
+const std::uint64_t target_chunk_bytes_ = 1 << 20;
+const std::uint64_t max_chunk_bytes_ = 1 << 30;
+const std::uint32_t max_rank_ = 32;
+
+struct Header {
+  char magic[8];
+  std::uint32_t byte_order;
+  std::uint32_t version;
+  std::uint32_t type;
+  std::uint32_t codec;
+  std::uint32_t rank;
+  std::uint32_t component_size;
+  std::uint64_t n_chunks;
+  std::uint64_t reserved[3];
+};
+
+struct IndexEntry {
+  std::uint64_t offset;
+  std::uint64_t stored_size;
+  std::uint32_t codec; /*!< NONE for chunks which did not compress */
+  std::uint32_t reserved;
+};
+
+struct Footer {
+  std::uint64_t index_offset;
+  std::uint64_t n_chunks;
+  char magic[8];
+};
+
+static_assert(sizeof(Header) == 64, "Array header must be packed");
+static_assert(sizeof(IndexEntry) == 24, "Array index entry must be packed");
+static_assert(sizeof(Footer) == 24, "Array footer must be packed");
+
+bool is_hdf5_path_(const ghc::filesystem::path &file_path) {
+  std::string extension_ = file_path.extension().string();
+  std::transform(extension_.begin(), extension_.end(), extension_.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return extension_ == ".h5" || extension_ == ".hdf5";
+}
+
+std::uint64_t product_(const std::vector<std::uint64_t> &extents) {
+  std::uint64_t product_ = 1;
+  for (std::uint64_t extent_ : extents) {
+    product_ *= extent_;
+  }
+  return product_;
+}
+
+/**
+ * @brief Chunks of about target_chunk_bytes_, halving leading dimensions
+ * first so chunks stay contiguous in the trailing ones
+ */
+std::vector<std::uint64_t>
+automatic_chunk_shape_(const std::vector<std::uint64_t> &shape,
+                       std::size_t element_size) {
+  std::vector<std::uint64_t> chunk_(shape);
+  for (std::uint64_t &extent_ : chunk_) {
+    extent_ = std::max<std::uint64_t>(extent_, 1);
+  }
+  for (std::size_t d = 0; d < chunk_.size(); ++d) {
+    while (chunk_[d] > 1 &&
+           product_(chunk_) * element_size > target_chunk_bytes_) {
+      chunk_[d] = (chunk_[d] + 1) / 2;
+    }
+  }
+  return chunk_;
+}
+
+/**
+ * @brief Whether each chunk extent is at least one and at most its
+ * dimension, or one for an empty dimension
+ */
+bool valid_chunk_shape_(const std::vector<std::uint64_t> &shape,
+                        const std::vector<std::uint64_t> &chunk_shape,
+                        std::size_t element_size) {
+  if (chunk_shape.size() != shape.size()) {
+    return false;
+  }
+  for (std::size_t d = 0; d < shape.size(); ++d) {
+    if (chunk_shape[d] == 0 ||
+        chunk_shape[d] > std::max<std::uint64_t>(shape[d], 1)) {
+      return false;
+    }
+  }
+  return product_(chunk_shape) * element_size <= max_chunk_bytes_;
+}
+
+/**
+ * @brief Geometry of the chunk grid of an array
+ */
+struct ChunkGrid {
+  std::vector<std::uint64_t> shape;
+  std::vector<std::uint64_t> chunk_shape;
+  std::vector<std::uint64_t> grid;
+
+  ChunkGrid(const std::vector<std::uint64_t> &shape,
+            const std::vector<std::uint64_t> &chunk_shape)
+      : shape(shape), chunk_shape(chunk_shape), grid(shape.size()) {
+    for (std::size_t d = 0; d < shape.size(); ++d) {
+      grid[d] = (shape[d] + chunk_shape[d] - 1) / chunk_shape[d];
+    }
+  }
+
+  std::uint64_t n_chunks() const { return product_(grid); }
+
+  /**
+   * @brief First element and extent of a chunk, clipped to the array
+   */
+  void bounds(std::uint64_t chunk, std::vector<std::uint64_t> &start,
+              std::vector<std::uint64_t> &extent) const {
+    start.resize(shape.size());
+    extent.resize(shape.size());
+    for (std::size_t d = shape.size(); d-- > 0;) {
+      start[d] = (chunk % grid[d]) * chunk_shape[d];
+      extent[d] = std::min(chunk_shape[d], shape[d] - start[d]);
+      chunk /= grid[d];
+    }
+  }
+};
+
+/**
+ * @brief Copy a box between two row-major arrays
+ *
+ * @param src array of src_shape, the box starts at src_start
+ * @param dst array of dst_shape, the box starts at dst_start
+ * @param extent shape of the box
+ */
+void copy_box_(const char *src, const std::vector<std::uint64_t> &src_shape,
+               const std::vector<std::uint64_t> &src_start, char *dst,
+               const std::vector<std::uint64_t> &dst_shape,
+               const std::vector<std::uint64_t> &dst_start,
+               const std::vector<std::uint64_t> &extent,
+               std::size_t element_size) {
+  const std::size_t rank_ = extent.size();
+  if (product_(extent) == 0) {
+    return;
+  }
+  const std::size_t run_bytes_ =
+      static_cast<std::size_t>(extent[rank_ - 1]) * element_size;
+  std::vector<std::uint64_t> index_(rank_, 0);
+  for (;;) {
+    std::uint64_t src_offset_ = 0;
+    std::uint64_t dst_offset_ = 0;
+    for (std::size_t d = 0; d < rank_; ++d) {
+      src_offset_ = src_offset_ * src_shape[d] + src_start[d] + index_[d];
+      dst_offset_ = dst_offset_ * dst_shape[d] + dst_start[d] + index_[d];
+    }
+    std::memcpy(dst + dst_offset_ * element_size,
+                src + src_offset_ * element_size, run_bytes_);
+
+    // Next run, the last dimension is copied whole
+    std::size_t d = rank_ - 1;
+    while (d-- > 0) {
+      if (++index_[d] < extent[d]) {
+        break;
+      }
+      index_[d] = 0;
+    }
+    if (d == static_cast<std::size_t>(-1)) {
+      return;
+    }
+  }
+}
+
+/**
+ * @brief Compress a chunk
+ *
+ * @return true dst holds the compressed chunk
+ * @return false the chunk did not compress and should be stored as is
+ */
+bool compress_(ArrayCodec codec, int level, const char *src,
+               std::size_t src_size, std::vector<char> &dst) {
+  switch (codec) {
+  case ArrayCodec::NONE:
+    // The arguments are only read by codecs, which may all be compiled out
+    (void)level;
+    (void)src;
+    (void)src_size;
+    (void)dst;
+    return false;
+#ifdef FDPAPI_WITH_ZSTD
+  case ArrayCodec::ZSTD: {
+    dst.resize(ZSTD_compressBound(src_size));
+    const std::size_t size_ =
+        ZSTD_compress(dst.data(), dst.size(), src, src_size, level);
+    if (ZSTD_isError(size_) || size_ >= src_size) {
+      return false;
+    }
+    dst.resize(size_);
+    return true;
+  }
+#endif
+#ifdef FDPAPI_WITH_LZ4
+  case ArrayCodec::LZ4: {
+    dst.resize(LZ4_compressBound(static_cast<int>(src_size)));
+    const int size_ =
+        LZ4_compress_default(src, dst.data(), static_cast<int>(src_size),
+                             static_cast<int>(dst.size()));
+    if (size_ <= 0 || static_cast<std::size_t>(size_) >= src_size) {
+      return false;
+    }
+    dst.resize(size_);
+    return true;
+  }
+#endif
+#ifdef FDPAPI_WITH_ZLIB
+  case ArrayCodec::DEFLATE: {
+    uLongf size_ = compressBound(static_cast<uLong>(src_size));
+    dst.resize(size_);
+    if (compress2(reinterpret_cast<Bytef *>(dst.data()), &size_,
+                  reinterpret_cast<const Bytef *>(src),
+                  static_cast<uLong>(src_size),
+                  std::min(std::max(level, 1), 9)) != Z_OK ||
+        size_ >= src_size) {
+      return false;
+    }
+    dst.resize(size_);
+    return true;
+  }
+#endif
+  default:
+    throw array_error("Codec " + to_string(codec) +
+                      " is not available in this build");
+  }
+}
+
+void decompress_(ArrayCodec codec, const char *src, std::size_t src_size,
+                 char *dst, std::size_t dst_size) {
+  bool ok_ = false;
+  switch (codec) {
+  case ArrayCodec::NONE:
+    ok_ = src_size == dst_size;
+    if (ok_) {
+      std::memcpy(dst, src, src_size);
+    }
+    break;
+#ifdef FDPAPI_WITH_ZSTD
+  case ArrayCodec::ZSTD:
+    ok_ = ZSTD_decompress(dst, dst_size, src, src_size) == dst_size;
+    break;
+#endif
+#ifdef FDPAPI_WITH_LZ4
+  case ArrayCodec::LZ4:
+    ok_ = LZ4_decompress_safe(src, dst, static_cast<int>(src_size),
+                              static_cast<int>(dst_size)) ==
+          static_cast<int>(dst_size);
+    break;
+#endif
+#ifdef FDPAPI_WITH_ZLIB
+  case ArrayCodec::DEFLATE: {
+    uLongf size_ = static_cast<uLongf>(dst_size);
+    ok_ = uncompress(reinterpret_cast<Bytef *>(dst), &size_,
+                     reinterpret_cast<const Bytef *>(src),
+                     static_cast<uLong>(src_size)) == Z_OK &&
+          size_ == dst_size;
+    break;
+  }
+#endif
+  default:
+    throw array_error("Codec " + to_string(codec) +
+                      " is not available in this build");
+  }
+  if (!ok_) {
+    throw array_error("Array chunk is corrupt");
+  }
+}
+
+void check_slab_(const std::vector<std::uint64_t> &shape,
+                 const std::vector<std::uint64_t> &offset,
+                 const std::vector<std::uint64_t> &count) {
+  if (offset.size() != shape.size() || count.size() != shape.size()) {
+    throw array_error("Hyperslab rank differs from the array rank " +
+                      std::to_string(shape.size()));
+  }
+  for (std::size_t d = 0; d < shape.size(); ++d) {
+    if (offset[d] > shape[d] || count[d] > shape[d] - offset[d]) {
+      throw array_error("Hyperslab is out of bounds in dimension " +
+                        std::to_string(d));
+    }
+  }
+}
+
+/**
+ * @brief Write the native format, hashing the bytes as they are written
+ */
+std::string write_native_(const ghc::filesystem::path &file_path,
+                          const std::string &component, ArrayType type,
+                          const char *data,
+                          const std::vector<std::uint64_t> &shape,
+                          const std::vector<std::uint64_t> &chunk_shape,
+                          const ArrayOptions &options) {
+  if (ghc::filesystem::exists(file_path)) {
+    throw array_error("Array file '" + file_path.string() +
+                      "' already exists, native array files hold one "
+                      "component");
+  }
+  const std::size_t element_size_ = array_type_size(type);
+  const ChunkGrid grid_(shape, chunk_shape);
+  const std::uint64_t n_chunks_ = grid_.n_chunks();
+
+  const ghc::filesystem::path tmp_path_(file_path.string() + ".tmp-" +
+                                        generate_random_hash());
+  digestpp::sha1 hasher_;
+  std::uint64_t position_ = 0;
+  std::vector<IndexEntry> index_(static_cast<std::size_t>(n_chunks_));
+  try {
+    std::ofstream out_(tmp_path_.string(),
+                       std::ios_base::out | std::ios_base::binary);
+    if (!out_) {
+      throw array_error("Cannot write array file '" + file_path.string() +
+                        "'");
+    }
+    auto write_ = [&](const void *bytes, std::size_t size) {
+      out_.write(static_cast<const char *>(bytes), size);
+      hasher_.absorb(static_cast<const char *>(bytes), size);
+      position_ += size;
+    };
+
+    Header header_;
+    std::memset(&header_, 0, sizeof(header_));
+    std::memcpy(header_.magic, magic_, sizeof(magic_));
+    header_.byte_order = byte_order_mark_;
+    header_.version = version_;
+    header_.type = static_cast<std::uint32_t>(type);
+    header_.codec = static_cast<std::uint32_t>(options.codec);
+    header_.rank = static_cast<std::uint32_t>(shape.size());
+    header_.component_size = static_cast<std::uint32_t>(component.size());
+    header_.n_chunks = n_chunks_;
+    write_(&header_, sizeof(header_));
+    write_(shape.data(), shape.size() * sizeof(std::uint64_t));
+    write_(chunk_shape.data(), chunk_shape.size() * sizeof(std::uint64_t));
+    write_(component.data(), component.size());
+
+    // Chunks are compressed a batch at a time, then written in order
+    const unsigned int n_threads_ =
+        resolve_thread_count(options.n_threads, n_chunks_);
+    const std::uint64_t batch_size_ = 4 * n_threads_;
+    std::vector<std::vector<char>> raw_(batch_size_);
+    std::vector<std::vector<char>> packed_(batch_size_);
+    std::vector<char> compressed_(batch_size_);
+    const std::vector<std::uint64_t> zero_(shape.size(), 0);
+    for (std::uint64_t first_ = 0; first_ < n_chunks_;
+         first_ += batch_size_) {
+      const std::size_t n_batch_ = static_cast<std::size_t>(
+          std::min(batch_size_, n_chunks_ - first_));
+      parallel_for(n_batch_, n_threads_, [&](std::size_t i) {
+        std::vector<std::uint64_t> start_;
+        std::vector<std::uint64_t> extent_;
+        grid_.bounds(first_ + i, start_, extent_);
+        raw_[i].resize(
+            static_cast<std::size_t>(product_(extent_)) * element_size_);
+        copy_box_(data, shape, start_, raw_[i].data(), extent_, zero_,
+                  extent_, element_size_);
+        compressed_[i] = compress_(options.codec, options.level,
+                                   raw_[i].data(), raw_[i].size(), packed_[i]);
+      });
+      for (std::size_t i = 0; i < n_batch_; ++i) {
+        const std::vector<char> &bytes_ =
+            compressed_[i] ? packed_[i] : raw_[i];
+        IndexEntry &entry_ = index_[static_cast<std::size_t>(first_ + i)];
+        entry_.offset = position_;
+        entry_.stored_size = bytes_.size();
+        entry_.codec = static_cast<std::uint32_t>(
+            compressed_[i] ? options.codec : ArrayCodec::NONE);
+        entry_.reserved = 0;
+        write_(bytes_.data(), bytes_.size());
+      }
+    }
+
+    Footer footer_;
+    footer_.index_offset = position_;
+    footer_.n_chunks = n_chunks_;
+    std::memcpy(footer_.magic, magic_, sizeof(magic_));
+    write_(index_.data(), index_.size() * sizeof(IndexEntry));
+    write_(&footer_, sizeof(footer_));
+    out_.close();
+    if (!out_) {
+      throw array_error("Failed writing array file '" + file_path.string() +
+                        "'");
+    }
+  } catch (...) {
+    std::error_code ec_;
+    ghc::filesystem::remove(tmp_path_, ec_);
+    throw;
+  }
+  ghc::filesystem::rename(tmp_path_, file_path);
+
+  const std::string hash_ = hasher_.hexdigest();
+  HashCache::key_type key_;
+  if (HashCache::get_key(file_path, key_)) {
+    HashCache::get_cache()->store(file_path, "sha1", key_, hash_);
+  }
+  return hash_;
+}
+} // namespace
+
+std::size_t array_type_size(ArrayType type) {
+  switch (type) {
+  case ArrayType::FLOAT32:
+  case ArrayType::INT32:
+    return 4;
+  case ArrayType::FLOAT64:
+  case ArrayType::INT64:
+    return 8;
+  }
+  throw array_error("Unknown array element type " +
+                    std::to_string(static_cast<std::uint32_t>(type)));
+}
+
+std::string to_string(ArrayType type) {
+  switch (type) {
+  case ArrayType::FLOAT32:
+    return "float32";
+  case ArrayType::FLOAT64:
+    return "float64";
+  case ArrayType::INT32:
+    return "int32";
+  case ArrayType::INT64:
+    return "int64";
+  }
+  return "unknown";
+}
+
+std::string to_string(ArrayCodec codec) {
+  switch (codec) {
+  case ArrayCodec::NONE:
+    return "none";
+  case ArrayCodec::LZ4:
+    return "lz4";
+  case ArrayCodec::ZSTD:
+    return "zstd";
+  case ArrayCodec::DEFLATE:
+    return "deflate";
+  }
+  return "unknown";
+}
+
+bool array_codec_available(ArrayCodec codec) {
+  switch (codec) {
+  case ArrayCodec::NONE:
+    return true;
+  case ArrayCodec::LZ4:
+#ifdef FDPAPI_WITH_LZ4
+    return true;
+#else
+    return false;
+#endif
+  case ArrayCodec::ZSTD:
+#ifdef FDPAPI_WITH_ZSTD
+    return true;
+#else
+    return false;
+#endif
+  case ArrayCodec::DEFLATE:
+#ifdef FDPAPI_WITH_ZLIB
+    return true;
+#else
+    return false;
+#endif
+  }
+  return false;
+}
+
+ArrayCodec default_array_codec() {
+  const ArrayCodec preferred_[] = {ArrayCodec::ZSTD, ArrayCodec::LZ4,
+                                   ArrayCodec::DEFLATE};
+  for (ArrayCodec codec_ : preferred_) {
+    if (array_codec_available(codec_)) {
+      return codec_;
+    }
+  }
+  return ArrayCodec::NONE;
+}
+
+bool array_hdf5_available() {
+#ifdef FDPAPI_WITH_HDF5
+  return true;
+#else
+  return false;
+#endif
+}
+
+/**
+ * @brief Storage backend of an ArrayReader
+ */
+class ArrayReader::Impl {
+public:
+  virtual ~Impl() = default;
+
+  virtual void read(void *out, const std::vector<std::uint64_t> &offset,
+                    const std::vector<std::uint64_t> &count) const = 0;
+
+  ArrayType type = ArrayType::FLOAT64;
+  ArrayCodec codec = ArrayCodec::NONE;
+  std::vector<std::uint64_t> shape;
+  std::vector<std::uint64_t> chunk_shape;
+};
+
+namespace {
+/**
+ * @brief Reader of the native format
+ */
+class NativeArray : public ArrayReader::Impl {
+public:
+  NativeArray(const ghc::filesystem::path &file_path,
+              const std::string &component, unsigned int n_threads)
+      : file_path_(file_path), n_threads_(n_threads) {
+    std::ifstream in_(file_path_.string(),
+                      std::ios_base::in | std::ios_base::binary);
+    if (!in_) {
+      throw array_error("Array file '" + file_path_.string() +
+                        "' not found");
+    }
+    in_.seekg(0, std::ios_base::end);
+    const std::uint64_t file_size_ = static_cast<std::uint64_t>(in_.tellg());
+    in_.seekg(0);
+
+    Header header_;
+    Footer footer_;
+    if (file_size_ < sizeof(Header) + sizeof(Footer) ||
+        !in_.read(reinterpret_cast<char *>(&header_), sizeof(header_)) ||
+        std::memcmp(header_.magic, magic_, sizeof(magic_)) != 0) {
+      throw array_error("File '" + file_path_.string() +
+                        "' is not an array file");
+    }
+    if (header_.byte_order != byte_order_mark_) {
+      throw array_error("Array file '" + file_path_.string() +
+                        "' was written with a different byte order");
+    }
+    if (header_.version != version_) {
+      throw array_error("Array file '" + file_path_.string() +
+                        "' has unsupported version " +
+                        std::to_string(header_.version));
+    }
+    type = static_cast<ArrayType>(header_.type);
+    codec = static_cast<ArrayCodec>(header_.codec);
+    element_size_ = array_type_size(type);
+
+    // Sizes in the header are bounded by the file before they are used
+    const std::uint64_t body_size_ =
+        file_size_ - sizeof(Header) - sizeof(Footer);
+    if (header_.rank == 0 || header_.rank > max_rank_ ||
+        2 * header_.rank * sizeof(std::uint64_t) + header_.component_size >
+            body_size_ ||
+        header_.n_chunks > body_size_ / sizeof(IndexEntry)) {
+      throw array_error("Array file '" + file_path_.string() +
+                        "' has a corrupt header");
+    }
+    shape.resize(header_.rank);
+    chunk_shape.resize(header_.rank);
+    std::string stored_component_(header_.component_size, '\0');
+    in_.read(reinterpret_cast<char *>(shape.data()),
+             shape.size() * sizeof(std::uint64_t));
+    in_.read(reinterpret_cast<char *>(chunk_shape.data()),
+             chunk_shape.size() * sizeof(std::uint64_t));
+    in_.read(&stored_component_[0], stored_component_.size());
+    if (!in_ || !valid_chunk_shape_(shape, chunk_shape, element_size_)) {
+      throw array_error("Array file '" + file_path_.string() +
+                        "' has an invalid shape or chunk shape");
+    }
+
+    in_.seekg(file_size_ - sizeof(Footer));
+    in_.read(reinterpret_cast<char *>(&footer_), sizeof(footer_));
+    const ChunkGrid grid_(shape, chunk_shape);
+    if (!in_ || std::memcmp(footer_.magic, magic_, sizeof(magic_)) != 0 ||
+        footer_.n_chunks != header_.n_chunks ||
+        footer_.n_chunks != grid_.n_chunks() ||
+        footer_.index_offset + footer_.n_chunks * sizeof(IndexEntry) +
+                sizeof(Footer) !=
+            file_size_) {
+      throw array_error("Array file '" + file_path_.string() +
+                        "' is truncated or corrupt");
+    }
+    if (stored_component_ != component) {
+      throw array_error("Array file '" + file_path_.string() +
+                        "' does not contain component " + component);
+    }
+
+    index_.resize(static_cast<std::size_t>(footer_.n_chunks));
+    in_.seekg(footer_.index_offset);
+    in_.read(reinterpret_cast<char *>(index_.data()),
+             index_.size() * sizeof(IndexEntry));
+    for (const IndexEntry &entry_ : index_) {
+      if (entry_.offset + entry_.stored_size > footer_.index_offset) {
+        throw array_error("Array file '" + file_path_.string() +
+                          "' has an invalid chunk index");
+      }
+    }
+  }
+
+  void read(void *out, const std::vector<std::uint64_t> &offset,
+            const std::vector<std::uint64_t> &count) const override {
+    const std::size_t rank_ = shape.size();
+    if (product_(count) == 0) {
+      return;
+    }
+    const ChunkGrid grid_(shape, chunk_shape);
+
+    // Chunks intersecting the slab, in file order
+    std::vector<std::uint64_t> first_(rank_);
+    std::vector<std::uint64_t> last_(rank_);
+    for (std::size_t d = 0; d < rank_; ++d) {
+      first_[d] = offset[d] / chunk_shape[d];
+      last_[d] = (offset[d] + count[d] - 1) / chunk_shape[d];
+    }
+    std::vector<std::uint64_t> chunks_;
+    std::vector<std::uint64_t> grid_index_(first_);
+    for (;;) {
+      std::uint64_t chunk_ = 0;
+      for (std::size_t d = 0; d < rank_; ++d) {
+        chunk_ = chunk_ * grid_.grid[d] + grid_index_[d];
+      }
+      chunks_.push_back(chunk_);
+      std::size_t d = rank_;
+      while (d-- > 0) {
+        if (++grid_index_[d] <= last_[d]) {
+          break;
+        }
+        grid_index_[d] = first_[d];
+      }
+      if (d == static_cast<std::size_t>(-1)) {
+        break;
+      }
+    }
+
+    std::ifstream in_(file_path_.string(),
+                      std::ios_base::in | std::ios_base::binary);
+    const unsigned int workers_ =
+        resolve_thread_count(n_threads_, chunks_.size());
+    const std::size_t batch_size_ = 4 * workers_;
+    std::vector<std::vector<char>> stored_(batch_size_);
+    for (std::size_t first_chunk_ = 0; first_chunk_ < chunks_.size();
+         first_chunk_ += batch_size_) {
+      const std::size_t n_batch_ =
+          std::min(batch_size_, chunks_.size() - first_chunk_);
+      for (std::size_t i = 0; i < n_batch_; ++i) {
+        const IndexEntry &entry_ =
+            index_[static_cast<std::size_t>(chunks_[first_chunk_ + i])];
+        stored_[i].resize(static_cast<std::size_t>(entry_.stored_size));
+        in_.seekg(entry_.offset);
+        in_.read(stored_[i].data(), stored_[i].size());
+      }
+      if (!in_) {
+        throw array_error("Failed reading array file '" +
+                          file_path_.string() + "'");
+      }
+
+      parallel_for(n_batch_, workers_, [&](std::size_t i) {
+        const std::uint64_t chunk_ = chunks_[first_chunk_ + i];
+        const IndexEntry &entry_ = index_[static_cast<std::size_t>(chunk_)];
+        std::vector<std::uint64_t> start_;
+        std::vector<std::uint64_t> extent_;
+        grid_.bounds(chunk_, start_, extent_);
+        std::vector<char> raw_(static_cast<std::size_t>(product_(extent_)) *
+                               element_size_);
+        decompress_(static_cast<ArrayCodec>(entry_.codec), stored_[i].data(),
+                    stored_[i].size(), raw_.data(), raw_.size());
+
+        // Intersection of the chunk and the slab
+        std::vector<std::uint64_t> chunk_start_(rank_);
+        std::vector<std::uint64_t> out_start_(rank_);
+        std::vector<std::uint64_t> box_(rank_);
+        for (std::size_t d = 0; d < rank_; ++d) {
+          const std::uint64_t lo_ = std::max(start_[d], offset[d]);
+          const std::uint64_t hi_ =
+              std::min(start_[d] + extent_[d], offset[d] + count[d]);
+          chunk_start_[d] = lo_ - start_[d];
+          out_start_[d] = lo_ - offset[d];
+          box_[d] = hi_ - lo_;
+        }
+        copy_box_(raw_.data(), extent_, chunk_start_,
+                  static_cast<char *>(out), count, out_start_, box_,
+                  element_size_);
+      });
+    }
+  }
+
+private:
+  ghc::filesystem::path file_path_;
+  unsigned int n_threads_;
+  std::size_t element_size_ = 0;
+  std::vector<IndexEntry> index_;
+};
+
+#ifdef FDPAPI_WITH_HDF5
+/**
+ * @brief The serial HDF5 library is not thread safe
+ */
+std::mutex &hdf5_mutex_() {
+  static std::mutex mutex_;
+  return mutex_;
+}
+
+/**
+ * @brief Closes an HDF5 handle on scope exit
+ */
+class Hdf5Handle {
+public:
+  Hdf5Handle(hid_t id, herr_t (*close)(hid_t)) : id_(id), close_(close) {}
+  ~Hdf5Handle() {
+    if (id_ >= 0) {
+      close_(id_);
+    }
+  }
+  hid_t get() const { return id_; }
+  bool valid() const { return id_ >= 0; }
+
+private:
+  Hdf5Handle(const Hdf5Handle &rhs) = delete;
+  Hdf5Handle &operator=(const Hdf5Handle &rhs) = delete;
+
+  hid_t id_;
+  herr_t (*close_)(hid_t);
+};
+
+hid_t hdf5_memory_type_(ArrayType type) {
+  switch (type) {
+  case ArrayType::FLOAT32:
+    return H5T_NATIVE_FLOAT;
+  case ArrayType::FLOAT64:
+    return H5T_NATIVE_DOUBLE;
+  case ArrayType::INT32:
+    return H5T_NATIVE_INT32;
+  case ArrayType::INT64:
+    return H5T_NATIVE_INT64;
+  }
+  throw array_error("Unknown array element type");
+}
+
+std::string hdf5_dataset_name_(const std::string &component) {
+  return component + "/array";
+}
+
+/**
+ * @brief Check a link exists, one path element at a time
+ */
+bool hdf5_exists_(hid_t file, const std::string &name) {
+  std::size_t end_ = 0;
+  while (end_ != std::string::npos) {
+    end_ = name.find('/', end_ + 1);
+    const std::string prefix_ = name.substr(0, end_);
+    if (H5Lexists(file, prefix_.c_str(), H5P_DEFAULT) <= 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::string write_hdf5_(const ghc::filesystem::path &file_path,
+                        const std::string &component, ArrayType type,
+                        const char *data,
+                        const std::vector<std::uint64_t> &shape,
+                        const std::vector<std::uint64_t> &chunk_shape,
+                        const ArrayOptions &options) {
+  const std::size_t rank_ = shape.size();
+  const std::size_t element_size_ = array_type_size(type);
+#ifdef FDPAPI_WITH_ZLIB
+  const bool deflate_ = options.codec != ArrayCodec::NONE;
+#else
+  const bool deflate_ = false;
+#endif
+  {
+    std::lock_guard<std::mutex> lock_(hdf5_mutex_());
+    hid_t file_id_ = -1;
+    H5E_BEGIN_TRY {
+      file_id_ = ghc::filesystem::exists(file_path)
+                     ? H5Fopen(file_path.string().c_str(), H5F_ACC_RDWR,
+                               H5P_DEFAULT)
+                     : H5Fcreate(file_path.string().c_str(), H5F_ACC_TRUNC,
+                                 H5P_DEFAULT, H5P_DEFAULT);
+    }
+    H5E_END_TRY;
+    Hdf5Handle file_(file_id_, H5Fclose);
+    if (!file_.valid()) {
+      throw array_error("Cannot open HDF5 file '" + file_path.string() + "'");
+    }
+    const std::string name_ = hdf5_dataset_name_(component);
+    if (hdf5_exists_(file_.get(), name_)) {
+      throw array_error("Component " + component + " already exists in '" +
+                        file_path.string() + "'");
+    }
+
+    std::vector<hsize_t> dims_(shape.begin(), shape.end());
+    std::vector<hsize_t> chunk_dims_(chunk_shape.begin(), chunk_shape.end());
+    Hdf5Handle space_(H5Screate_simple(static_cast<int>(rank_), dims_.data(),
+                                       nullptr),
+                      H5Sclose);
+    Hdf5Handle lcpl_(H5Pcreate(H5P_LINK_CREATE), H5Pclose);
+    H5Pset_create_intermediate_group(lcpl_.get(), 1);
+    Hdf5Handle dcpl_(H5Pcreate(H5P_DATASET_CREATE), H5Pclose);
+    H5Pset_chunk(dcpl_.get(), static_cast<int>(rank_), chunk_dims_.data());
+    if (deflate_) {
+      H5Pset_deflate(dcpl_.get(), std::min(std::max(options.level, 1), 9));
+    }
+    Hdf5Handle dataset_(H5Dcreate2(file_.get(), name_.c_str(),
+                                   hdf5_memory_type_(type), space_.get(),
+                                   lcpl_.get(), dcpl_.get(), H5P_DEFAULT),
+                        H5Dclose);
+    if (!dataset_.valid()) {
+      throw array_error("Cannot create " + name_ + " in '" +
+                        file_path.string() + "'");
+    }
+
+    // Chunks are padded to full size and deflated on every thread, then
+    // written directly, bypassing the HDF5 filter pipeline
+    const ChunkGrid grid_(shape, chunk_shape);
+    const std::uint64_t n_chunks_ = grid_.n_chunks();
+    const unsigned int n_threads_ =
+        resolve_thread_count(options.n_threads, n_chunks_);
+    const std::uint64_t batch_size_ = 4 * n_threads_;
+    const std::size_t chunk_bytes_ =
+        static_cast<std::size_t>(product_(chunk_shape)) * element_size_;
+    const std::vector<std::uint64_t> zero_(rank_, 0);
+    std::vector<std::vector<char>> raw_(batch_size_);
+    std::vector<std::vector<char>> packed_(batch_size_);
+    std::vector<char> compressed_(batch_size_);
+    for (std::uint64_t first_ = 0; first_ < n_chunks_;
+         first_ += batch_size_) {
+      const std::size_t n_batch_ = static_cast<std::size_t>(
+          std::min(batch_size_, n_chunks_ - first_));
+      parallel_for(n_batch_, n_threads_, [&](std::size_t i) {
+        std::vector<std::uint64_t> start_;
+        std::vector<std::uint64_t> extent_;
+        grid_.bounds(first_ + i, start_, extent_);
+        raw_[i].assign(chunk_bytes_, 0);
+        copy_box_(data, shape, start_, raw_[i].data(), chunk_shape, zero_,
+                  extent_, element_size_);
+        compressed_[i] =
+            deflate_ && compress_(ArrayCodec::DEFLATE, options.level,
+                                  raw_[i].data(), raw_[i].size(), packed_[i]);
+      });
+      for (std::size_t i = 0; i < n_batch_; ++i) {
+        std::vector<std::uint64_t> start_;
+        std::vector<std::uint64_t> extent_;
+        grid_.bounds(first_ + i, start_, extent_);
+        std::vector<hsize_t> chunk_offset_(start_.begin(), start_.end());
+        const std::vector<char> &bytes_ =
+            compressed_[i] ? packed_[i] : raw_[i];
+        // Bit 0 of the filter mask skips deflate for incompressible chunks
+        const std::uint32_t filter_mask_ =
+            deflate_ && !compressed_[i] ? 1u : 0u;
+        if (H5Dwrite_chunk(dataset_.get(), H5P_DEFAULT, filter_mask_,
+                           chunk_offset_.data(), bytes_.size(),
+                           bytes_.data()) < 0) {
+          throw array_error("Failed writing " + name_ + " in '" +
+                            file_path.string() + "'");
+        }
+      }
+    }
+  }
+  // HDF5 writes the file itself, so it is hashed once it is closed
+  return calculate_hash_from_file(file_path);
+}
+
+/**
+ * @brief Reader of HDF5 datasets
+ */
+class Hdf5Array : public ArrayReader::Impl {
+public:
+  Hdf5Array(const ghc::filesystem::path &file_path,
+            const std::string &component) {
+    std::lock_guard<std::mutex> lock_(hdf5_mutex_());
+    hid_t file_id_ = -1;
+    H5E_BEGIN_TRY {
+      file_id_ =
+          H5Fopen(file_path.string().c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+    }
+    H5E_END_TRY;
+    file_ = open_(file_id_, H5Fclose,
+                  "Cannot open HDF5 file '" + file_path.string() + "'");
+    const std::string name_ = hdf5_dataset_name_(component);
+    if (!hdf5_exists_(file_->get(), name_)) {
+      throw array_error("HDF5 file '" + file_path.string() +
+                        "' does not contain component " + component);
+    }
+    dataset_ = open_(H5Dopen2(file_->get(), name_.c_str(), H5P_DEFAULT),
+                     H5Dclose, "Cannot open " + name_);
+
+    Hdf5Handle file_type_(H5Dget_type(dataset_->get()), H5Tclose);
+    const H5T_class_t class_ = H5Tget_class(file_type_.get());
+    const std::size_t size_ = H5Tget_size(file_type_.get());
+    if (class_ == H5T_FLOAT && size_ == 4) {
+      type = ArrayType::FLOAT32;
+    } else if (class_ == H5T_FLOAT && size_ == 8) {
+      type = ArrayType::FLOAT64;
+    } else if (class_ == H5T_INTEGER && size_ <= 4) {
+      type = ArrayType::INT32;
+    } else if (class_ == H5T_INTEGER) {
+      type = ArrayType::INT64;
+    } else {
+      throw array_error(name_ + " in '" + file_path.string() +
+                        "' is not a numeric array");
+    }
+
+    Hdf5Handle space_(H5Dget_space(dataset_->get()), H5Sclose);
+    const int rank_ = H5Sget_simple_extent_ndims(space_.get());
+    std::vector<hsize_t> dims_(std::max(rank_, 0));
+    H5Sget_simple_extent_dims(space_.get(), dims_.data(), nullptr);
+    shape.assign(dims_.begin(), dims_.end());
+    chunk_shape = shape;
+
+    Hdf5Handle dcpl_(H5Dget_create_plist(dataset_->get()), H5Pclose);
+    if (H5Pget_layout(dcpl_.get()) == H5D_CHUNKED) {
+      std::vector<hsize_t> chunk_dims_(dims_.size());
+      H5Pget_chunk(dcpl_.get(), rank_, chunk_dims_.data());
+      chunk_shape.assign(chunk_dims_.begin(), chunk_dims_.end());
+    }
+    const int n_filters_ = H5Pget_nfilters(dcpl_.get());
+    for (int i = 0; i < n_filters_; ++i) {
+      unsigned int flags_ = 0;
+      std::size_t n_values_ = 0;
+      if (H5Pget_filter2(dcpl_.get(), i, &flags_, &n_values_, nullptr, 0,
+                         nullptr, nullptr) == H5Z_FILTER_DEFLATE) {
+        codec = ArrayCodec::DEFLATE;
+      }
+    }
+  }
+
+  ~Hdf5Array() override {
+    std::lock_guard<std::mutex> lock_(hdf5_mutex_());
+    dataset_.reset();
+    file_.reset();
+  }
+
+  void read(void *out, const std::vector<std::uint64_t> &offset,
+            const std::vector<std::uint64_t> &count) const override {
+    if (product_(count) == 0) {
+      return;
+    }
+    std::lock_guard<std::mutex> lock_(hdf5_mutex_());
+    std::vector<hsize_t> start_(offset.begin(), offset.end());
+    std::vector<hsize_t> dims_(count.begin(), count.end());
+    Hdf5Handle file_space_(H5Dget_space(dataset_->get()), H5Sclose);
+    H5Sselect_hyperslab(file_space_.get(), H5S_SELECT_SET, start_.data(),
+                        nullptr, dims_.data(), nullptr);
+    Hdf5Handle memory_space_(
+        H5Screate_simple(static_cast<int>(dims_.size()), dims_.data(),
+                         nullptr),
+        H5Sclose);
+    if (H5Dread(dataset_->get(), hdf5_memory_type_(type),
+                memory_space_.get(), file_space_.get(), H5P_DEFAULT,
+                out) < 0) {
+      throw array_error("Failed reading HDF5 array");
+    }
+  }
+
+private:
+  static std::unique_ptr<Hdf5Handle> open_(hid_t id, herr_t (*close)(hid_t),
+                                           const std::string &message) {
+    if (id < 0) {
+      throw array_error(message);
+    }
+    return std::unique_ptr<Hdf5Handle>(new Hdf5Handle(id, close));
+  }
+
+  std::unique_ptr<Hdf5Handle> file_;
+  std::unique_ptr<Hdf5Handle> dataset_;
+};
+#endif
+} // namespace
+
+std::string write_array(const ghc::filesystem::path &file_path,
+                        const std::string &component, ArrayType type,
+                        const void *data,
+                        const std::vector<std::uint64_t> &shape,
+                        const ArrayOptions &options) {
+  const std::size_t element_size_ = array_type_size(type);
+  if (shape.empty() || shape.size() > max_rank_) {
+    throw array_error("Array " + component + " must have between 1 and " +
+                      std::to_string(max_rank_) + " dimensions");
+  }
+  if (options.codec != ArrayCodec::NONE &&
+      !array_codec_available(options.codec)) {
+    throw array_error("Codec " + to_string(options.codec) +
+                      " is not available in this build");
+  }
+  const std::vector<std::uint64_t> chunk_shape_ =
+      options.chunk_shape.empty()
+          ? automatic_chunk_shape_(shape, element_size_)
+          : options.chunk_shape;
+  if (!valid_chunk_shape_(shape, chunk_shape_, element_size_)) {
+    throw array_error("Invalid chunk shape for array " + component);
+  }
+
+  std::string hash_;
+  if (is_hdf5_path_(file_path)) {
+#ifdef FDPAPI_WITH_HDF5
+    hash_ = write_hdf5_(file_path, component, type,
+                        static_cast<const char *>(data), shape, chunk_shape_,
+                        options);
+#else
+    throw array_error("Cannot write '" + file_path.string() +
+                      "', the library was built without HDF5");
+#endif
+  } else {
+    hash_ = write_native_(file_path, component, type,
+                          static_cast<const char *>(data), shape,
+                          chunk_shape_, options);
+  }
+  logger::get_logger()->debug()
+      << "write_array: Wrote " << component << " (" << product_(shape)
+      << " " << to_string(type) << ") to '" << file_path.string() << "'";
+  return hash_;
+}
+
+ArrayReader::ArrayReader(std::unique_ptr<Impl> impl)
+    : impl_(std::move(impl)) {}
+
+ArrayReader::~ArrayReader() = default;
+
+ArrayReader::sptr ArrayReader::open(const ghc::filesystem::path &file_path,
+                                    const std::string &component,
+                                    unsigned int n_threads) {
+  if (!ghc::filesystem::exists(file_path)) {
+    throw array_error("Array file '" + file_path.string() + "' not found");
+  }
+  std::unique_ptr<Impl> impl_;
+  if (is_hdf5_path_(file_path)) {
+#ifdef FDPAPI_WITH_HDF5
+    (void)n_threads;
+    impl_.reset(new Hdf5Array(file_path, component));
+#else
+    throw array_error("Cannot read '" + file_path.string() +
+                      "', the library was built without HDF5");
+#endif
+  } else {
+    impl_.reset(new NativeArray(file_path, component, n_threads));
+  }
+  return sptr(new ArrayReader(std::move(impl_)));
+}
+
+ArrayType ArrayReader::get_type() const { return impl_->type; }
+
+ArrayCodec ArrayReader::get_codec() const { return impl_->codec; }
+
+const std::vector<std::uint64_t> &ArrayReader::get_shape() const {
+  return impl_->shape;
+}
+
+const std::vector<std::uint64_t> &ArrayReader::get_chunk_shape() const {
+  return impl_->chunk_shape;
+}
+
+std::uint64_t ArrayReader::size() const { return product_(impl_->shape); }
+
+void ArrayReader::read(ArrayType type, void *out,
+                       const std::vector<std::uint64_t> &offset,
+                       const std::vector<std::uint64_t> &count) const {
+  if (type != impl_->type) {
+    throw array_error("Array is " + to_string(impl_->type) +
+                      ", cannot read it as " + to_string(type));
+  }
+  check_slab_(impl_->shape, offset, count);
+  impl_->read(out, offset, count);
+}
+
+}; // namespace FairDataPipeline
@@ -0,0 +1,1284 @@
+#include "fdp/utilities/arrow_table.hxx"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <utility>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "fdp/utilities/hash_cache.hxx"
+#include "fdp/utilities/hashing.hxx"
+#include "fdp/utilities/logging.hxx"
+
+namespace FairDataPipeline {
+
+namespace {
+const char magic_[8] = {'A', 'R', 'R', 'O', 'W', '1', '\0', '\0'};
+const std::uint32_t continuation_ = 0xFFFFFFFFu;
+const std::size_t alignment_ = 8;
+const char padding_[alignment_] = {};
+
+// Values of the enumerations of the Arrow flatbuffer schema (Schema.fbs,
+// Message.fbs and File.fbs)
+const std::int16_t metadata_v5_ = 4;
+const std::uint8_t header_schema_ = 1;
+const std::uint8_t header_record_batch_ = 3;
+const std::uint8_t type_int_ = 2;
+const std::uint8_t type_floating_point_ = 3;
+const std::uint8_t type_utf8_ = 5;
+const std::int16_t precision_single_ = 1;
+const std::int16_t precision_double_ = 2;
+
+bool little_endian_() {
+  const std::uint16_t one_ = 1;
+  unsigned char first_ = 0;
+  std::memcpy(&first_, &one_, 1);
+  return first_ == 1;
+}
+
+/**
+ * @brief Endianness of the buffers of the host, as written in a schema
+ */
+std::int16_t host_endianness_() { return little_endian_() ? 0 : 1; }
+
+std::size_t padded_(std::size_t size) {
+  return (size + alignment_ - 1) & ~(alignment_ - 1);
+}
+
+/**
+ * @brief Size of a value in bytes, 0 for strings
+ */
+std::size_t type_width_(ArrowType type) {
+  switch (type) {
+  case ArrowType::INT32:
+  case ArrowType::FLOAT32:
+    return 4;
+  case ArrowType::INT64:
+  case ArrowType::FLOAT64:
+    return 8;
+  case ArrowType::STRING:
+    return 0;
+  }
+  throw arrow_error("Invalid Arrow column type " +
+                    std::to_string(static_cast<std::uint32_t>(type)));
+}
+
+/**
+ * @brief Append an integer in little endian order, as flatbuffers are
+ */
+void append_le_(std::vector<std::uint8_t> &bytes, std::uint64_t value,
+                std::size_t size) {
+  for (std::size_t i = 0; i < size; ++i) {
+    bytes.push_back(static_cast<std::uint8_t>(value >> (8 * i)));
+  }
+}
+
+/**
+ * @brief Builder of a flatbuffer, front to back
+ *
+ * Each table is written before the objects it refers to, and its offsets
+ * are filled in by link() once they are written, so every offset points
+ * forward as flatbuffers requires. Vtables precede their tables.
+ */
+class FlatBuilder_ {
+public:
+  /**
+   * @brief Fields of a table, integers or offsets
+   */
+  class Table {
+  public:
+    template <typename T> Table &scalar(std::uint16_t id, T value) {
+      fields_.push_back(
+          Field{id, sizeof(T),
+                static_cast<std::uint64_t>(static_cast<std::int64_t>(value))});
+      return *this;
+    }
+
+    /**
+     * @brief Offset to an object written later, set by link()
+     */
+    Table &offset(std::uint16_t id) {
+      fields_.push_back(Field{id, 0, 0});
+      return *this;
+    }
+
+  private:
+    friend class FlatBuilder_;
+    struct Field {
+      std::uint16_t id;
+      std::size_t size; /*!< 0 for an offset */
+      std::uint64_t value;
+    };
+    std::vector<Field> fields_;
+  };
+
+  FlatBuilder_() : buffer_(4, 0) {}
+
+  /**
+   * @brief Write a table
+   *
+   * @param table
+   * @param slots set to the positions of its offsets, in the order added
+   * @return std::size_t position of the table
+   */
+  std::size_t table(const Table &table, std::vector<std::size_t> &slots) {
+    const std::vector<Table::Field> &fields_ = table.fields_;
+    std::size_t n_ids_ = 0;
+    for (const Table::Field &field_ : fields_) {
+      n_ids_ = std::max<std::size_t>(n_ids_, field_.id + 1u);
+    }
+    // Widest fields first, so the table needs no padding within it
+    std::vector<std::size_t> order_(fields_.size());
+    std::iota(order_.begin(), order_.end(), 0);
+    std::stable_sort(order_.begin(), order_.end(),
+                     [&](std::size_t a, std::size_t b) {
+                       return width_(fields_[a]) > width_(fields_[b]);
+                     });
+
+    pad_(2);
+    const std::size_t vtable_ = buffer_.size();
+    buffer_.resize(vtable_ + 4 + 2 * n_ids_, 0);
+    pad_(alignment_);
+    const std::size_t table_ = buffer_.size();
+    append_le_(buffer_, table_ - vtable_, 4);
+
+    std::vector<std::size_t> positions_(fields_.size(), 0);
+    for (std::size_t index_ : order_) {
+      const Table::Field &field_ = fields_[index_];
+      pad_(width_(field_));
+      const std::size_t position_ = buffer_.size();
+      put_(vtable_ + 4 + 2 * field_.id, position_ - table_, 2);
+      append_le_(buffer_, field_.value, width_(field_));
+      positions_[index_] = position_;
+    }
+    slots.clear();
+    for (std::size_t i = 0; i < fields_.size(); ++i) {
+      if (fields_[i].size == 0) {
+        slots.push_back(positions_[i]);
+      }
+    }
+    put_(vtable_, 4 + 2 * n_ids_, 2);
+    put_(vtable_ + 2, buffer_.size() - table_, 2);
+    return table_;
+  }
+
+  std::size_t string(const std::string &value) {
+    pad_(4);
+    const std::size_t position_ = buffer_.size();
+    append_le_(buffer_, value.size(), 4);
+    buffer_.insert(buffer_.end(), value.begin(), value.end());
+    buffer_.push_back(0);
+    return position_;
+  }
+
+  /**
+   * @brief Write a vector of structs
+   *
+   * @param bytes the structs, little endian
+   * @param n number of structs
+   * @return std::size_t position of the vector
+   */
+  std::size_t structs(const std::vector<std::uint8_t> &bytes, std::size_t n) {
+    while ((buffer_.size() + 4) % alignment_) {
+      buffer_.push_back(0);
+    }
+    const std::size_t position_ = buffer_.size();
+    append_le_(buffer_, n, 4);
+    buffer_.insert(buffer_.end(), bytes.begin(), bytes.end());
+    return position_;
+  }
+
+  /**
+   * @brief Write a vector of offsets to tables, set by link()
+   *
+   * @param n
+   * @param slots set to the positions of the offsets
+   * @return std::size_t position of the vector
+   */
+  std::size_t tables(std::size_t n, std::vector<std::size_t> &slots) {
+    pad_(4);
+    const std::size_t position_ = buffer_.size();
+    append_le_(buffer_, n, 4);
+    slots.clear();
+    for (std::size_t i = 0; i < n; ++i) {
+      slots.push_back(buffer_.size());
+      append_le_(buffer_, 0, 4);
+    }
+    return position_;
+  }
+
+  void link(std::size_t slot, std::size_t target) {
+    put_(slot, target - slot, 4);
+  }
+
+  /**
+   * @brief Set the root table and return the buffer, padded to 8 bytes
+   */
+  std::vector<std::uint8_t> finish(std::size_t root) {
+    link(0, root);
+    pad_(alignment_);
+    return std::move(buffer_);
+  }
+
+private:
+  static std::size_t width_(const Table::Field &field) {
+    return field.size ? field.size : 4;
+  }
+
+  void pad_(std::size_t alignment) {
+    while (buffer_.size() % alignment) {
+      buffer_.push_back(0);
+    }
+  }
+
+  void put_(std::size_t position, std::uint64_t value, std::size_t size) {
+    for (std::size_t i = 0; i < size; ++i) {
+      buffer_[position + i] = static_cast<std::uint8_t>(value >> (8 * i));
+    }
+  }
+
+  std::vector<std::uint8_t> buffer_;
+};
+
+/**
+ * @brief Read an integer in little endian order
+ *
+ * @throws arrow_error if it is beyond size
+ */
+template <typename T>
+T get_le_(const std::uint8_t *data, std::size_t size, std::size_t position) {
+  if (position > size || size - position < sizeof(T)) {
+    throw arrow_error("Offset beyond the end of a flatbuffer");
+  }
+  std::uint64_t value_ = 0;
+  for (std::size_t i = 0; i < sizeof(T); ++i) {
+    value_ |= static_cast<std::uint64_t>(data[position + i]) << (8 * i);
+  }
+  return static_cast<T>(value_);
+}
+
+/**
+ * @brief Table of a flatbuffer, every read is checked against its size
+ */
+class FlatTable_ {
+public:
+  static FlatTable_ root(const std::uint8_t *data, std::size_t size) {
+    return FlatTable_(data, size, 0).at(0);
+  }
+
+  bool has(std::uint16_t id) const { return field_(id) != 0; }
+
+  template <typename T> T scalar(std::uint16_t id, T default_value) const {
+    const std::size_t position_ = field_(id);
+    return position_ ? get_le_<T>(data_, size_, position_) : default_value;
+  }
+
+  /**
+   * @throws arrow_error if the table is absent
+   */
+  FlatTable_ table(std::uint16_t id) const {
+    const std::size_t position_ = field_(id);
+    if (!position_) {
+      throw arrow_error("Missing flatbuffer table");
+    }
+    return at(position_);
+  }
+
+  std::string string(std::uint16_t id) const {
+    const std::size_t position_ = field_(id);
+    if (!position_) {
+      return "";
+    }
+    const std::size_t string_ = target_(position_);
+    const std::uint32_t length_ = get_le_<std::uint32_t>(data_, size_, string_);
+    if (size_ - string_ - 4 < length_) {
+      throw arrow_error("String beyond the end of a flatbuffer");
+    }
+    return std::string(reinterpret_cast<const char *>(data_) + string_ + 4,
+                       length_);
+  }
+
+  /**
+   * @brief Find a vector
+   *
+   * @param id
+   * @param element_size
+   * @param n set to the number of elements, 0 if the vector is absent
+   * @return std::size_t position of the first element
+   */
+  std::size_t vector(std::uint16_t id, std::size_t element_size,
+                     std::size_t &n) const {
+    n = 0;
+    const std::size_t position_ = field_(id);
+    if (!position_) {
+      return 0;
+    }
+    const std::size_t vector_ = target_(position_);
+    n = get_le_<std::uint32_t>(data_, size_, vector_);
+    if ((size_ - vector_ - 4) / element_size < n) {
+      throw arrow_error("Vector beyond the end of a flatbuffer");
+    }
+    return vector_ + 4;
+  }
+
+  /**
+   * @brief Table referred to by the offset at a position
+   */
+  FlatTable_ at(std::size_t position) const {
+    return FlatTable_(data_, size_, target_(position));
+  }
+
+  template <typename T> T get(std::size_t position) const {
+    return get_le_<T>(data_, size_, position);
+  }
+
+private:
+  FlatTable_(const std::uint8_t *data, std::size_t size, std::size_t position)
+      : data_(data), size_(size), position_(position) {}
+
+  std::size_t target_(std::size_t position) const {
+    const std::size_t target_ =
+        position + get_le_<std::uint32_t>(data_, size_, position);
+    if (target_ >= size_) {
+      throw arrow_error("Offset beyond the end of a flatbuffer");
+    }
+    return target_;
+  }
+
+  /**
+   * @brief Position of a field, 0 if absent
+   */
+  std::size_t field_(std::uint16_t id) const {
+    if (position_ == 0) {
+      return 0;
+    }
+    const std::int64_t vtable_ =
+        static_cast<std::int64_t>(position_) -
+        get_le_<std::int32_t>(data_, size_, position_);
+    if (vtable_ < 0) {
+      throw arrow_error("Invalid flatbuffer vtable");
+    }
+    const std::size_t vtable_size_ =
+        get_le_<std::uint16_t>(data_, size_, static_cast<std::size_t>(vtable_));
+    const std::size_t entry_ = 4 + 2 * static_cast<std::size_t>(id);
+    if (entry_ + 2 > vtable_size_) {
+      return 0;
+    }
+    const std::uint16_t offset_ = get_le_<std::uint16_t>(
+        data_, size_, static_cast<std::size_t>(vtable_) + entry_);
+    return offset_ ? position_ + offset_ : 0;
+  }
+
+  const std::uint8_t *data_;
+  std::size_t size_;
+  std::size_t position_;
+};
+
+std::size_t type_table_(FlatBuilder_ &builder, ArrowType type) {
+  std::vector<std::size_t> slots_;
+  FlatBuilder_::Table table_;
+  switch (type) {
+  case ArrowType::INT32:
+  case ArrowType::INT64:
+    table_.scalar<std::int32_t>(0, type == ArrowType::INT32 ? 32 : 64)
+        .scalar<std::uint8_t>(1, 1);
+    break;
+  case ArrowType::FLOAT32:
+    table_.scalar<std::int16_t>(0, precision_single_);
+    break;
+  case ArrowType::FLOAT64:
+    table_.scalar<std::int16_t>(0, precision_double_);
+    break;
+  case ArrowType::STRING:
+    break;
+  }
+  return builder.table(table_, slots_);
+}
+
+std::uint8_t type_type_(ArrowType type) {
+  switch (type) {
+  case ArrowType::INT32:
+  case ArrowType::INT64:
+    return type_int_;
+  case ArrowType::FLOAT32:
+  case ArrowType::FLOAT64:
+    return type_floating_point_;
+  case ArrowType::STRING:
+    return type_utf8_;
+  }
+  return 0;
+}
+
+std::size_t schema_table_(FlatBuilder_ &builder,
+                          const std::vector<ArrowField> &schema) {
+  std::vector<std::size_t> slots_;
+  const std::size_t schema_ = builder.table(
+      FlatBuilder_::Table()
+          .scalar<std::int16_t>(0, host_endianness_())
+          .offset(1),
+      slots_);
+  std::vector<std::size_t> field_slots_;
+  builder.link(slots_[0], builder.tables(schema.size(), field_slots_));
+  for (std::size_t i = 0; i < schema.size(); ++i) {
+    std::vector<std::size_t> offsets_;
+    const std::size_t field_ = builder.table(
+        FlatBuilder_::Table()
+            .offset(0)
+            .scalar<std::uint8_t>(1, 1)
+            .scalar<std::uint8_t>(2, type_type_(schema[i].type))
+            .offset(3)
+            .offset(5),
+        offsets_);
+    builder.link(field_slots_[i], field_);
+    builder.link(offsets_[0], builder.string(schema[i].name));
+    builder.link(offsets_[1], type_table_(builder, schema[i].type));
+    std::vector<std::size_t> children_;
+    builder.link(offsets_[2], builder.tables(0, children_));
+  }
+  return schema_;
+}
+
+std::vector<std::uint8_t>
+schema_message_(const std::vector<ArrowField> &schema) {
+  FlatBuilder_ builder_;
+  std::vector<std::size_t> slots_;
+  const std::size_t message_ =
+      builder_.table(FlatBuilder_::Table()
+                         .scalar<std::int16_t>(0, metadata_v5_)
+                         .scalar<std::uint8_t>(1, header_schema_)
+                         .offset(2)
+                         .scalar<std::int64_t>(3, 0),
+                     slots_);
+  builder_.link(slots_[0], schema_table_(builder_, schema));
+  return builder_.finish(message_);
+}
+
+/**
+ * @brief Offset and length of a buffer, or length and null count of a
+ * column, the structs of a record batch
+ */
+typedef std::pair<std::int64_t, std::int64_t> Pair_;
+
+std::vector<std::uint8_t> pair_bytes_(const std::vector<Pair_> &pairs) {
+  std::vector<std::uint8_t> bytes_;
+  for (const Pair_ &pair_ : pairs) {
+    append_le_(bytes_, static_cast<std::uint64_t>(pair_.first), 8);
+    append_le_(bytes_, static_cast<std::uint64_t>(pair_.second), 8);
+  }
+  return bytes_;
+}
+
+std::vector<std::uint8_t>
+record_batch_message_(std::int64_t n_rows, const std::vector<Pair_> &nodes,
+                      const std::vector<Pair_> &buffers,
+                      std::int64_t body_size) {
+  FlatBuilder_ builder_;
+  std::vector<std::size_t> slots_;
+  const std::size_t message_ =
+      builder_.table(FlatBuilder_::Table()
+                         .scalar<std::int16_t>(0, metadata_v5_)
+                         .scalar<std::uint8_t>(1, header_record_batch_)
+                         .offset(2)
+                         .scalar<std::int64_t>(3, body_size),
+                     slots_);
+  std::vector<std::size_t> batch_slots_;
+  const std::size_t batch_ =
+      builder_.table(FlatBuilder_::Table()
+                         .scalar<std::int64_t>(0, n_rows)
+                         .offset(1)
+                         .offset(2),
+                     batch_slots_);
+  builder_.link(slots_[0], batch_);
+  builder_.link(batch_slots_[0],
+                builder_.structs(pair_bytes_(nodes), nodes.size()));
+  builder_.link(batch_slots_[1],
+                builder_.structs(pair_bytes_(buffers), buffers.size()));
+  return builder_.finish(message_);
+}
+} // namespace
+
+std::string to_string(ArrowType type) {
+  switch (type) {
+  case ArrowType::INT32:
+    return "int32";
+  case ArrowType::INT64:
+    return "int64";
+  case ArrowType::FLOAT32:
+    return "float32";
+  case ArrowType::FLOAT64:
+    return "float64";
+  case ArrowType::STRING:
+    return "utf8";
+  }
+  return "unknown";
+}
+
+ArrowWriter::ArrowWriter(const ghc::filesystem::path &file_path,
+                         const std::vector<ArrowField> &schema,
+                         std::size_t batch_rows)
+    : file_path_(file_path),
+      tmp_path_(file_path.string() + ".tmp-" + generate_random_hash()),
+      schema_(schema), builders_(schema.size()), batch_rows_(batch_rows) {
+  if (schema_.empty()) {
+    throw arrow_error("Arrow schema of '" + file_path_.string() +
+                      "' has no fields");
+  }
+  if (batch_rows_ == 0) {
+    throw arrow_error("Arrow batches must have at least one row");
+  }
+  for (std::size_t c = 0; c < schema_.size(); ++c) {
+    const std::size_t width_ = type_width_(schema_[c].type);
+    if (width_) {
+      builders_[c].values.reserve(batch_rows_ * width_);
+    } else {
+      builders_[c].offsets.assign(1, 0);
+    }
+  }
+  out_.reset(new std::ofstream(tmp_path_.string(),
+                               std::ios_base::out | std::ios_base::binary));
+  if (!*out_) {
+    throw arrow_error("Cannot write Arrow file '" + file_path_.string() + "'");
+  }
+  write_(magic_, sizeof(magic_));
+  write_message_(schema_message_(schema_));
+}
+
+ArrowWriter::sptr
+ArrowWriter::construct(const ghc::filesystem::path &file_path,
+                       const std::vector<ArrowField> &schema,
+                       std::size_t batch_rows) {
+  return sptr(new ArrowWriter(file_path, schema, batch_rows));
+}
+
+ArrowWriter::~ArrowWriter() {
+  if (closed_) {
+    return;
+  }
+  try {
+    close();
+  } catch (const std::exception &e) {
+    logger::get_logger()->error()
+        << "ArrowWriter: Failed to write '" << file_path_.string()
+        << "': " << e.what();
+  }
+}
+
+void ArrowWriter::write_(const void *data, std::size_t size) {
+  out_->write(static_cast<const char *>(data),
+              static_cast<std::streamsize>(size));
+  hasher_.absorb(static_cast<const char *>(data), size);
+  offset_ += static_cast<std::int64_t>(size);
+}
+
+void ArrowWriter::write_message_(const std::vector<std::uint8_t> &metadata) {
+  std::vector<std::uint8_t> prefix_;
+  append_le_(prefix_, continuation_, 4);
+  append_le_(prefix_, metadata.size(), 4);
+  write_(prefix_.data(), prefix_.size());
+  write_(metadata.data(), metadata.size());
+}
+
+void ArrowWriter::write_record_batch_(
+    std::size_t n_rows, const std::vector<ColumnBuffers> &columns) {
+  // Body: for each column an empty validity buffer, as no value is null,
+  // then the offsets of a string column, then the values
+  std::vector<Pair_> nodes_;
+  std::vector<Pair_> buffers_;
+  std::int64_t body_size_ = 0;
+  const auto add_buffer_ = [&](std::size_t size) {
+    buffers_.emplace_back(body_size_, static_cast<std::int64_t>(size));
+    body_size_ += static_cast<std::int64_t>(padded_(size));
+  };
+  for (const ColumnBuffers &column_ : columns) {
+    nodes_.emplace_back(static_cast<std::int64_t>(n_rows), 0);
+    add_buffer_(0);
+    if (column_.offsets) {
+      add_buffer_((n_rows + 1) * sizeof(std::int32_t));
+    }
+    add_buffer_(column_.values_size);
+  }
+
+  const std::vector<std::uint8_t> metadata_ = record_batch_message_(
+      static_cast<std::int64_t>(n_rows), nodes_, buffers_, body_size_);
+  Block block_;
+  block_.offset = offset_;
+  block_.metadata_size = static_cast<std::int32_t>(8 + metadata_.size());
+  block_.body_size = body_size_;
+  write_message_(metadata_);
+
+  const auto write_padded_ = [&](const void *data, std::size_t size) {
+    write_(data, size);
+    write_(padding_, padded_(size) - size);
+  };
+  for (const ColumnBuffers &column_ : columns) {
+    if (column_.offsets) {
+      write_padded_(column_.offsets, (n_rows + 1) * sizeof(std::int32_t));
+    }
+    write_padded_(column_.values, column_.values_size);
+  }
+  blocks_.push_back(block_);
+}
+
+void ArrowWriter::write_batch(const std::vector<ArrowColumn> &columns) {
+  if (closed_) {
+    throw arrow_error("Arrow file '" + file_path_.string() + "' is closed");
+  }
+  if (n_fields_ > 0) {
+    throw arrow_error("Cannot write a batch within a row");
+  }
+  if (columns.size() != schema_.size()) {
+    throw arrow_error("Batch has " + std::to_string(columns.size()) +
+                      " columns, expected " + std::to_string(schema_.size()));
+  }
+  const std::size_t n_rows_batch_ = columns[0].size();
+  for (std::size_t c = 0; c < columns.size(); ++c) {
+    if (columns[c].get_type() != schema_[c].type) {
+      throw arrow_error("Column '" + schema_[c].name + "' is " +
+                        to_string(schema_[c].type) + ", not " +
+                        to_string(columns[c].get_type()));
+    }
+    if (columns[c].size() != n_rows_batch_) {
+      throw arrow_error("Column '" + schema_[c].name + "' has " +
+                        std::to_string(columns[c].size()) + " rows, expected " +
+                        std::to_string(n_rows_batch_));
+    }
+    if (schema_[c].type == ArrowType::STRING && !columns[c].get_strings()) {
+      throw arrow_error("Column '" + schema_[c].name +
+                        "' needs a vector of strings");
+    }
+  }
+  flush_rows_();
+  if (n_rows_batch_ == 0) {
+    return;
+  }
+
+  // Strings are gathered into offsets and data, fixed width values are
+  // written from the caller's vectors
+  std::vector<std::vector<std::int32_t>> offsets_(columns.size());
+  std::vector<std::string> strings_(columns.size());
+  std::vector<ColumnBuffers> buffers_(columns.size());
+  for (std::size_t c = 0; c < columns.size(); ++c) {
+    if (schema_[c].type != ArrowType::STRING) {
+      buffers_[c] = ColumnBuffers{
+          columns[c].get_values(),
+          n_rows_batch_ * type_width_(schema_[c].type), nullptr};
+      continue;
+    }
+    const std::vector<std::string> &values_ = *columns[c].get_strings();
+    std::size_t size_ = 0;
+    for (const std::string &value_ : values_) {
+      size_ += value_.size();
+    }
+    if (size_ > static_cast<std::size_t>(
+                    std::numeric_limits<std::int32_t>::max())) {
+      throw arrow_error("Strings of column '" + schema_[c].name +
+                        "' exceed 2 GiB, write smaller batches");
+    }
+    strings_[c].reserve(size_);
+    offsets_[c].reserve(values_.size() + 1);
+    offsets_[c].push_back(0);
+    for (const std::string &value_ : values_) {
+      strings_[c] += value_;
+      offsets_[c].push_back(static_cast<std::int32_t>(strings_[c].size()));
+    }
+    buffers_[c] = ColumnBuffers{strings_[c].data(), strings_[c].size(),
+                                offsets_[c].data()};
+  }
+  write_record_batch_(n_rows_batch_, buffers_);
+  n_rows_ += n_rows_batch_;
+}
+
+ArrowWriter::Builder &ArrowWriter::next_field_(ArrowType &type) {
+  if (closed_) {
+    throw arrow_error("Arrow file '" + file_path_.string() + "' is closed");
+  }
+  if (n_fields_ >= schema_.size()) {
+    drop_row_();
+    throw arrow_error("Row has more than " + std::to_string(schema_.size()) +
+                      " fields");
+  }
+  type = schema_[n_fields_].type;
+  return builders_[n_fields_];
+}
+
+void ArrowWriter::mismatch_(const std::string &value) {
+  const ArrowField field_ = schema_[n_fields_];
+  drop_row_();
+  throw arrow_error("Cannot write " + value + " to column '" + field_.name +
+                    "' of type " + to_string(field_.type));
+}
+
+namespace {
+template <typename T> void append_value_(std::vector<char> &values, T value) {
+  const char *bytes_ = reinterpret_cast<const char *>(&value);
+  values.insert(values.end(), bytes_, bytes_ + sizeof(T));
+}
+} // namespace
+
+ArrowWriter &ArrowWriter::integer_field_(std::int64_t value) {
+  ArrowType type_;
+  Builder &builder_ = next_field_(type_);
+  switch (type_) {
+  case ArrowType::INT32:
+    if (value < std::numeric_limits<std::int32_t>::min() ||
+        value > std::numeric_limits<std::int32_t>::max()) {
+      const std::string name_ = schema_[n_fields_].name;
+      drop_row_();
+      throw arrow_error(std::to_string(value) + " does not fit column '" +
+                        name_ + "' of type int32");
+    }
+    append_value_(builder_.values, static_cast<std::int32_t>(value));
+    break;
+  case ArrowType::INT64:
+    append_value_(builder_.values, value);
+    break;
+  case ArrowType::FLOAT32:
+    append_value_(builder_.values, static_cast<float>(value));
+    break;
+  case ArrowType::FLOAT64:
+    append_value_(builder_.values, static_cast<double>(value));
+    break;
+  case ArrowType::STRING:
+    mismatch_("a number");
+  }
+  ++n_fields_;
+  return *this;
+}
+
+ArrowWriter &ArrowWriter::unsigned_field_(std::uint64_t value) {
+  if (value <= static_cast<std::uint64_t>(
+                   std::numeric_limits<std::int64_t>::max())) {
+    return integer_field_(static_cast<std::int64_t>(value));
+  }
+  ArrowType type_;
+  Builder &builder_ = next_field_(type_);
+  switch (type_) {
+  case ArrowType::INT32:
+  case ArrowType::INT64: {
+    const std::string name_ = schema_[n_fields_].name;
+    drop_row_();
+    throw arrow_error(std::to_string(value) + " does not fit column '" +
+                      name_ + "' of type " + to_string(type_));
+  }
+  case ArrowType::FLOAT32:
+    append_value_(builder_.values, static_cast<float>(value));
+    break;
+  case ArrowType::FLOAT64:
+    append_value_(builder_.values, static_cast<double>(value));
+    break;
+  case ArrowType::STRING:
+    mismatch_("a number");
+  }
+  ++n_fields_;
+  return *this;
+}
+
+ArrowWriter &ArrowWriter::field(double value) {
+  ArrowType type_;
+  Builder &builder_ = next_field_(type_);
+  if (type_ == ArrowType::FLOAT32) {
+    append_value_(builder_.values, static_cast<float>(value));
+  } else if (type_ == ArrowType::FLOAT64) {
+    append_value_(builder_.values, value);
+  } else {
+    mismatch_("a double");
+  }
+  ++n_fields_;
+  return *this;
+}
+
+ArrowWriter &ArrowWriter::field(const std::string &value) {
+  return string_field_(value.data(), value.size());
+}
+
+ArrowWriter &ArrowWriter::string_field_(const char *text, std::size_t size) {
+  ArrowType type_;
+  Builder &builder_ = next_field_(type_);
+  if (type_ != ArrowType::STRING) {
+    mismatch_("a string");
+  }
+  if (builder_.values.size() + size >
+      static_cast<std::size_t>(std::numeric_limits<std::int32_t>::max())) {
+    const std::string name_ = schema_[n_fields_].name;
+    drop_row_();
+    throw arrow_error("Strings of column '" + name_ +
+                      "' exceed 2 GiB, use smaller batches");
+  }
+  builder_.values.insert(builder_.values.end(), text, text + size);
+  builder_.offsets.push_back(static_cast<std::int32_t>(builder_.values.size()));
+  ++n_fields_;
+  return *this;
+}
+
+void ArrowWriter::drop_row_() {
+  for (std::size_t c = 0; c < n_fields_; ++c) {
+    Builder &builder_ = builders_[c];
+    if (schema_[c].type == ArrowType::STRING) {
+      builder_.offsets.pop_back();
+      builder_.values.resize(static_cast<std::size_t>(builder_.offsets.back()));
+    } else {
+      builder_.values.resize(builder_.values.size() -
+                             type_width_(schema_[c].type));
+    }
+  }
+  n_fields_ = 0;
+}
+
+ArrowWriter &ArrowWriter::end_row() {
+  if (n_fields_ != schema_.size()) {
+    const std::size_t n_fields_written_ = n_fields_;
+    drop_row_();
+    throw arrow_error("Row has " + std::to_string(n_fields_written_) +
+                      " fields, expected " + std::to_string(schema_.size()));
+  }
+  n_fields_ = 0;
+  ++n_rows_;
+  if (++n_pending_ >= batch_rows_) {
+    flush_rows_();
+  }
+  return *this;
+}
+
+void ArrowWriter::flush_rows_() {
+  if (n_pending_ == 0) {
+    return;
+  }
+  std::vector<ColumnBuffers> buffers_;
+  for (const Builder &builder_ : builders_) {
+    buffers_.push_back(ColumnBuffers{
+        builder_.values.data(), builder_.values.size(),
+        builder_.offsets.empty() ? nullptr : builder_.offsets.data()});
+  }
+  write_record_batch_(n_pending_, buffers_);
+  for (Builder &builder_ : builders_) {
+    builder_.values.clear();
+    if (!builder_.offsets.empty()) {
+      builder_.offsets.assign(1, 0);
+    }
+  }
+  n_pending_ = 0;
+}
+
+std::string ArrowWriter::close() {
+  if (closed_) {
+    return hash_;
+  }
+  try {
+    if (n_fields_ > 0) {
+      end_row();
+    }
+    flush_rows_();
+
+    std::vector<std::uint8_t> end_;
+    append_le_(end_, continuation_, 4);
+    append_le_(end_, 0, 4);
+    write_(end_.data(), end_.size());
+
+    FlatBuilder_ builder_;
+    std::vector<std::size_t> slots_;
+    const std::size_t footer_ =
+        builder_.table(FlatBuilder_::Table()
+                           .scalar<std::int16_t>(0, metadata_v5_)
+                           .offset(1)
+                           .offset(2)
+                           .offset(3),
+                       slots_);
+    builder_.link(slots_[0], schema_table_(builder_, schema_));
+    builder_.link(slots_[1], builder_.structs({}, 0));
+    std::vector<std::uint8_t> blocks_bytes_;
+    for (const Block &block_ : blocks_) {
+      append_le_(blocks_bytes_, static_cast<std::uint64_t>(block_.offset), 8);
+      append_le_(blocks_bytes_,
+                 static_cast<std::uint32_t>(block_.metadata_size), 4);
+      append_le_(blocks_bytes_, 0, 4);
+      append_le_(blocks_bytes_, static_cast<std::uint64_t>(block_.body_size),
+                 8);
+    }
+    builder_.link(slots_[2], builder_.structs(blocks_bytes_, blocks_.size()));
+    const std::vector<std::uint8_t> footer_bytes_ = builder_.finish(footer_);
+    write_(footer_bytes_.data(), footer_bytes_.size());
+    std::vector<std::uint8_t> trailer_;
+    append_le_(trailer_, footer_bytes_.size(), 4);
+    write_(trailer_.data(), trailer_.size());
+    write_(magic_, 6);
+
+    out_->close();
+    if (!*out_) {
+      throw arrow_error("Failed writing Arrow file '" + file_path_.string() +
+                        "'");
+    }
+    std::error_code ec_;
+    ghc::filesystem::rename(tmp_path_, file_path_, ec_);
+    if (ec_) {
+      throw arrow_error("Cannot move Arrow file to '" + file_path_.string() +
+                        "': " + ec_.message());
+    }
+  } catch (...) {
+    closed_ = true;
+    std::error_code ec_;
+    ghc::filesystem::remove(tmp_path_, ec_);
+    throw;
+  }
+  closed_ = true;
+  hash_ = hasher_.hexdigest();
+  HashCache::key_type key_;
+  if (HashCache::get_key(file_path_, key_)) {
+    HashCache::get_cache()->store(file_path_, "sha1", key_, hash_);
+  }
+  logger::get_logger()->debug()
+      << "ArrowWriter: Wrote " << n_rows_ << " rows in " << blocks_.size()
+      << " batches to '" << file_path_.string() << "'";
+  return hash_;
+}
+
+const char *const ArrowTable::file_type = "arrow";
+
+ArrowTable::sptr ArrowTable::open(const ghc::filesystem::path &file_path) {
+  std::shared_ptr<ArrowTable> table_(new ArrowTable());
+  table_->parse_(file_path);
+  return table_;
+}
+
+ArrowTable::~ArrowTable() {
+#ifndef _WIN32
+  if (mapped_) {
+    ::munmap(const_cast<std::uint8_t *>(data_), size_);
+  }
+#endif
+}
+
+void ArrowTable::parse_(const ghc::filesystem::path &file_path) {
+#ifndef _WIN32
+  const int fd_ = ::open(file_path.string().c_str(), O_RDONLY);
+  if (fd_ < 0) {
+    throw arrow_error("Failed to open '" + file_path.string() + "'");
+  }
+  struct stat st_;
+  if (::fstat(fd_, &st_) == 0) {
+    size_ = static_cast<std::size_t>(st_.st_size);
+    if (size_ > 0) {
+      void *data_map_ = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+      if (data_map_ != MAP_FAILED) {
+        data_ = static_cast<const std::uint8_t *>(data_map_);
+        mapped_ = true;
+      }
+    }
+  }
+  ::close(fd_);
+#endif
+  if (!mapped_) {
+    // No mmap on this platform, or the map failed: read the file into
+    // memory aligned for any column type
+    std::ifstream in_(file_path.string(),
+                      std::ios_base::binary | std::ios_base::ate);
+    if (!in_) {
+      throw arrow_error("Failed to open '" + file_path.string() + "'");
+    }
+    size_ = static_cast<std::size_t>(in_.tellg());
+    buffer_.resize(size_ / sizeof(std::uint64_t) + 1);
+    in_.seekg(0);
+    in_.read(reinterpret_cast<char *>(buffer_.data()),
+             static_cast<std::streamsize>(size_));
+    data_ = reinterpret_cast<const std::uint8_t *>(buffer_.data());
+  }
+
+  try {
+    if (size_ < sizeof(magic_) + 10 ||
+        std::memcmp(data_, magic_, 6) != 0 ||
+        std::memcmp(data_ + size_ - 6, magic_, 6) != 0) {
+      throw arrow_error("not an Arrow IPC file");
+    }
+    const std::int32_t footer_size_ =
+        get_le_<std::int32_t>(data_, size_, size_ - 10);
+    if (footer_size_ <= 0 ||
+        static_cast<std::size_t>(footer_size_) > size_ - sizeof(magic_) - 10) {
+      throw arrow_error("invalid footer size");
+    }
+    const FlatTable_ footer_ = FlatTable_::root(
+        data_ + size_ - 10 - footer_size_,
+        static_cast<std::size_t>(footer_size_));
+
+    const FlatTable_ flat_schema_ = footer_.table(1);
+    if (flat_schema_.scalar<std::int16_t>(0, 0) != host_endianness_()) {
+      throw arrow_error("byte order differs from this machine");
+    }
+    std::size_t n_fields_ = 0;
+    const std::size_t fields_ = flat_schema_.vector(1, 4, n_fields_);
+    for (std::size_t i = 0; i < n_fields_; ++i) {
+      const FlatTable_ field_ = flat_schema_.at(fields_ + 4 * i);
+      ArrowField arrow_field_{field_.string(0), ArrowType::INT32};
+      if (field_.has(4)) {
+        throw arrow_error("column '" + arrow_field_.name +
+                          "' is dictionary encoded");
+      }
+      const std::uint8_t type_type_ = field_.scalar<std::uint8_t>(2, 0);
+      const FlatTable_ type_ = field_.table(3);
+      bool supported_ = true;
+      if (type_type_ == type_int_) {
+        const std::int32_t bits_ = type_.scalar<std::int32_t>(0, 0);
+        supported_ = type_.scalar<std::uint8_t>(1, 0) &&
+                     (bits_ == 32 || bits_ == 64);
+        arrow_field_.type = bits_ == 32 ? ArrowType::INT32 : ArrowType::INT64;
+      } else if (type_type_ == type_floating_point_) {
+        const std::int16_t precision_ = type_.scalar<std::int16_t>(0, 0);
+        supported_ = precision_ == precision_single_ ||
+                     precision_ == precision_double_;
+        arrow_field_.type = precision_ == precision_single_
+                                ? ArrowType::FLOAT32
+                                : ArrowType::FLOAT64;
+      } else if (type_type_ == type_utf8_) {
+        arrow_field_.type = ArrowType::STRING;
+      } else {
+        supported_ = false;
+      }
+      if (!supported_) {
+        throw arrow_error("column '" + arrow_field_.name +
+                          "' has an unsupported type");
+      }
+      schema_.push_back(arrow_field_);
+    }
+
+    std::size_t n_dictionaries_ = 0;
+    footer_.vector(2, 24, n_dictionaries_);
+    if (n_dictionaries_ > 0) {
+      throw arrow_error("dictionaries are not supported");
+    }
+
+    std::size_t n_blocks_ = 0;
+    const std::size_t blocks_ = footer_.vector(3, 24, n_blocks_);
+    for (std::size_t i = 0; i < n_blocks_; ++i) {
+      const std::size_t block_ = blocks_ + 24 * i;
+      const std::int64_t offset_ = footer_.get<std::int64_t>(block_);
+      const std::int32_t metadata_size_ = footer_.get<std::int32_t>(block_ + 8);
+      const std::int64_t body_size_ = footer_.get<std::int64_t>(block_ + 16);
+      if (offset_ < 0 || metadata_size_ < 8 || body_size_ < 0 ||
+          static_cast<std::uint64_t>(offset_) > size_ ||
+          size_ - static_cast<std::size_t>(offset_) <
+              static_cast<std::uint64_t>(metadata_size_) +
+                  static_cast<std::uint64_t>(body_size_)) {
+        throw arrow_error("record batch beyond the end of the file");
+      }
+      const std::size_t message_ = static_cast<std::size_t>(offset_);
+      const std::size_t body_ =
+          message_ + static_cast<std::size_t>(metadata_size_);
+
+      // Messages of files before Arrow 0.15 have no continuation marker
+      std::size_t flatbuffer_ = message_ + 4;
+      std::int32_t flatbuffer_size_ =
+          get_le_<std::int32_t>(data_, size_, message_);
+      if (static_cast<std::uint32_t>(flatbuffer_size_) == continuation_) {
+        flatbuffer_ = message_ + 8;
+        flatbuffer_size_ = get_le_<std::int32_t>(data_, size_, message_ + 4);
+      }
+      if (flatbuffer_size_ <= 0 ||
+          flatbuffer_ + static_cast<std::size_t>(flatbuffer_size_) > body_) {
+        throw arrow_error("invalid record batch metadata");
+      }
+      const FlatTable_ message_table_ = FlatTable_::root(
+          data_ + flatbuffer_, static_cast<std::size_t>(flatbuffer_size_));
+      if (message_table_.scalar<std::uint8_t>(1, 0) != header_record_batch_) {
+        throw arrow_error("block is not a record batch");
+      }
+      const FlatTable_ record_batch_ = message_table_.table(2);
+      if (record_batch_.has(3)) {
+        throw arrow_error("compressed record batches are not supported");
+      }
+      const std::int64_t n_rows_batch_ =
+          record_batch_.scalar<std::int64_t>(0, 0);
+      // Every column takes at least four bytes a row
+      if (n_rows_batch_ < 0 ||
+          static_cast<std::uint64_t>(n_rows_batch_) > size_ / 4) {
+        throw arrow_error("invalid record batch length");
+      }
+      const std::size_t length_ = static_cast<std::size_t>(n_rows_batch_);
+
+      std::size_t n_nodes_ = 0;
+      std::size_t n_buffers_ = 0;
+      const std::size_t nodes_ = record_batch_.vector(1, 16, n_nodes_);
+      const std::size_t buffer_entries_ =
+          record_batch_.vector(2, 16, n_buffers_);
+      if (n_nodes_ != schema_.size()) {
+        throw arrow_error("record batch has " + std::to_string(n_nodes_) +
+                          " columns, expected " +
+                          std::to_string(schema_.size()));
+      }
+
+      Batch batch_;
+      batch_.n_rows = length_;
+      std::size_t buffer_index_ = 0;
+      // Pointer to the next buffer of the body, checked to hold min_size
+      const auto next_buffer_ = [&](std::size_t min_size, std::size_t align)
+          -> std::pair<const std::uint8_t *, std::size_t> {
+        if (buffer_index_ >= n_buffers_) {
+          throw arrow_error("record batch has too few buffers");
+        }
+        const std::size_t entry_ = buffer_entries_ + 16 * buffer_index_++;
+        const std::int64_t buffer_offset_ =
+            record_batch_.get<std::int64_t>(entry_);
+        const std::int64_t buffer_size_ =
+            record_batch_.get<std::int64_t>(entry_ + 8);
+        if (buffer_offset_ < 0 || buffer_size_ < 0 ||
+            buffer_offset_ > body_size_ - buffer_size_ ||
+            static_cast<std::uint64_t>(buffer_size_) < min_size) {
+          throw arrow_error("record batch buffer out of bounds");
+        }
+        const std::uint8_t *pointer_ =
+            data_ + body_ + static_cast<std::size_t>(buffer_offset_);
+        if (min_size > 0 &&
+            reinterpret_cast<std::uintptr_t>(pointer_) % align) {
+          throw arrow_error("record batch buffer is not aligned");
+        }
+        return std::make_pair(pointer_, static_cast<std::size_t>(buffer_size_));
+      };
+
+      for (std::size_t c = 0; c < schema_.size(); ++c) {
+        const std::int64_t null_count_ =
+            record_batch_.get<std::int64_t>(nodes_ + 16 * c + 8);
+        if (null_count_ < 0 ||
+            static_cast<std::uint64_t>(null_count_) > length_) {
+          throw arrow_error("invalid null count");
+        }
+        Buffers column_;
+        column_.null_count = static_cast<std::size_t>(null_count_);
+        column_.validity =
+            next_buffer_(null_count_ ? (length_ + 7) / 8 : 0, 1).first;
+        if (!null_count_) {
+          column_.validity = nullptr;
+        }
+        column_.offsets = nullptr;
+        const std::size_t width_ = type_width_(schema_[c].type);
+        if (width_) {
+          column_.values = next_buffer_(length_ * width_, width_).first;
+        } else {
+          static const std::int32_t empty_offsets_[1] = {0};
+          const std::pair<const std::uint8_t *, std::size_t> offsets_ =
+              next_buffer_(length_ ? (length_ + 1) * 4 : 0, 4);
+          const std::pair<const std::uint8_t *, std::size_t> strings_ =
+              next_buffer_(0, 1);
+          column_.offsets =
+              length_ ? reinterpret_cast<const std::int32_t *>(offsets_.first)
+                      : empty_offsets_;
+          column_.values = strings_.first;
+          if (column_.offsets[0] < 0 ||
+              column_.offsets[length_] < column_.offsets[0] ||
+              static_cast<std::size_t>(column_.offsets[length_]) >
+                  strings_.second) {
+            throw arrow_error("string offsets out of bounds");
+          }
+        }
+        batch_.columns.push_back(column_);
+      }
+      n_rows_ += length_;
+      batches_.push_back(std::move(batch_));
+    }
+  } catch (const arrow_error &e) {
+    throw arrow_error("Cannot read Arrow file '" + file_path.string() +
+                      "': " + e.what());
+  }
+  logger::get_logger()->debug()
+      << "ArrowTable: Mapped " << n_rows_ << " rows in " << batches_.size()
+      << " batches from '" << file_path.string() << "'";
+}
+
+std::size_t ArrowTable::batch_rows(std::size_t batch) const {
+  if (batch >= batches_.size()) {
+    throw arrow_error("No batch " + std::to_string(batch) + " of " +
+                      std::to_string(batches_.size()));
+  }
+  return batches_[batch].n_rows;
+}
+
+std::size_t ArrowTable::column_index(const std::string &name) const {
+  for (std::size_t c = 0; c < schema_.size(); ++c) {
+    if (schema_[c].name == name) {
+      return c;
+    }
+  }
+  throw arrow_error("No column '" + name + "'");
+}
+
+const ArrowTable::Buffers &ArrowTable::buffers_(std::size_t batch,
+                                                std::size_t column) const {
+  batch_rows(batch);
+  if (column >= schema_.size()) {
+    throw arrow_error("No column " + std::to_string(column) + " of " +
+                      std::to_string(schema_.size()));
+  }
+  return batches_[batch].columns[column];
+}
+
+const void *ArrowTable::values_(std::size_t batch, std::size_t column,
+                                ArrowType type) const {
+  const Buffers &buffers_column_ = buffers_(batch, column);
+  if (schema_[column].type != type) {
+    throw arrow_error("Column '" + schema_[column].name + "' is " +
+                      to_string(schema_[column].type) + ", not " +
+                      to_string(type));
+  }
+  return buffers_column_.values;
+}
+
+std::size_t ArrowTable::null_count(std::size_t batch,
+                                   std::size_t column) const {
+  return buffers_(batch, column).null_count;
+}
+
+bool ArrowTable::is_valid(std::size_t batch, std::size_t column,
+                          std::size_t row) const {
+  const Buffers &buffers_column_ = buffers_(batch, column);
+  if (row >= batches_[batch].n_rows) {
+    throw arrow_error("No row " + std::to_string(row) + " of " +
+                      std::to_string(batches_[batch].n_rows));
+  }
+  return !buffers_column_.validity ||
+         ((buffers_column_.validity[row >> 3] >> (row & 7)) & 1);
+}
+
+const std::int32_t *ArrowTable::string_offsets(std::size_t batch,
+                                               std::size_t column) const {
+  values_(batch, column, ArrowType::STRING);
+  return batches_[batch].columns[column].offsets;
+}
+
+const char *ArrowTable::string_data(std::size_t batch,
+                                    std::size_t column) const {
+  return static_cast<const char *>(values_(batch, column, ArrowType::STRING));
+}
+
+std::string ArrowTable::get_string(std::size_t batch, std::size_t column,
+                                   std::size_t row) const {
+  const char *data_column_ = string_data(batch, column);
+  if (!is_valid(batch, column, row)) {
+    return "";
+  }
+  const std::int32_t *offsets_ = batches_[batch].columns[column].offsets;
+  const std::size_t n_rows_batch_ = batches_[batch].n_rows;
+  if (offsets_[row] < offsets_[0] || offsets_[row + 1] < offsets_[row] ||
+      offsets_[row + 1] > offsets_[n_rows_batch_]) {
+    throw arrow_error("String offsets of column '" + schema_[column].name +
+                      "' out of bounds");
+  }
+  return std::string(
+      data_column_ + offsets_[row],
+      static_cast<std::size_t>(offsets_[row + 1] - offsets_[row]));
+}
+
+std::vector<std::string> ArrowTable::read_strings(std::size_t column) const {
+  std::vector<std::string> strings_;
+  strings_.reserve(n_rows_);
+  for (std::size_t b = 0; b < batches_.size(); ++b) {
+    for (std::size_t row_ = 0; row_ < batches_[b].n_rows; ++row_) {
+      strings_.push_back(get_string(b, column, row_));
+    }
+  }
+  return strings_;
+}
+
+}; // namespace FairDataPipeline
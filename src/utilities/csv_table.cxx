@@ -0,0 +1,1136 @@
+#include "fdp/utilities/csv_table.hxx"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <limits>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FDP_CSV_SSE2_
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "fdp/utilities/hash_cache.hxx"
+#include "fdp/utilities/hashing.hxx"
+#include "fdp/utilities/logging.hxx"
+#include "fdp/utilities/parallel.hxx"
+
+namespace FairDataPipeline {
+
+namespace {
+const std::size_t chunk_bytes_ = 4 << 20;
+const std::size_t flush_bytes_ = 1 << 20;
+
+/**
+ * @brief Contents of a file, mapped where possible
+ */
+class FileText {
+public:
+  explicit FileText(const ghc::filesystem::path &file_path) {
+#ifndef _WIN32
+    const int fd_ = ::open(file_path.string().c_str(), O_RDONLY);
+    if (fd_ < 0) {
+      throw csv_error("Failed to open '" + file_path.string() + "'");
+    }
+    struct stat st_;
+    if (::fstat(fd_, &st_) == 0) {
+      size_ = static_cast<std::size_t>(st_.st_size);
+      if (size_ > 0) {
+        void *data_map_ =
+            ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+        if (data_map_ != MAP_FAILED) {
+          data_ = static_cast<const char *>(data_map_);
+          mapped_ = true;
+        }
+      }
+    }
+    ::close(fd_);
+#endif
+    if (!mapped_) {
+      // No mmap on this platform, or the map failed: read the file instead
+      std::ifstream in_(file_path.string(), std::ios_base::binary);
+      if (!in_) {
+        throw csv_error("Failed to open '" + file_path.string() + "'");
+      }
+      buffer_.assign(std::istreambuf_iterator<char>(in_),
+                     std::istreambuf_iterator<char>());
+      data_ = buffer_.data();
+      size_ = buffer_.size();
+    }
+  }
+
+  ~FileText() {
+#ifndef _WIN32
+    if (mapped_) {
+      ::munmap(const_cast<char *>(data_), size_);
+    }
+#endif
+  }
+
+  const char *data() const { return data_; }
+  std::size_t size() const { return size_; }
+
+private:
+  FileText(const FileText &rhs) = delete;
+  FileText &operator=(const FileText &rhs) = delete;
+
+  const char *data_ = nullptr;
+  std::size_t size_ = 0;
+  bool mapped_ = false;
+  std::vector<char> buffer_;
+};
+
+unsigned int popcount_(std::uint32_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<unsigned int>(__builtin_popcount(mask));
+#else
+  unsigned int count_ = 0;
+  for (; mask; mask &= mask - 1) {
+    ++count_;
+  }
+  return count_;
+#endif
+}
+
+unsigned int lowest_bit_(std::uint32_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<unsigned int>(__builtin_ctz(mask));
+#elif defined(_MSC_VER)
+  unsigned long index_ = 0;
+  _BitScanForward(&index_, mask);
+  return static_cast<unsigned int>(index_);
+#else
+  unsigned int index_ = 0;
+  while (!(mask & 1u)) {
+    mask >>= 1;
+    ++index_;
+  }
+  return index_;
+#endif
+}
+
+/**
+ * @brief Positions of the characters which structure a CSV file in a block
+ * of 16 bytes, bit i for byte i
+ */
+struct Block {
+  std::uint32_t quotes;
+  std::uint32_t delimiters;
+  std::uint32_t newlines;
+};
+
+Block classify_(const char *bytes, char delimiter) {
+  Block block_;
+#ifdef FDP_CSV_SSE2_
+  const __m128i text_ =
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(bytes));
+  block_.quotes = static_cast<std::uint32_t>(
+      _mm_movemask_epi8(_mm_cmpeq_epi8(text_, _mm_set1_epi8('"'))));
+  block_.delimiters = static_cast<std::uint32_t>(
+      _mm_movemask_epi8(_mm_cmpeq_epi8(text_, _mm_set1_epi8(delimiter))));
+  block_.newlines = static_cast<std::uint32_t>(
+      _mm_movemask_epi8(_mm_cmpeq_epi8(text_, _mm_set1_epi8('\n'))));
+#else
+  block_.quotes = block_.delimiters = block_.newlines = 0;
+  for (unsigned int i = 0; i < 16; ++i) {
+    block_.quotes |= std::uint32_t(bytes[i] == '"') << i;
+    block_.delimiters |= std::uint32_t(bytes[i] == delimiter) << i;
+    block_.newlines |= std::uint32_t(bytes[i] == '\n') << i;
+  }
+#endif
+  return block_;
+}
+
+/**
+ * @brief Call function(position, block) for each block of [begin, end),
+ * with bits past end cleared
+ */
+template <typename Function>
+void for_each_block_(const char *data, std::size_t begin, std::size_t end,
+                     char delimiter, Function &&function) {
+  std::size_t position_ = begin;
+  for (; position_ + 16 <= end; position_ += 16) {
+    if (!function(position_, classify_(data + position_, delimiter))) {
+      return;
+    }
+  }
+  if (position_ < end) {
+    char tail_[16] = {0};
+    const std::size_t n_tail_ = end - position_;
+    std::memcpy(tail_, data + position_, n_tail_);
+    Block block_ = classify_(tail_, delimiter);
+    const std::uint32_t valid_ = (1u << n_tail_) - 1u;
+    block_.quotes &= valid_;
+    block_.delimiters &= valid_;
+    block_.newlines &= valid_;
+    function(position_, block_);
+  }
+}
+
+/**
+ * @brief Count the quotes and newlines of [begin, end)
+ */
+void count_structure_(const char *data, std::size_t begin, std::size_t end,
+                      std::uint64_t &n_quotes, std::uint64_t &n_newlines) {
+  n_quotes = n_newlines = 0;
+  for_each_block_(data, begin, end, '"',
+                  [&](std::size_t, const Block &block) {
+                    n_quotes += popcount_(block.quotes);
+                    n_newlines += popcount_(block.newlines);
+                    return true;
+                  });
+}
+
+/**
+ * @brief Position after the first newline outside quotes at or after begin
+ */
+std::size_t find_row_end_(const char *data, std::size_t begin,
+                          std::size_t end, bool in_quotes) {
+  std::size_t row_end_ = end;
+  for_each_block_(data, begin, end, '"',
+                  [&](std::size_t position, const Block &block) {
+                    if (!block.quotes) {
+                      if (!in_quotes && block.newlines) {
+                        row_end_ = position + lowest_bit_(block.newlines) + 1;
+                        return false;
+                      }
+                      return true;
+                    }
+                    std::uint32_t bits_ = block.quotes | block.newlines;
+                    while (bits_) {
+                      const unsigned int bit_ = lowest_bit_(bits_);
+                      bits_ &= bits_ - 1;
+                      if (block.quotes & (1u << bit_)) {
+                        in_quotes = !in_quotes;
+                      } else if (!in_quotes) {
+                        row_end_ = position + bit_ + 1;
+                        return false;
+                      }
+                    }
+                    return true;
+                  });
+  return row_end_;
+}
+
+/**
+ * @brief Split [begin, end), which starts at a row, into fields
+ *
+ * on_field(index, text, size, quoted) is called for each field and
+ * on_row(n_fields, position) at the end of each row, with the position of
+ * its first byte. Empty lines are skipped.
+ */
+template <typename OnField, typename OnRow>
+void scan_fields_(const char *data, std::size_t begin, std::size_t end,
+                  char delimiter, OnField &&on_field, OnRow &&on_row) {
+  bool in_quotes_ = false;
+  bool quoted_ = false;
+  std::size_t field_start_ = begin;
+  std::size_t row_start_ = begin;
+  std::size_t n_fields_ = 0;
+
+  auto end_field_ = [&](std::size_t position, bool row_end) {
+    std::size_t size_ = position - field_start_;
+    if (row_end && size_ > 0 && data[position - 1] == '\r') {
+      --size_;
+    }
+    if (row_end && n_fields_ == 0 && size_ == 0 && !quoted_) {
+      // Empty line
+    } else {
+      on_field(n_fields_++, data + field_start_, size_, quoted_);
+      if (row_end) {
+        on_row(n_fields_, row_start_);
+      }
+    }
+    if (row_end) {
+      n_fields_ = 0;
+      row_start_ = position + 1;
+    }
+    field_start_ = position + 1;
+    quoted_ = false;
+  };
+
+  for_each_block_(
+      data, begin, end, delimiter, [&](std::size_t position, const Block &block) {
+        std::uint32_t bits_ = block.quotes | block.delimiters | block.newlines;
+        while (bits_) {
+          const unsigned int bit_ = lowest_bit_(bits_);
+          const std::uint32_t flag_ = 1u << bit_;
+          bits_ &= bits_ - 1;
+          if (block.quotes & flag_) {
+            in_quotes_ = !in_quotes_;
+            quoted_ = true;
+          } else if (in_quotes_) {
+            continue;
+          } else {
+            end_field_(position + bit_, (block.newlines & flag_) != 0);
+          }
+        }
+        return true;
+      });
+  if (field_start_ < end || n_fields_ > 0) {
+    end_field_(end, true);
+  }
+}
+
+/**
+ * @brief Text of a field with its quotes removed
+ */
+void unquote_(const char *text, std::size_t size, std::string &out) {
+  out.clear();
+  if (size >= 2 && text[0] == '"' && text[size - 1] == '"') {
+    ++text;
+    size -= 2;
+  }
+  out.reserve(size);
+  for (std::size_t i = 0; i < size; ++i) {
+    out.push_back(text[i]);
+    if (text[i] == '"' && i + 1 < size && text[i + 1] == '"') {
+      ++i;
+    }
+  }
+}
+
+bool parse_int64_(const char *text, std::size_t size, std::int64_t &value) {
+  std::size_t i = 0;
+  const bool negative_ = size > 0 && text[0] == '-';
+  if (size > 0 && (text[0] == '-' || text[0] == '+')) {
+    ++i;
+  }
+  if (i == size) {
+    return false;
+  }
+  const std::uint64_t limit_ =
+      static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max()) +
+      (negative_ ? 1u : 0u);
+  std::uint64_t magnitude_ = 0;
+  for (; i < size; ++i) {
+    const unsigned int digit_ = static_cast<unsigned char>(text[i]) - '0';
+    if (digit_ > 9 || magnitude_ > (limit_ - digit_) / 10) {
+      return false;
+    }
+    magnitude_ = magnitude_ * 10 + digit_;
+  }
+  value = negative_ ? static_cast<std::int64_t>(0 - magnitude_)
+                    : static_cast<std::int64_t>(magnitude_);
+  return true;
+}
+
+bool equals_lower_(const char *text, std::size_t size, const char *lower) {
+  for (std::size_t i = 0; i < size; ++i) {
+    if (lower[i] == '\0' ||
+        std::tolower(static_cast<unsigned char>(text[i])) != lower[i]) {
+      return false;
+    }
+  }
+  return lower[size] == '\0';
+}
+
+/**
+ * @brief Parse a decimal number
+ *
+ * Numbers of up to 19 significant digits with a power of ten in [-22, 22]
+ * are exact in double arithmetic, others are left to strtod.
+ */
+bool parse_float64_(const char *text, std::size_t size, double &value) {
+  static const double powers_[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                                    1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                                    1e18, 1e19, 1e20, 1e21, 1e22};
+  std::size_t i = 0;
+  const bool negative_ = size > 0 && text[0] == '-';
+  if (size > 0 && (text[0] == '-' || text[0] == '+')) {
+    ++i;
+  }
+  if (equals_lower_(text + i, size - i, "nan")) {
+    value = std::numeric_limits<double>::quiet_NaN();
+    return true;
+  }
+  if (equals_lower_(text + i, size - i, "inf") ||
+      equals_lower_(text + i, size - i, "infinity")) {
+    value = negative_ ? -std::numeric_limits<double>::infinity()
+                      : std::numeric_limits<double>::infinity();
+    return true;
+  }
+
+  std::uint64_t mantissa_ = 0;
+  int n_digits_ = 0;
+  int exponent_ = 0;
+  bool exact_ = true;
+  std::size_t n_mantissa_chars_ = 0;
+  for (bool fraction_ = false; i < size; ++i) {
+    const char c_ = text[i];
+    if (c_ == '.' && !fraction_) {
+      fraction_ = true;
+      continue;
+    }
+    const unsigned int digit_ = static_cast<unsigned char>(c_) - '0';
+    if (digit_ > 9) {
+      break;
+    }
+    ++n_mantissa_chars_;
+    if (mantissa_ == 0 && digit_ == 0) {
+      exponent_ -= fraction_ ? 1 : 0;
+      continue;
+    }
+    if (n_digits_ < 19) {
+      mantissa_ = mantissa_ * 10 + digit_;
+      ++n_digits_;
+      exponent_ -= fraction_ ? 1 : 0;
+    } else {
+      exact_ = exact_ && digit_ == 0;
+      exponent_ += fraction_ ? 0 : 1;
+    }
+  }
+  if (n_mantissa_chars_ == 0) {
+    return false;
+  }
+  if (i < size && (text[i] == 'e' || text[i] == 'E')) {
+    ++i;
+    const bool negative_exponent_ = i < size && text[i] == '-';
+    if (i < size && (text[i] == '-' || text[i] == '+')) {
+      ++i;
+    }
+    if (i == size) {
+      return false;
+    }
+    int written_ = 0;
+    for (; i < size; ++i) {
+      const unsigned int digit_ = static_cast<unsigned char>(text[i]) - '0';
+      if (digit_ > 9) {
+        return false;
+      }
+      written_ = std::min(written_ * 10 + static_cast<int>(digit_), 100000);
+    }
+    exponent_ += negative_exponent_ ? -written_ : written_;
+  }
+  if (i != size) {
+    return false;
+  }
+
+  if (exact_ && mantissa_ <= (std::uint64_t(1) << 53) && exponent_ >= -22 &&
+      exponent_ <= 22) {
+    value = static_cast<double>(mantissa_);
+    value = exponent_ < 0 ? value / powers_[-exponent_]
+                          : value * powers_[exponent_];
+    if (negative_) {
+      value = -value;
+    }
+  } else {
+    const std::string copy_(text, size);
+    value = std::strtod(copy_.c_str(), nullptr);
+  }
+  return true;
+}
+
+void promote_to_float64_(CsvTable::Column &column) {
+  column.float64s.reserve(column.int64s.size());
+  for (std::int64_t value_ : column.int64s) {
+    column.float64s.push_back(static_cast<double>(value_));
+  }
+  std::vector<std::int64_t>().swap(column.int64s);
+  column.type = CsvType::FLOAT64;
+}
+
+/**
+ * @brief Rows of one chunk, parsed into columns of their own
+ */
+struct Fragment {
+  std::size_t begin = 0;
+  std::size_t end = 0;
+  std::size_t n_rows = 0;
+  std::size_t n_rows_expected = 0; /*!< newlines in the chunk, to reserve */
+  std::vector<CsvTable::Column> columns;
+};
+
+/**
+ * @brief Parses the rows of a chunk into typed columns
+ */
+class ChunkParser {
+public:
+  ChunkParser(const char *data, char delimiter,
+              const std::vector<std::string> &names,
+              const std::vector<CsvType> &types,
+              const std::vector<bool> &forced)
+      : data_(data), delimiter_(delimiter), names_(names), types_(types),
+        forced_(forced) {}
+
+  void parse(Fragment &fragment) const {
+    const std::size_t n_columns_ = names_.size();
+    fragment.columns.assign(n_columns_, CsvTable::Column());
+    for (std::size_t c = 0; c < n_columns_; ++c) {
+      CsvTable::Column &column_ = fragment.columns[c];
+      column_.type = types_[c];
+      switch (column_.type) {
+      case CsvType::INT64:
+        column_.int64s.reserve(fragment.n_rows_expected);
+        break;
+      case CsvType::FLOAT64:
+        column_.float64s.reserve(fragment.n_rows_expected);
+        break;
+      case CsvType::STRING:
+        column_.strings.reserve(fragment.n_rows_expected);
+        break;
+      }
+    }
+    std::vector<bool> as_strings_(n_columns_, false);
+    std::string scratch_;
+    scan_fields_(
+        data_, fragment.begin, fragment.end, delimiter_,
+        [&](std::size_t c, const char *text, std::size_t size, bool quoted) {
+          if (c >= n_columns_ || as_strings_[c]) {
+            return;
+          }
+          if (quoted) {
+            unquote_(text, size, scratch_);
+            text = scratch_.data();
+            size = scratch_.size();
+          }
+          if (!add_(fragment.columns[c], c, text, size)) {
+            as_strings_[c] = true;
+          }
+        },
+        [&](std::size_t n_fields, std::size_t position) {
+          if (n_fields != n_columns_) {
+            throw csv_error("Row at byte " + std::to_string(position) +
+                            " has " + std::to_string(n_fields) +
+                            " fields, expected " +
+                            std::to_string(n_columns_));
+          }
+          ++fragment.n_rows;
+        });
+
+    // Columns which met a value that is not a number are read again
+    for (std::size_t c = 0; c < n_columns_; ++c) {
+      if (as_strings_[c]) {
+        parse_strings(fragment, c);
+      }
+    }
+  }
+
+  /**
+   * @brief Parse one column of a fragment as strings
+   */
+  void parse_strings(Fragment &fragment, std::size_t column) const {
+    CsvTable::Column &strings_ = fragment.columns[column];
+    strings_ = CsvTable::Column();
+    strings_.type = CsvType::STRING;
+    strings_.strings.reserve(fragment.n_rows);
+    scan_fields_(
+        data_, fragment.begin, fragment.end, delimiter_,
+        [&](std::size_t c, const char *text, std::size_t size, bool quoted) {
+          if (c != column) {
+            return;
+          }
+          if (quoted) {
+            strings_.strings.emplace_back();
+            unquote_(text, size, strings_.strings.back());
+          } else {
+            strings_.strings.emplace_back(text, size);
+          }
+        },
+        [](std::size_t, std::size_t) {});
+  }
+
+private:
+  /**
+   * @brief Add a value to a column
+   *
+   * @return false if the column is inferred, holds numbers and must be read
+   * again as strings
+   */
+  bool add_(CsvTable::Column &column, std::size_t c, const char *text,
+            std::size_t size) const {
+    switch (column.type) {
+    case CsvType::STRING:
+      column.strings.emplace_back(text, size);
+      return true;
+    case CsvType::INT64: {
+      std::int64_t value_ = 0;
+      if (size > 0 && parse_int64_(text, size, value_)) {
+        column.int64s.push_back(value_);
+        return true;
+      }
+      double float_ = std::numeric_limits<double>::quiet_NaN();
+      if (size > 0 && !parse_float64_(text, size, float_)) {
+        return reject_(column, c, text, size);
+      }
+      if (forced_[c]) {
+        throw csv_error("Value '" + std::string(text, size) +
+                        "' in int64 column " + names_[c] +
+                        " is not an integer");
+      }
+      promote_to_float64_(column);
+      column.float64s.push_back(float_);
+      return true;
+    }
+    case CsvType::FLOAT64: {
+      double value_ = std::numeric_limits<double>::quiet_NaN();
+      if (size > 0 && !parse_float64_(text, size, value_)) {
+        return reject_(column, c, text, size);
+      }
+      column.float64s.push_back(value_);
+      return true;
+    }
+    }
+    return true;
+  }
+
+  bool reject_(CsvTable::Column &column, std::size_t c, const char *text,
+               std::size_t size) const {
+    if (forced_[c]) {
+      throw csv_error("Value '" + std::string(text, size) + "' in " +
+                      to_string(types_[c]) + " column " + names_[c] +
+                      " is not a number");
+    }
+    if (!column.int64s.empty() || !column.float64s.empty()) {
+      return false;
+    }
+    // Nothing to convert, the column continues as strings
+    column.type = CsvType::STRING;
+    column.strings.emplace_back(text, size);
+    return true;
+  }
+
+  const char *data_;
+  char delimiter_;
+  const std::vector<std::string> &names_;
+  const std::vector<CsvType> &types_;
+  const std::vector<bool> &forced_;
+};
+
+/**
+ * @brief Append the shortest decimal m / 10^d which reads back as value
+ *
+ * With m < 2^53 and d <= 22 both are exact doubles, and the correctly
+ * rounded quotient is what a reader of the decimal gets.
+ *
+ * @return false if value needs more digits or a large exponent
+ */
+bool append_decimal_(std::string &buffer, double value) {
+  static const double powers_[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                                    1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                                    1e18, 1e19, 1e20, 1e21, 1e22};
+  const double limit_ = 9007199254740992.0;
+  const double magnitude_ = std::fabs(value);
+  if (!(magnitude_ < limit_) || (magnitude_ != 0.0 && magnitude_ < 1e-5)) {
+    return false;
+  }
+  for (int d = 0; d <= 22; ++d) {
+    const double scaled_ = std::floor(magnitude_ * powers_[d] + 0.5);
+    if (scaled_ >= limit_) {
+      return false;
+    }
+    if (scaled_ / powers_[d] != magnitude_) {
+      continue;
+    }
+    char digits_[48];
+    char *end_ = digits_ + sizeof(digits_);
+    char *it_ = end_;
+    std::uint64_t mantissa_ = static_cast<std::uint64_t>(scaled_);
+    // Fraction digits, or a zero, then the point and the integer part
+    if (d == 0) {
+      *--it_ = '0';
+    }
+    for (int i = 0; i < d; ++i) {
+      *--it_ = static_cast<char>('0' + mantissa_ % 10);
+      mantissa_ /= 10;
+    }
+    *--it_ = '.';
+    do {
+      *--it_ = static_cast<char>('0' + mantissa_ % 10);
+      mantissa_ /= 10;
+    } while (mantissa_ > 0);
+    if (std::signbit(value)) {
+      *--it_ = '-';
+    }
+    buffer.append(it_, end_);
+    return true;
+  }
+  return false;
+}
+
+void append_integer_(std::string &buffer, std::uint64_t magnitude,
+                     bool negative) {
+  char digits_[24];
+  char *end_ = digits_ + sizeof(digits_);
+  char *it_ = end_;
+  do {
+    *--it_ = static_cast<char>('0' + magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude);
+  if (negative) {
+    *--it_ = '-';
+  }
+  buffer.append(it_, end_);
+}
+
+void append_integer_(std::string &buffer, std::int64_t value) {
+  append_integer_(buffer,
+                  value < 0 ? 0 - static_cast<std::uint64_t>(value)
+                            : static_cast<std::uint64_t>(value),
+                  value < 0);
+}
+} // namespace
+
+std::string to_string(CsvType type) {
+  switch (type) {
+  case CsvType::INT64:
+    return "int64";
+  case CsvType::FLOAT64:
+    return "float64";
+  case CsvType::STRING:
+    return "string";
+  }
+  return "unknown";
+}
+
+CsvTable::sptr CsvTable::read(const ghc::filesystem::path &file_path,
+                              const CsvOptions &options) {
+  const char delimiter_ = options.delimiter;
+  if (delimiter_ == '"' || delimiter_ == '\n' || delimiter_ == '\r') {
+    throw csv_error("Invalid CSV delimiter");
+  }
+  if (!ghc::filesystem::exists(file_path)) {
+    throw csv_error("File '" + file_path.string() +
+                    "' could not be opened as it does not exist");
+  }
+  const FileText text_(file_path);
+  const char *data_ = text_.data();
+  const std::size_t size_ = text_.size();
+
+  // Skip a UTF-8 byte order mark and leading empty lines
+  std::size_t begin_ = 0;
+  if (size_ >= 3 && std::memcmp(data_, "\xEF\xBB\xBF", 3) == 0) {
+    begin_ = 3;
+  }
+  while (begin_ < size_ && (data_[begin_] == '\n' || data_[begin_] == '\r')) {
+    ++begin_;
+  }
+
+  sptr table_(new CsvTable());
+  const std::size_t first_row_end_ =
+      find_row_end_(data_, begin_, size_, false);
+  std::vector<std::string> first_row_;
+  scan_fields_(
+      data_, begin_, first_row_end_, delimiter_,
+      [&](std::size_t, const char *text, std::size_t size, bool quoted) {
+        first_row_.emplace_back();
+        if (quoted) {
+          unquote_(text, size, first_row_.back());
+        } else {
+          first_row_.back().assign(text, size);
+        }
+      },
+      [](std::size_t, std::size_t) {});
+  if (options.header) {
+    table_->names_ = first_row_;
+    begin_ = first_row_end_;
+  } else {
+    for (std::size_t c = 0; c < first_row_.size(); ++c) {
+      table_->names_.push_back("column_" + std::to_string(c + 1));
+    }
+  }
+  const std::size_t n_columns_ = table_->names_.size();
+
+  std::vector<CsvType> types_(n_columns_, CsvType::INT64);
+  std::vector<bool> forced_(n_columns_, false);
+  for (const auto &type_ : options.column_types) {
+    const std::size_t c = table_->column_index(type_.first);
+    types_[c] = type_.second;
+    forced_[c] = true;
+  }
+
+  // Rows end at newlines outside quotes: the parity of the quotes before a
+  // chunk tells whether it starts inside a quoted field
+  const std::size_t n_chunks_ =
+      std::max<std::size_t>(1, (size_ - begin_ + chunk_bytes_ - 1) /
+                                   chunk_bytes_);
+  const unsigned int n_threads_ =
+      resolve_thread_count(options.n_threads, n_chunks_);
+  std::vector<std::uint64_t> quotes_(n_chunks_, 0);
+  std::vector<Fragment> fragments_(n_chunks_);
+  parallel_for(n_chunks_, n_threads_, [&](std::size_t i) {
+    std::uint64_t n_newlines_ = 0;
+    count_structure_(data_, begin_ + i * chunk_bytes_,
+                     std::min(size_, begin_ + (i + 1) * chunk_bytes_),
+                     quotes_[i], n_newlines_);
+    fragments_[i].n_rows_expected = static_cast<std::size_t>(n_newlines_) + 1;
+  });
+  std::vector<bool> in_quotes_(n_chunks_, false);
+  for (std::size_t i = 1; i < n_chunks_; ++i) {
+    in_quotes_[i] = in_quotes_[i - 1] != (quotes_[i - 1] % 2 == 1);
+  }
+  parallel_for(n_chunks_, n_threads_, [&](std::size_t i) {
+    fragments_[i].begin =
+        i == 0 ? begin_
+               : find_row_end_(data_, begin_ + i * chunk_bytes_, size_,
+                               in_quotes_[i]);
+  });
+  for (std::size_t i = 0; i < n_chunks_; ++i) {
+    if (i > 0) {
+      fragments_[i].begin =
+          std::max(fragments_[i].begin, fragments_[i - 1].begin);
+    }
+    fragments_[i].end = i + 1 < n_chunks_ ? 0 : size_;
+    if (i > 0) {
+      fragments_[i - 1].end = fragments_[i].begin;
+    }
+  }
+
+  const ChunkParser parser_(data_, delimiter_, table_->names_, types_,
+                            forced_);
+  parallel_for(n_chunks_, n_threads_,
+               [&](std::size_t i) { parser_.parse(fragments_[i]); });
+
+  // Every fragment takes the widest type of its column
+  for (std::size_t c = 0; c < n_columns_; ++c) {
+    for (const Fragment &fragment_ : fragments_) {
+      types_[c] = std::max(types_[c], fragment_.columns[c].type);
+    }
+  }
+  parallel_for(n_chunks_, n_threads_, [&](std::size_t i) {
+    Fragment &fragment_ = fragments_[i];
+    for (std::size_t c = 0; c < n_columns_; ++c) {
+      CsvTable::Column &column_ = fragment_.columns[c];
+      if (column_.type == types_[c]) {
+        continue;
+      }
+      if (types_[c] == CsvType::STRING) {
+        parser_.parse_strings(fragment_, c);
+      } else {
+        promote_to_float64_(column_);
+      }
+    }
+  });
+
+  for (const Fragment &fragment_ : fragments_) {
+    table_->n_rows_ += fragment_.n_rows;
+  }
+  table_->columns_.resize(n_columns_);
+  parallel_for(n_columns_, n_threads_, [&](std::size_t c) {
+    CsvTable::Column &column_ = table_->columns_[c];
+    column_.type = types_[c];
+    switch (column_.type) {
+    case CsvType::INT64:
+      column_.int64s.reserve(table_->n_rows_);
+      break;
+    case CsvType::FLOAT64:
+      column_.float64s.reserve(table_->n_rows_);
+      break;
+    case CsvType::STRING:
+      column_.strings.reserve(table_->n_rows_);
+      break;
+    }
+    for (Fragment &fragment_ : fragments_) {
+      CsvTable::Column &part_ = fragment_.columns[c];
+      column_.int64s.insert(column_.int64s.end(), part_.int64s.begin(),
+                            part_.int64s.end());
+      column_.float64s.insert(column_.float64s.end(), part_.float64s.begin(),
+                              part_.float64s.end());
+      std::move(part_.strings.begin(), part_.strings.end(),
+                std::back_inserter(column_.strings));
+      part_ = CsvTable::Column();
+    }
+  });
+
+  logger::get_logger()->debug()
+      << "CsvTable: Read " << table_->n_rows_ << " rows of " << n_columns_
+      << " columns from '" << file_path.string() << "'";
+  return table_;
+}
+
+std::size_t CsvTable::column_index(const std::string &name) const {
+  const auto it = std::find(names_.begin(), names_.end(), name);
+  if (it == names_.end()) {
+    throw csv_error("Table has no column " + name);
+  }
+  return static_cast<std::size_t>(it - names_.begin());
+}
+
+CsvType CsvTable::get_type(std::size_t column) const {
+  if (column >= columns_.size()) {
+    throw csv_error("Table has no column " + std::to_string(column));
+  }
+  return columns_[column].type;
+}
+
+const CsvTable::Column &CsvTable::column_(std::size_t column,
+                                          CsvType type) const {
+  if (get_type(column) != type) {
+    throw csv_error("Column " + names_[column] + " is " +
+                    to_string(columns_[column].type) + ", not " +
+                    to_string(type));
+  }
+  return columns_[column];
+}
+
+const std::vector<std::int64_t> &
+CsvTable::get_int64(std::size_t column) const {
+  return column_(column, CsvType::INT64).int64s;
+}
+
+const std::vector<double> &CsvTable::get_float64(std::size_t column) const {
+  return column_(column, CsvType::FLOAT64).float64s;
+}
+
+const std::vector<std::string> &
+CsvTable::get_strings(std::size_t column) const {
+  return column_(column, CsvType::STRING).strings;
+}
+
+std::vector<double> CsvTable::as_float64(std::size_t column) const {
+  if (get_type(column) == CsvType::FLOAT64) {
+    return columns_[column].float64s;
+  }
+  const std::vector<std::int64_t> &int64s_ = get_int64(column);
+  return std::vector<double>(int64s_.begin(), int64s_.end());
+}
+
+CsvWriter::CsvWriter(const ghc::filesystem::path &file_path,
+                     const std::vector<std::string> &column_names,
+                     char delimiter)
+    : file_path_(file_path),
+      tmp_path_(file_path.string() + ".tmp-" + generate_random_hash()),
+      n_columns_(column_names.size()), delimiter_(delimiter) {
+  if (delimiter_ == '"' || delimiter_ == '\n' || delimiter_ == '\r') {
+    throw csv_error("Invalid CSV delimiter");
+  }
+  out_.reset(new std::ofstream(tmp_path_.string(),
+                               std::ios_base::out | std::ios_base::binary));
+  if (!*out_) {
+    throw csv_error("Cannot write CSV file '" + file_path_.string() + "'");
+  }
+  buffer_.reserve(flush_bytes_ + 4096);
+  for (const std::string &name_ : column_names) {
+    field(name_);
+  }
+  if (n_columns_ > 0) {
+    end_line_();
+    n_fields_ = 0;
+    row_start_ = buffer_.size();
+  }
+}
+
+CsvWriter::sptr
+CsvWriter::construct(const ghc::filesystem::path &file_path,
+                     const std::vector<std::string> &column_names,
+                     char delimiter) {
+  return sptr(new CsvWriter(file_path, column_names, delimiter));
+}
+
+CsvWriter::~CsvWriter() {
+  if (closed_) {
+    return;
+  }
+  try {
+    close();
+  } catch (const std::exception &e) {
+    logger::get_logger()->error()
+        << "CsvWriter: Failed to write '" << file_path_.string()
+        << "': " << e.what();
+  }
+}
+
+void CsvWriter::separator_() {
+  if (closed_) {
+    throw csv_error("CSV file '" + file_path_.string() + "' is closed");
+  }
+  if (n_fields_++ > 0) {
+    buffer_.push_back(delimiter_);
+  }
+}
+
+CsvWriter &CsvWriter::field(double value) {
+  separator_();
+  if (std::isnan(value)) {
+    return *this;
+  }
+  if (std::isinf(value)) {
+    buffer_ += value < 0 ? "-inf" : "inf";
+    return *this;
+  }
+  if (append_decimal_(buffer_, value)) {
+    return *this;
+  }
+  // Any value with a round trip form of at most 15 significant digits is
+  // printed that way by %.15g, which drops trailing zeros. Otherwise the
+  // correctly rounded 16 digits read back exactly if any 16 digits do, and
+  // 17 always do, so the first precision which reads back is the shortest
+  char digits_[32];
+  int size_ = 0;
+  for (int precision_ = 15; precision_ <= 17; ++precision_) {
+    size_ = std::snprintf(digits_, sizeof(digits_), "%.*g", precision_, value);
+    if (std::strtod(digits_, nullptr) == value) {
+      break;
+    }
+  }
+  buffer_.append(digits_, static_cast<std::size_t>(size_));
+  // Keep a decimal point so the column reads back as float64
+  if (std::strpbrk(digits_, ".e") == nullptr) {
+    buffer_ += ".0";
+  }
+  return *this;
+}
+
+CsvWriter &CsvWriter::integer_field_(std::int64_t value) {
+  separator_();
+  append_integer_(buffer_, value);
+  return *this;
+}
+
+CsvWriter &CsvWriter::unsigned_field_(std::uint64_t value) {
+  separator_();
+  append_integer_(buffer_, value, false);
+  return *this;
+}
+
+CsvWriter &CsvWriter::field(const std::string &value) {
+  return string_field_(value.data(), value.size());
+}
+
+CsvWriter &CsvWriter::string_field_(const char *text, std::size_t size) {
+  separator_();
+  const char *end_ = text + size;
+  const bool quote_ = std::find_if(text, end_, [&](char c) {
+                        return c == '"' || c == '\n' || c == '\r' ||
+                               c == delimiter_;
+                      }) != end_;
+  if (!quote_) {
+    buffer_.append(text, size);
+    return *this;
+  }
+  buffer_.push_back('"');
+  for (const char *it_ = text; it_ != end_; ++it_) {
+    if (*it_ == '"') {
+      buffer_.push_back('"');
+    }
+    buffer_.push_back(*it_);
+  }
+  buffer_.push_back('"');
+  return *this;
+}
+
+CsvWriter &CsvWriter::end_row() {
+  if (n_columns_ > 0 && n_fields_ != n_columns_) {
+    const std::size_t n_fields_written_ = n_fields_;
+    buffer_.resize(row_start_);
+    n_fields_ = 0;
+    throw csv_error("Row has " + std::to_string(n_fields_written_) +
+                    " fields, expected " + std::to_string(n_columns_));
+  }
+  end_line_();
+  n_fields_ = 0;
+  ++n_rows_;
+  if (buffer_.size() >= flush_bytes_) {
+    flush_();
+  }
+  row_start_ = buffer_.size();
+  return *this;
+}
+
+void CsvWriter::write_table(const CsvTable &table) {
+  const std::size_t n_columns_table_ = table.n_columns();
+  if (n_columns_ > 0 && n_columns_table_ != n_columns_) {
+    throw csv_error("Table has " + std::to_string(n_columns_table_) +
+                    " columns, expected " + std::to_string(n_columns_));
+  }
+  std::vector<const std::vector<std::int64_t> *> int64s_(n_columns_table_);
+  std::vector<const std::vector<double> *> float64s_(n_columns_table_);
+  std::vector<const std::vector<std::string> *> strings_(n_columns_table_);
+  for (std::size_t c = 0; c < n_columns_table_; ++c) {
+    switch (table.get_type(c)) {
+    case CsvType::INT64:
+      int64s_[c] = &table.get_int64(c);
+      break;
+    case CsvType::FLOAT64:
+      float64s_[c] = &table.get_float64(c);
+      break;
+    case CsvType::STRING:
+      strings_[c] = &table.get_strings(c);
+      break;
+    }
+  }
+  for (std::size_t row_ = 0; row_ < table.n_rows(); ++row_) {
+    for (std::size_t c = 0; c < n_columns_table_; ++c) {
+      if (int64s_[c]) {
+        integer_field_((*int64s_[c])[row_]);
+      } else if (float64s_[c]) {
+        field((*float64s_[c])[row_]);
+      } else {
+        field((*strings_[c])[row_]);
+      }
+    }
+    end_row();
+  }
+}
+
+void CsvWriter::end_line_() {
+  // A row of one empty field would be an empty line, which is skipped
+  if (n_fields_ == 1 && buffer_.size() == row_start_) {
+    buffer_ += "\"\"";
+  }
+  buffer_.push_back('\n');
+}
+
+void CsvWriter::flush_() {
+  out_->write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+  hasher_.absorb(buffer_.data(), buffer_.size());
+  buffer_.clear();
+}
+
+std::string CsvWriter::close() {
+  if (closed_) {
+    return hash_;
+  }
+  try {
+    if (n_fields_ > 0) {
+      end_row();
+    }
+    flush_();
+    out_->close();
+    if (!*out_) {
+      throw csv_error("Failed writing CSV file '" + file_path_.string() +
+                      "'");
+    }
+    std::error_code ec_;
+    ghc::filesystem::rename(tmp_path_, file_path_, ec_);
+    if (ec_) {
+      throw csv_error("Cannot move CSV file to '" + file_path_.string() +
+                      "': " + ec_.message());
+    }
+  } catch (...) {
+    closed_ = true;
+    std::error_code ec_;
+    ghc::filesystem::remove(tmp_path_, ec_);
+    throw;
+  }
+  closed_ = true;
+  hash_ = hasher_.hexdigest();
+  HashCache::key_type key_;
+  if (HashCache::get_key(file_path_, key_)) {
+    HashCache::get_cache()->store(file_path_, "sha1", key_, hash_);
+  }
+  logger::get_logger()->debug()
+      << "CsvWriter: Wrote " << n_rows_ << " rows to '" << file_path_.string()
+      << "'";
+  return hash_;
+}
+
+}; // namespace FairDataPipeline
@@ -1,111 +1,134 @@
 #include "fdp/utilities/data_io.hxx"
 
+#include "fdp/objects/shared_parameter_cache.hxx"
+#include "fdp/utilities/toml_document.hxx"
+
 namespace FairDataPipeline {
 
+namespace {
+/**
+ * @brief Read a point estimate from the node-local shared cache
+ *
+ * @return true the value was found, false if the caller must read the TOML
+ */
+bool cached_point_estimate_(const ParameterStore::sptr &store,
+                            const std::string &component, double &value) {
+  if (!store) {
+    return false;
+  }
+  const ParameterStore::Record *record_ =
+      store->find(component.data(), component.size());
+  if (!record_ || record_->type != static_cast<std::uint32_t>(
+                                       ParameterStore::Type::POINT_ESTIMATE)) {
+    return false;
+  }
+  value = record_->value;
+  return true;
+}
+} // namespace
+
 double read_point_estimate_from_toml(const ghc::filesystem::path file_path, const std::string &component) {
-  toml::value value = read_parameter_from_toml(file_path, "point-estimate", component);
-  return (value.is_floating())
-             ? value.as_floating()
-             : static_cast<double>(
-                   value.as_integer());
+  double value_ = 0.0;
+  if (cached_point_estimate_(SharedParameterCache::open_shared(file_path),
+                             component, value_)) {
+    return value_;
+  }
+  return TomlDocument::open(file_path)->point_estimate(component);
+}
+
+std::vector<double> read_point_estimates_from_toml(
+    const ghc::filesystem::path file_path,
+    const std::vector<std::string> &components) {
+  const ParameterStore::sptr store_ =
+      SharedParameterCache::open_shared(file_path);
+  if (store_) {
+    std::vector<double> values_(components.size());
+    bool complete_ = true;
+    for (std::size_t i = 0; complete_ && i < components.size(); ++i) {
+      complete_ = cached_point_estimate_(store_, components[i], values_[i]);
+    }
+    if (complete_) {
+      return values_;
+    }
+  }
+
+  const TomlDocument::sptr document_ = TomlDocument::open(file_path);
+  std::vector<double> values_;
+  values_.reserve(components.size());
+  for (const std::string &component_ : components) {
+    values_.push_back(document_->point_estimate(component_));
+  }
+  return values_;
+}
+
+ghc::filesystem::path write_point_estimates(
+    const std::vector<std::string> &components,
+    const std::vector<double> &values, const ghc::filesystem::path file_path) {
+  if (components.size() != values.size()) {
+    throw toml_error("Expected one value per component");
+  }
+  std::vector<toml::value> data_;
+  data_.reserve(components.size());
+  for (std::size_t i = 0; i < components.size(); ++i) {
+    const toml::value component_data_{
+        {components[i], {{"type", "point-estimate"}, {"value", values[i]}}}};
+    data_.push_back(component_data_);
+  }
+  return write_toml_data(file_path, components, data_);
 }
 
 double read_point_estimate_from_toml(const ghc::filesystem::path file_path) {
-  return read_point_estimate_from_toml(file_path, get_first_component(file_path));
+  const TomlDocument::sptr document_ = TomlDocument::open(file_path);
+  return document_->point_estimate(document_->first_component());
 }
 
 toml::value read_parameter_from_toml(const ghc::filesystem::path file_path, const std::string &parameter) {
-  return read_parameter_from_toml(file_path, parameter, get_first_component(file_path));
+  const TomlDocument::sptr document_ = TomlDocument::open(file_path);
+  return document_->parameter(parameter, document_->first_component());
 }
 
 toml::value read_data_from_toml(const ghc::filesystem::path file_path){
-  if (!ghc::filesystem::exists(file_path)) {
-      throw toml_error("File '" + file_path.string() +
-                              "' could not be opened as it does not exist");
-    }
-  if (ghc::filesystem::is_empty(file_path)) {
-    throw toml_error("File '" + file_path.string() +
-                             "' appears to be empty");
-  }
-
-  auto toml_data_ = toml::parse(file_path.string());
-  return toml_data_;
-
+  return TomlDocument::open(file_path)->get_data();
 }
 
 toml::value read_component_from_toml(const ghc::filesystem::path file_path, const std::string &component){
-  toml::value component_ = read_data_from_toml(file_path.string()).at(component);
-  return component_;
+  return TomlDocument::open(file_path)->component(component);
 }
 
-
 toml::value read_parameter_from_toml(const ghc::filesystem::path file_path, const std::string &parameter, const std::string &component) {
- 
-  toml::value toml_data_ = read_data_from_toml(file_path);
-
-  if(!component_exists(file_path, component)){
-    throw toml_error("Component " + component + "does not exist");
-  }
-
-  if (!toml_data_.at(component).contains("type")) {
-    throw toml_error("Expected 'type' tag but none found");
-  }
-
-  if (static_cast<std::string>(
-          toml_data_.at(component).at("type").as_string()) !=
-      parameter) {
-    throw toml_error(
-        "Expected "+ parameter +" for type but got '" +
-        static_cast<std::string>(toml_data_.at(component).at("type").as_string()) + "'");
-  }
-
-  return toml_data_.at(component).at("value");
-
+  return TomlDocument::open(file_path)->parameter(parameter, component);
 }
 
 ghc::filesystem::path write_toml_data(ghc::filesystem::path file_path, 
                                       const std::string &component,
                                       const toml::value &data){
-  auto the_logger = logger::get_logger();
-
-  if(component_exists(file_path, component)){
-    throw toml_error("Component " + component + " already exists in " + file_path.string());
-  }
-
-  std::ofstream toml_out_;
+  TomlWriter::sptr writer_ = TomlWriter::construct(file_path);
+  writer_->add(component, data);
+  return writer_->flush();
+}
 
-  if (!ghc::filesystem::exists(file_path.parent_path())) {
-    ghc::filesystem::create_directories(file_path.parent_path());
+ghc::filesystem::path write_toml_data(ghc::filesystem::path file_path,
+                                      const std::vector<std::string> &components,
+                                      const std::vector<toml::value> &data) {
+  if (components.size() != data.size()) {
+    throw toml_error("Expected one data table per component");
   }
 
-  toml_out_.open(file_path.string(), std::ios_base::app);
-
-  if (!toml_out_) {
-    throw toml_error("Failed to open TOML file for writing");
+  TomlWriter::sptr writer_ = TomlWriter::construct(file_path);
+  try {
+    for (std::size_t i = 0; i < components.size(); ++i) {
+      writer_->add(components[i], data[i]);
+    }
+  } catch (...) {
+    // Nothing is written if any component is a duplicate
+    writer_->discard();
+    throw;
   }
-
-  toml_out_ << data;
-
-  toml_out_.close();
-
-  the_logger->debug() 
-      <<  "FileSystem:WriteToml: Wrote " << data << " to '" << file_path.string() << "'";
-
-  return file_path;
+  return writer_->flush();
 }
 
 std::string get_first_component(const ghc::filesystem::path &file_path){
-  if (!ghc::filesystem::exists(file_path)) {
-    throw toml_error("File '" + file_path.string() +
-                             "' could not be opened as it does not exist");
-  }
-  if (ghc::filesystem::is_empty(file_path)) {
-    throw toml_error("File '" + file_path.string() +
-                             "' appears to be empty");
-  }
-  const auto toml_data_ = toml::parse(file_path.string());
-
-  return toml_data_.as_table().begin()->first;
+  return TomlDocument::open(file_path)->first_component();
 }
 
 bool component_exists(const ghc::filesystem::path &file_path, const std::string &component){
@@ -113,19 +136,7 @@ bool component_exists(const ghc::filesystem::path &file_path, const std::string
   {
     return false;
   }
-  if (ghc::filesystem::is_empty(file_path)) {
-    throw toml_error("File '" + file_path.string() +
-                             "' appears to be empty");
-  }
-  const auto toml_data_ = toml::parse(file_path.string());
-  if(!toml_data_.contains(component)){
-    return false;
-  }
-  else{
-    const auto& table = toml::find(toml_data_, component);
-    return table.is_table();
-  }
-  
+  return TomlDocument::open(file_path)->has_component(component);
 }
 
 }; // namespace FairDataPipeline
@@ -0,0 +1,157 @@
+#include "fdp/utilities/data_store.hxx"
+
+#include <system_error>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+#include "fdp/exceptions.hxx"
+#include "fdp/objects/metadata.hxx"
+#include "fdp/utilities/logging.hxx"
+
+namespace FairDataPipeline {
+
+namespace {
+/**
+ * @brief Clone a file's extents into a new file (Btrfs, XFS, bcachefs...)
+ */
+bool reflink_(const ghc::filesystem::path &source,
+              const ghc::filesystem::path &target) {
+#if defined(__linux__) && defined(FICLONE)
+  const int src_fd_ = ::open(source.string().c_str(), O_RDONLY);
+  if (src_fd_ < 0) {
+    return false;
+  }
+  const int dst_fd_ =
+      ::open(target.string().c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+  if (dst_fd_ < 0) {
+    ::close(src_fd_);
+    return false;
+  }
+  const bool cloned_ = ::ioctl(dst_fd_, FICLONE, src_fd_) == 0;
+  ::close(dst_fd_);
+  ::close(src_fd_);
+  if (!cloned_) {
+    ::unlink(target.string().c_str());
+  }
+  return cloned_;
+#else
+  (void)source;
+  (void)target;
+  return false;
+#endif
+}
+
+/**
+ * @brief Copy a file via a temporary name so target never appears partial
+ */
+void copy_atomically_(const ghc::filesystem::path &source,
+                      const ghc::filesystem::path &target) {
+  const ghc::filesystem::path tmp_(target.string() + ".tmp-" +
+                                   generate_random_hash());
+  ghc::filesystem::copy_file(source, tmp_);
+  ghc::filesystem::rename(tmp_, target);
+}
+} // namespace
+
+DataStore::DataStore(const ghc::filesystem::path &root)
+    : blob_root_(root / ".fdp" / "blobs") {}
+
+DataStore::sptr DataStore::construct(const ghc::filesystem::path &root) {
+  return sptr(new DataStore(root));
+}
+
+ghc::filesystem::path DataStore::blob_path(const std::string &hash,
+                                           const std::string &extension) const {
+  // Fan out on the first two characters to keep directories small
+  const std::string prefix_ = hash.size() > 2 ? hash.substr(0, 2) : hash;
+  return blob_root_ / prefix_ / (hash + extension);
+}
+
+ghc::filesystem::path DataStore::store(const ghc::filesystem::path &source,
+                                       const std::string &hash,
+                                       const std::string &extension) {
+  const ghc::filesystem::path blob_ = blob_path(hash, extension);
+
+  if (ghc::filesystem::exists(blob_)) {
+    logger::get_logger()->debug()
+        << "DataStore: Content of '" << source.string()
+        << "' already stored as '" << blob_.string() << "'";
+    ghc::filesystem::remove(source);
+    return blob_;
+  }
+
+  ghc::filesystem::create_directories(blob_.parent_path());
+
+  std::error_code ec_;
+  ghc::filesystem::rename(source, blob_, ec_);
+  if (ec_) {
+    // Most likely a cross-device move, copy then remove the original
+    logger::get_logger()->debug()
+        << "DataStore: Rename of '" << source.string()
+        << "' failed (" << ec_.message() << "), copying instead";
+    copy_atomically_(source, blob_);
+    ghc::filesystem::remove(source);
+  }
+
+  return blob_;
+}
+
+DataStore::LinkType DataStore::link(const ghc::filesystem::path &blob,
+                                    const ghc::filesystem::path &target) {
+  if (ghc::filesystem::exists(target)) {
+    if (calculate_hash_from_file(target) == calculate_hash_from_file(blob)) {
+      return LinkType::EXISTING;
+    }
+    ghc::filesystem::remove(target);
+  }
+
+  ghc::filesystem::create_directories(target.parent_path());
+
+  if (reflink_(blob, target)) {
+    return LinkType::REFLINK;
+  }
+
+  std::error_code ec_;
+  ghc::filesystem::create_hard_link(blob, target, ec_);
+  if (!ec_) {
+    return LinkType::HARDLINK;
+  }
+
+  copy_atomically_(blob, target);
+  return LinkType::COPY;
+}
+
+DataStore::LinkType DataStore::commit(const ghc::filesystem::path &source,
+                                      const std::string &hash,
+                                      const ghc::filesystem::path &target) {
+  const ghc::filesystem::path blob_ =
+      store(source, hash, target.extension().string());
+  const LinkType link_type_ = link(blob_, target);
+
+  logger::get_logger()->debug()
+      << "DataStore: Linked '" << target.string() << "' to '"
+      << blob_.string() << "' via " << to_string(link_type_);
+
+  return link_type_;
+}
+
+std::string to_string(DataStore::LinkType link_type) {
+  switch (link_type) {
+  case DataStore::LinkType::REFLINK:
+    return "reflink";
+  case DataStore::LinkType::HARDLINK:
+    return "hardlink";
+  case DataStore::LinkType::COPY:
+    return "copy";
+  case DataStore::LinkType::EXISTING:
+    return "existing";
+  }
+  return "unknown";
+}
+
+}; // namespace FairDataPipeline
@@ -0,0 +1,337 @@
+#include "fdp/utilities/hash_cache.hxx"
+
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#if defined(__linux__)
+#include <sys/xattr.h>
+#define FDP_HAVE_XATTR 1
+#elif defined(__APPLE__)
+#include <sys/xattr.h>
+#define FDP_HAVE_XATTR 1
+#endif
+
+#include "fdp/utilities/hashing.hxx"
+#include "fdp/utilities/logging.hxx"
+
+namespace FairDataPipeline {
+
+namespace {
+std::string format_entry_(const HashCache::key_type &key,
+                          const std::string &hash) {
+  std::ostringstream oss;
+  oss << key.device << " " << key.inode << " " << key.size << " "
+      << key.mtime_ns << " " << hash;
+  return oss.str();
+}
+
+bool parse_entry_(const std::string &entry, HashCache::key_type &key,
+                  std::string &hash) {
+  std::istringstream iss(entry);
+  return static_cast<bool>(iss >> key.device >> key.inode >> key.size >>
+                           key.mtime_ns >> hash);
+}
+
+#ifdef FDP_HAVE_XATTR
+std::string xattr_name_(const std::string &algorithm) {
+  return "user.fdp." + algorithm;
+}
+
+bool read_xattr_(const ghc::filesystem::path &file_path,
+                 const std::string &algorithm, std::string &value) {
+  char buffer_[256];
+#if defined(__APPLE__)
+  ssize_t len_ = getxattr(file_path.string().c_str(),
+                          xattr_name_(algorithm).c_str(), buffer_,
+                          sizeof(buffer_), 0, 0);
+#else
+  ssize_t len_ = getxattr(file_path.string().c_str(),
+                          xattr_name_(algorithm).c_str(), buffer_,
+                          sizeof(buffer_));
+#endif
+  if (len_ <= 0) {
+    return false;
+  }
+  value.assign(buffer_, static_cast<std::size_t>(len_));
+  return true;
+}
+
+bool write_xattr_(const ghc::filesystem::path &file_path,
+                  const std::string &algorithm, const std::string &value) {
+#if defined(__APPLE__)
+  return setxattr(file_path.string().c_str(), xattr_name_(algorithm).c_str(),
+                  value.c_str(), value.size(), 0, 0) == 0;
+#else
+  return setxattr(file_path.string().c_str(), xattr_name_(algorithm).c_str(),
+                  value.c_str(), value.size(), 0) == 0;
+#endif
+}
+#endif
+} // namespace
+
+bool HashCache::strict_from_environment(bool &strict) {
+  const char *setting_ = std::getenv("FDP_STRICT_HASH");
+  if (!setting_) {
+    return false;
+  }
+  const std::string value_(setting_);
+  strict = !(value_.empty() || value_ == "0" || value_ == "false");
+  return true;
+}
+
+bool HashCache::key_type::operator<(const key_type &rhs) const {
+  if (device != rhs.device)
+    return device < rhs.device;
+  if (inode != rhs.inode)
+    return inode < rhs.inode;
+  if (size != rhs.size)
+    return size < rhs.size;
+  return mtime_ns < rhs.mtime_ns;
+}
+
+bool HashCache::key_type::operator==(const key_type &rhs) const {
+  return device == rhs.device && inode == rhs.inode && size == rhs.size &&
+         mtime_ns == rhs.mtime_ns;
+}
+
+HashCache::HashCache() { strict_from_environment(strict_); }
+
+HashCache::sptr HashCache::construct() { return sptr(new HashCache()); }
+
+HashCache::sptr HashCache::construct(const ghc::filesystem::path &database_path) {
+  sptr pobj = sptr(new HashCache());
+  pobj->database_path_ = database_path;
+  return pobj;
+}
+
+HashCache::~HashCache() {
+  // The logger may already have been destroyed at exit, so a failed write is
+  // dropped silently here; Config::finalise flushes (and logs) explicitly
+  try {
+    std::lock_guard<std::mutex> lock_(mutex_);
+    flush_(false);
+  } catch (...) {
+  }
+}
+
+bool HashCache::get_key(const ghc::filesystem::path &file_path,
+                        key_type &key) {
+#ifdef _WIN32
+  // No stable inode numbers are exposed through _stat on Windows
+  return false;
+#else
+  struct stat st_;
+  if (stat(file_path.string().c_str(), &st_) != 0 || !S_ISREG(st_.st_mode)) {
+    return false;
+  }
+  key.device = static_cast<std::uint64_t>(st_.st_dev);
+  key.inode = static_cast<std::uint64_t>(st_.st_ino);
+  key.size = static_cast<std::uint64_t>(st_.st_size);
+#if defined(__APPLE__)
+  key.mtime_ns = static_cast<std::int64_t>(st_.st_mtimespec.tv_sec) *
+                     1000000000LL +
+                 st_.st_mtimespec.tv_nsec;
+#else
+  key.mtime_ns = static_cast<std::int64_t>(st_.st_mtim.tv_sec) * 1000000000LL +
+                 st_.st_mtim.tv_nsec;
+#endif
+  return true;
+#endif
+}
+
+bool HashCache::lookup(const ghc::filesystem::path &file_path,
+                       const std::string &algorithm, std::string &hash) {
+  if (is_strict()) {
+    return false;
+  }
+
+  key_type key_;
+  if (!get_key(file_path, key_)) {
+    return false;
+  }
+
+#ifdef FDP_HAVE_XATTR
+  std::string xattr_value_;
+  if (read_xattr_(file_path, algorithm, xattr_value_)) {
+    key_type cached_key_;
+    std::string cached_hash_;
+    if (parse_entry_(xattr_value_, cached_key_, cached_hash_) &&
+        cached_key_ == key_) {
+      hash = cached_hash_;
+      return true;
+    }
+  }
+#endif
+
+  std::lock_guard<std::mutex> lock_(mutex_);
+  if (database_path_.empty()) {
+    return false;
+  }
+  load_();
+  auto it = entries_.find(std::make_pair(key_, algorithm));
+  if (it == entries_.end()) {
+    return false;
+  }
+  hash = it->second;
+  return true;
+}
+
+void HashCache::store(const ghc::filesystem::path &file_path,
+                      const std::string &algorithm, const key_type &key,
+                      const std::string &hash) {
+  if (is_strict()) {
+    return;
+  }
+
+#ifdef FDP_HAVE_XATTR
+  if (write_xattr_(file_path, algorithm, format_entry_(key, hash))) {
+    return;
+  }
+#endif
+
+  std::lock_guard<std::mutex> lock_(mutex_);
+  if (database_path_.empty()) {
+    return;
+  }
+  load_();
+
+  // Drop stale entries for earlier versions of the same file
+  key_type first_;
+  first_.device = key.device;
+  first_.inode = key.inode;
+  first_.mtime_ns = std::numeric_limits<std::int64_t>::min();
+  auto it = entries_.lower_bound(std::make_pair(first_, std::string()));
+  while (it != entries_.end() && it->first.first.device == key.device &&
+         it->first.first.inode == key.inode) {
+    if (it->first.second == algorithm) {
+      it = entries_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  entries_[std::make_pair(key, algorithm)] = hash;
+  dirty_ = true;
+}
+
+void HashCache::flush() {
+  std::lock_guard<std::mutex> lock_(mutex_);
+  flush_(true);
+}
+
+void HashCache::set_database_path(const ghc::filesystem::path &database_path) {
+  std::lock_guard<std::mutex> lock_(mutex_);
+  if (database_path == database_path_) {
+    return;
+  }
+  flush_(true);
+  database_path_ = database_path;
+  entries_.clear();
+  loaded_ = false;
+}
+
+ghc::filesystem::path HashCache::get_database_path() const {
+  std::lock_guard<std::mutex> lock_(mutex_);
+  return database_path_;
+}
+
+void HashCache::set_strict(bool strict) {
+  std::lock_guard<std::mutex> lock_(mutex_);
+  strict_ = strict;
+}
+
+bool HashCache::is_strict() const {
+  std::lock_guard<std::mutex> lock_(mutex_);
+  return strict_;
+}
+
+void HashCache::load_() {
+  if (loaded_) {
+    return;
+  }
+  loaded_ = true;
+
+  std::ifstream db_(database_path_.string());
+  if (!db_) {
+    return;
+  }
+
+  std::string line_;
+  while (std::getline(db_, line_)) {
+    std::istringstream iss_(line_);
+    std::string algorithm_;
+    std::string entry_;
+    if (!(iss_ >> algorithm_) || !std::getline(iss_, entry_)) {
+      continue;
+    }
+    key_type key_;
+    std::string hash_;
+    if (parse_entry_(entry_, key_, hash_)) {
+      entries_.insert(std::make_pair(std::make_pair(key_, algorithm_), hash_));
+    }
+  }
+}
+
+void HashCache::flush_(bool log_errors) {
+  if (!dirty_ || database_path_.empty()) {
+    return;
+  }
+
+  // Merge with any entries written by other processes since we loaded
+  table_type ours_;
+  ours_.swap(entries_);
+  loaded_ = false;
+  load_();
+  for (const auto &entry : ours_) {
+    entries_[entry.first] = entry.second;
+  }
+
+  // The cache is advisory, failing to persist it must not fail the run
+  try {
+    if (!database_path_.parent_path().empty()) {
+      ghc::filesystem::create_directories(database_path_.parent_path());
+    }
+
+    // Write to a uniquely named temporary file then rename so readers never
+    // see a partial db and concurrent writers never share a temporary file
+    const ghc::filesystem::path tmp_path_(database_path_.string() + ".tmp-" +
+                                          generate_random_hash());
+    {
+      std::ofstream db_(tmp_path_.string(), std::ios_base::trunc);
+      if (!db_) {
+        throw std::runtime_error("cannot open " + tmp_path_.string());
+      }
+      for (const auto &entry : entries_) {
+        db_ << entry.first.second << " "
+            << format_entry_(entry.first.first, entry.second) << "\n";
+      }
+    }
+
+    std::error_code ec_;
+    ghc::filesystem::rename(tmp_path_, database_path_, ec_);
+    if (ec_) {
+      ghc::filesystem::remove(tmp_path_, ec_);
+      throw std::runtime_error("cannot rename " + tmp_path_.string());
+    }
+    dirty_ = false;
+  } catch (const std::exception &e) {
+    if (!log_errors) {
+      return;
+    }
+    logger::get_logger()->warn()
+        << "HashCache: Failed to write hash cache '"
+        << database_path_.string() << "': " << e.what();
+  }
+}
+
+HashCache::sptr HashCache::get_cache() {
+  static HashCache::sptr instance_ = HashCache::construct();
+  return instance_;
+}
+
+}; // namespace FairDataPipeline
@@ -0,0 +1,44 @@
+#include "fdp/utilities/hashing.hxx"
+
+#include <chrono>
+#include <random>
+
+#include "digestpp/digestpp.hpp"
+
+namespace FairDataPipeline {
+
+std::string calculate_hash_from_string(const std::string &input) {
+  return digestpp::sha1().absorb(input).hexdigest();
+}
+
+std::string generate_random_hash() {
+  std::string random_string;
+
+  // Use Both the random_device and chrono high resolution clock to generate
+  // a good random seed
+
+  std::random_device rd;
+  std::mt19937::result_type seed =
+      rd() ^
+      ((std::mt19937::result_type)
+           std::chrono::duration_cast<std::chrono::seconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+               .count() +
+       (std::mt19937::result_type)
+           std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::high_resolution_clock::now().time_since_epoch())
+               .count());
+
+  // Using mt19937 and a uniform distribution generate a 24 character random
+  // string
+  std::mt19937 gen(seed);
+  std::uniform_int_distribution<unsigned> distrib('a', '9');
+
+  for (unsigned long j = 0; j < 24; ++j) {
+    random_string += distrib(gen);
+  }
+
+  return calculate_hash_from_string(random_string);
+}
+
+}; // namespace FairDataPipeline
@@ -0,0 +1,212 @@
+#include "fdp/utilities/journal.hxx"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <json/reader.h>
+#include <json/writer.h>
+
+#ifdef _WIN32
+#include <io.h>
+#include <sys/locking.h>
+#else
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "fdp/exceptions.hxx"
+#include "fdp/utilities/logging.hxx"
+
+namespace FairDataPipeline {
+
+namespace {
+// Locks are released when the file is closed, including by a crash. False
+// if another session holds the lock, any other failure, such as a file
+// system without locks, throws rather than reading as a held lock
+bool lock_file_(std::FILE *file, const ghc::filesystem::path &file_path) {
+#ifdef _WIN32
+  _lseek(_fileno(file), 0, SEEK_SET);
+  if (_locking(_fileno(file), _LK_NBLCK, 1) == 0) {
+    return true;
+  }
+  if (errno == EACCES || errno == EDEADLOCK) {
+    return false;
+  }
+#else
+  if (flock(fileno(file), LOCK_EX | LOCK_NB) == 0) {
+    return true;
+  }
+  if (errno == EWOULDBLOCK || errno == EAGAIN) {
+    return false;
+  }
+#endif
+  throw write_error("Failed to lock journal '" + file_path.string() +
+                    "': " + std::strerror(errno));
+}
+
+void close_file_(std::FILE *file) {
+#ifdef _WIN32
+  _lseek(_fileno(file), 0, SEEK_SET);
+  _locking(_fileno(file), _LK_UNLCK, 1);
+#endif
+  std::fclose(file);
+}
+
+// False if the journal was completed and removed before it was locked
+bool is_open_file_(std::FILE *file, const ghc::filesystem::path &file_path) {
+#ifdef _WIN32
+  (void)file;
+  (void)file_path;
+  return true;
+#else
+  struct stat open_;
+  struct stat named_;
+  return fstat(fileno(file), &open_) == 0 &&
+         stat(file_path.string().c_str(), &named_) == 0 &&
+         open_.st_dev == named_.st_dev && open_.st_ino == named_.st_ino;
+#endif
+}
+} // namespace
+
+Journal::Journal(const ghc::filesystem::path &journal_path)
+    : path_(journal_path) {}
+
+std::vector<Json::Value> Journal::load_(const ghc::filesystem::path &journal_path,
+                                        std::uintmax_t &good_size) {
+  std::vector<Json::Value> records_;
+  good_size = 0;
+
+  std::ifstream in_(journal_path.string(), std::ios_base::binary);
+  if (!in_) {
+    return records_;
+  }
+
+  Json::CharReaderBuilder builder_;
+  const std::unique_ptr<Json::CharReader> reader_(builder_.newCharReader());
+  std::string line_;
+  while (std::getline(in_, line_)) {
+    // A record is only complete once its newline has been written
+    Json::Value record_;
+    JSONCPP_STRING err_;
+    if (in_.eof() ||
+        !reader_->parse(line_.c_str(), line_.c_str() + line_.size(), &record_,
+                        &err_) ||
+        !record_.isMember("step")) {
+      logger::get_logger()->warn()
+          << "Journal: Ignoring incomplete record in '"
+          << journal_path.string() << "'";
+      break;
+    }
+    records_.push_back(record_);
+    good_size += line_.size() + 1;
+  }
+
+  return records_;
+}
+
+std::vector<Json::Value> Journal::load(const ghc::filesystem::path &journal_path) {
+  std::uintmax_t good_size_ = 0;
+  return load_(journal_path, good_size_);
+}
+
+Journal::sptr Journal::open(const ghc::filesystem::path &journal_path) {
+  sptr pobj = try_open(journal_path);
+  if (!pobj) {
+    throw write_error("Journal '" + journal_path.string() +
+                      "' is in use by another session");
+  }
+  return pobj;
+}
+
+Journal::sptr Journal::try_open(const ghc::filesystem::path &journal_path) {
+  if (!journal_path.parent_path().empty()) {
+    ghc::filesystem::create_directories(journal_path.parent_path());
+  }
+
+  sptr pobj;
+  do {
+    pobj = sptr(new Journal(journal_path));
+    pobj->file_ = std::fopen(journal_path.string().c_str(), "ab");
+    if (!pobj->file_) {
+      throw write_error("Failed to open journal '" + journal_path.string() +
+                        "'");
+    }
+    if (!lock_file_(pobj->file_, journal_path)) {
+      return sptr();
+    }
+  } while (!is_open_file_(pobj->file_, journal_path));
+
+  // Cut a torn final record so appended records start on a fresh line
+  std::uintmax_t good_size_ = 0;
+  pobj->replayed_ = load_(journal_path, good_size_);
+  if (ghc::filesystem::file_size(journal_path) > good_size_) {
+    ghc::filesystem::resize_file(journal_path, good_size_);
+  }
+
+  if (!pobj->replayed_.empty()) {
+    logger::get_logger()->info()
+        << "Journal: Resuming from " << pobj->replayed_.size()
+        << " recorded steps in '" << journal_path.string() << "'";
+  }
+
+  return pobj;
+}
+
+Journal::~Journal() {
+  if (file_) {
+    close_file_(file_);
+  }
+}
+
+void Journal::record(const std::string &step, const Json::Value &data) {
+  Json::Value record_;
+  record_["step"] = step;
+  record_["data"] = data;
+
+  Json::StreamWriterBuilder builder_;
+  builder_["indentation"] = "";
+  const std::string line_ = Json::writeString(builder_, record_) + "\n";
+
+  std::lock_guard<std::mutex> lock_(mutex_);
+  if (!file_) {
+    throw write_error("Journal '" + path_.string() + "' is closed");
+  }
+  if (std::fwrite(line_.data(), 1, line_.size(), file_) != line_.size() ||
+      std::fflush(file_) != 0) {
+    throw write_error("Failed to write journal '" + path_.string() + "'");
+  }
+#ifdef _WIN32
+  _commit(_fileno(file_));
+#else
+  fsync(fileno(file_));
+#endif
+}
+
+Json::Value Journal::find_last(const std::string &step) const {
+  for (auto it = replayed_.rbegin(); it != replayed_.rend(); ++it) {
+    if ((*it)["step"].asString() == step) {
+      return (*it)["data"];
+    }
+  }
+  return Json::Value();
+}
+
+void Journal::complete() {
+  std::lock_guard<std::mutex> lock_(mutex_);
+  if (!file_) {
+    return;
+  }
+  // Removed while still locked, so no other session can open it meanwhile
+#ifdef _WIN32
+  close_file_(file_);
+  file_ = nullptr;
+  ghc::filesystem::remove(path_);
+#else
+  ghc::filesystem::remove(path_);
+  close_file_(file_);
+  file_ = nullptr;
+#endif
+}
+
+}; // namespace FairDataPipeline
@@ -1,5 +1,6 @@
 #include <iostream>
 #include <map>
+#include <mutex>
 #ifdef _WIN32
     #include <windows_sys/time.h>
 #else
@@ -159,6 +160,9 @@ namespace FairDataPipeline {
 
         int OStreamSink::log( enum LOG_LEVEL msg_lvl, const std::string& s)
         {
+            // Whole messages are written under the lock so lines from
+            // different threads are never interleaved
+            std::lock_guard< std::mutex > lock( _mutex );
             _os << s;
 
             return 0;
@@ -204,7 +208,8 @@ namespace FairDataPipeline {
     
     logger::logger_sptr logger::get_logger()
     {
-        if( NULL == logger::_instance )
+        static std::once_flag init_flag;
+        std::call_once( init_flag, []()
         {
             enum logging::LOG_LEVEL log_lvl = logging::OFF;
 
@@ -213,7 +218,7 @@ namespace FairDataPipeline {
 
             auto sink = logging::OStreamSink::create( log_lvl, std::cout );
             logger::_instance = logging::Logger::create( log_lvl, sink, "FDPAPI" );
-        }
+        });
 
         return logger::_instance;
     }
@@ -0,0 +1,186 @@
+#include "fdp/utilities/parallel.hxx"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace FairDataPipeline {
+
+namespace {
+// Claim and run tasks until none remain, the first exception is kept and
+// stops further tasks being claimed
+void run_tasks_(std::atomic<std::size_t> &next_task, std::size_t n_tasks,
+                const std::function<void(std::size_t)> &function,
+                std::exception_ptr &error, std::mutex &error_mutex) {
+  try {
+    for (std::size_t i = next_task++; i < n_tasks; i = next_task++) {
+      function(i);
+    }
+  } catch (...) {
+    std::lock_guard<std::mutex> lock_(error_mutex);
+    if (!error) {
+      error = std::current_exception();
+    }
+    next_task = n_tasks;
+  }
+}
+} // namespace
+
+struct ThreadPool::job {
+  job(std::size_t n_tasks_in, unsigned int helpers_wanted_in,
+      const std::function<void(std::size_t)> &function_in)
+      : n_tasks(n_tasks_in), helpers_wanted(helpers_wanted_in),
+        function(function_in) {}
+
+  const std::size_t n_tasks;
+  const unsigned int helpers_wanted;
+  const std::function<void(std::size_t)> &function;
+  std::atomic<std::size_t> next_task{0};
+  std::exception_ptr error;
+  std::mutex error_mutex;
+
+  // Guarded by the pool mutex
+  unsigned int helpers_joined = 0;
+  unsigned int helpers_active = 0;
+  std::condition_variable finished;
+
+  void run() { run_tasks_(next_task, n_tasks, function, error, error_mutex); }
+};
+
+ThreadPool::sptr ThreadPool::construct(unsigned int n_threads) {
+  if (n_threads == 0) {
+    n_threads = std::max(1u, std::thread::hardware_concurrency()) - 1;
+  }
+  return ThreadPool::sptr(new ThreadPool(n_threads));
+}
+
+ThreadPool::ThreadPool(unsigned int n_threads) {
+  threads_.reserve(n_threads);
+  for (unsigned int t = 0; t < n_threads; ++t) {
+    threads_.emplace_back(&ThreadPool::work_, this);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock_(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  for (auto &thread_ : threads_) {
+    thread_.join();
+  }
+}
+
+unsigned int ThreadPool::size() const {
+  return static_cast<unsigned int>(threads_.size());
+}
+
+void ThreadPool::work_() {
+  for (;;) {
+    std::shared_ptr<job> job_;
+    {
+      std::unique_lock<std::mutex> lock_(mutex_);
+      wake_.wait(lock_, [this]() { return stopping_ || !jobs_.empty(); });
+      if (stopping_) {
+        return;
+      }
+      job_ = jobs_.front();
+      ++job_->helpers_active;
+      if (++job_->helpers_joined == job_->helpers_wanted) {
+        jobs_.pop_front();
+      }
+    }
+    job_->run();
+    {
+      std::lock_guard<std::mutex> lock_(mutex_);
+      --job_->helpers_active;
+    }
+    job_->finished.notify_all();
+  }
+}
+
+void ThreadPool::parallel_for(std::size_t n_tasks, unsigned int n_threads,
+                              const std::function<void(std::size_t)> &function) {
+  if (n_tasks == 0) {
+    return;
+  }
+  const unsigned int helpers_ = static_cast<unsigned int>(std::min<std::size_t>(
+      {n_threads == 0 ? size() : n_threads - 1, size(), n_tasks - 1}));
+  if (helpers_ == 0) {
+    for (std::size_t i = 0; i < n_tasks; ++i) {
+      function(i);
+    }
+    return;
+  }
+
+  auto job_ = std::make_shared<job>(n_tasks, helpers_, function);
+  {
+    std::lock_guard<std::mutex> lock_(mutex_);
+    jobs_.push_back(job_);
+  }
+  wake_.notify_all();
+
+  // The caller never waits for a helper to start, only for those which
+  // did to finish, so calls made from inside a task cannot deadlock
+  job_->run();
+  {
+    std::unique_lock<std::mutex> lock_(mutex_);
+    auto it = std::find(jobs_.begin(), jobs_.end(), job_);
+    if (it != jobs_.end()) {
+      jobs_.erase(it);
+    }
+    job_->finished.wait(lock_, [&]() { return job_->helpers_active == 0; });
+  }
+
+  if (job_->error) {
+    std::rethrow_exception(job_->error);
+  }
+}
+
+unsigned int resolve_thread_count(unsigned int n_threads, std::size_t n_tasks) {
+  if (n_threads == 0) {
+    n_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  return static_cast<unsigned int>(
+      std::max<std::size_t>(1, std::min<std::size_t>(n_threads, n_tasks)));
+}
+
+void parallel_for(std::size_t n_tasks, unsigned int n_threads,
+                  const std::function<void(std::size_t)> &function,
+                  ThreadPool *pool) {
+  if (pool) {
+    pool->parallel_for(n_tasks, n_threads, function);
+    return;
+  }
+  if (n_tasks == 0) {
+    return;
+  }
+  n_threads = resolve_thread_count(n_threads, n_tasks);
+
+  std::atomic<std::size_t> next_task_(0);
+  std::exception_ptr error_;
+  std::mutex error_mutex_;
+
+  auto worker_ = [&]() {
+    run_tasks_(next_task_, n_tasks, function, error_, error_mutex_);
+  };
+
+  std::vector<std::thread> threads_;
+  for (unsigned int t = 1; t < n_threads; ++t) {
+    threads_.emplace_back(worker_);
+  }
+  worker_();
+  for (auto &thread_ : threads_) {
+    thread_.join();
+  }
+
+  if (error_) {
+    std::rethrow_exception(error_);
+  }
+}
+
+}; // namespace FairDataPipeline
@@ -0,0 +1,52 @@
+#include "fdp/utilities/path_allocator.hxx"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+namespace FairDataPipeline {
+
+namespace {
+std::string random_session_id_() {
+  // Seeded once per session, so the cost of random_device is paid once
+  std::random_device rd_;
+  std::seed_seq seed_{
+      rd_(), rd_(), rd_(), rd_(),
+      static_cast<unsigned int>(
+          std::chrono::high_resolution_clock::now().time_since_epoch().count())};
+  std::mt19937_64 gen_(seed_);
+
+  char buffer_[33];
+  std::snprintf(buffer_, sizeof(buffer_), "%016llx%016llx",
+                static_cast<unsigned long long>(gen_()),
+                static_cast<unsigned long long>(gen_()));
+  return std::string(buffer_, 32);
+}
+} // namespace
+
+PathAllocator::PathAllocator()
+    : session_id_(random_session_id_()), counter_(0) {}
+
+std::string PathAllocator::unique_filename(const std::string &extension) {
+  char buffer_[17];
+  const int size_ = std::snprintf(
+      buffer_, sizeof(buffer_), "%llx",
+      static_cast<unsigned long long>(counter_.fetch_add(1)));
+
+  std::string filename_;
+  filename_.reserve(4 + session_id_.size() + 1 + size_ + 1 + extension.size());
+  filename_.append("dat-").append(session_id_).append(1, '-');
+  filename_.append(buffer_, size_).append(1, '.').append(extension);
+  return filename_;
+}
+
+void PathAllocator::ensure_directory(const ghc::filesystem::path &directory) {
+  const std::string key_ = directory.string();
+  if (created_directories_.contains(key_)) {
+    return;
+  }
+  ghc::filesystem::create_directories(directory);
+  created_directories_.insert_or_assign(key_, true);
+}
+
+}; // namespace FairDataPipeline
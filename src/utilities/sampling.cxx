@@ -0,0 +1,405 @@
+#include "fdp/utilities/sampling.hxx"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <limits>
+
+#include "fdp/exceptions.hxx"
+#include "fdp/utilities/parallel.hxx"
+#include "fdp/utilities/philox.hxx"
+
+namespace FairDataPipeline {
+namespace sampling {
+
+namespace {
+const double two_pi_ = 6.283185307179586476925286766559;
+const double log_sqrt_two_pi_ = 0.91893853320467274178032973640562;
+const double sqrt_three_ = 1.7320508075688772935274463415059;
+
+/**
+ * @brief Elements handed to a thread at a time
+ */
+const std::size_t chunk_size_ = 16384;
+
+/**
+ * @brief Pairs whose random bits are generated before being transformed
+ */
+const std::size_t block_pairs_ = 64;
+
+Philox4x32::counter_type bits_(const Philox4x32::key_type &key,
+                               std::uint64_t index, std::uint32_t attempt,
+                               std::uint32_t lane) {
+  return Philox4x32::block(
+      Philox4x32::counter_type{{static_cast<std::uint32_t>(index),
+                                static_cast<std::uint32_t>(index >> 32),
+                                attempt, lane}},
+      key);
+}
+
+template <typename Kernel>
+void run_chunked_(std::size_t n, unsigned int n_threads, Kernel &&kernel) {
+  const std::size_t n_chunks_ = (n + chunk_size_ - 1) / chunk_size_;
+  parallel_for(n_chunks_, n_threads, [&](std::size_t chunk) {
+    const std::size_t begin_ = chunk * chunk_size_;
+    kernel(begin_, std::min(n, begin_ + chunk_size_));
+  });
+}
+
+/**
+ * @brief Fill out[0, n) with draws first, ..., first + n - 1 of a stream in
+ * which pair p of draws comes from the uniforms of Philox block p
+ *
+ * transform(u_a, u_b, x_0, x_1) maps the two uniforms in [0, 1) of a block
+ * to the draws 2p and 2p + 1.
+ */
+template <typename Transform>
+void pair_stream_(const Philox4x32::key_type &key, std::uint64_t first,
+                  double *out, std::size_t n, Transform &&transform) {
+  std::size_t j_ = 0;
+  double pair_[2];
+  if (n > 0 && (first & 1)) {
+    const Philox4x32::counter_type b_ = bits_(key, first >> 1, 0, 0);
+    transform(Philox4x32::to_unit(b_[0], b_[1]),
+              Philox4x32::to_unit(b_[2], b_[3]), pair_[0], pair_[1]);
+    out[j_++] = pair_[1];
+  }
+
+  double u_a_[block_pairs_];
+  double u_b_[block_pairs_];
+  while (n - j_ >= 2) {
+    const std::uint64_t pair_index_ = (first + j_) >> 1;
+    const std::size_t n_pairs_ = std::min(block_pairs_, (n - j_) / 2);
+    for (std::size_t k = 0; k < n_pairs_; ++k) {
+      const Philox4x32::counter_type b_ = bits_(key, pair_index_ + k, 0, 0);
+      u_a_[k] = Philox4x32::to_unit(b_[0], b_[1]);
+      u_b_[k] = Philox4x32::to_unit(b_[2], b_[3]);
+    }
+    double *block_out_ = out + j_;
+    for (std::size_t k = 0; k < n_pairs_; ++k) {
+      transform(u_a_[k], u_b_[k], block_out_[2 * k], block_out_[2 * k + 1]);
+    }
+    j_ += 2 * n_pairs_;
+  }
+
+  if (j_ < n) {
+    const Philox4x32::counter_type b_ = bits_(key, (first + j_) >> 1, 0, 0);
+    transform(Philox4x32::to_unit(b_[0], b_[1]),
+              Philox4x32::to_unit(b_[2], b_[3]), pair_[0], pair_[1]);
+    out[j_] = pair_[0];
+  }
+}
+
+/**
+ * @brief Box-Muller transform of two uniforms in [0, 1)
+ */
+void standard_normals_(double u_a, double u_b, double &z_0, double &z_1) {
+  const double r_ = std::sqrt(-2.0 * std::log(1.0 - u_a));
+  const double theta_ = two_pi_ * u_b;
+  z_0 = r_ * std::cos(theta_);
+  z_1 = r_ * std::sin(theta_);
+}
+
+/**
+ * @brief Marsaglia-Tsang draw i of a gamma stream with unit scale
+ *
+ * Each attempt uses its own Philox blocks, so the draw depends on i only.
+ */
+double gamma_draw_(const Philox4x32::key_type &key, std::uint64_t i,
+                   double shape) {
+  const bool boost_ = shape < 1.0;
+  const double d_ = (boost_ ? shape + 1.0 : shape) - 1.0 / 3.0;
+  const double c_ = 1.0 / std::sqrt(9.0 * d_);
+  double x_ = 0.0;
+  for (std::uint32_t attempt_ = 0;; ++attempt_) {
+    const Philox4x32::counter_type b_ = bits_(key, i, attempt_, 1);
+    double z_;
+    double unused_;
+    standard_normals_(Philox4x32::to_unit(b_[0], b_[1]),
+                      Philox4x32::to_unit(b_[2], b_[3]), z_, unused_);
+    double v_ = 1.0 + c_ * z_;
+    if (v_ <= 0.0) {
+      continue;
+    }
+    v_ = v_ * v_ * v_;
+    const Philox4x32::counter_type a_ = bits_(key, i, attempt_, 2);
+    const double u_ = Philox4x32::to_unit(a_[0], a_[1]);
+    const double z2_ = z_ * z_;
+    if (u_ < 1.0 - 0.0331 * z2_ * z2_ ||
+        std::log(u_) < 0.5 * z2_ + d_ * (1.0 - v_ + std::log(v_))) {
+      x_ = d_ * v_;
+      break;
+    }
+  }
+  if (boost_) {
+    const Philox4x32::counter_type b_ = bits_(key, i, 0, 3);
+    x_ *= std::pow(1.0 - Philox4x32::to_unit(b_[0], b_[1]), 1.0 / shape);
+  }
+  return x_;
+}
+
+/**
+ * @brief Regularised lower incomplete gamma function P(a, x)
+ *
+ * @param log_gamma_a lgamma(a), computed once by the caller as lgamma is
+ * not thread safe everywhere
+ */
+double gamma_p_(double a, double x, double log_gamma_a) {
+  if (x <= 0.0) {
+    return 0.0;
+  }
+  const double log_prefix_ = a * std::log(x) - x - log_gamma_a;
+  if (x < a + 1.0) {
+    // Series expansion
+    double term_ = 1.0 / a;
+    double sum_ = term_;
+    for (int n = 1; n < 1000; ++n) {
+      term_ *= x / (a + n);
+      sum_ += term_;
+      if (std::fabs(term_) < std::fabs(sum_) * 1e-16) {
+        break;
+      }
+    }
+    return std::min(1.0, sum_ * std::exp(log_prefix_));
+  }
+  // Continued fraction for Q(a, x), modified Lentz's method
+  const double tiny_ = 1e-300;
+  double b_ = x + 1.0 - a;
+  double c_ = 1.0 / tiny_;
+  double d_ = 1.0 / b_;
+  double h_ = d_;
+  for (int i = 1; i < 1000; ++i) {
+    const double an_ = -i * (i - a);
+    b_ += 2.0;
+    d_ = an_ * d_ + b_;
+    if (std::fabs(d_) < tiny_) {
+      d_ = tiny_;
+    }
+    c_ = b_ + an_ / c_;
+    if (std::fabs(c_) < tiny_) {
+      c_ = tiny_;
+    }
+    d_ = 1.0 / d_;
+    const double delta_ = d_ * c_;
+    h_ *= delta_;
+    if (std::fabs(delta_ - 1.0) < 1e-16) {
+      break;
+    }
+  }
+  return std::max(0.0, 1.0 - std::exp(log_prefix_) * h_);
+}
+
+/**
+ * @brief Gamma shape and scale from mean and standard deviation
+ */
+void gamma_shape_scale_(double mu, double sigma, double &shape,
+                        double &scale) {
+  shape = (mu * mu) / (sigma * sigma);
+  scale = (sigma * sigma) / mu;
+}
+
+/**
+ * @brief Uniform bounds from mean and standard deviation
+ */
+void uniform_bounds_(double mu, double sigma, double &lower, double &upper) {
+  lower = mu - sqrt_three_ * sigma;
+  upper = mu + sqrt_three_ * sigma;
+}
+} // namespace
+
+Family family_from_name(const std::string &name) {
+  std::string lower_(name);
+  std::transform(lower_.begin(), lower_.end(), lower_.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  if (lower_ == "normal" || lower_ == "gaussian") {
+    return Family::NORMAL;
+  } else if (lower_ == "lognormal" || lower_ == "log-normal") {
+    return Family::LOGNORMAL;
+  } else if (lower_ == "gamma") {
+    return Family::GAMMA;
+  } else if (lower_ == "uniform") {
+    return Family::UNIFORM;
+  }
+  throw validation_error("Distribution '" + name +
+                         "' is not supported for sampling");
+}
+
+void check_parameters(Family family, double mu, double sigma) {
+  if (!std::isfinite(mu) || !std::isfinite(sigma) || !(sigma > 0.0)) {
+    throw validation_error(
+        "Distribution parameters must be finite with sigma > 0");
+  }
+  if (family == Family::GAMMA && !(mu > 0.0)) {
+    throw validation_error("Gamma distribution mean must be positive");
+  }
+}
+
+void sample(Family family, double mu, double sigma, std::uint64_t seed,
+            std::uint64_t first, double *out, std::size_t n,
+            unsigned int n_threads) {
+  check_parameters(family, mu, sigma);
+  const Philox4x32::key_type key_ = Philox4x32::make_key(seed);
+
+  switch (family) {
+  case Family::NORMAL:
+    run_chunked_(n, n_threads, [&](std::size_t begin, std::size_t end) {
+      pair_stream_(key_, first + begin, out + begin, end - begin,
+                   [mu, sigma](double u_a, double u_b, double &x_0,
+                               double &x_1) {
+                     standard_normals_(u_a, u_b, x_0, x_1);
+                     x_0 = mu + sigma * x_0;
+                     x_1 = mu + sigma * x_1;
+                   });
+    });
+    break;
+  case Family::LOGNORMAL:
+    run_chunked_(n, n_threads, [&](std::size_t begin, std::size_t end) {
+      pair_stream_(key_, first + begin, out + begin, end - begin,
+                   [mu, sigma](double u_a, double u_b, double &x_0,
+                               double &x_1) {
+                     standard_normals_(u_a, u_b, x_0, x_1);
+                     x_0 = std::exp(mu + sigma * x_0);
+                     x_1 = std::exp(mu + sigma * x_1);
+                   });
+    });
+    break;
+  case Family::UNIFORM: {
+    double lower_;
+    double upper_;
+    uniform_bounds_(mu, sigma, lower_, upper_);
+    const double width_ = upper_ - lower_;
+    run_chunked_(n, n_threads, [&](std::size_t begin, std::size_t end) {
+      pair_stream_(key_, first + begin, out + begin, end - begin,
+                   [lower_, width_](double u_a, double u_b, double &x_0,
+                                    double &x_1) {
+                     x_0 = lower_ + width_ * u_a;
+                     x_1 = lower_ + width_ * u_b;
+                   });
+    });
+    break;
+  }
+  case Family::GAMMA: {
+    double shape_;
+    double scale_;
+    gamma_shape_scale_(mu, sigma, shape_, scale_);
+    run_chunked_(n, n_threads, [&](std::size_t begin, std::size_t end) {
+      for (std::size_t j = begin; j < end; ++j) {
+        out[j] = scale_ * gamma_draw_(key_, first + j, shape_);
+      }
+    });
+    break;
+  }
+  }
+}
+
+void log_pdf(Family family, double mu, double sigma, const double *x,
+             double *out, std::size_t n, unsigned int n_threads) {
+  check_parameters(family, mu, sigma);
+  const double minus_inf_ = -std::numeric_limits<double>::infinity();
+  const double log_sigma_ = std::log(sigma);
+
+  switch (family) {
+  case Family::NORMAL:
+    run_chunked_(n, n_threads, [&](std::size_t begin, std::size_t end) {
+      for (std::size_t j = begin; j < end; ++j) {
+        const double z_ = (x[j] - mu) / sigma;
+        out[j] = -0.5 * z_ * z_ - log_sigma_ - log_sqrt_two_pi_;
+      }
+    });
+    break;
+  case Family::LOGNORMAL:
+    run_chunked_(n, n_threads, [&](std::size_t begin, std::size_t end) {
+      for (std::size_t j = begin; j < end; ++j) {
+        const double log_x_ = std::log(x[j]);
+        const double z_ = (log_x_ - mu) / sigma;
+        out[j] = x[j] > 0.0
+                     ? -0.5 * z_ * z_ - log_sigma_ - log_sqrt_two_pi_ - log_x_
+                     : minus_inf_;
+      }
+    });
+    break;
+  case Family::UNIFORM: {
+    double lower_;
+    double upper_;
+    uniform_bounds_(mu, sigma, lower_, upper_);
+    const double log_density_ = -std::log(upper_ - lower_);
+    run_chunked_(n, n_threads, [&](std::size_t begin, std::size_t end) {
+      for (std::size_t j = begin; j < end; ++j) {
+        out[j] = (x[j] >= lower_ && x[j] <= upper_) ? log_density_
+                                                   : minus_inf_;
+      }
+    });
+    break;
+  }
+  case Family::GAMMA: {
+    double shape_;
+    double scale_;
+    gamma_shape_scale_(mu, sigma, shape_, scale_);
+    const double constant_ =
+        -std::lgamma(shape_) - shape_ * std::log(scale_);
+    run_chunked_(n, n_threads, [&](std::size_t begin, std::size_t end) {
+      for (std::size_t j = begin; j < end; ++j) {
+        if (x[j] < 0.0) {
+          out[j] = minus_inf_;
+        } else if (x[j] == 0.0 && shape_ == 1.0) {
+          out[j] = constant_;
+        } else {
+          out[j] = (shape_ - 1.0) * std::log(x[j]) - x[j] / scale_ + constant_;
+        }
+      }
+    });
+    break;
+  }
+  }
+}
+
+void cdf(Family family, double mu, double sigma, const double *x, double *out,
+         std::size_t n, unsigned int n_threads) {
+  check_parameters(family, mu, sigma);
+  const double scale_z_ = 1.0 / (sigma * std::sqrt(2.0));
+
+  switch (family) {
+  case Family::NORMAL:
+    run_chunked_(n, n_threads, [&](std::size_t begin, std::size_t end) {
+      for (std::size_t j = begin; j < end; ++j) {
+        out[j] = 0.5 * std::erfc((mu - x[j]) * scale_z_);
+      }
+    });
+    break;
+  case Family::LOGNORMAL:
+    run_chunked_(n, n_threads, [&](std::size_t begin, std::size_t end) {
+      for (std::size_t j = begin; j < end; ++j) {
+        out[j] = x[j] > 0.0 ? 0.5 * std::erfc((mu - std::log(x[j])) * scale_z_)
+                            : 0.0;
+      }
+    });
+    break;
+  case Family::UNIFORM: {
+    double lower_;
+    double upper_;
+    uniform_bounds_(mu, sigma, lower_, upper_);
+    const double width_ = upper_ - lower_;
+    run_chunked_(n, n_threads, [&](std::size_t begin, std::size_t end) {
+      for (std::size_t j = begin; j < end; ++j) {
+        out[j] = std::min(1.0, std::max(0.0, (x[j] - lower_) / width_));
+      }
+    });
+    break;
+  }
+  case Family::GAMMA: {
+    double shape_;
+    double scale_;
+    gamma_shape_scale_(mu, sigma, shape_, scale_);
+    const double log_gamma_shape_ = std::lgamma(shape_);
+    run_chunked_(n, n_threads, [&](std::size_t begin, std::size_t end) {
+      for (std::size_t j = begin; j < end; ++j) {
+        out[j] = gamma_p_(shape_, x[j] / scale_, log_gamma_shape_);
+      }
+    });
+    break;
+  }
+  }
+}
+
+} // namespace sampling
+}; // namespace FairDataPipeline
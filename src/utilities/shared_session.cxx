@@ -0,0 +1,324 @@
+#include "fdp/utilities/shared_session.hxx"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <json/reader.h>
+#include <json/writer.h>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+#include "fdp/exceptions.hxx"
+#include "fdp/utilities/hashing.hxx"
+#include "fdp/utilities/logging.hxx"
+
+namespace FairDataPipeline {
+
+namespace {
+const char *const session_file_ = "session.json";
+
+std::string log_name_(int rank, const std::string &nonce) {
+  return "worker-" + std::to_string(rank) + "-" + nonce + ".jsonl";
+}
+
+bool read_env_int_(const char *name, int &value) {
+  const char *env_ = std::getenv(name);
+  if (!env_ || !*env_) {
+    return false;
+  }
+  char *end_ = nullptr;
+  const long parsed_ = std::strtol(env_, &end_, 10);
+  if (*end_ != '\0') {
+    return false;
+  }
+  value = static_cast<int>(parsed_);
+  return true;
+}
+
+/**
+ * @brief Poll until a condition holds or the timeout expires
+ *
+ * The interval starts at 50 ms and doubles up to 1 s, so a long wait does
+ * not keep a shared filesystem busy.
+ */
+template <typename Condition>
+bool wait_for_(Condition &&condition, double timeout_s) {
+  const auto deadline_ =
+      std::chrono::steady_clock::now() +
+      std::chrono::milliseconds(static_cast<long long>(timeout_s * 1000.0));
+  std::chrono::milliseconds interval_(50);
+  while (!condition()) {
+    if (std::chrono::steady_clock::now() >= deadline_) {
+      return false;
+    }
+    std::this_thread::sleep_for(interval_);
+    interval_ = std::min(interval_ * 2, std::chrono::milliseconds(1000));
+  }
+  return true;
+}
+
+/**
+ * @brief Modification time stamped by the filesystem holding a directory
+ *
+ * Written and read on that filesystem, so it can be compared with the
+ * modification time of other files there whichever host wrote them.
+ */
+ghc::filesystem::file_time_type
+filesystem_now_(const ghc::filesystem::path &directory) {
+  ghc::filesystem::create_directories(directory);
+  const ghc::filesystem::path marker_ =
+      directory / ("clock-" + generate_random_hash());
+  {
+    std::ofstream out_(marker_.string());
+    if (!out_) {
+      throw write_error("Failed to write '" + marker_.string() + "'");
+    }
+  }
+  const ghc::filesystem::file_time_type now_ =
+      ghc::filesystem::last_write_time(marker_);
+  std::error_code ec_;
+  ghc::filesystem::remove(marker_, ec_);
+  return now_;
+}
+
+/**
+ * @brief Append the complete records written to a log since offset
+ *
+ * @return false the log was truncated, and is read again from the start
+ */
+bool read_new_records_(const ghc::filesystem::path &log_path,
+                       std::uintmax_t &offset,
+                       std::vector<Json::Value> &records) {
+  std::ifstream in_(log_path.string(), std::ios_base::binary);
+  if (!in_) {
+    return true;
+  }
+  in_.seekg(0, std::ios_base::end);
+  const std::uintmax_t size_ = static_cast<std::uintmax_t>(in_.tellg());
+  if (size_ < offset) {
+    offset = 0;
+    records.clear();
+    return false;
+  }
+  in_.seekg(static_cast<std::streamoff>(offset));
+  std::string line_;
+  Json::CharReaderBuilder builder_;
+  const std::unique_ptr<Json::CharReader> reader_(builder_.newCharReader());
+  // A record is only complete once its newline has been written
+  while (std::getline(in_, line_) && !in_.eof()) {
+    Json::Value record_;
+    JSONCPP_STRING err_;
+    if (!reader_->parse(line_.c_str(), line_.c_str() + line_.size(), &record_,
+                        &err_)) {
+      throw json_parse_error("Failed to parse worker log '" +
+                             log_path.string() + "': " + err_);
+    }
+    records.push_back(record_);
+    offset += line_.size() + 1;
+  }
+  return true;
+}
+} // namespace
+
+SharedSession::SharedSession(const ghc::filesystem::path &root,
+                             const std::string &session_id, int rank,
+                             int n_ranks, double timeout_s)
+    : directory_(root / ".fdp" / "sessions" /
+                 calculate_hash_from_string(session_id)),
+      id_(session_id), rank_(rank), n_ranks_(n_ranks), timeout_s_(timeout_s) {
+}
+
+SharedSession::sptr SharedSession::construct(const ghc::filesystem::path &root,
+                                             const std::string &session_id,
+                                             int rank, int n_ranks,
+                                             double timeout_s) {
+  if (n_ranks < 1 || rank < 0 || rank >= n_ranks) {
+    logger::get_logger()->error()
+        << "SharedSession: Invalid rank " << rank << " of " << n_ranks;
+    throw sync_error("Invalid shared session rank " + std::to_string(rank) +
+                     " of " + std::to_string(n_ranks));
+  }
+  if (session_id.empty()) {
+    logger::get_logger()->error() << "SharedSession: Empty session id";
+    throw sync_error("Shared session id must not be empty");
+  }
+  return sptr(new SharedSession(root, session_id, rank, n_ranks, timeout_s));
+}
+
+bool SharedSession::detect_rank(int &rank, int &n_ranks) {
+  static const char *const variables_[][2] = {
+      {"FDP_SESSION_RANK", "FDP_SESSION_SIZE"},
+      {"OMPI_COMM_WORLD_RANK", "OMPI_COMM_WORLD_SIZE"},
+      {"PMI_RANK", "PMI_SIZE"},
+      {"PMIX_RANK", "PMIX_SIZE"}};
+  for (const auto &pair_ : variables_) {
+    int rank_;
+    int size_;
+    if (read_env_int_(pair_[0], rank_) && read_env_int_(pair_[1], size_)) {
+      rank = rank_;
+      n_ranks = size_;
+      return true;
+    }
+  }
+  return false;
+}
+
+std::string SharedSession::detect_id() {
+  for (const char *name_ : {"FDP_SESSION_ID", "SLURM_JOB_ID"}) {
+    const char *env_ = std::getenv(name_);
+    if (env_ && *env_) {
+      return env_;
+    }
+  }
+  return "";
+}
+
+void SharedSession::prepare() {
+  nonce_ = generate_random_hash();
+  ghc::filesystem::create_directories(directory_);
+  ghc::filesystem::remove(directory_ / session_file_);
+}
+
+void SharedSession::publish(const Json::Value &session) {
+  if (nonce_.empty()) {
+    prepare();
+  }
+
+  Json::Value published_;
+  published_["nonce"] = nonce_;
+  published_["session"] = session;
+
+  Json::StreamWriterBuilder builder_;
+  const ghc::filesystem::path tmp_(
+      (directory_ / session_file_).string() + ".tmp-" + nonce_);
+  {
+    std::ofstream out_(tmp_.string(), std::ios_base::trunc);
+    if (!out_) {
+      throw write_error("Failed to write shared session '" + tmp_.string() +
+                        "'");
+    }
+    out_ << Json::writeString(builder_, published_);
+  }
+  // Workers only ever see a complete session file
+  ghc::filesystem::rename(tmp_, directory_ / session_file_);
+
+  logger::get_logger()->info()
+      << "SharedSession: Published session '" << id_ << "' for "
+      << n_ranks_ << " processes";
+}
+
+Json::Value SharedSession::attach() {
+  const ghc::filesystem::path session_path_ = directory_ / session_file_;
+
+  logger::get_logger()->debug()
+      << "SharedSession: Rank " << rank_ << " waiting for '"
+      << session_path_.string() << "'";
+
+  // Processes of one run start within the timeout of each other, so an
+  // older session file was published by an earlier run. Its age is taken
+  // from modification times stamped by the filesystem, not by the clocks
+  // of the hosts which wrote and read it
+  const ghc::filesystem::file_time_type oldest_ =
+      filesystem_now_(directory_) -
+      std::chrono::duration_cast<ghc::filesystem::file_time_type::duration>(
+          std::chrono::duration<double>(timeout_s_));
+  Json::Value published_;
+  const auto published_by_this_run_ = [&]() {
+    std::error_code ec_;
+    const ghc::filesystem::file_time_type modified_ =
+        ghc::filesystem::last_write_time(session_path_, ec_);
+    if (ec_ || modified_ < oldest_) {
+      return false;
+    }
+    std::ifstream in_(session_path_.string());
+    if (!in_) {
+      return false;
+    }
+    Json::CharReaderBuilder builder_;
+    JSONCPP_STRING err_;
+    if (!Json::parseFromStream(builder_, in_, &published_, &err_)) {
+      throw json_parse_error("Failed to parse shared session '" +
+                             session_path_.string() + "': " + err_);
+    }
+    return true;
+  };
+
+  if (!wait_for_(published_by_this_run_, timeout_s_)) {
+    logger::get_logger()->error()
+        << "SharedSession: Timed out waiting for the leader to publish '"
+        << session_path_.string() << "'";
+    throw sync_error("Timed out waiting for shared session '" + id_ + "'");
+  }
+
+  nonce_ = published_["nonce"].asString();
+  return published_["session"];
+}
+
+ghc::filesystem::path SharedSession::worker_log_path() const {
+  return directory_ / log_name_(rank_, nonce_);
+}
+
+std::vector<Json::Value>
+SharedSession::collect(const std::string &code_run_uuid) const {
+  std::vector<std::vector<Json::Value>> logs_(n_ranks_);
+  std::vector<std::uintmax_t> offsets_(n_ranks_, 0);
+  std::vector<int> pending_;
+  for (int rank_i = 1; rank_i < n_ranks_; ++rank_i) {
+    pending_.push_back(rank_i);
+  }
+
+  // A worker is done once its log ends with a finalise record for this run.
+  // Each poll only reads the records appended since the last one
+  const auto poll_ = [&]() {
+    std::vector<int> still_pending_;
+    for (int rank_i : pending_) {
+      std::vector<Json::Value> &records_ = logs_[rank_i];
+      const ghc::filesystem::path log_path_ =
+          directory_ / log_name_(rank_i, nonce_);
+      if (!read_new_records_(log_path_, offsets_[rank_i], records_)) {
+        read_new_records_(log_path_, offsets_[rank_i], records_);
+      }
+      if (!records_.empty() &&
+          records_.back()["step"].asString() == "finalise" &&
+          records_.back()["data"]["code_run"].asString() == code_run_uuid) {
+        records_.pop_back();
+      } else {
+        still_pending_.push_back(rank_i);
+      }
+    }
+    pending_.swap(still_pending_);
+    return pending_.empty();
+  };
+
+  if (!wait_for_(poll_, timeout_s_)) {
+    std::ostringstream missing_;
+    for (int rank_i : pending_) {
+      missing_ << " " << rank_i;
+    }
+    logger::get_logger()->error()
+        << "SharedSession: Timed out waiting for ranks" << missing_.str()
+        << " to finalise";
+    throw sync_error("Timed out waiting for ranks" + missing_.str() +
+                     " of shared session '" + id_ + "' to finalise");
+  }
+
+  std::vector<Json::Value> records_;
+  for (int rank_i = 1; rank_i < n_ranks_; ++rank_i) {
+    for (Json::Value &record_ : logs_[rank_i]) {
+      record_["rank"] = rank_i;
+      records_.push_back(record_);
+    }
+  }
+
+  logger::get_logger()->info()
+      << "SharedSession: Collected " << records_.size() << " records from "
+      << n_ranks_ - 1 << " workers";
+
+  return records_;
+}
+
+void SharedSession::close() { ghc::filesystem::remove_all(directory_); }
+
+}; // namespace FairDataPipeline
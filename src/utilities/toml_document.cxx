@@ -0,0 +1,152 @@
+#include "fdp/utilities/toml_document.hxx"
+
+#include <map>
+#include <mutex>
+#include <utility>
+
+#include "fdp/exceptions.hxx"
+#include "fdp/utilities/hash_cache.hxx"
+#include "fdp/utilities/logging.hxx"
+
+namespace FairDataPipeline {
+
+namespace {
+/**
+ * @brief Documents kept before the cache is trimmed
+ */
+const std::size_t max_cached_documents_ = 64;
+
+struct CacheEntry {
+  HashCache::key_type key;
+  TomlDocument::sptr document;
+};
+
+std::mutex &cache_mutex_() {
+  static std::mutex mutex_;
+  return mutex_;
+}
+
+std::map<std::string, CacheEntry> &cache_() {
+  static std::map<std::string, CacheEntry> cache_;
+  return cache_;
+}
+
+void check_not_empty_(const ghc::filesystem::path &file_path) {
+  if (!ghc::filesystem::exists(file_path)) {
+    throw toml_error("File '" + file_path.string() +
+                     "' could not be opened as it does not exist");
+  }
+  if (ghc::filesystem::is_empty(file_path)) {
+    throw toml_error("File '" + file_path.string() + "' appears to be empty");
+  }
+}
+} // namespace
+
+TomlDocument::TomlDocument(const ghc::filesystem::path &file_path,
+                           toml::value data)
+    : file_path_(file_path), data_(std::move(data)) {
+  if (data_.is_table() && !data_.as_table().empty()) {
+    first_component_ = data_.as_table().begin()->first;
+  }
+}
+
+TomlDocument::sptr TomlDocument::parse(const ghc::filesystem::path &file_path) {
+  check_not_empty_(file_path);
+  return sptr(new TomlDocument(file_path, toml::parse(file_path.string())));
+}
+
+TomlDocument::sptr TomlDocument::open(const ghc::filesystem::path &file_path) {
+  HashCache::key_type key_;
+  if (!HashCache::get_key(file_path, key_)) {
+    // No stable file identity to validate a cached copy against
+    return parse(file_path);
+  }
+  if (key_.size == 0) {
+    throw toml_error("File '" + file_path.string() + "' appears to be empty");
+  }
+
+  const std::string cache_key_ = file_path.string();
+  {
+    std::lock_guard<std::mutex> lock_(cache_mutex_());
+    auto it = cache_().find(cache_key_);
+    if (it != cache_().end() && it->second.key == key_) {
+      return it->second.document;
+    }
+  }
+
+  // Parse outside the lock so different files can be parsed concurrently
+  sptr document_ = parse(file_path);
+
+  std::lock_guard<std::mutex> lock_(cache_mutex_());
+  if (cache_().size() >= max_cached_documents_ &&
+      cache_().find(cache_key_) == cache_().end()) {
+    cache_().clear();
+  }
+  CacheEntry &entry_ = cache_()[cache_key_];
+  entry_.key = key_;
+  entry_.document = document_;
+
+  logger::get_logger()->debug()
+      << "TomlDocument: Parsed '" << cache_key_ << "'";
+  return document_;
+}
+
+void TomlDocument::invalidate(const ghc::filesystem::path &file_path) {
+  std::lock_guard<std::mutex> lock_(cache_mutex_());
+  cache_().erase(file_path.string());
+}
+
+void TomlDocument::clear_cache() {
+  std::lock_guard<std::mutex> lock_(cache_mutex_());
+  cache_().clear();
+}
+
+std::size_t TomlDocument::cache_size() {
+  std::lock_guard<std::mutex> lock_(cache_mutex_());
+  return cache_().size();
+}
+
+const std::string &TomlDocument::first_component() const {
+  if (first_component_.empty()) {
+    throw toml_error("File '" + file_path_.string() +
+                     "' does not contain any components");
+  }
+  return first_component_;
+}
+
+bool TomlDocument::has_component(const std::string &component) const {
+  return data_.is_table() && data_.contains(component) &&
+         data_.at(component).is_table();
+}
+
+const toml::value &
+TomlDocument::component(const std::string &component) const {
+  if (!has_component(component)) {
+    throw toml_error("Component " + component + " does not exist");
+  }
+  return data_.at(component);
+}
+
+const toml::value &
+TomlDocument::parameter(const std::string &parameter,
+                        const std::string &component) const {
+  const toml::value &component_ = this->component(component);
+  if (!component_.contains("type")) {
+    throw toml_error("Expected 'type' tag but none found");
+  }
+  const std::string type_ =
+      static_cast<std::string>(component_.at("type").as_string());
+  if (type_ != parameter) {
+    throw toml_error("Expected " + parameter + " for type but got '" + type_ +
+                     "'");
+  }
+  return component_.at("value");
+}
+
+double TomlDocument::point_estimate(const std::string &component) const {
+  const toml::value &value_ = parameter("point-estimate", component);
+  return value_.is_floating() ? value_.as_floating()
+                              : static_cast<double>(value_.as_integer());
+}
+
+}; // namespace FairDataPipeline
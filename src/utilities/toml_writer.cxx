@@ -0,0 +1,203 @@
+#include "fdp/utilities/toml_writer.hxx"
+
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <unordered_set>
+
+#include "fdp/exceptions.hxx"
+#include "fdp/utilities/hash_cache.hxx"
+#include "fdp/utilities/logging.hxx"
+#include "fdp/utilities/toml_document.hxx"
+
+namespace FairDataPipeline {
+
+/**
+ * @brief Component names of a file as of its identity at the last flush,
+ * and the names pending in live writers on the file
+ */
+struct TomlWriter::ComponentIndex {
+  std::mutex mutex;
+  bool valid = false;
+  HashCache::key_type key;
+  std::unordered_set<std::string> names;
+  std::unordered_set<std::string> reserved;
+};
+
+namespace {
+/**
+ * @brief Indices kept before the index table is trimmed
+ */
+const std::size_t max_cached_indices_ = 64;
+
+typedef std::map<std::string, std::shared_ptr<TomlWriter::ComponentIndex>>
+    index_table_type;
+
+std::mutex &indices_mutex_() {
+  static std::mutex mutex_;
+  return mutex_;
+}
+
+index_table_type &indices_() {
+  static index_table_type indices_;
+  return indices_;
+}
+
+std::shared_ptr<TomlWriter::ComponentIndex>
+index_for_(const ghc::filesystem::path &file_path) {
+  std::shared_ptr<TomlWriter::ComponentIndex> index_;
+  {
+    std::lock_guard<std::mutex> lock_(indices_mutex_());
+    index_table_type::iterator it = indices_().find(file_path.string());
+    if (it == indices_().end()) {
+      // Writers still holding trimmed indices keep them alive
+      if (indices_().size() >= max_cached_indices_) {
+        indices_().clear();
+      }
+      it = indices_()
+               .insert(std::make_pair(
+                   file_path.string(),
+                   std::make_shared<TomlWriter::ComponentIndex>()))
+               .first;
+    }
+    index_ = it->second;
+  }
+
+  std::lock_guard<std::mutex> lock_(index_->mutex);
+  if (!ghc::filesystem::exists(file_path)) {
+    index_->names.clear();
+    index_->valid = false;
+    return index_;
+  }
+
+  HashCache::key_type key_;
+  const bool has_key_ = HashCache::get_key(file_path, key_);
+  if (index_->valid && has_key_ && index_->key == key_) {
+    return index_;
+  }
+
+  // Changed outside this process since it was indexed, read the names again
+  const TomlDocument::sptr document_ = TomlDocument::open(file_path);
+  index_->names.clear();
+  if (document_->get_data().is_table()) {
+    for (const auto &entry_ : document_->get_data().as_table()) {
+      if (entry_.second.is_table()) {
+        index_->names.insert(entry_.first);
+      }
+    }
+  }
+  index_->key = key_;
+  index_->valid = has_key_;
+  return index_;
+}
+} // namespace
+
+TomlWriter::TomlWriter(const ghc::filesystem::path &file_path)
+    : file_path_(file_path), index_(index_for_(file_path)) {}
+
+TomlWriter::sptr TomlWriter::construct(const ghc::filesystem::path &file_path) {
+  return sptr(new TomlWriter(file_path));
+}
+
+TomlWriter::~TomlWriter() {
+  const std::size_t n_pending_ = pending_.size();
+  try {
+    flush();
+  } catch (const std::exception &e) {
+    logger::get_logger()->error()
+        << "TomlWriter: Failed to write " << n_pending_
+        << " components to '" << file_path_.string() << "': " << e.what();
+  }
+}
+
+bool TomlWriter::has_component(const std::string &component) const {
+  if (pending_.count(component)) {
+    return true;
+  }
+  std::lock_guard<std::mutex> lock_(index_->mutex);
+  return index_->names.count(component) > 0 ||
+         index_->reserved.count(component) > 0;
+}
+
+void TomlWriter::add(const std::string &component, const toml::value &data) {
+  // Reserved until flushed or discarded, so no other writer on the file can
+  // add the same component meanwhile
+  {
+    std::lock_guard<std::mutex> lock_(index_->mutex);
+    if (pending_.count(component) || index_->names.count(component) ||
+        !index_->reserved.insert(component).second) {
+      throw toml_error("Component " + component + " already exists in " +
+                       file_path_.string());
+    }
+  }
+  pending_.insert(component);
+  buffer_ << data;
+}
+
+ghc::filesystem::path TomlWriter::flush() {
+  if (pending_.empty()) {
+    return file_path_;
+  }
+
+  if (!file_path_.parent_path().empty() &&
+      !ghc::filesystem::exists(file_path_.parent_path())) {
+    ghc::filesystem::create_directories(file_path_.parent_path());
+  }
+
+  // Writers on the same file append one at a time
+  std::unique_lock<std::mutex> lock_(index_->mutex);
+  std::error_code ec_;
+  const std::uintmax_t size_before_ =
+      ghc::filesystem::exists(file_path_) ? ghc::filesystem::file_size(file_path_)
+                                          : 0;
+  bool written_ = false;
+  {
+    std::ofstream toml_out_(file_path_.string(), std::ios_base::app);
+    if (toml_out_) {
+      toml_out_ << buffer_.str();
+      written_ = static_cast<bool>(toml_out_.flush());
+    }
+  }
+  if (!written_) {
+    // Cut any partial append and drop the components, so neither a later
+    // flush nor the destructor appends them a second time
+    if (ghc::filesystem::exists(file_path_)) {
+      ghc::filesystem::resize_file(file_path_, size_before_, ec_);
+    }
+    lock_.unlock();
+    discard();
+    throw toml_error("Failed to write TOML file '" + file_path_.string() +
+                     "'");
+  }
+  TomlDocument::invalidate(file_path_);
+
+  for (const std::string &component_ : pending_) {
+    index_->reserved.erase(component_);
+  }
+  index_->names.insert(pending_.begin(), pending_.end());
+  index_->valid = HashCache::get_key(file_path_, index_->key);
+  lock_.unlock();
+
+  logger::get_logger()->debug()
+      << "FileSystem:WriteToml: Wrote " << pending_.size()
+      << " components to '" << file_path_.string() << "'";
+
+  pending_.clear();
+  buffer_.str(std::string());
+  buffer_.clear();
+  return file_path_;
+}
+
+void TomlWriter::discard() {
+  {
+    std::lock_guard<std::mutex> lock_(index_->mutex);
+    for (const std::string &component_ : pending_) {
+      index_->reserved.erase(component_);
+    }
+  }
+  pending_.clear();
+  buffer_.str(std::string());
+  buffer_.clear();
+}
+
+}; // namespace FairDataPipeline
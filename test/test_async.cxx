@@ -0,0 +1,67 @@
+#ifdef FDPAPI_WITH_COROUTINES
+
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "fdp/async.hxx"
+#include "gtest/gtest.h"
+
+using namespace FairDataPipeline;
+using namespace FairDataPipeline::coro;
+
+namespace {
+Task<int> add_on(Executor::sptr executor, int a, int b) {
+  const int a_ = co_await async_call(executor, [a]() { return a; });
+  const int b_ = co_await async_call(executor, [b]() { return b; });
+  co_return a_ + b_;
+}
+
+Task<> throw_on(Executor::sptr executor) {
+  co_await async_call(executor,
+                      []() { throw std::runtime_error("registry down"); });
+}
+} // namespace
+
+TEST(AsyncTest, sync_wait_task) {
+  ThreadPoolExecutor::sptr executor = ThreadPoolExecutor::construct(2);
+  EXPECT_EQ(executor->size(), 2u);
+  EXPECT_EQ(sync_wait(add_on(executor, 2, 3)), 5);
+}
+
+TEST(AsyncTest, exceptions_propagate) {
+  ThreadPoolExecutor::sptr executor = ThreadPoolExecutor::construct(1);
+  EXPECT_THROW(sync_wait(throw_on(executor)), std::runtime_error);
+}
+
+TEST(AsyncTest, resumes_on_executor) {
+  ThreadPoolExecutor::sptr executor = ThreadPoolExecutor::construct(1);
+  auto task_ = [](Executor::sptr executor) -> Task<bool> {
+    const std::thread::id call_id_ = co_await async_call(
+        executor, []() { return std::this_thread::get_id(); });
+    co_return call_id_ == std::this_thread::get_id();
+  };
+  EXPECT_TRUE(sync_wait(task_(executor)));
+}
+
+TEST(AsyncTest, many_tasks_share_pool) {
+  ThreadPoolExecutor::sptr executor = ThreadPoolExecutor::construct(2);
+  std::atomic<int> total(0);
+  std::vector<std::thread> drivers;
+  for (int i = 0; i < 8; ++i) {
+    drivers.emplace_back([&executor, &total, i]() {
+      for (int j = 0; j < 50; ++j) {
+        total += sync_wait(add_on(executor, i, j));
+      }
+    });
+  }
+  for (std::thread &driver : drivers) {
+    driver.join();
+  }
+  // sum over i < 8, j < 50 of i + j
+  EXPECT_EQ(total.load(), 50 * 28 + 8 * 1225);
+}
+
+#endif
@@ -6,6 +6,7 @@
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <thread>
 
 #include "fdp/fdp.h"
 #include "fdp/objects/metadata.hxx" // read_token
@@ -137,6 +138,199 @@ TEST(CTest, c_to_cpp) {
   EXPECT_EQ(fdp_finalise(&c_pipeline), FDP_ERR_NONE);
 }
 
+TEST(CTest, link_many) {
+  fdp_set_log_level(FDP_LOG_DEBUG);
+
+  FdpDataPipeline *pipeline;
+  fs::path config = fs::path(TESTDIR) / "data" / "read_write_csv.yaml";
+  fs::path script = fs::path(TESTDIR) / "test_script.sh";
+  std::string token =
+      fdp::read_token(fs::path(home_dir()) / ".fair" / "registry" / "token");
+  ASSERT_EQ(fdp_init(&pipeline, config.string().c_str(),
+                     script.string().c_str(), token.c_str()),
+            FDP_ERR_NONE);
+
+  // A missing product fails on its own, the rest of the batch is linked
+  const char *writes[] = {"test/threads/a", "test/threads/b",
+                          "test/threads/a", "test/threads/missing"};
+  char bufs[4][BUFFER_SIZE] = {};
+  char *outputs[] = {bufs[0], bufs[1], bufs[2], bufs[3]};
+  FdpError errors[4];
+  EXPECT_EQ(fdp_link_write_many(pipeline, writes, 4, outputs, BUFFER_SIZE,
+                                errors),
+            FDP_ERR_CONFIG_PARSE);
+  EXPECT_EQ(errors[0], FDP_ERR_NONE);
+  EXPECT_EQ(errors[1], FDP_ERR_NONE);
+  EXPECT_EQ(errors[2], FDP_ERR_NONE);
+  EXPECT_EQ(errors[3], FDP_ERR_CONFIG_PARSE);
+  EXPECT_STRNE(bufs[0], bufs[1]);
+  EXPECT_STREQ(bufs[0], bufs[2]);
+
+  for (int ii = 0; ii < 2; ++ii) {
+    std::ofstream fstream(bufs[ii]);
+    fstream << "Test";
+  }
+
+  const char *reads[] = {"test/csv"};
+  char read_buf[BUFFER_SIZE] = {};
+  char *read_outputs[] = {read_buf};
+  EXPECT_EQ(fdp_link_read_many(pipeline, reads, 1, read_outputs, BUFFER_SIZE,
+                               NULL),
+            FDP_ERR_NONE);
+  EXPECT_GT(strlen(read_buf), 1);
+
+  EXPECT_EQ(fdp_finalise(&pipeline), FDP_ERR_NONE);
+}
+
+TEST(CTest, finalise_async) {
+  fdp_set_log_level(FDP_LOG_DEBUG);
+  char buf[BUFFER_SIZE];
+
+  FdpDataPipeline *pipeline;
+  fs::path config = fs::path(TESTDIR) / "data" / "write_csv.yaml";
+  fs::path script = fs::path(TESTDIR) / "test_script.sh";
+  std::string token =
+      fdp::read_token(fs::path(home_dir()) / ".fair" / "registry" / "token");
+  ASSERT_EQ(fdp_init(&pipeline, config.string().c_str(),
+                     script.string().c_str(), token.c_str()),
+            FDP_ERR_NONE);
+
+  EXPECT_EQ(fdp_finalise_poll(pipeline, NULL), FDP_ERR_OTHER);
+
+  ASSERT_EQ(fdp_link_write(pipeline, "test/csv", buf, BUFFER_SIZE),
+            FDP_ERR_NONE);
+  std::ofstream fstream(buf);
+  fstream << "Test";
+  fstream.close();
+
+  // Finalise runs on a background thread, waited for from another thread
+  ASSERT_EQ(fdp_finalise_start(pipeline), FDP_ERR_NONE);
+  EXPECT_EQ(fdp_finalise_start(pipeline), FDP_ERR_OTHER);
+  EXPECT_EQ(fdp_finalise(&pipeline), FDP_ERR_OTHER);
+
+  FdpFinaliseProgress progress;
+  FdpError poll_err;
+  do {
+    poll_err = fdp_finalise_poll(pipeline, &progress);
+    EXPECT_LE(progress.outputs_hashed, progress.outputs_total);
+  } while (!progress.done);
+  EXPECT_EQ(poll_err, FDP_ERR_NONE);
+  EXPECT_EQ(progress.outputs_total, 1);
+  EXPECT_EQ(progress.outputs_hashed, 1);
+  EXPECT_EQ(progress.outputs_registered, 1);
+  EXPECT_GT(progress.registry_calls, 0);
+
+  FdpError wait_err = FDP_ERR_OTHER;
+  std::thread waiter([&]() { wait_err = fdp_finalise_wait(&pipeline); });
+  waiter.join();
+  EXPECT_EQ(wait_err, FDP_ERR_NONE);
+  EXPECT_EQ(pipeline, nullptr);
+}
+
+TEST(CTest, finalise_race) {
+  char buf[BUFFER_SIZE];
+
+  FdpDataPipeline *pipeline;
+  fs::path config = fs::path(TESTDIR) / "data" / "write_csv.yaml";
+  fs::path script = fs::path(TESTDIR) / "test_script.sh";
+  std::string token =
+      fdp::read_token(fs::path(home_dir()) / ".fair" / "registry" / "token");
+  ASSERT_EQ(fdp_init(&pipeline, config.string().c_str(),
+                     script.string().c_str(), token.c_str()),
+            FDP_ERR_NONE);
+  ASSERT_EQ(fdp_link_write(pipeline, "test/csv", buf, BUFFER_SIZE),
+            FDP_ERR_NONE);
+  std::ofstream fstream(buf);
+  fstream << "Test";
+  fstream.close();
+
+  // fdp_finalise and fdp_finalise_start race, only one of them finalises.
+  // Finalise takes far longer than starting a thread, so the pipeline is
+  // not deleted before the loser has returned
+  FdpDataPipeline *finalised = pipeline;
+  FdpError finalise_err = FDP_ERR_OTHER;
+  FdpError start_err = FDP_ERR_OTHER;
+  std::thread finaliser(
+      [&]() { finalise_err = fdp_finalise(&finalised); });
+  std::thread starter([&]() { start_err = fdp_finalise_start(pipeline); });
+  finaliser.join();
+  starter.join();
+  EXPECT_NE(finalise_err == FDP_ERR_NONE, start_err == FDP_ERR_NONE);
+  if (start_err == FDP_ERR_NONE) {
+    EXPECT_NE(finalised, nullptr);
+    EXPECT_EQ(fdp_finalise_wait(&pipeline), FDP_ERR_NONE);
+  } else {
+    EXPECT_EQ(finalised, nullptr);
+  }
+}
+
+TEST(CTest, error_messages) {
+  char buf[BUFFER_SIZE];
+  EXPECT_STREQ(fdp_error_name(FDP_ERR_CONFIG_PARSE), "Config Parse");
+  EXPECT_STREQ(fdp_error_name(FDP_ERR_NONE), "None");
+
+  EXPECT_EQ(fdp_link_read(NULL, "test/csv", buf, BUFFER_SIZE), FDP_ERR_OTHER);
+  const std::string message = fdp_last_error_message();
+  EXPECT_NE(message.find("fdp_link_read"), std::string::npos);
+
+  // Each thread keeps its own message
+  std::string thread_message;
+  std::thread other([&]() {
+    EXPECT_EQ(fdp_link_write(NULL, "test/csv", buf, BUFFER_SIZE),
+              FDP_ERR_OTHER);
+    thread_message = fdp_last_error_message();
+  });
+  other.join();
+  EXPECT_NE(thread_message.find("fdp_link_write"), std::string::npos);
+  EXPECT_EQ(message, fdp_last_error_message());
+}
+
+TEST(CTest, point_estimates_and_distributions) {
+  const fs::path temp = fs::path(TESTDIR) / "data" / "temp";
+  fs::create_directories(temp);
+  const std::string estimates = (temp / "c_estimates.toml").string();
+  const std::string distributions = (temp / "c_distributions.toml").string();
+
+  const char *components[] = {"first", "second"};
+  const double values[] = {1.5, 2.5};
+  double read_values[2] = {0.0, 0.0};
+  EXPECT_EQ(fdp_write_point_estimates(estimates.c_str(), components, values, 2),
+            FDP_ERR_NONE);
+  EXPECT_EQ(fdp_write_point_estimate(estimates.c_str(), "third", 3.5),
+            FDP_ERR_NONE);
+  EXPECT_EQ(
+      fdp_read_point_estimates(estimates.c_str(), components, 2, read_values),
+      FDP_ERR_NONE);
+  EXPECT_EQ(read_values[0], 1.5);
+  EXPECT_EQ(read_values[1], 2.5);
+  EXPECT_EQ(fdp_read_point_estimate(estimates.c_str(), NULL, read_values),
+            FDP_ERR_NONE);
+  EXPECT_EQ(read_values[0], 1.5);
+
+  const char *names[] = {"normal", "gamma"};
+  const double mus[] = {0.5, 2.0};
+  const double sigmas[] = {0.25, 1.0};
+  EXPECT_EQ(fdp_write_distributions(distributions.c_str(), components, names,
+                                    mus, sigmas, 2),
+            FDP_ERR_NONE);
+  char name[BUFFER_SIZE];
+  double mu = 0.0;
+  double sigma = 0.0;
+  EXPECT_EQ(fdp_read_distribution(distributions.c_str(), "second", name,
+                                  BUFFER_SIZE, &mu, &sigma),
+            FDP_ERR_NONE);
+  EXPECT_STREQ(name, "gamma");
+  EXPECT_EQ(mu, 2.0);
+  EXPECT_EQ(sigma, 1.0);
+
+  char short_name[2];
+  EXPECT_EQ(fdp_read_distribution(distributions.c_str(), "first", short_name,
+                                  2, &mu, &sigma),
+            FDP_ERR_OTHER);
+
+  fs::remove_all(temp);
+}
+
 TEST(CTest, log_levels) {
   fdp_set_log_level(FDP_LOG_INFO);
   EXPECT_EQ(fdp_get_log_level(), FDP_LOG_INFO);
@@ -82,6 +82,46 @@ TEST_F(ConfigTest, TestLinkWrite){
   
 }
 
+TEST_F(ConfigTest, TestLinkWriteDirectory){
+  Config::sptr cnf = config();
+  std::string data_product = "test/shards";
+  ghc::filesystem::path currentLink = cnf->link_write(data_product);
+  ASSERT_TRUE(ghc::filesystem::is_directory(currentLink));
+
+  for (int rank = 0; rank < 4; ++rank) {
+    std::ofstream shard((currentLink / ("rank_" + std::to_string(rank) + ".csv")).string());
+    shard << "rank," << rank;
+  }
+
+  const std::string root = calculate_directory_hash(currentLink);
+
+  cnf->finalise();
+
+  EXPECT_FALSE(ghc::filesystem::exists(currentLink));
+  ghc::filesystem::path stored = currentLink.parent_path() / (root + ".csv");
+  EXPECT_TRUE(ghc::filesystem::is_directory(stored));
+}
+
+TEST_F(ConfigTest, TestLinkWriteArrowFileType){
+  Config::sptr cnf = config();
+  ghc::filesystem::path currentLink = cnf->link_write("test/arrow");
+  EXPECT_EQ(currentLink.extension().string(), ".arrow");
+  std::ofstream table(currentLink.string());
+  table << "ARROW1";
+  table.close();
+
+  cnf->finalise();
+
+  // The file type is stored with its name and without the leading dot
+  Json::Value query;
+  query["extension"] = "arrow";
+  const Json::Value file_types =
+      API::construct(cnf->get_api_url())->get_by_json_query("file_type", query);
+  ASSERT_EQ(file_types.size(), 1u);
+  EXPECT_EQ(file_types[0]["name"].asString(), "Apache Arrow IPC");
+  EXPECT_EQ(file_types[0]["extension"].asString(), "arrow");
+}
+
 TEST_F(ConfigTest, TestLinkRead){
     Config::sptr cnf = config(true, "read_csv.yaml");
   std::string data_product = "test/csv";
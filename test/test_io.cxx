@@ -4,11 +4,43 @@
 
 #include "fdp/utilities/data_io.hxx"
 #include "fdp/objects/distribution.hxx"
+#include "fdp/objects/parameter_bindings.hxx"
+#include "fdp/objects/parameter_set.hxx"
+#include "fdp/objects/parameter_store.hxx"
+#include "fdp/objects/shared_parameter_cache.hxx"
+#include "fdp/utilities/array_io.hxx"
+#include "fdp/utilities/arrow_table.hxx"
+#include "fdp/utilities/toml_document.hxx"
+#include "fdp/utilities/toml_writer.hxx"
 #include "fdp/exceptions.hxx"
 #include "gtest/gtest.h"
 
+#include <cstdint>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 using namespace FairDataPipeline;
 
+struct BoundParameters {
+  double estimate = 0.0;
+  int count = 0;
+  Distribution delay{"normal", 0.0, 1.0};
+};
+
+FDP_PARAMETER_SCHEMA(BoundParameters,
+                     FDP_PARAMETER(estimate, "Test_Component"),
+                     FDP_PARAMETER(count, "Test_Count"),
+                     FDP_PARAMETER(delay, "Test_Distribution"))
+
+struct WideParameters {
+  std::int64_t total = 0;
+};
+
+FDP_PARAMETER_SCHEMA(WideParameters, FDP_PARAMETER(total, "Test_Total"))
+
 class IOTest : public ::testing::Test {
 protected:
   void SetUp() override {}
@@ -199,4 +231,567 @@ TEST_F(IOTest, TestInvalidToml) {
         FAIL() << "Exception Thrown" << std::endl;
     }    
 
-}
\ No newline at end of file
+}
+
+TEST_F(IOTest, TestEstimatesBatch) {
+  const ghc::filesystem::path estimates_toml =
+      ghc::filesystem::path(TESTDIR) / "data" / "temp" / "test_estimates.toml";
+  const std::vector<std::string> components = {component, component_2};
+  const std::vector<double> values = {p_estimate, p_estimate_2};
+
+  write_point_estimates(components, values, estimates_toml);
+  EXPECT_EQ(read_point_estimates_from_toml(estimates_toml, components), values);
+  EXPECT_EQ(read_point_estimate_from_toml(estimates_toml, component_2),
+            p_estimate_2);
+
+  // Nothing is written if any component already exists
+  EXPECT_THROW(write_point_estimates({"Test_Component_3", component},
+                                     {1.0, 2.0}, estimates_toml),
+               toml_error);
+  EXPECT_FALSE(component_exists(estimates_toml, "Test_Component_3"));
+}
+
+TEST_F(IOTest, TestDistributionsBatch) {
+  const std::vector<Distribution> distributions = {
+      Distribution(distribution, mu, sigma, component),
+      Distribution("normal", 2.0, 3, component_2)};
+  const std::string file_name(test_distribution_4_toml.string());
+
+  Distribution::write_many_to_toml(distributions, file_name);
+  const std::vector<Distribution> read_ = Distribution::read_many_from_toml(
+      file_name, {component_2, component});
+
+  ASSERT_EQ(read_.size(), 2u);
+  EXPECT_EQ(read_[0], distributions[1]);
+  EXPECT_EQ(read_[1], distributions[0]);
+}
+
+TEST_F(IOTest, TestDocumentCache) {
+  const ghc::filesystem::path estimates_toml =
+      ghc::filesystem::path(TESTDIR) / "data" / "temp" / "test_cache.toml";
+  write_point_estimate(p_estimate, component, estimates_toml);
+
+  const TomlDocument::sptr document_ = TomlDocument::open(estimates_toml);
+  EXPECT_EQ(TomlDocument::open(estimates_toml), document_);
+  EXPECT_EQ(document_->first_component(), component);
+  EXPECT_TRUE(document_->has_component(component));
+  EXPECT_EQ(document_->point_estimate(component), p_estimate);
+  EXPECT_THROW(document_->parameter("distribution", component), toml_error);
+  EXPECT_THROW(document_->component(component_2), toml_error);
+
+  // Writing through the API drops the cached document
+  write_point_estimate(p_estimate_2, component_2, estimates_toml);
+  const TomlDocument::sptr updated_ = TomlDocument::open(estimates_toml);
+  EXPECT_NE(updated_, document_);
+  EXPECT_EQ(updated_->point_estimate(component_2), p_estimate_2);
+  EXPECT_EQ(read_point_estimate_from_toml(estimates_toml, component_2),
+            p_estimate_2);
+  EXPECT_FALSE(document_->has_component(component_2));
+}
+
+TEST_F(IOTest, TestTomlWriter) {
+  const ghc::filesystem::path writer_toml =
+      ghc::filesystem::path(TESTDIR) / "data" / "temp" / "test_writer.toml";
+  {
+    TomlWriter::sptr writer_ = TomlWriter::construct(writer_toml);
+    write_point_estimate(p_estimate, component, *writer_);
+    write_point_estimate(p_estimate_3, component_2, *writer_);
+    Distribution(distribution, mu, sigma, "Test_Distribution")
+        .write_to_toml(*writer_);
+    EXPECT_THROW(write_point_estimate(p_estimate_2, component, *writer_),
+                 toml_error);
+
+    EXPECT_EQ(writer_->pending(), 3u);
+    EXPECT_FALSE(ghc::filesystem::exists(writer_toml));
+    writer_->flush();
+    EXPECT_EQ(writer_->pending(), 0u);
+  }
+
+  EXPECT_EQ(
+      read_point_estimates_from_toml(writer_toml, {component, component_2}),
+      std::vector<double>({p_estimate, double(p_estimate_3)}));
+  EXPECT_EQ(Distribution(writer_toml.string(), "Test_Distribution"),
+            Distribution(distribution, mu, sigma, "Test_Distribution"));
+
+  // A new writer sees the components already in the file
+  TomlWriter::sptr writer_ = TomlWriter::construct(writer_toml);
+  EXPECT_TRUE(writer_->has_component(component));
+  EXPECT_THROW(write_point_estimate(p_estimate, component, writer_toml),
+               toml_error);
+
+  // A component pending in one writer cannot be added by another
+  TomlWriter::sptr other_ = TomlWriter::construct(writer_toml);
+  writer_->add_parameter("point-estimate", "Pending_Component", 1.0);
+  EXPECT_TRUE(other_->has_component("Pending_Component"));
+  EXPECT_THROW(
+      other_->add_parameter("point-estimate", "Pending_Component", 2.0),
+      toml_error);
+  writer_->discard();
+  other_->add_parameter("point-estimate", "Pending_Component", 2.0);
+  other_->flush();
+  EXPECT_EQ(read_point_estimate_from_toml(writer_toml, "Pending_Component"),
+            2.0);
+}
+
+TEST_F(IOTest, TestParameterSet) {
+  const ghc::filesystem::path temp_ =
+      ghc::filesystem::path(TESTDIR) / "data" / "temp";
+  const ghc::filesystem::path first_toml = temp_ / "test_set_1.toml";
+  const ghc::filesystem::path second_toml = temp_ / "test_set_2.toml";
+  {
+    TomlWriter::sptr writer_ = TomlWriter::construct(first_toml);
+    write_point_estimate(p_estimate, component, *writer_);
+    write_point_estimate(p_estimate_3, component_2, *writer_);
+    Distribution(distribution, mu, sigma, "Test_Distribution")
+        .write_to_toml(*writer_);
+    writer_->add_parameter("samples", "Test_Samples", 1.0);
+  }
+  write_point_estimate(p_estimate_2, component, second_toml);
+
+  const ParameterSet::sptr set_ = ParameterSet::load(first_toml);
+  EXPECT_EQ(set_->size(), 4u);
+  EXPECT_TRUE(set_->contains(component));
+  EXPECT_FALSE(set_->contains("Missing"));
+  EXPECT_EQ(set_->type(component), ParameterSet::Type::POINT_ESTIMATE);
+  EXPECT_EQ(set_->type("Test_Samples"), ParameterSet::Type::OTHER);
+  EXPECT_EQ(set_->point_estimate(component), p_estimate);
+  EXPECT_EQ(set_->point_estimate(component_2), p_estimate_3);
+  EXPECT_EQ(set_->distribution("Test_Distribution"),
+            Distribution(distribution, mu, sigma, "Test_Distribution"));
+  EXPECT_THROW(set_->point_estimate("Test_Distribution"), toml_error);
+  EXPECT_THROW(set_->distribution(component), toml_error);
+  EXPECT_THROW(set_->value("Missing"), toml_error);
+
+  const std::vector<ParameterSet::sptr> sets_ =
+      ParameterSet::load_many({first_toml, second_toml}, 2);
+  ASSERT_EQ(sets_.size(), 2u);
+  EXPECT_EQ(sets_[0]->point_estimate(component), p_estimate);
+  EXPECT_EQ(sets_[1]->point_estimate(component), p_estimate_2);
+  EXPECT_THROW(ParameterSet::load_many({first_toml, temp_ / "missing.toml"}),
+               toml_error);
+}
+
+TEST_F(IOTest, TestParameterStore) {
+  const ghc::filesystem::path temp_ =
+      ghc::filesystem::path(TESTDIR) / "data" / "temp";
+  const ghc::filesystem::path store_path = temp_ / "test_store.fdpp";
+
+  ParameterStoreWriter writer_;
+  write_point_estimate(p_estimate, component, writer_);
+  writer_.add_point_estimate(component_2, p_estimate_3);
+  writer_.add_distribution(
+      Distribution(distribution, mu, sigma, "Test_Distribution"));
+  writer_.write(store_path);
+
+  const ParameterStore::sptr store_ = ParameterStore::open(store_path);
+  EXPECT_EQ(store_->size(), 3u);
+  EXPECT_TRUE(store_->contains(component));
+  EXPECT_FALSE(store_->contains("Missing"));
+  EXPECT_EQ(store_->point_estimate(component), p_estimate);
+  EXPECT_EQ(store_->point_estimate(component_2), p_estimate_3);
+  EXPECT_EQ(store_->distribution("Test_Distribution"),
+            Distribution(distribution, mu, sigma, "Test_Distribution"));
+  EXPECT_THROW(store_->point_estimate("Test_Distribution"),
+               parameter_store_error);
+  EXPECT_THROW(store_->point_estimate("Missing"), parameter_store_error);
+
+  writer_.add_point_estimate(component, p_estimate_2);
+  EXPECT_THROW(writer_.write(temp_ / "duplicate.fdpp"), parameter_store_error);
+
+  // Round trip through TOML
+  const ghc::filesystem::path toml_path = temp_ / "test_store.toml";
+  const ghc::filesystem::path copy_path = temp_ / "test_store_copy.fdpp";
+  convert_parameter_store_to_toml(store_path, toml_path);
+  EXPECT_EQ(read_point_estimate_from_toml(toml_path, component), p_estimate);
+  convert_toml_to_parameter_store(toml_path, copy_path);
+  const ParameterStore::sptr copy_ = ParameterStore::open(copy_path);
+  EXPECT_EQ(copy_->size(), 3u);
+  EXPECT_EQ(copy_->distribution("Test_Distribution"),
+            store_->distribution("Test_Distribution"));
+
+  EXPECT_THROW(ParameterStore::open(toml_path), parameter_store_error);
+}
+
+TEST_F(IOTest, TestParameterBindings) {
+  const ghc::filesystem::path temp_ =
+      ghc::filesystem::path(TESTDIR) / "data" / "temp";
+  const ghc::filesystem::path toml_path = temp_ / "test_bindings.toml";
+  const ghc::filesystem::path store_path = temp_ / "test_bindings.fdpp";
+  {
+    TomlWriter::sptr writer_ = TomlWriter::construct(toml_path);
+    write_point_estimate(p_estimate, component, *writer_);
+    write_point_estimate(12, "Test_Count", *writer_);
+    Distribution(distribution, mu, sigma, "Test_Distribution")
+        .write_to_toml(*writer_);
+  }
+  convert_toml_to_parameter_store(toml_path, store_path);
+
+  const std::vector<std::string> components_ =
+      parameter_components<BoundParameters>();
+  ASSERT_EQ(components_.size(), 3u);
+  EXPECT_EQ(components_[0], component);
+
+  for (const ghc::filesystem::path &path_ : {toml_path, store_path}) {
+    const BoundParameters parameters_ =
+        load_parameters<BoundParameters>(path_);
+    EXPECT_EQ(parameters_.estimate, p_estimate);
+    EXPECT_EQ(parameters_.count, 12);
+    EXPECT_EQ(parameters_.delay,
+              Distribution(distribution, mu, sigma, "Test_Distribution"));
+  }
+
+  // Missing component
+  const ghc::filesystem::path missing_path =
+      temp_ / "test_bindings_missing.toml";
+  write_point_estimates(
+      std::vector<std::string>{component, "Test_Count"},
+      std::vector<double>{p_estimate, 3.0}, missing_path);
+  BoundParameters parameters_;
+  EXPECT_THROW(bind_parameters(missing_path, parameters_), toml_error);
+
+  // Non-integer value for an integer member
+  const ghc::filesystem::path bad_path = temp_ / "test_bindings_bad.toml";
+  write_point_estimates(
+      std::vector<std::string>{component, "Test_Count"},
+      std::vector<double>{p_estimate, 1.5}, bad_path);
+  EXPECT_THROW(bind_parameters(bad_path, parameters_), validation_error);
+
+  // 2^63 is the first double above the range of a 64 bit member, the
+  // double just below it still binds exactly
+  const ghc::filesystem::path wide_path = temp_ / "test_bindings_wide.toml";
+  WideParameters wide_;
+  write_point_estimates(std::vector<std::string>{"Test_Total"},
+                        std::vector<double>{9223372036854775808.0}, wide_path);
+  EXPECT_THROW(bind_parameters(wide_path, wide_), validation_error);
+  write_point_estimates(std::vector<std::string>{"Test_Total"},
+                        std::vector<double>{9223372036854774784.0}, wide_path);
+  bind_parameters(wide_path, wide_);
+  EXPECT_EQ(wide_.total, INT64_C(9223372036854774784));
+}
+
+TEST_F(IOTest, TestSharedParameterCache) {
+  const ghc::filesystem::path temp_ =
+      ghc::filesystem::path(TESTDIR) / "data" / "temp";
+  const ghc::filesystem::path cache_dir = temp_ / "parameter_cache";
+  const ghc::filesystem::path toml_path = temp_ / "test_shared.toml";
+  {
+    TomlWriter::sptr writer_ = TomlWriter::construct(toml_path);
+    write_point_estimate(p_estimate, component, *writer_);
+    Distribution(distribution, mu, sigma, "Test_Distribution")
+        .write_to_toml(*writer_);
+  }
+
+#ifndef _WIN32
+  // Replicas build the store once and map it
+  std::vector<pid_t> replicas_;
+  for (int i = 0; i < 4; ++i) {
+    const pid_t pid_ = fork();
+    ASSERT_GE(pid_, 0);
+    if (pid_ == 0) {
+      int status_ = 1;
+      try {
+        SharedParameterCache::enable(cache_dir);
+        if (read_point_estimate_from_toml(toml_path, component) ==
+            p_estimate) {
+          status_ = 0;
+        }
+      } catch (...) {
+      }
+      _exit(status_);
+    }
+    replicas_.push_back(pid_);
+  }
+  for (pid_t pid_ : replicas_) {
+    int status_ = -1;
+    waitpid(pid_, &status_, 0);
+    EXPECT_TRUE(WIFEXITED(status_) && WEXITSTATUS(status_) == 0);
+  }
+#endif
+
+  SharedParameterCache::enable(cache_dir);
+  const SharedParameterCache::sptr cache_ = SharedParameterCache::get_cache();
+  ASSERT_TRUE(cache_);
+  const ghc::filesystem::path store_path =
+      cache_dir / (calculate_hash_from_file(toml_path) + ".fdpp");
+  EXPECT_EQ(read_point_estimate_from_toml(toml_path, component), p_estimate);
+  EXPECT_TRUE(ghc::filesystem::exists(store_path));
+  EXPECT_EQ(Distribution(toml_path.string(), "Test_Distribution"),
+            Distribution(distribution, mu, sigma, "Test_Distribution"));
+  EXPECT_THROW(read_point_estimate_from_toml(toml_path, "Missing"),
+               toml_error);
+
+  // Changing the file gives it a new store, and the old store is kept for
+  // a copy which still has the old contents
+  const ghc::filesystem::path copy_path = temp_ / "test_shared_copy.toml";
+  ghc::filesystem::copy_file(toml_path, copy_path,
+                             ghc::filesystem::copy_options::overwrite_existing);
+  write_point_estimate(p_estimate_2, component_2, toml_path);
+  EXPECT_EQ(read_point_estimate_from_toml(toml_path, component_2),
+            p_estimate_2);
+  EXPECT_TRUE(ghc::filesystem::exists(
+      cache_dir / (calculate_hash_from_file(toml_path) + ".fdpp")));
+  EXPECT_TRUE(ghc::filesystem::exists(store_path));
+  EXPECT_EQ(read_point_estimate_from_toml(copy_path, component), p_estimate);
+
+  // Files with other components are read as TOML
+  const ghc::filesystem::path other_path = temp_ / "test_shared_other.toml";
+  write_point_estimate(p_estimate, component, other_path);
+  TomlWriter::construct(other_path)
+      ->add_parameter("samples", "Test_Samples", 1.0);
+  EXPECT_EQ(read_point_estimate_from_toml(other_path, component), p_estimate);
+  EXPECT_FALSE(cache_->open(other_path));
+
+  EXPECT_GT(cache_->clear(), 0u);
+  SharedParameterCache::disable();
+  EXPECT_FALSE(SharedParameterCache::get_cache());
+  EXPECT_EQ(read_point_estimate_from_toml(toml_path, component), p_estimate);
+
+#ifndef _WIN32
+  // A directory other users can write to, or a symlink, is refused
+  const ghc::filesystem::path open_dir = temp_ / "parameter_cache_open";
+  ghc::filesystem::create_directories(open_dir);
+  ghc::filesystem::permissions(open_dir, ghc::filesystem::perms::all);
+  EXPECT_THROW(SharedParameterCache::construct(open_dir),
+               parameter_store_error);
+  const ghc::filesystem::path link_dir = temp_ / "parameter_cache_link";
+  ghc::filesystem::remove(link_dir);
+  ghc::filesystem::create_directory_symlink(cache_dir, link_dir);
+  EXPECT_THROW(SharedParameterCache::construct(link_dir),
+               parameter_store_error);
+  ghc::filesystem::remove(link_dir);
+  ghc::filesystem::remove_all(open_dir);
+#endif
+}
+
+TEST_F(IOTest, TestArrayNative) {
+  const ghc::filesystem::path temp_ =
+      ghc::filesystem::path(TESTDIR) / "data" / "temp";
+  ghc::filesystem::create_directories(temp_);
+  const std::vector<std::uint64_t> shape = {7, 5, 6};
+  std::vector<double> data(7 * 5 * 6);
+  for (std::size_t i = 0; i < data.size(); ++i) {
+    data[i] = 0.5 * static_cast<double>(i % 11);
+  }
+
+  std::vector<ArrayCodec> codecs_ = {ArrayCodec::NONE};
+  if (default_array_codec() != ArrayCodec::NONE) {
+    codecs_.push_back(default_array_codec());
+  }
+  for (ArrayCodec codec_ : codecs_) {
+    const ghc::filesystem::path array_path =
+        temp_ / ("test_array_" + to_string(codec_) + ".fdpa");
+    ArrayOptions options_;
+    options_.chunk_shape = {3, 2, 4};
+    options_.codec = codec_;
+    options_.n_threads = 3;
+    const std::string hash_ =
+        write_array(array_path, "grid/values", data, shape, options_);
+    EXPECT_EQ(hash_, calculate_hash_from_file(array_path));
+
+    const ArrayReader::sptr reader_ =
+        ArrayReader::open(array_path, "grid/values", 2);
+    EXPECT_EQ(reader_->get_type(), ArrayType::FLOAT64);
+    EXPECT_EQ(reader_->get_shape(), shape);
+    EXPECT_EQ(reader_->get_chunk_shape(), options_.chunk_shape);
+    EXPECT_EQ(reader_->read<double>(), data);
+
+    // A slab crossing chunk boundaries
+    const std::vector<double> slab_ =
+        reader_->read_slab<double>({2, 1, 3}, {4, 3, 2});
+    ASSERT_EQ(slab_.size(), 24u);
+    for (std::uint64_t i = 0; i < 4; ++i) {
+      for (std::uint64_t j = 0; j < 3; ++j) {
+        for (std::uint64_t k = 0; k < 2; ++k) {
+          EXPECT_EQ(slab_[(i * 3 + j) * 2 + k],
+                    data[((i + 2) * 5 + j + 1) * 6 + k + 3]);
+        }
+      }
+    }
+
+    EXPECT_THROW(reader_->read<float>(), array_error);
+    EXPECT_THROW(reader_->read_slab<double>({6, 0, 0}, {2, 1, 1}),
+                 array_error);
+    EXPECT_THROW(ArrayReader::open(array_path, "other"), array_error);
+    EXPECT_THROW(write_array(array_path, "grid/values", data, shape),
+                 array_error);
+  }
+
+  std::vector<std::uint64_t> read_shape_;
+  const std::vector<std::int32_t> counts = {1, 2, 3, 4, 5, 6};
+  write_array(temp_ / "test_counts.fdpa", "counts", counts, {2, 3});
+  EXPECT_EQ(read_array<std::int32_t>(temp_ / "test_counts.fdpa", "counts",
+                                     read_shape_),
+            counts);
+  EXPECT_EQ(read_shape_, std::vector<std::uint64_t>({2, 3}));
+  EXPECT_THROW(write_array(temp_ / "test_bad.fdpa", "counts", counts, {4, 2}),
+               array_error);
+  ArrayOptions chunked_;
+  chunked_.chunk_shape = {2, 4};
+  EXPECT_THROW(
+      write_array(temp_ / "test_bad.fdpa", "counts", counts, {2, 3}, chunked_),
+      array_error);
+
+  // Corrupt rank and chunk shapes in the header are rejected, the rank is
+  // at offset 24 and the chunk shape follows the shape from offset 64
+  const auto corrupt_ = [&](std::streamoff offset, const void *bytes,
+                            std::size_t size) {
+    const ghc::filesystem::path corrupt_path = temp_ / "test_corrupt.fdpa";
+    ghc::filesystem::copy_file(
+        temp_ / "test_counts.fdpa", corrupt_path,
+        ghc::filesystem::copy_options::overwrite_existing);
+    std::fstream file_(corrupt_path.string(), std::ios_base::in |
+                                                  std::ios_base::out |
+                                                  std::ios_base::binary);
+    file_.seekp(offset);
+    file_.write(static_cast<const char *>(bytes), size);
+    file_.close();
+    return corrupt_path;
+  };
+  const std::uint32_t large_rank_ = 0x10000000;
+  EXPECT_THROW(ArrayReader::open(corrupt_(24, &large_rank_, 4), "counts"),
+               array_error);
+  const std::uint64_t zero_chunk_[] = {0, 3};
+  EXPECT_THROW(ArrayReader::open(corrupt_(80, zero_chunk_, 16), "counts"),
+               array_error);
+  const std::uint64_t large_chunk_[] = {2, 4};
+  EXPECT_THROW(ArrayReader::open(corrupt_(80, large_chunk_, 16), "counts"),
+               array_error);
+  EXPECT_THROW(ArrayReader::open(test_distribution_toml, "counts"),
+               array_error);
+}
+
+TEST_F(IOTest, TestArrayHdf5) {
+  if (!array_hdf5_available()) {
+    return;
+  }
+  const ghc::filesystem::path fixture_ =
+      ghc::filesystem::path(TESTDIR) / "data" / "test_array.h5";
+  const ArrayReader::sptr home_ =
+      ArrayReader::open(fixture_, "contact_matrices/home");
+  ASSERT_EQ(home_->get_shape().size(), 2u);
+  const std::vector<double> matrix_ = home_->read<double>();
+  EXPECT_EQ(matrix_.size(), home_->size());
+  const std::vector<double> row_ =
+      home_->read_slab<double>({1, 0}, {1, home_->get_shape()[1]});
+  EXPECT_TRUE(std::equal(row_.begin(), row_.end(),
+                         matrix_.begin() + home_->get_shape()[1]));
+  EXPECT_THROW(ArrayReader::open(fixture_, "contact_matrices/missing"),
+               array_error);
+
+  const ghc::filesystem::path temp_ =
+      ghc::filesystem::path(TESTDIR) / "data" / "temp";
+  ghc::filesystem::create_directories(temp_);
+  const ghc::filesystem::path array_path = temp_ / "test_array.h5";
+  const std::vector<std::uint64_t> shape = {9, 4};
+  std::vector<float> data(36);
+  for (std::size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<float>(i % 5);
+  }
+  ArrayOptions options_;
+  options_.chunk_shape = {4, 4};
+  const std::string hash_ =
+      write_array(array_path, "outputs/prevalence", data, shape, options_);
+  EXPECT_EQ(hash_, calculate_hash_from_file(array_path));
+  write_array(array_path, "outputs/incidence", data, shape, options_);
+  EXPECT_THROW(write_array(array_path, "outputs/incidence", data, shape),
+               array_error);
+
+  const ArrayReader::sptr reader_ =
+      ArrayReader::open(array_path, "outputs/prevalence");
+  EXPECT_EQ(reader_->get_type(), ArrayType::FLOAT32);
+  EXPECT_EQ(reader_->get_chunk_shape(), options_.chunk_shape);
+  EXPECT_EQ(reader_->read<float>(), data);
+  EXPECT_EQ(reader_->read_slab<float>({7, 1}, {2, 2}),
+            std::vector<float>({data[29], data[30], data[33], data[34]}));
+}
+
+TEST_F(IOTest, TestArrowTable) {
+  const ghc::filesystem::path temp_ =
+      ghc::filesystem::path(TESTDIR) / "data" / "temp";
+  ghc::filesystem::create_directories(temp_);
+  const ghc::filesystem::path table_path =
+      temp_ / (std::string("test_table.") + ArrowTable::file_type);
+
+  const std::vector<std::int64_t> days = {1, 2, 3};
+  const std::vector<std::string> regions = {"north", "", "mid, \"west\""};
+  const std::vector<std::int32_t> cases = {10, -20, 30};
+  const std::vector<double> rates = {0.5, 1e300, -2.25};
+  ArrowWriter::sptr writer_ = ArrowWriter::construct(
+      table_path, {{"day", ArrowType::INT64},
+                   {"region", ArrowType::STRING},
+                   {"cases", ArrowType::INT32},
+                   {"rate", ArrowType::FLOAT64}},
+      4);
+  writer_->write_batch({days, regions, cases, rates});
+  EXPECT_THROW(writer_->write_batch({days, regions, rates, rates}),
+               arrow_error);
+  EXPECT_THROW(writer_->write_row(4, "east", 1), arrow_error);
+  EXPECT_THROW(writer_->write_row(4, 5, 1, 0.5), arrow_error);
+  for (int i = 0; i < 6; ++i) {
+    writer_->write_row(10 + i, "row " + std::to_string(i), i, 0.25 * i);
+  }
+  const std::string hash_ = writer_->close();
+  EXPECT_EQ(hash_, calculate_hash_from_file(table_path));
+  EXPECT_EQ(writer_->n_rows(), 9u);
+  EXPECT_EQ(writer_->n_batches(), 3u);
+
+  const ArrowTable::sptr table_ = ArrowTable::open(table_path);
+  ASSERT_EQ(table_->n_columns(), 4u);
+  EXPECT_EQ(table_->n_rows(), 9u);
+  ASSERT_EQ(table_->n_batches(), 3u);
+  EXPECT_EQ(table_->batch_rows(1), 4u);
+  EXPECT_EQ(table_->get_schema()[1].name, "region");
+  EXPECT_EQ(table_->get_schema()[2].type, ArrowType::INT32);
+  EXPECT_EQ(table_->column_index("rate"), 3u);
+  EXPECT_THROW(table_->column_index("missing"), arrow_error);
+
+  const double *rates_ = table_->values<double>(0, 3);
+  EXPECT_EQ(std::vector<double>(rates_, rates_ + 3), rates);
+  EXPECT_EQ(table_->null_count(0, 3), 0u);
+  EXPECT_TRUE(table_->is_valid(0, 1, 1));
+  EXPECT_EQ(table_->get_string(0, 1, 2), regions[2]);
+  EXPECT_EQ(table_->string_offsets(0, 1)[3], 16);
+  const std::vector<std::int64_t> days_ = table_->read_column<std::int64_t>(0);
+  EXPECT_EQ(days_, std::vector<std::int64_t>(
+                       {1, 2, 3, 10, 11, 12, 13, 14, 15}));
+  const std::vector<std::string> regions_ = table_->read_strings(1);
+  EXPECT_EQ(regions_[1], "");
+  EXPECT_EQ(regions_[8], "row 5");
+  EXPECT_EQ(table_->read_column<std::int32_t>(2)[8], 5);
+  EXPECT_THROW(table_->values<float>(0, 3), arrow_error);
+  EXPECT_THROW(table_->batch_rows(3), arrow_error);
+  EXPECT_THROW(ArrowTable::open(test_distribution_toml), arrow_error);
+  EXPECT_THROW(ArrowTable::open(temp_ / "missing.arrow"), arrow_error);
+
+  // Written by pyarrow, with nulls, in two batches
+  const ArrowTable::sptr fixture_ = ArrowTable::open(
+      ghc::filesystem::path(TESTDIR) / "data" / "test_table.arrow");
+  EXPECT_EQ(fixture_->n_rows(), 5u);
+  ASSERT_EQ(fixture_->n_batches(), 2u);
+  EXPECT_EQ(fixture_->get_schema()[4].type, ArrowType::FLOAT32);
+  EXPECT_EQ(fixture_->null_count(0, 0), 1u);
+  EXPECT_FALSE(fixture_->is_valid(0, 0, 2));
+  EXPECT_FALSE(fixture_->is_valid(0, 3, 1));
+  EXPECT_TRUE(fixture_->is_valid(1, 1, 1));
+  EXPECT_EQ(fixture_->read_strings(1),
+            std::vector<std::string>(
+                {"north", "", "east", "west", "mid, west"}));
+  EXPECT_EQ(fixture_->values<std::int32_t>(1, 2)[1], 50);
+  EXPECT_EQ(fixture_->values<double>(1, 3)[0], 2.5);
+
+  // Unsigned values beyond int64 only fit floating point columns
+  const std::uint64_t large_unsigned =
+      std::numeric_limits<std::uint64_t>::max();
+  ArrowWriter::sptr unsigned_ = ArrowWriter::construct(
+      temp_ / "test_unsigned.arrow",
+      {{"count", ArrowType::INT64}, {"value", ArrowType::FLOAT64}});
+  EXPECT_THROW(unsigned_->write_row(large_unsigned, 1.0), arrow_error);
+  unsigned_->write_row(std::uint64_t(5), large_unsigned);
+  unsigned_->close();
+  const ArrowTable::sptr unsigned_table_ =
+      ArrowTable::open(temp_ / "test_unsigned.arrow");
+  EXPECT_EQ(unsigned_table_->read_column<std::int64_t>(0),
+            std::vector<std::int64_t>({5}));
+  EXPECT_EQ(unsigned_table_->read_column<double>(1)[0],
+            static_cast<double>(large_unsigned));
+}
@@ -2,9 +2,18 @@
 #define TESTDIR ""
 #endif
 
+#include <atomic>
 #include <iostream>
 #include <fstream>
+#include <thread>
+#include <vector>
 
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "fdp/exceptions.hxx"
 #include "fdp/fdp.hxx"
 #include "fdp/objects/metadata.hxx"
 #include "fdp/utilities/logging.hxx"
@@ -64,3 +73,161 @@ TEST_F(PimplTest, TestDataPipelineInit) {
   dp->finalise();
 
 }
+
+TEST_F(PimplTest, TestDataPipelineConcurrentLinks) {
+  const ghc::filesystem::path config_path_ =
+      ghc::filesystem::path(TESTDIR) / "data" / "read_write_csv.yaml";
+  const ghc::filesystem::path script_path_ =
+      ghc::filesystem::path(TESTDIR) / "test_script.sh";
+  DataPipeline::sptr dp = DataPipeline::construct(config_path_.string(), script_path_.string(), token );
+
+  const int n_threads_ = 64;
+  std::atomic<int> failures_(0);
+  std::vector<std::string> paths_(n_threads_);
+  std::vector<std::thread> threads_;
+
+  for (int i = 0; i < n_threads_; ++i) {
+    threads_.emplace_back([&, i]() {
+      try {
+        if (i % 2 == 0) {
+          std::string data_product = i % 4 == 0 ? "test/threads/a" : "test/threads/b";
+          paths_[i] = dp->link_write(data_product);
+          std::ofstream out_(paths_[i]);
+          out_ << "thread," << i;
+        }
+        else {
+          std::string data_product = "test/csv";
+          paths_[i] = dp->link_read(data_product);
+        }
+      }
+      catch (...) {
+        ++failures_;
+      }
+    });
+  }
+  for (auto &thread_ : threads_) {
+    thread_.join();
+  }
+
+  EXPECT_EQ(failures_, 0);
+  for (int i = 0; i < n_threads_; ++i) {
+    EXPECT_GT(paths_[i].size(), 1);
+    // Every read resolves to the same product, every write gets its own path
+    if (i % 2 == 1) {
+      EXPECT_EQ(paths_[i], paths_[1]);
+    }
+    else if (i > 0) {
+      EXPECT_NE(paths_[i], paths_[0]);
+    }
+  }
+
+  dp->finalise();
+}
+
+TEST_F(PimplTest, TestDataPipelineLinkMany) {
+  const ghc::filesystem::path config_path_ =
+      ghc::filesystem::path(TESTDIR) / "data" / "read_write_csv.yaml";
+  const ghc::filesystem::path script_path_ =
+      ghc::filesystem::path(TESTDIR) / "test_script.sh";
+  DataPipeline::sptr dp = DataPipeline::construct(config_path_.string(), script_path_.string(), token );
+
+  const std::vector<std::string> writes_ = {"test/threads/a", "test/threads/b"};
+  const std::vector<std::string> paths_ = dp->link_write_many(writes_);
+  ASSERT_EQ(paths_.size(), 2);
+  EXPECT_NE(paths_[0], paths_[1]);
+  for (const std::string &path_ : paths_) {
+    std::ofstream out_(path_);
+    out_ << "batch";
+  }
+
+  std::vector<std::exception_ptr> errors_;
+  const std::vector<std::string> reads_ =
+      dp->link_read_many({"test/csv", "test/missing", "test/csv"}, &errors_);
+  ASSERT_EQ(errors_.size(), 3);
+  EXPECT_FALSE(errors_[0]);
+  EXPECT_TRUE(errors_[1]);
+  EXPECT_TRUE(reads_[1].empty());
+  EXPECT_EQ(reads_[0], reads_[2]);
+
+  // Without an error vector the first failure is thrown
+  EXPECT_THROW(dp->link_read_many({"test/missing"}), config_parsing_error);
+
+  dp->finalise();
+}
+
+TEST_F(PimplTest, TestPipelineContextSessions) {
+  const ghc::filesystem::path config_path_ =
+      ghc::filesystem::path(TESTDIR) / "data" / "write_csv.yaml";
+  const ghc::filesystem::path script_path_ =
+      ghc::filesystem::path(TESTDIR) / "test_script.sh";
+  PipelineContext::sptr context_ = PipelineContext::construct(config_path_.string(), script_path_.string(), token );
+
+  std::vector<std::string> paths_;
+  for (int i = 0; i < 3; ++i) {
+    DataPipeline::sptr dp = context_->create_session();
+    std::string data_product = "test/csv";
+    paths_.push_back(dp->link_write(data_product));
+
+    std::ofstream testCSV(paths_.back());
+    testCSV << "session," << i;
+    testCSV.close();
+
+    dp->finalise();
+    EXPECT_FALSE(ghc::filesystem::exists(paths_.back()));
+  }
+
+  EXPECT_NE(paths_[0], paths_[1]);
+  EXPECT_NE(paths_[1], paths_[2]);
+}
+
+#ifndef _WIN32
+TEST_F(PimplTest, TestDataPipelineSharedSession) {
+  const ghc::filesystem::path config_path_ =
+      ghc::filesystem::path(TESTDIR) / "data" / "write_csv.yaml";
+  const ghc::filesystem::path script_path_ =
+      ghc::filesystem::path(TESTDIR) / "test_script.sh";
+  const std::string session_id_ = "pimpl-" + std::to_string(getpid());
+  const int n_ranks_ = 4;
+
+  // Each rank writes one shard of a directory product and one csv product
+  const auto run_rank_ = [&](int rank_) {
+    DataPipeline::sptr dp = DataPipeline::construct_shared(config_path_.string(),
+        script_path_.string(), token, rank_, n_ranks_, session_id_);
+    std::string shards_product_ = "test/shards";
+    const std::string shards_ = dp->link_write(shards_product_);
+    std::ofstream shard_((ghc::filesystem::path(shards_) /
+        ("rank_" + std::to_string(rank_) + ".csv")).string());
+    shard_ << "rank," << rank_;
+    shard_.close();
+    return std::make_pair(dp, shards_);
+  };
+
+  std::vector<pid_t> workers_;
+  for (int rank_ = 1; rank_ < n_ranks_; ++rank_) {
+    const pid_t pid_ = fork();
+    ASSERT_GE(pid_, 0);
+    if (pid_ == 0) {
+      int status_ = 1;
+      try {
+        run_rank_(rank_).first->finalise();
+        status_ = 0;
+      } catch (...) {
+      }
+      _exit(status_);
+    }
+    workers_.push_back(pid_);
+  }
+
+  auto leader_ = run_rank_(0);
+  leader_.first->finalise();
+
+  for (pid_t pid_ : workers_) {
+    int status_ = -1;
+    waitpid(pid_, &status_, 0);
+    EXPECT_TRUE(WIFEXITED(status_) && WEXITSTATUS(status_) == 0);
+  }
+
+  // All shards were moved into the product as a single directory
+  EXPECT_FALSE(ghc::filesystem::exists(leader_.second));
+}
+#endif
@@ -5,10 +5,35 @@
 #include "fdp/utilities/json.hxx"
 #include "fdp/utilities/semver.hxx"
 #include "fdp/objects/metadata.hxx"
+#include "fdp/objects/product_table.hxx"
+#include "fdp/utilities/csv_table.hxx"
+#include "fdp/utilities/data_store.hxx"
+#include "fdp/utilities/hash_cache.hxx"
+#include "fdp/utilities/journal.hxx"
+#include "fdp/utilities/logging.hxx"
+#include "fdp/utilities/parallel.hxx"
+#include "fdp/utilities/path_allocator.hxx"
+#include "fdp/utilities/philox.hxx"
+#include "fdp/utilities/sampling.hxx"
+#include "fdp/utilities/sharded_map.hxx"
+#include "fdp/utilities/shared_session.hxx"
 #include "gtest/gtest.h"
 
 #include "json/reader.h"
 
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 using namespace FairDataPipeline;
 
 TEST(FDPAPITest, TestSemVerComparisons) {
@@ -53,4 +78,731 @@ TEST(FDAPITest, TestRandomHash) {
 
 TEST(FDAPITest, TestRemoveLocalFromRoot) {
   ASSERT_EQ(remove_local_from_root(std::string("file://test")), "test");
-}
\ No newline at end of file
+}
+
+TEST(FDAPITest, TestHashCache) {
+  const ghc::filesystem::path temp_dir_ =
+      ghc::filesystem::path(TESTDIR) / "data" / "temp_hash_cache";
+  ghc::filesystem::create_directories(temp_dir_);
+  const ghc::filesystem::path file_ = temp_dir_ / "hashed.txt";
+  {
+    std::ofstream out_(file_.string());
+    out_ << "Test";
+  }
+
+  HashCache::sptr cache_ =
+      HashCache::construct(temp_dir_ / ".fdp" / "hash_cache");
+  HashCache::key_type key_;
+  std::string hash_;
+
+  if (HashCache::get_key(file_, key_)) {
+    EXPECT_FALSE(cache_->lookup(file_, "test", hash_));
+    cache_->store(file_, "test", key_, "cached");
+    ASSERT_TRUE(cache_->lookup(file_, "test", hash_));
+    EXPECT_EQ(hash_, "cached");
+
+    // Changing the file size invalidates the entry
+    {
+      std::ofstream out_(file_.string(), std::ios_base::app);
+      out_ << "More";
+    }
+    EXPECT_FALSE(cache_->lookup(file_, "test", hash_));
+
+    // Strict mode never serves cached digests
+    ASSERT_TRUE(HashCache::get_key(file_, key_));
+    cache_->store(file_, "test", key_, "cached");
+    cache_->set_strict(true);
+    EXPECT_FALSE(cache_->lookup(file_, "test", hash_));
+  }
+
+#ifndef _WIN32
+  // FDP_STRICT_HASH is parsed rather than only tested for presence
+  bool strict_ = true;
+  unsetenv("FDP_STRICT_HASH");
+  EXPECT_FALSE(HashCache::strict_from_environment(strict_));
+  EXPECT_TRUE(strict_);
+  for (const char *off_ : {"", "0", "false"}) {
+    setenv("FDP_STRICT_HASH", off_, 1);
+    EXPECT_TRUE(HashCache::strict_from_environment(strict_));
+    EXPECT_FALSE(strict_);
+  }
+  setenv("FDP_STRICT_HASH", "1", 1);
+  EXPECT_TRUE(HashCache::strict_from_environment(strict_));
+  EXPECT_TRUE(strict_);
+  unsetenv("FDP_STRICT_HASH");
+#endif
+
+  ghc::filesystem::remove_all(temp_dir_);
+}
+
+TEST(FDAPITest, TestTreeHash) {
+  const ghc::filesystem::path temp_dir_ =
+      ghc::filesystem::path(TESTDIR) / "data" / "temp_tree_hash";
+  ghc::filesystem::create_directories(temp_dir_);
+  const ghc::filesystem::path file_ = temp_dir_ / "large.dat";
+  {
+    std::ofstream out_(file_.string(), std::ios_base::binary);
+    for (int i = 0; i < 100000; ++i) {
+      out_ << i << ",";
+    }
+  }
+
+  // Strict mode is process wide, so restore it for the tests that follow
+  const bool strict_ = HashCache::get_cache()->is_strict();
+  HashCache::get_cache()->set_strict(true);
+
+  // The root must not depend on the number of threads used
+  const std::string single_ = calculate_tree_hash_from_file(file_, 1, 4096);
+  EXPECT_EQ(single_, calculate_tree_hash_from_file(file_, 4, 4096));
+  EXPECT_EQ(single_, calculate_tree_hash_from_file(file_, 64, 4096));
+  EXPECT_NE(single_, calculate_tree_hash_from_file(file_, 1, 8192));
+  EXPECT_NE(single_, calculate_hash_from_file(file_));
+
+  HashCache::get_cache()->set_strict(strict_);
+  ghc::filesystem::remove_all(temp_dir_);
+}
+
+TEST(FDAPITest, TestDirectoryHash) {
+  const ghc::filesystem::path temp_dir_ =
+      ghc::filesystem::path(TESTDIR) / "data" / "temp_directory_hash";
+  const ghc::filesystem::path shards_ = temp_dir_ / "shards";
+  ghc::filesystem::create_directories(shards_ / "nested");
+  for (int rank = 0; rank < 8; ++rank) {
+    std::ofstream out_((shards_ / ("rank_" + std::to_string(rank) + ".csv")).string());
+    out_ << "rank," << rank;
+  }
+  {
+    std::ofstream out_((shards_ / "nested" / "summary.csv").string());
+    out_ << "summary";
+  }
+
+  const std::string root_ = calculate_directory_hash(shards_, 1);
+  EXPECT_EQ(root_, calculate_directory_hash(shards_, 8));
+
+  // Renaming a shard changes the root even though contents are unchanged
+  ghc::filesystem::rename(shards_ / "rank_0.csv", shards_ / "rank_00.csv");
+  EXPECT_NE(root_, calculate_directory_hash(shards_, 4));
+
+  // Tree leaves give a SHA-256 root rather than a SHA1 one
+  const std::string tree_root_ =
+      calculate_directory_hash(shards_, 4, nullptr, "sha256-tree");
+  EXPECT_EQ(root_.size(), 40);
+  EXPECT_EQ(tree_root_.size(), 64);
+  EXPECT_EQ(tree_root_,
+            calculate_directory_hash(shards_, 1, nullptr, "sha256-tree"));
+  EXPECT_THROW(calculate_directory_hash(shards_, 1, nullptr, "md5"),
+               std::invalid_argument);
+
+  ghc::filesystem::remove_all(temp_dir_);
+}
+
+TEST(FDAPITest, TestDataStoreDeduplication) {
+  const ghc::filesystem::path root_ =
+      ghc::filesystem::path(TESTDIR) / "data" / "temp_data_store";
+  ghc::filesystem::create_directories(root_);
+  DataStore::sptr store_ = DataStore::construct(root_);
+
+  const std::vector<std::string> products_{"first", "second"};
+  std::string hash_;
+  for (const auto &product : products_) {
+    const ghc::filesystem::path tmp_ = root_ / ("dat-" + product + ".csv");
+    {
+      std::ofstream out_(tmp_.string());
+      out_ << "identical,content";
+    }
+    hash_ = calculate_hash_from_file(tmp_);
+    const ghc::filesystem::path target_ =
+        root_ / "testing" / product / (hash_ + ".csv");
+    store_->commit(tmp_, hash_, target_);
+
+    EXPECT_FALSE(ghc::filesystem::exists(tmp_));
+    ASSERT_TRUE(ghc::filesystem::exists(target_));
+    EXPECT_EQ(calculate_hash_from_file(target_), hash_);
+  }
+
+  // Both products share a single blob
+  std::size_t n_blobs_ = 0;
+  for (ghc::filesystem::recursive_directory_iterator it(store_->get_blob_root()), end;
+       it != end; ++it) {
+    if (ghc::filesystem::is_regular_file(it->path())) {
+      ++n_blobs_;
+    }
+  }
+  EXPECT_EQ(n_blobs_, 1);
+  EXPECT_TRUE(ghc::filesystem::exists(store_->blob_path(hash_, ".csv")));
+
+  ghc::filesystem::remove_all(root_);
+}
+
+TEST(FDAPITest, TestJournalReplay) {
+  const ghc::filesystem::path journal_path_ =
+      ghc::filesystem::path(TESTDIR) / "data" / "temp_journal" / "run.jsonl";
+  ghc::filesystem::remove_all(journal_path_.parent_path());
+
+  {
+    Journal::sptr journal_ = Journal::open(journal_path_);
+    EXPECT_TRUE(journal_->replayed().empty());
+
+    Json::Value first_;
+    first_["data_product"] = "test/csv";
+    journal_->record("link_write", first_);
+    Json::Value second_;
+    second_["data_product"] = "test/shards";
+    journal_->record("link_write", second_);
+  }
+
+  // Simulate a crash part way through writing the next record
+  {
+    std::ofstream out_(journal_path_.string(), std::ios_base::app);
+    out_ << "{\"step\":\"stored\",\"da";
+  }
+
+  {
+    Journal::sptr journal_ = Journal::open(journal_path_);
+    ASSERT_EQ(journal_->replayed().size(), 2);
+    EXPECT_EQ(journal_->find_last("link_write")["data_product"].asString(),
+              "test/shards");
+    EXPECT_TRUE(journal_->find_last("stored").isNull());
+
+    // The torn record is cut before the next one is appended
+    Json::Value stored_;
+    stored_["data_product"] = "test/csv";
+    journal_->record("stored", stored_);
+  }
+
+  Journal::sptr journal_ = Journal::open(journal_path_);
+  ASSERT_EQ(journal_->replayed().size(), 3);
+  EXPECT_EQ(journal_->find_last("stored")["data_product"].asString(),
+            "test/csv");
+
+  // An open journal belongs to one session
+  EXPECT_FALSE(Journal::try_open(journal_path_));
+  EXPECT_THROW(Journal::open(journal_path_), write_error);
+
+  journal_->complete();
+  EXPECT_FALSE(ghc::filesystem::exists(journal_path_));
+
+  ghc::filesystem::remove_all(journal_path_.parent_path());
+}
+
+TEST(FDAPITest, TestShardedMapConcurrentAccess) {
+  ShardedMap<std::string> map_;
+  const int n_threads_ = 64;
+  const int n_keys_ = 200;
+  std::vector<logger::logger_sptr> loggers_(n_threads_);
+  std::vector<std::thread> threads_;
+
+  for (int t = 0; t < n_threads_; ++t) {
+    threads_.emplace_back([&, t]() {
+      loggers_[t] = logger::get_logger();
+      for (int k = 0; k < n_keys_; ++k) {
+        const std::string key_ =
+            "thread/" + std::to_string(t) + "/" + std::to_string(k);
+        map_.insert_or_assign(key_, key_);
+        std::string value_;
+        if (!map_.find(key_, value_) || value_ != key_) {
+          ADD_FAILURE() << "Lost entry " << key_;
+        }
+        // Every thread also contends on a shared key
+        map_.insert_or_assign("shared", key_);
+        if (k % 2 == 1) {
+          map_.erase(key_);
+        }
+      }
+    });
+  }
+  for (auto &thread_ : threads_) {
+    thread_.join();
+  }
+
+  EXPECT_EQ(map_.size(), n_threads_ * n_keys_ / 2 + 1);
+  EXPECT_TRUE(map_.contains("shared"));
+  EXPECT_EQ(map_.snapshot().size(), map_.size());
+
+  // The logger is created exactly once regardless of which thread asks first
+  for (int t = 1; t < n_threads_; ++t) {
+    EXPECT_EQ(loggers_[t], loggers_[0]);
+  }
+}
+
+TEST(FDAPITest, TestThreadPool) {
+  ThreadPool::sptr pool_ = ThreadPool::construct(3);
+  EXPECT_EQ(pool_->size(), 3u);
+
+  // Every call reuses the same workers rather than starting its own
+  std::mutex ids_mutex_;
+  std::set<std::thread::id> ids_;
+  for (int call = 0; call < 20; ++call) {
+    parallel_for(64, 0, [&](std::size_t) {
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+      std::lock_guard<std::mutex> lock_(ids_mutex_);
+      ids_.insert(std::this_thread::get_id());
+    }, pool_.get());
+  }
+  EXPECT_LE(ids_.size(), 4u);
+  EXPECT_TRUE(ids_.count(std::this_thread::get_id()));
+
+  // Concurrent and nested calls share the workers without deadlocking
+  std::atomic<std::size_t> total_(0);
+  std::vector<std::thread> callers_;
+  for (int t = 0; t < 4; ++t) {
+    callers_.emplace_back([&]() {
+      pool_->parallel_for(8, 0, [&](std::size_t) {
+        pool_->parallel_for(8, 0, [&](std::size_t) { ++total_; });
+      });
+    });
+  }
+  for (auto &caller_ : callers_) {
+    caller_.join();
+  }
+  EXPECT_EQ(total_, 4u * 8u * 8u);
+
+  // The first exception reaches the caller and the pool stays usable
+  EXPECT_THROW(pool_->parallel_for(16, 0,
+                                   [](std::size_t i) {
+                                     if (i == 5) {
+                                       throw std::runtime_error("task");
+                                     }
+                                   }),
+               std::runtime_error);
+  total_ = 0;
+  pool_->parallel_for(100, 2, [&](std::size_t) { ++total_; });
+  EXPECT_EQ(total_, 100u);
+}
+
+TEST(FDAPITest, TestCsvTable) {
+  const ghc::filesystem::path temp_dir_ =
+      ghc::filesystem::path(TESTDIR) / "data" / "temp_csv";
+  ghc::filesystem::create_directories(temp_dir_);
+  const ghc::filesystem::path csv_path_ = temp_dir_ / "table.csv";
+
+  CsvWriter::sptr writer_ =
+      CsvWriter::construct(csv_path_, {"day", "region", "rate", "code"});
+  writer_->write_row(1, "north", 0.1, "007");
+  writer_->write_row(-2, "south, \"east\"", std::nan(""), "8");
+  writer_->write_row(3, "two\nlines", 2.0, "9");
+  EXPECT_THROW(writer_->write_row(4, "short"), csv_error);
+  const std::string hash_ = writer_->close();
+  EXPECT_EQ(hash_, calculate_hash_from_file(csv_path_));
+
+  CsvOptions options_;
+  options_.column_types["code"] = CsvType::STRING;
+  CsvTable::sptr table_ = CsvTable::read(csv_path_, options_);
+  ASSERT_EQ(table_->n_rows(), 3u);
+  EXPECT_EQ(table_->get_column_names(),
+            std::vector<std::string>({"day", "region", "rate", "code"}));
+  EXPECT_EQ(table_->get_int64(0), std::vector<std::int64_t>({1, -2, 3}));
+  EXPECT_EQ(table_->get_strings(1),
+            std::vector<std::string>({"north", "south, \"east\"",
+                                      "two\nlines"}));
+  const std::vector<double> &rate_ = table_->get_float64(2);
+  EXPECT_EQ(rate_[0], 0.1);
+  EXPECT_TRUE(std::isnan(rate_[1]));
+  EXPECT_EQ(rate_[2], 2.0);
+  EXPECT_EQ(table_->get_strings(table_->column_index("code"))[0], "007");
+  EXPECT_THROW(table_->get_float64(0), csv_error);
+  EXPECT_THROW(table_->column_index("missing"), csv_error);
+
+  // Doubles are written in the fewest digits which read back exactly
+  const std::vector<double> doubles_ = {-1.5131402663111935e-222, 1e300,
+                                        0.30000000000000004, 123456789.123,
+                                        -0.0, 7.0, 1.0 / 3.0};
+  {
+    CsvWriter::sptr doubles_writer_ =
+        CsvWriter::construct(temp_dir_ / "doubles.csv", {"x"});
+    for (double x_ : doubles_) {
+      doubles_writer_->write_row(x_);
+    }
+  }
+  EXPECT_EQ(CsvTable::read(temp_dir_ / "doubles.csv")->get_float64(0),
+            doubles_);
+  {
+    std::ifstream in_((temp_dir_ / "doubles.csv").string());
+    const std::string text_((std::istreambuf_iterator<char>(in_)),
+                            std::istreambuf_iterator<char>());
+    EXPECT_EQ(text_, "x\n-1.5131402663111935e-222\n1e+300\n"
+                     "0.30000000000000004\n123456789.123\n-0.0\n7.0\n"
+                     "0.3333333333333333\n");
+  }
+
+  // Empty fields in one column rows are quoted rather than read as empty
+  // lines, and unsigned values beyond int64 are written in full
+  const std::uint64_t large_unsigned_ =
+      std::numeric_limits<std::uint64_t>::max();
+  {
+    CsvWriter::sptr single_ =
+        CsvWriter::construct(temp_dir_ / "single.csv", {"x"});
+    single_->write_row(1.5).write_row(std::nan("")).write_row(2.0);
+    CsvWriter::sptr strings_writer_ =
+        CsvWriter::construct(temp_dir_ / "strings.csv", {"s"});
+    strings_writer_->write_row("a").write_row("").write_row("b");
+    CsvWriter::sptr unsigned_ =
+        CsvWriter::construct(temp_dir_ / "unsigned.csv", {"n"});
+    unsigned_->write_row(large_unsigned_);
+  }
+  const std::vector<double> single_read_ =
+      CsvTable::read(temp_dir_ / "single.csv")->get_float64(0);
+  ASSERT_EQ(single_read_.size(), 3u);
+  EXPECT_TRUE(std::isnan(single_read_[1]));
+  CsvOptions strings_options_;
+  strings_options_.column_types["s"] = CsvType::STRING;
+  EXPECT_EQ(
+      CsvTable::read(temp_dir_ / "strings.csv", strings_options_)
+          ->get_strings(0),
+      std::vector<std::string>({"a", "", "b"}));
+  EXPECT_EQ(CsvTable::read(temp_dir_ / "unsigned.csv")->get_float64(0)[0],
+            static_cast<double>(large_unsigned_));
+
+  // Rows written back from the table give the same file
+  const ghc::filesystem::path copy_path_ = temp_dir_ / "copy.csv";
+  CsvWriter::sptr copy_ =
+      CsvWriter::construct(copy_path_, table_->get_column_names());
+  copy_->write_table(*table_);
+  EXPECT_EQ(copy_->close(), hash_);
+
+  // Several chunks, with quoted newlines and a column which only turns out
+  // to hold strings near the end
+  const ghc::filesystem::path large_path_ = temp_dir_ / "large.csv";
+  const std::size_t n_rows_ = 200000;
+  {
+    CsvWriter::sptr large_ =
+        CsvWriter::construct(large_path_, {"id", "note", "value", "tag"});
+    for (std::size_t i = 0; i < n_rows_; ++i) {
+      large_->field(i)
+          .field(i % 3 == 0 ? std::string("line\n\"") + std::to_string(i)
+                            : std::string("n") + std::to_string(i))
+          .field(i % 5 == 0 ? 0.25 * static_cast<double>(i)
+                            : static_cast<double>(i));
+      if (i == n_rows_ - 10) {
+        large_->field("x");
+      } else {
+        large_->field(i % 7);
+      }
+      large_->end_row();
+    }
+  }
+  for (unsigned int n_threads_ : {1u, 4u}) {
+    CsvOptions large_options_;
+    large_options_.n_threads = n_threads_;
+    CsvTable::sptr large_ = CsvTable::read(large_path_, large_options_);
+    ASSERT_EQ(large_->n_rows(), n_rows_);
+    const std::vector<std::int64_t> &ids_ = large_->get_int64(0);
+    const std::vector<std::string> &notes_ = large_->get_strings(1);
+    const std::vector<double> &values_ = large_->get_float64(2);
+    const std::vector<std::string> &tags_ = large_->get_strings(3);
+    for (std::size_t i = 0; i < n_rows_; i += 997) {
+      EXPECT_EQ(ids_[i], static_cast<std::int64_t>(i));
+      EXPECT_EQ(notes_[i], i % 3 == 0
+                               ? std::string("line\n\"") + std::to_string(i)
+                               : std::string("n") + std::to_string(i));
+      EXPECT_EQ(values_[i], i % 5 == 0 ? 0.25 * static_cast<double>(i)
+                                       : static_cast<double>(i));
+      EXPECT_EQ(tags_[i], std::to_string(i % 7));
+    }
+    EXPECT_EQ(tags_[n_rows_ - 10], "x");
+  }
+
+  {
+    std::ofstream out_((temp_dir_ / "ragged.csv").string());
+    out_ << "a;b\r\n1;2\r\n\r\n3\r\n";
+  }
+  CsvOptions ragged_;
+  ragged_.delimiter = ';';
+  EXPECT_THROW(CsvTable::read(temp_dir_ / "ragged.csv", ragged_), csv_error);
+  ragged_.header = false;
+  ragged_.column_types["column_2"] = CsvType::INT64;
+  EXPECT_THROW(CsvTable::read(temp_dir_ / "ragged.csv", ragged_), csv_error);
+  EXPECT_THROW(CsvTable::read(temp_dir_ / "missing.csv"), csv_error);
+
+  ghc::filesystem::remove_all(temp_dir_);
+}
+
+TEST(FDAPITest, TestProductTable) {
+  ProductTable table_;
+  const int n_products_ = 5000;
+
+  for (int i = 0; i < n_products_; ++i) {
+    const std::string name_ = "model/output/" + std::to_string(i);
+    table_.insert_or_assign(IOObject(name_, name_, "0.0.1", "PSU",
+                                     "out/" + std::to_string(i) + ".csv",
+                                     "Model output", i % 2 == 0));
+  }
+  EXPECT_EQ(table_.size(), n_products_);
+  EXPECT_EQ(table_.count_registered(), 0);
+
+  // Linking a product again replaces its row
+  table_.insert_or_assign(IOObject("model/output/7", "renamed", "0.0.2",
+                                   "SCRC", "other.csv", "Replaced", true,
+                                   true));
+  EXPECT_EQ(table_.size(), n_products_);
+
+  IOObject product_;
+  ASSERT_TRUE(table_.find("model/output/7", product_));
+  EXPECT_EQ(product_.get_use_data_product(), "renamed");
+  EXPECT_EQ(product_.get_use_version(), "0.0.2");
+  EXPECT_EQ(product_.get_use_namespace(), "SCRC");
+  EXPECT_EQ(product_.get_path(), ghc::filesystem::path("other.csv"));
+  EXPECT_EQ(product_.get_data_product_description(), "Replaced");
+  EXPECT_TRUE(product_.is_public());
+  EXPECT_TRUE(product_.is_directory());
+  EXPECT_FALSE(product_.get_component_object());
+
+  ASSERT_TRUE(table_.find("model/output/8", product_));
+  EXPECT_EQ(product_.get_path(), ghc::filesystem::path("out/8.csv"));
+  EXPECT_TRUE(product_.is_public());
+  EXPECT_FALSE(product_.is_directory());
+  EXPECT_FALSE(table_.find("model/output/missing", product_));
+  EXPECT_FALSE(table_.contains("model/output"));
+
+  EXPECT_TRUE(table_.set_registry_objects(
+      "model/output/8", "http://localhost/api/object_component/3/",
+      "http://localhost/api/data_product/4/"));
+  EXPECT_FALSE(table_.set_registry_objects("missing", "", ""));
+  EXPECT_EQ(table_.count_registered(), 1);
+  ASSERT_TRUE(table_.find("model/output/8", product_));
+  ASSERT_TRUE(product_.get_component_object());
+  EXPECT_EQ(product_.get_component_object()->get_id(), 3);
+  EXPECT_EQ(product_.get_data_product_object()->get_id(), 4);
+
+  int visited_ = 0;
+  table_.for_each([&](const IOObject &) { ++visited_; });
+  EXPECT_EQ(visited_, n_products_);
+
+  // Shards pick products by the high bits of the hash and their indexes
+  // probe from the low bits, so keys are not clustered within a shard
+  EXPECT_LT(table_.mean_probe_length(), 2.0);
+
+  // Shared fields are pooled, so rows cost far less than an IOObject each
+  EXPECT_LT(table_.memory_usage(), n_products_ * sizeof(IOObject));
+
+  // Re-linking a product reuses its pool entries rather than adding more
+  const std::size_t memory_usage_ = table_.memory_usage();
+  for (int i = 0; i < 10000; ++i) {
+    table_.insert_or_assign(IOObject("model/output/8", "model/output/8",
+                                     "0.0.1", "PSU",
+                                     "out/" + std::to_string(i % 10) + ".csv",
+                                     "Model output", true));
+    table_.set_registry_objects(
+        "model/output/8",
+        "http://localhost/api/object_component/" + std::to_string(i % 10) +
+            "/",
+        "http://localhost/api/data_product/4/");
+  }
+  EXPECT_EQ(table_.memory_usage(), memory_usage_);
+  ASSERT_TRUE(table_.find("model/output/8", product_));
+  EXPECT_EQ(product_.get_path(), ghc::filesystem::path("out/9.csv"));
+  EXPECT_EQ(product_.get_component_object()->get_id(), 9);
+}
+
+TEST(FDAPITest, TestPathAllocator) {
+  PathAllocator allocator_;
+  PathAllocator other_;
+  EXPECT_EQ(allocator_.get_session_id().size(), 32);
+  EXPECT_NE(allocator_.get_session_id(), other_.get_session_id());
+
+  std::set<std::string> names_;
+  std::vector<std::thread> threads_;
+  std::mutex names_mutex_;
+  for (int t = 0; t < 8; ++t) {
+    threads_.emplace_back([&]() {
+      for (int i = 0; i < 1000; ++i) {
+        const std::string name_ = allocator_.unique_filename("csv");
+        std::lock_guard<std::mutex> lock_(names_mutex_);
+        names_.insert(name_);
+      }
+    });
+  }
+  for (auto &thread_ : threads_) {
+    thread_.join();
+  }
+  EXPECT_EQ(names_.size(), 8000);
+  EXPECT_EQ(names_.begin()->substr(0, 4), "dat-");
+  EXPECT_EQ(ghc::filesystem::path(*names_.begin()).extension(), ".csv");
+
+  const ghc::filesystem::path root_ =
+      ghc::filesystem::temp_directory_path() / ("fdp-paths-" + generate_random_hash());
+  allocator_.ensure_directory(root_ / "a" / "b");
+  EXPECT_TRUE(ghc::filesystem::is_directory(root_ / "a" / "b"));
+  // A directory already created is not checked again
+  ghc::filesystem::remove_all(root_);
+  allocator_.ensure_directory(root_ / "a" / "b");
+  EXPECT_FALSE(ghc::filesystem::exists(root_));
+  other_.ensure_directory(root_ / "a" / "b");
+  EXPECT_TRUE(ghc::filesystem::is_directory(root_ / "a" / "b"));
+  ghc::filesystem::remove_all(root_);
+}
+
+TEST(FDAPITest, TestPhilox) {
+  // Known answer from the Random123 distribution
+  const Philox4x32::counter_type zero_ =
+      Philox4x32::block(Philox4x32::counter_type{{0, 0, 0, 0}},
+                        Philox4x32::key_type{{0, 0}});
+  EXPECT_EQ(zero_[0], 0x6627e8d5u);
+  EXPECT_EQ(zero_[1], 0xe169c58du);
+  EXPECT_EQ(zero_[2], 0xbc57ac4cu);
+  EXPECT_EQ(zero_[3], 0x9b00dbd8u);
+
+  EXPECT_EQ(Philox4x32::to_unit(0, 0), 0.0);
+  EXPECT_LT(Philox4x32::to_unit(0xffffffffu, 0xffffffffu), 1.0);
+}
+
+TEST(FDAPITest, TestSampling) {
+  using namespace sampling;
+  const std::size_t n_ = 200001;
+  const Family families_[] = {Family::NORMAL, Family::LOGNORMAL,
+                              Family::GAMMA, Family::UNIFORM};
+  for (Family family_ : families_) {
+    const double mu_ = family_ == Family::LOGNORMAL ? 0.5 : 3.0;
+    const double sigma_ = family_ == Family::GAMMA ? 4.0 : 0.25;
+
+    // Same stream for any thread count or batch split
+    std::vector<double> serial_(n_);
+    std::vector<double> threaded_(n_);
+    std::vector<double> split_(n_);
+    sample(family_, mu_, sigma_, 42, 0, serial_.data(), n_);
+    sample(family_, mu_, sigma_, 42, 0, threaded_.data(), n_, 4);
+    sample(family_, mu_, sigma_, 42, 0, split_.data(), 7);
+    sample(family_, mu_, sigma_, 42, 7, split_.data() + 7, n_ - 7, 3);
+    ASSERT_EQ(serial_, threaded_);
+    ASSERT_EQ(serial_, split_);
+
+    std::vector<double> other_(n_);
+    sample(family_, mu_, sigma_, 43, 0, other_.data(), n_);
+    EXPECT_NE(serial_, other_);
+
+    double sum_ = 0.0;
+    double sum_sq_ = 0.0;
+    for (double x_ : serial_) {
+      const double y_ = family_ == Family::LOGNORMAL ? std::log(x_) : x_;
+      sum_ += y_;
+      sum_sq_ += y_ * y_;
+    }
+    const double mean_ = sum_ / n_;
+    const double sd_ = std::sqrt(sum_sq_ / n_ - mean_ * mean_);
+    EXPECT_NEAR(mean_, mu_, 0.02 * mu_);
+    EXPECT_NEAR(sd_, sigma_, 0.02 * sigma_);
+  }
+
+  EXPECT_EQ(family_from_name("Gaussian"), Family::NORMAL);
+  EXPECT_THROW(family_from_name("cauchy"), validation_error);
+  double out_;
+  EXPECT_THROW(sample(Family::GAMMA, -1.0, 1.0, 1, 0, &out_, 1),
+               validation_error);
+}
+
+TEST(FDAPITest, TestDensities) {
+  using namespace sampling;
+  const double x_[] = {-1.0, 0.0, 0.5, 1.0, 2.0};
+  double out_[5];
+
+  log_pdf(Family::NORMAL, 0.0, 1.0, x_, out_, 5);
+  EXPECT_NEAR(out_[1], -0.9189385332046727, 1e-12);
+  EXPECT_NEAR(out_[4], -2.9189385332046727, 1e-12);
+  cdf(Family::NORMAL, 0.0, 1.0, x_, out_, 5);
+  EXPECT_NEAR(out_[0], 0.15865525393145707, 1e-12);
+  EXPECT_NEAR(out_[1], 0.5, 1e-12);
+
+  // Exponential with rate 1
+  cdf(Family::GAMMA, 1.0, 1.0, x_, out_, 5);
+  EXPECT_EQ(out_[0], 0.0);
+  EXPECT_NEAR(out_[2], 1.0 - std::exp(-0.5), 1e-12);
+  EXPECT_NEAR(out_[4], 1.0 - std::exp(-2.0), 1e-12);
+  log_pdf(Family::GAMMA, 1.0, 1.0, x_, out_, 5);
+  EXPECT_TRUE(std::isinf(out_[0]));
+  EXPECT_NEAR(out_[1], 0.0, 1e-12);
+  EXPECT_NEAR(out_[3], -1.0, 1e-12);
+
+  log_pdf(Family::LOGNORMAL, 0.0, 1.0, x_, out_, 5);
+  EXPECT_TRUE(std::isinf(out_[1]));
+  EXPECT_NEAR(out_[3], -0.9189385332046727, 1e-12);
+  cdf(Family::LOGNORMAL, 0.0, 1.0, x_, out_, 5);
+  EXPECT_NEAR(out_[3], 0.5, 1e-12);
+
+  // Uniform on [0, 1]
+  const double sd_ = 1.0 / std::sqrt(12.0);
+  cdf(Family::UNIFORM, 0.5, sd_, x_, out_, 5);
+  EXPECT_EQ(out_[0], 0.0);
+  EXPECT_NEAR(out_[2], 0.5, 1e-12);
+  EXPECT_EQ(out_[4], 1.0);
+  log_pdf(Family::UNIFORM, 0.5, sd_, x_, out_, 5);
+  EXPECT_NEAR(out_[2], 0.0, 1e-12);
+  EXPECT_TRUE(std::isinf(out_[4]));
+}
+
+#ifndef _WIN32
+TEST(FDAPITest, TestSharedSessionProcesses) {
+  const ghc::filesystem::path root_ =
+      ghc::filesystem::path(TESTDIR) / "data" / "temp_shared_session";
+  const std::string session_id_ = "test-" + std::to_string(getpid());
+  const int n_ranks_ = 4;
+
+  // A session left by an earlier run with the same id is never attached to
+  const ghc::filesystem::path directory_ =
+      SharedSession::construct(root_, session_id_, 0, n_ranks_)
+          ->get_directory();
+  ghc::filesystem::create_directories(directory_);
+  {
+    std::ofstream out_((directory_ / "session.json").string());
+    out_ << "{\"nonce\":\"stale\","
+         << "\"session\":{\"code_run\":{\"uuid\":\"stale-code-run\"}}}";
+  }
+  ghc::filesystem::last_write_time(
+      directory_ / "session.json",
+      ghc::filesystem::file_time_type::clock::now() - std::chrono::hours(1));
+
+  // Workers start before the leader has published and wait for it
+  std::vector<pid_t> workers_;
+  for (int rank_ = 1; rank_ < n_ranks_; ++rank_) {
+    const pid_t pid_ = fork();
+    ASSERT_GE(pid_, 0);
+    if (pid_ == 0) {
+      int status_ = 1;
+      try {
+        SharedSession::sptr session_ =
+            SharedSession::construct(root_, session_id_, rank_, n_ranks_, 30.0);
+        const Json::Value published_ = session_->attach();
+        Journal::sptr log_ = Journal::open(session_->worker_log_path());
+        Json::Value write_;
+        write_["data_product"] = "test/shards";
+        write_["path"] = "rank_" + std::to_string(rank_) + ".csv";
+        log_->record("link_write", write_);
+        Json::Value finalised_;
+        finalised_["code_run"] = published_["code_run"]["uuid"];
+        log_->record("finalise", finalised_);
+        status_ = 0;
+      } catch (...) {
+      }
+      _exit(status_);
+    }
+    workers_.push_back(pid_);
+  }
+
+  SharedSession::sptr leader_ =
+      SharedSession::construct(root_, session_id_, 0, n_ranks_, 30.0);
+  EXPECT_TRUE(leader_->is_leader());
+  leader_->prepare();
+  Json::Value session_;
+  session_["code_run"]["uuid"] = "shared-code-run";
+  leader_->publish(session_);
+
+  const std::vector<Json::Value> records_ = leader_->collect("shared-code-run");
+  ASSERT_EQ(records_.size(), n_ranks_ - 1);
+  for (int rank_ = 1; rank_ < n_ranks_; ++rank_) {
+    const Json::Value &record_ = records_[rank_ - 1];
+    EXPECT_EQ(record_["rank"].asInt(), rank_);
+    EXPECT_EQ(record_["step"].asString(), "link_write");
+    EXPECT_EQ(record_["data"]["path"].asString(),
+              "rank_" + std::to_string(rank_) + ".csv");
+  }
+
+  for (pid_t pid_ : workers_) {
+    int status_ = -1;
+    waitpid(pid_, &status_, 0);
+    EXPECT_TRUE(WIFEXITED(status_) && WEXITSTATUS(status_) == 0);
+  }
+
+  leader_->close();
+  EXPECT_FALSE(ghc::filesystem::exists(leader_->get_directory()));
+  ghc::filesystem::remove_all(root_);
+}
+#endif